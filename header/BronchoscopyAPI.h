@@ -1,11 +1,14 @@
 #ifndef BRONCHOSCOPY_API_H
 #define BRONCHOSCOPY_API_H
 
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 // Forward declarations
 class vtkPolyData;
+class vtkImageData;
 class vtkRenderWindow;
 class vtkRenderer;
 
@@ -19,6 +22,13 @@ namespace BronchoscopyLib {
      */
     class BronchoscopyAPI {
     public:
+        // Transparency strategies for the translucent overview (airway and path tube)
+        enum TransparencyMode {
+            TRANSPARENCY_BLEND,          // Blending in draw order: cheapest, sorting artifacts
+            TRANSPARENCY_DEPTH_PEELING,  // Dual depth peeling: exact, cost grows with the peel budget
+            TRANSPARENCY_WEIGHTED_OIT    // Weighted blended OIT: single pass, approximate colors
+        };
+        
         BronchoscopyAPI();
         ~BronchoscopyAPI();
         
@@ -26,7 +36,85 @@ namespace BronchoscopyLib {
         void Initialize();
         
         // Model management
-        bool LoadAirwayModel(vtkPolyData* polyData);
+        // By default the model is deep-copied. With adopt = true the library takes
+        // over the caller's data and shares its buffers instead of copying them;
+        // the caller must not modify the polyData afterwards.
+        bool LoadAirwayModel(vtkPolyData* polyData, bool adopt = false);
+        
+        // Mesh preprocessing: reorder triangles for vertex-cache locality and
+        // renumber vertices in first-use order (off by default)
+        void SetVertexCacheOptimization(bool enable);
+        bool GetVertexCacheStats(double& acmrBefore, double& acmrAfter) const;
+        
+        // Compact mesh mode: float32 positions and octahedral-packed normals;
+        // the double-precision source is released after preprocessing (off by default)
+        void SetCompactMode(bool enable);
+        
+        // Bytes retained by each preprocessing stage of the current model
+        // (arrays shared between stages are counted once)
+        void GetModelMemoryUsage(std::vector<std::string>& stages, std::vector<size_t>& bytes) const;
+        
+        // Shader variant cache counters: variant lookups served from cache, variants
+        // composed, and mappers left untouched because they already used the variant
+        void GetShaderCacheStats(unsigned long& hits, unsigned long& misses, unsigned long& reused) const;
+        
+        // Each instance owns its shader state. Instances created on different threads can
+        // share the parsed shader files and composed variants of another instance; the
+        // shared cache is thread-safe, so lookups from several instances run concurrently.
+        // Actors already shaded switch to the shared variants on their next model load.
+        void ShareShaderCache(const BronchoscopyAPI& other);
+        
+        // Shader hot reload (development aid, Linux only)
+        // Watches the directory (the shaders/ folder is searched for when empty) and uses it
+        // as the shader override path. Changed files are re-parsed on a background thread;
+        // ProcessShaderHotReload() must be called periodically on the render thread to apply
+        // them to the affected actors. If an edited shader fails to compile the error is
+        // reported and the last good version stays in use. Returns the number of updated mappers.
+        bool EnableShaderHotReload(const std::string& directory = "");
+        void DisableShaderHotReload();
+        int ProcessShaderHotReload();
+        
+        // Asynchronous model loading
+        // The reader fills the given (empty) polyData, e.g. by running a VTK reader and
+        // shallow-copying its output; it runs on a worker thread together with cleaning,
+        // normal generation and the optional optimization stages. The current model stays
+        // interactive until the finished geometry is swapped in by ProcessAsyncLoad().
+        typedef std::function<bool(vtkPolyData* output)> ModelReader;
+        typedef std::function<void(double progress, const std::string& stage)> LoadProgressCallback;
+        typedef std::function<void(bool success)> LoadFinishedCallback;
+        
+        // Starts a background load; a load already in flight is cancelled. Loads run one at a
+        // time, so the new one starts once the cancelled one has stopped at its next check.
+        // Preprocessing settings are captured at call time.
+        bool LoadAirwayModelAsync(ModelReader reader,
+                                  LoadProgressCallback progress = nullptr,
+                                  LoadFinishedCallback finished = nullptr);
+        void CancelAsyncLoad();
+        bool IsAsyncLoadPending() const;
+        
+        // Must be called periodically on the render (UI) thread, e.g. from a timer.
+        // Delivers progress and completion callbacks on that thread and installs the
+        // finished model in one step. It also swaps in endoscope visibility sets built in the
+        // background (see SetVisibilityCulling), so keep calling it while culling is enabled.
+        void ProcessAsyncLoad();
+        
+        // Loading from a segmentation volume
+        // The airway surface is extracted from the labeled voxels (parallel marching cubes,
+        // optionally Gaussian pre-smoothing, Taubin smoothing and decimation) and then goes
+        // through the same preprocessing as a loaded mesh. Coordinates follow the volume's
+        // origin and spacing. Label 0 selects all non-zero voxels; the defaults are
+        // label 0, sigma 0.7 voxels, 10 smoothing iterations and no decimation.
+        void SetVolumeSurfaceSettings(int label, double gaussianSigma = 0.7,
+                                      int smoothingIterations = 10, double decimation = 0.0);
+        bool LoadAirwayVolume(vtkImageData* volume);
+        
+        // Asynchronous variant: the reader fills the given (empty) image, e.g. by
+        // shallow-copying the output of a VTK image reader; extraction and preprocessing
+        // run on the same worker as LoadAirwayModelAsync and share its cancel/finish handling.
+        typedef std::function<bool(vtkImageData* output)> VolumeReader;
+        bool LoadAirwayVolumeAsync(VolumeReader reader,
+                                   LoadProgressCallback progress = nullptr,
+                                   LoadFinishedCallback finished = nullptr);
         
         // Path management
         bool LoadCameraPath(const std::vector<double>& positions);
@@ -60,6 +148,24 @@ namespace BronchoscopyLib {
         void SetMarkerRadius(double radius);
         void SetModelOpacity(double opacity);
         
+        // Feature angle for normal generation (0-180 degrees, default 80). Edges sharper
+        // than this keep a crease; only the normal stage is recomputed on the cached mesh.
+        void SetModelSmoothingAngle(double degrees);
+        
+        // Endoscope visibility culling (off by default). For each path node the mesh chunks
+        // visible from around the node are precomputed by ray sampling when the model, path or
+        // endoscope FOV changes; the endoscope view then draws only the chunks visible between
+        // the camera and the target node. The precomputation runs on the worker threads and the
+        // full mesh is drawn until it finishes (swapped in by ProcessAsyncLoad or the next
+        // navigation step). Sampling is an approximation, not a conservative test: chunks smaller
+        // than the ray spacing can be missed for some poses. When the endoscope camera is moved
+        // off the path (mouse interaction in the endoscope window) the full mesh is drawn until
+        // navigation returns it to a path pose.
+        // The fraction is the share of triangles currently drawn (1: all).
+        void SetVisibilityCulling(bool enable);
+        bool GetVisibilityCulling() const;
+        double GetEndoscopeVisibleFraction() const;
+        
         // Camera control
         void ResetCameras();
         void Render();
@@ -72,6 +178,66 @@ namespace BronchoscopyLib {
         bool HasModel() const;
         bool HasPath() const;
         
+        // Surface queries against the airway mesh, accelerated by a BVH built at load time.
+        // CastRay returns the nearest wall hit along direction within maxDistance (<= 0: unlimited).
+        bool CastRay(const double origin[3], const double direction[3], double hitPoint[3],
+                     double& distance, double maxDistance = 0.0) const;
+        bool GetClosestSurfacePoint(const double point[3], double closest[3], double& distance) const;
+        
+        // Lumen radius at a path node (-1: current node), from a ring of rays perpendicular to the
+        // path. Precomputed for all nodes whenever the model or the path changes, so it is a table
+        // lookup. Returns false without model/path or when no ray hit the wall at that node.
+        bool GetLumenRadius(int index, double& minRadius, double& maxRadius, double& meanRadius) const;
+        
+        // Narrow-band signed distance field of the lumen, built after the BVH (off by default; also
+        // built while centerline extraction is on, which needs it). Sizes <= 0 are chosen
+        // automatically; changing them on a loaded model rebuilds only the field.
+        void SetDistanceField(bool enable, double voxelSize = 0.0, double bandWidth = 0.0);
+        
+        // Trilinear distance to the wall: positive inside the lumen, negative outside, clamped to
+        // the band width. gradient (optional) points towards the lumen interior. False without a field.
+        bool GetWallDistance(const double point[3], double& distance, double gradient[3] = nullptr) const;
+        
+        // Keep the endoscope camera inside the lumen during transitions: interpolated positions
+        // closer to the wall than clearance are pushed back along the distance field gradient.
+        // Off by default; enabling it also turns on the distance field.
+        void SetLumenConstraint(bool enable, double clearance = 0.5);
+        
+        // Airway centerline tree, skeletonized from the distance field at load time (off by default;
+        // turning it on also builds the distance field). Route planning and path branch labels
+        // below need it. Branch points are xyz triples; a child branch starts at the last point
+        // of its parent, the root branch starts at the trachea opening.
+        void SetCenterlineExtraction(bool enable);
+        int GetCenterlineBranchCount() const;
+        bool GetCenterlineBranch(int index, std::vector<double>& points, std::vector<double>& radii,
+                                 int& parent) const;
+        
+        // Positions from the root to the end of a branch (-1: the leaf farthest from the root),
+        // in the format accepted by LoadCameraPath. LoadCenterlinePath loads them directly.
+        bool GetCenterlinePath(int branch, std::vector<double>& positions) const;
+        bool LoadCenterlinePath(int branch = -1);
+        
+        // Shortest route from the trachea to a target point (e.g. a nodule) over the centerline.
+        // Centerline points whose lumen radius is below the scope radius are not traversable
+        // (0: no limit). The route ends at the reachable point closest to the target; targetDistance
+        // is the remaining straight-line distance. Distances from the trachea are precomputed per
+        // model and scope radius, so planning for a new target is a single scan.
+        void SetScopeRadius(double radius);
+        double GetScopeRadius() const;
+        bool GetRouteToTarget(const double target[3], std::vector<double>& positions,
+                              double& targetDistance) const;
+        bool LoadRouteToTarget(const double target[3]);
+        
+        // Cache for data derived from the mesh ("sdf": distance field, "centerline").
+        // The library does no file I/O: the host persists the serialized data by name, e.g. next
+        // to the mesh file; stale data (other mesh or settings) is rebuilt. The callbacks run on
+        // the loader thread for async loads and on the calling thread for synchronous loads and
+        // setting changes, but never concurrently. Each model keeps the callbacks that were set
+        // when its load started, so set them for the next file before starting its load.
+        typedef std::function<bool(const std::string& name, std::vector<unsigned char>& data)> ModelCacheLoader;
+        typedef std::function<void(const std::string& name, const std::vector<unsigned char>& data)> ModelCacheStore;
+        void SetModelCache(ModelCacheLoader load, ModelCacheStore store);
+        
         // 新增：自动播放控制（来自NavigationController）
         void StartAutoPlay(int intervalMs = 100);
         void StopAutoPlay();
@@ -86,6 +252,13 @@ namespace BronchoscopyLib {
         // 新增：进度控制（来自NavigationController）
         bool MoveToPosition(int index);
         double GetProgressPercentage() const;
+        
+        // Path nodes are labeled with the centerline branch they lie in once per path/model.
+        // MoveToNextBifurcation jumps to the first node past the next carina (false if none ahead).
+        // GetNodeBranch (-1: current node) reports the branch, its generation (trachea = 0) and the
+        // distance along the path to the next bifurcation (-1 if none).
+        bool MoveToNextBifurcation();
+        bool GetNodeBranch(int index, int& branch, int& generation, double& distanceToBifurcation) const;
         bool IsAtStart() const;
         bool IsAtEnd() const;
         
@@ -99,6 +272,66 @@ namespace BronchoscopyLib {
         void SetOverviewBackground(double r, double g, double b);
         void SetEndoscopeBackground(double r, double g, double b);
         
+        // FXAA post-processing anti-aliasing for both views (off by default); a cheap
+        // alternative when MSAA is disabled on the render windows
+        void SetFXAA(bool enable);
+        bool GetFXAA() const;
+        
+        // Per-pass timing of the last frames, in milliseconds ("scene" is the view itself
+        // rendered off-screen); names are prefixed with "overview/" or "endoscope/".
+        // GPU times lag a few frames behind and are -1 until the first query result arrives.
+        void GetPostProcessingTimings(std::vector<std::string>& passes,
+                                      std::vector<double>& cpuMs,
+                                      std::vector<double>& gpuMs) const;
+        
+        // Transparency strategy of the overview (TRANSPARENCY_BLEND by default). Depth peeling
+        // stops after maxPeels layers, or earlier once fewer than occlusionRatio of the pixels
+        // still change (0 peels until no fragments remain).
+        void SetTransparencyMode(TransparencyMode mode);
+        TransparencyMode GetTransparencyMode() const;
+        void SetDepthPeelingBudget(int maxPeels, double occlusionRatio = 0.0);
+        
+        // Dynamic resolution for the endoscope view (off by default). While a camera transition
+        // is running (including animated autoplay steps) the view renders at a reduced resolution and is upscaled;
+        // the scale adapts within [minScale, 1] to hold targetFrameMs, and a full-resolution
+        // frame is rendered as soon as the motion stops (see UpdateAnimation).
+        void SetDynamicResolution(bool enable, double targetFrameMs = 1000.0 / 60.0, double minScale = 0.5);
+        bool GetDynamicResolution() const;
+        
+        // Current endoscope resolution scale (1 when the camera is still or the mode is off)
+        double GetDynamicResolutionScale() const;
+        
+        // Mean overview frame time while the given mode was active, over the rolling profile
+        // window, in milliseconds. GPU time is -1 without timer queries. Returns false if the
+        // mode has not rendered a frame yet.
+        bool GetTransparencyFrameTime(TransparencyMode mode, double& cpuMs, double& gpuMs) const;
+        
+        // Render profiling (off by default) for tracking frame cost per shader variant.
+        // Each render step, actor and post-processing pass of both views is timed with GPU
+        // timer queries where the driver supports them; otherwise only CPU time is measured,
+        // with glFinish around each section so it reflects execution (software rendering).
+        void SetRenderProfiling(bool enable);
+        bool GetRenderProfiling() const;
+        
+        // Rolling statistics over the last `frames` frames (120 by default), in milliseconds.
+        // Series are "<view>/frame", "<view>/step/<opaque|translucent|volume|overlay>",
+        // "<view>/actor/<shader variant>" and "<view>/post/<pass>", with <view> "overview"
+        // or "endoscope". GPU values are -1 for series without timer query results.
+        void SetRenderProfileWindow(size_t frames);
+        void GetRenderProfile(std::vector<std::string>& series,
+                              std::vector<double>& cpuMeanMs, std::vector<double>& cpuP95Ms,
+                              std::vector<double>& gpuMeanMs, std::vector<double>& gpuP95Ms) const;
+        void ResetRenderProfile();
+        
+        // Runtime shader parameters. They are uniforms uploaded once per frame, so
+        // changes take effect on the next render without recompiling any shader.
+        // Endoscope imaging: exposure gain, contrast and vignette strength (0 = none)
+        void SetEndoscopeImaging(double exposure, double contrast, double vignette);
+        // Tissue material: roughness, metallic, subsurface scattering and clearcoat, all 0..1
+        void SetTissueMaterial(double roughness, double metallic, double subsurface, double clearcoat);
+        // Any float uniform declared by the view or material shaders (e.g. "focusDistance")
+        void SetShaderParameter(const std::string& name, double value);
+        
     private:
         class Impl;
         std::unique_ptr<Impl> pImpl;
@@ -42,9 +42,13 @@ private slots:
     void createStatusBar();
     void setupDualViewWidget();
     void loadAirwayModel();
+    void loadAirwayVolume();
     void loadCameraPath();
+    void loadCenterlinePath();
+    void planRouteToTarget();
     void navigateNext();
     void navigatePrevious();
+    void navigateNextBifurcation();
     void resetNavigation();
     void toggleAutoPlay();
     void updateAnimation();  // 更新动画帧
@@ -53,6 +57,15 @@ protected:
     void keyPressEvent(QKeyEvent *event) override;
 
 private:
+    // 路径进度文本，附带当前节点的管腔直径（有模型时）
+    QString pathStatusText(int current, int total) const;
+    
+    // 异步加载完成（模型文件和体数据共用）
+    void onAsyncLoadFinished(const QString& fileName, bool success);
+    
+    // 派生数据缓存放在文件旁
+    void setModelCache(const std::string& fileStr);
+    
     // UI组件 - 双窗口
     QVTKOpenGLWidget *overviewWidget;   // 左侧：全局视图
     QVTKOpenGLWidget *endoscopeWidget;  // 右侧：内窥镜视图
@@ -67,11 +80,15 @@ private:
     
     // 动作
     QAction *loadModelAct;
+    QAction *loadVolumeAct;
     QAction *loadPathAct;
+    QAction *centerlinePathAct;
+    QAction *planRouteAct;
     QAction *exitAct;
     QAction *aboutAct;
     QAction *nextAct;
     QAction *previousAct;
+    QAction *nextBifurcationAct;
     QAction *resetAct;
     QAction *playAct;
     
@@ -84,6 +101,8 @@ private:
     // 定时器
     QTimer *autoPlayTimer;     // 自动播放定时器
     QTimer *animationTimer;     // 动画更新定时器
+    QTimer *asyncLoadTimer;     // 异步模型加载轮询定时器
+    QTimer *shaderReloadTimer;  // shader热重载轮询定时器（仅设置BRONCHOSCOPY_SHADER_DIR时启用）
     bool isPlaying;
     bool isAnimating;           // 是否正在动画过渡中
 };
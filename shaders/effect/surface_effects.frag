@@ -0,0 +1,36 @@
+# Surface Effects Shader
+# 表面效果 - 菲涅尔轮廓光和深度雾，按变体特性宏选择（FEATURE_FRESNEL / FEATURE_FOG）
+
+//VTK::System::Dec AFTER
+//VTK::System::Dec
+#ifdef FEATURE_FRESNEL
+uniform float fresnelPower = 3.0;                        // 轮廓光衰减指数
+uniform float fresnelStrength = 0.35;                    // 轮廓光强度
+uniform vec3 fresnelColor = vec3(1.0, 0.95, 0.9);        // 轮廓光颜色
+#endif
+#ifdef FEATURE_FOG
+uniform float fogStart = 20.0;                           // 雾起始距离（相机空间）
+uniform float fogEnd = 150.0;                            // 雾完全覆盖距离
+uniform vec3 fogColor = vec3(0.05, 0.02, 0.02);          // 雾颜色（腔道深处偏暗红）
+#endif
+END_REPLACEMENT
+
+//VTK::Light::Impl AFTER
+//VTK::Light::Impl
+
+  // ============ 表面效果 ============
+
+#ifdef FEATURE_FRESNEL
+  // 菲涅尔轮廓光：掠射角处增亮，突出腔壁轮廓
+  vec3 rimN = normalize(normalVCVSOutput);
+  vec3 rimV = normalize(-vertexVC.xyz);
+  float rim = pow(1.0 - clamp(dot(rimN, rimV), 0.0, 1.0), fresnelPower);
+  fragOutput0.rgb += fresnelColor * rim * fresnelStrength;
+#endif
+
+#ifdef FEATURE_FOG
+  // 深度雾：按相机距离线性混合雾颜色
+  float fogFactor = clamp((length(vertexVC.xyz) - fogStart) / max(fogEnd - fogStart, 0.001), 0.0, 1.0);
+  fragOutput0.rgb = mix(fragOutput0.rgb, fogColor, fogFactor);
+#endif
+END_REPLACEMENT
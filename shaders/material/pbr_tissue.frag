@@ -2,7 +2,8 @@
 # 基于物理的渲染 - 模拟真实的组织材质
 
 //VTK::System::Dec AFTER
-// PBR参数声明
+//VTK::System::Dec
+// PBR参数声明（运行时uniform，由ShaderSystem参数块设置）
 uniform float metallic = 0.0;      // 组织非金属
 uniform float roughness = 0.4;     // 中等粗糙度
 uniform float subsurface = 0.8;    // 高次表面散射
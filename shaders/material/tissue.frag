@@ -2,11 +2,12 @@
 # Physically Based Rendering for tissue
 
 //VTK::System::Dec AFTER
-// PBR material parameters
-const float metallic = 0.0;
-const float roughness = 0.45;  // Increased for stability
-const float subsurface = 0.5;
-const float clearcoat = 0.1;
+//VTK::System::Dec
+// PBR material parameters (runtime uniforms, set through ShaderSystem parameter blocks)
+uniform float metallic = 0.0;
+uniform float roughness = 0.45;  // Increased for stability
+uniform float subsurface = 0.5;
+uniform float clearcoat = 0.1;
 END_REPLACEMENT
 
 //VTK::Light::Impl AFTER
@@ -1,19 +1,58 @@
-#version 120
+//VTK::System::Dec
 
-// 简化的FXAA片段着色器
+// FXAA片段着色器（基于亮度的快速近似抗锯齿）
 uniform sampler2D screenTexture;
 uniform vec2 screenSize;
 
 varying vec2 texCoord;
 
+//VTK::Output::Dec
+
+// 边缘方向采样的最大跨度（像素）
+const float FXAA_SPAN_MAX = 8.0;
+// 按局部亮度缩小方向向量，避免平坦区域过度模糊
+const float FXAA_REDUCE_MUL = 1.0 / 8.0;
+const float FXAA_REDUCE_MIN = 1.0 / 128.0;
+
+float Luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
 void main() {
-    // 暂时只是pass-through，后期实现FXAA算法
-    vec4 color = texture2D(screenTexture, texCoord);
+    vec2 texel = 1.0 / screenSize;
+    
+    // 1. 亮度计算：中心和四个对角邻居
+    vec4 colorM = texture2D(screenTexture, texCoord);
+    float lumaNW = Luma(texture2D(screenTexture, texCoord + vec2(-1.0, -1.0) * texel).rgb);
+    float lumaNE = Luma(texture2D(screenTexture, texCoord + vec2( 1.0, -1.0) * texel).rgb);
+    float lumaSW = Luma(texture2D(screenTexture, texCoord + vec2(-1.0,  1.0) * texel).rgb);
+    float lumaSE = Luma(texture2D(screenTexture, texCoord + vec2( 1.0,  1.0) * texel).rgb);
+    float lumaM = Luma(colorM.rgb);
+    
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+    
+    // 2. 边缘检测：亮度梯度的垂直方向即边缘方向
+    vec2 dir;
+    dir.x = -((lumaNW + lumaNE) - (lumaSW + lumaSE));
+    dir.y =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));
+    
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL),
+                          FXAA_REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texel;
+    
+    // 3. 子像素抗锯齿：沿边缘方向采样
+    vec3 rgbA = 0.5 * (
+        texture2D(screenTexture, texCoord + dir * (1.0 / 3.0 - 0.5)).rgb +
+        texture2D(screenTexture, texCoord + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (
+        texture2D(screenTexture, texCoord + dir * -0.5).rgb +
+        texture2D(screenTexture, texCoord + dir *  0.5).rgb);
     
-    // TODO: 实现FXAA抗锯齿
-    // 1. 亮度计算
-    // 2. 边缘检测
-    // 3. 子像素抗锯齿
+    // 较宽的采样跨出了局部亮度范围（越过了另一条边）时退回较窄的结果
+    float lumaB = Luma(rgbB);
+    vec3 color = (lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB;
     
-    gl_FragColor = color;
-}
\ No newline at end of file
+    gl_FragData[0] = vec4(color, colorM.a);
+}
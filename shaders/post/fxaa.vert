@@ -1,11 +1,13 @@
-#version 120
+//VTK::System::Dec
 
 // FXAA顶点着色器（全屏四边形）
+// 顶点和纹理坐标由vtkOpenGLRenderUtilities::RenderQuad提供
 attribute vec4 vertexMC;
+attribute vec2 tcoordMC;
 
 varying vec2 texCoord;
 
 void main() {
     gl_Position = vertexMC;
-    texCoord = (vertexMC.xy + 1.0) * 0.5;
-}
\ No newline at end of file
+    texCoord = tcoordMC;
+}
@@ -2,10 +2,12 @@
 # Endoscope imaging effects
 
 //VTK::System::Dec AFTER
-// Imaging parameters
-const float exposure = 1.3;
-const float contrast = 1.15;
-const float vignette = 0.25;
+//VTK::System::Dec
+// Imaging parameters (runtime uniforms, set through ShaderSystem parameter blocks)
+uniform float exposure = 1.3;
+uniform float contrast = 1.15;
+uniform float vignette = 0.25;
+uniform vec4 viewport = vec4(0.0, 0.0, 1920.0, 1080.0); // x, y, width, height in pixels
 END_REPLACEMENT
 
 //VTK::Color::Impl AFTER
@@ -23,7 +25,7 @@ END_REPLACEMENT
   vec3 color = fragOutput0.rgb;
   
   // Screen coordinates
-  vec2 uv = gl_FragCoord.xy / vec2(1920.0, 1080.0);
+  vec2 uv = (gl_FragCoord.xy - viewport.xy) / viewport.zw;
   vec2 center = uv - vec2(0.5);
   
   // 1. Radial distortion
@@ -38,9 +40,11 @@ END_REPLACEMENT
   color = mix(color, aberratedColor, 0.6);
   
   // 3. Vignetting
+#ifdef FEATURE_VIGNETTE
   float vignetteFactor = 1.0 - smoothstep(0.0, 0.7, dist2 * 0.8);
   vignetteFactor = mix(1.0, vignetteFactor, vignette);
   color *= vignetteFactor;
+#endif
   
   // 4. Edge blur
   float edgeBlur = smoothstep(0.3, 0.7, dist2);
@@ -71,13 +75,15 @@ END_REPLACEMENT
   // 8. Exposure
   color *= exposure;
   
-  // 9. Tone mapping (ACES)
+  // 9. Tone mapping (ACES), skipped when the PBR material already tone-mapped
+#ifndef FEATURE_PBR
   float a = 2.51;
   float b = 0.03;
   float c = 2.43;
   float d = 0.59;
   float e = 0.14;
   color = clamp((color * (a * color + b)) / (color * (c * color + d) + e), 0.0, 1.0);
+#endif
   
   // 10. Output
   fragOutput0.rgb = color;
@@ -34,11 +34,14 @@
   
   // --- 4. 简单色调映射 ---
   
+  // PBR材质已做色调映射和Gamma校正时跳过
+#ifndef FEATURE_PBR
   // Reinhard
   color = color / (color + vec3(1.0));
   
   // Gamma校正
   color = pow(color, vec3(1.0/2.2));
+#endif
   
   // --- 5. 输出 ---
   
@@ -2,12 +2,15 @@
 # 真实内窥镜视图 - 模拟医疗成像特性和真实光照
 
 //VTK::System::Dec AFTER
-// 视图特定参数
+//VTK::System::Dec
+// 视图特定参数（运行时uniform，由ShaderSystem参数块设置）
 uniform float exposure = 1.2;        // 曝光度
 uniform float contrast = 1.1;        // 对比度
 uniform float saturation = 0.9;      // 饱和度（略微降低模拟医疗设备）
 uniform float vignette = 0.3;        // 暗角强度
 uniform float filmGrain = 0.02;      // 胶片颗粒
+uniform float focusDistance = 50.0;  // 焦点距离
+uniform vec4 viewport = vec4(0.0, 0.0, 1920.0, 1080.0); // 视口原点和尺寸（像素）
 END_REPLACEMENT
 
 //VTK::Color::Impl AFTER
@@ -24,13 +27,12 @@ END_REPLACEMENT
   // ============ 真实内窥镜成像效果 ============
   
   vec3 color = fragOutput0.rgb;
-  vec2 uv = gl_FragCoord.xy / vec2(1920.0, 1080.0); // 假设分辨率
+  vec2 uv = (gl_FragCoord.xy - viewport.xy) / viewport.zw;
   
   // --- 1. 景深效果模拟 ---
   
   // 计算深度
   float depth = length(vertexVC.xyz);
-  float focusDistance = 50.0; // 焦点距离
   float dofStrength = abs(depth - focusDistance) / 100.0;
   dofStrength = clamp(dofStrength, 0.0, 1.0);
   
@@ -50,10 +52,12 @@ END_REPLACEMENT
   
   // --- 3. 暗角效果（Vignetting） ---
   
+#ifdef FEATURE_VIGNETTE
   float dist = distance(uv, vec2(0.5));
   float vignetteFactor = smoothstep(0.8, 0.3, dist);
   vignetteFactor = mix(1.0, vignetteFactor, vignette);
   color *= vignetteFactor;
+#endif
   
   // --- 4. 镜头光晕（简化） ---
   
@@ -94,6 +98,8 @@ END_REPLACEMENT
   
   // --- 9. 高级色调映射（Filmic） ---
   
+  // PBR材质已做色调映射和Gamma校正时跳过
+#ifndef FEATURE_PBR
   // Filmic Tonemapping (John Hable's Uncharted 2)
   vec3 x = max(vec3(0.0), color - 0.004);
   vec3 result = (x * (6.2 * x + 0.5)) / (x * (6.2 * x + 1.7) + 0.06);
@@ -102,6 +108,7 @@ END_REPLACEMENT
   // --- 10. 最终Gamma校正 ---
   
   color = pow(color, vec3(1.0/2.2));
+#endif
   
   // 确保在有效范围内
   fragOutput0.rgb = clamp(color, 0.0, 1.0);
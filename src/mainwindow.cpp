@@ -13,6 +13,8 @@
 #include <QVTKOpenGLWidget.h>
 #include <QKeyEvent>
 #include <QDebug>
+#include <QInputDialog>
+#include <QRegExp>
 
 // 包含静态库头文件
 #include "BronchoscopyAPI.h"
@@ -26,8 +28,14 @@
 #include <vtkOBJReader.h>
 #include <vtkSmartPointer.h>
 #include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkImageData.h>
+#include <vtkImageAlgorithm.h>
+#include <vtkMetaImageReader.h>
+#include <vtkNIFTIImageReader.h>
 
 #include <fstream>
+#include <iterator>
 #include <sstream>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -36,6 +44,8 @@ MainWindow::MainWindow(QWidget *parent)
     , endoscopeWidget(nullptr)
     , autoPlayTimer(nullptr)
     , animationTimer(nullptr)
+    , asyncLoadTimer(nullptr)
+    , shaderReloadTimer(nullptr)
     , isPlaying(false)
     , isAnimating(false)
     , bronchoscopyAPI(std::make_unique<BronchoscopyLib::BronchoscopyAPI>())
@@ -62,6 +72,26 @@ MainWindow::MainWindow(QWidget *parent)
     animationTimer = new QTimer(this);
     animationTimer->setInterval(16);  // 约60FPS
     connect(animationTimer, &QTimer::timeout, this, &MainWindow::updateAnimation);
+    
+    // 异步模型加载轮询定时器（进度回调和模型替换在UI线程执行）
+    asyncLoadTimer = new QTimer(this);
+    asyncLoadTimer->setInterval(50);
+    connect(asyncLoadTimer, &QTimer::timeout, this, [this]() {
+        bronchoscopyAPI->ProcessAsyncLoad();
+    });
+    
+    // 开发用：设置BRONCHOSCOPY_SHADER_DIR时监视该目录，修改shader后无需重启
+    if (qEnvironmentVariableIsSet("BRONCHOSCOPY_SHADER_DIR")) {
+        QString shaderDir = qEnvironmentVariable("BRONCHOSCOPY_SHADER_DIR");
+        if (bronchoscopyAPI->EnableShaderHotReload(shaderDir.toStdString())) {
+            shaderReloadTimer = new QTimer(this);
+            shaderReloadTimer->setInterval(200);
+            connect(shaderReloadTimer, &QTimer::timeout, this, [this]() {
+                bronchoscopyAPI->ProcessShaderHotReload();
+            });
+            shaderReloadTimer->start();
+        }
+    }
 }
 
 MainWindow::~MainWindow()
@@ -76,11 +106,23 @@ void MainWindow::createActions()
     loadModelAct->setStatusTip("加载气管模型文件 (.vtk, .vtp, .stl)");
     connect(loadModelAct, &QAction::triggered, this, &MainWindow::loadAirwayModel);
     
+    loadVolumeAct = new QAction("加载分割体数据(&V)...", this);
+    loadVolumeAct->setStatusTip("由气道分割体数据提取表面作为模型 (.mha, .mhd, .nii)");
+    connect(loadVolumeAct, &QAction::triggered, this, &MainWindow::loadAirwayVolume);
+    
     loadPathAct = new QAction("加载相机路径(&P)...", this);
     loadPathAct->setShortcut(QKeySequence("Ctrl+P"));
     loadPathAct->setStatusTip("加载相机路径文件 (.txt, .csv)");
     connect(loadPathAct, &QAction::triggered, this, &MainWindow::loadCameraPath);
     
+    centerlinePathAct = new QAction("使用中心线路径(&C)", this);
+    centerlinePathAct->setStatusTip("以模型自动提取的中心线（气管开口到最远末端）作为相机路径");
+    connect(centerlinePathAct, &QAction::triggered, this, &MainWindow::loadCenterlinePath);
+    
+    planRouteAct = new QAction("规划到目标的路线(&T)...", this);
+    planRouteAct->setStatusTip("输入目标点坐标（如结节位置），沿中心线规划从气管出发的最短路线");
+    connect(planRouteAct, &QAction::triggered, this, &MainWindow::planRouteToTarget);
+    
     exitAct = new QAction("退出(&Q)", this);
     exitAct->setShortcuts(QKeySequence::Quit);
     exitAct->setStatusTip("退出应用程序");
@@ -99,6 +141,12 @@ void MainWindow::createActions()
     previousAct->setEnabled(false);
     connect(previousAct, &QAction::triggered, this, &MainWindow::navigatePrevious);
     
+    nextBifurcationAct = new QAction("下一分叉(&F)", this);
+    nextBifurcationAct->setShortcut(QKeySequence("PgDown"));
+    nextBifurcationAct->setStatusTip("跳到路径上的下一个分叉（需要模型的中心线）");
+    nextBifurcationAct->setEnabled(false);
+    connect(nextBifurcationAct, &QAction::triggered, this, &MainWindow::navigateNextBifurcation);
+    
     resetAct = new QAction("重置(&R)", this);
     resetAct->setShortcut(QKeySequence("Home"));
     resetAct->setStatusTip("回到路径起点");
@@ -131,7 +179,10 @@ void MainWindow::createMenus()
     // 文件菜单
     fileMenu = menuBar()->addMenu("文件(&F)");
     fileMenu->addAction(loadModelAct);
+    fileMenu->addAction(loadVolumeAct);
     fileMenu->addAction(loadPathAct);
+    fileMenu->addAction(centerlinePathAct);
+    fileMenu->addAction(planRouteAct);
     fileMenu->addSeparator();
     fileMenu->addAction(exitAct);
     
@@ -139,6 +190,7 @@ void MainWindow::createMenus()
     navigationMenu = menuBar()->addMenu("导航(&N)");
     navigationMenu->addAction(previousAct);
     navigationMenu->addAction(nextAct);
+    navigationMenu->addAction(nextBifurcationAct);
     navigationMenu->addAction(resetAct);
     navigationMenu->addSeparator();
     navigationMenu->addAction(playAct);
@@ -236,6 +288,9 @@ void MainWindow::setupDualViewWidget()
     bronchoscopyAPI->SetOverviewRenderWindow(overviewWidget->GetRenderWindow());
     bronchoscopyAPI->SetEndoscopeRenderWindow(endoscopeWidget->GetRenderWindow());
     
+    // 中心线路径、路线规划和分叉导航菜单需要中心线（库默认不提取）
+    bronchoscopyAPI->SetCenterlineExtraction(true);
+    
     // 调试：确保渲染窗口和交互器正确连接
     qDebug() << "Overview RenderWindow:" << overviewWidget->GetRenderWindow();
     qDebug() << "Overview Interactor:" << overviewWidget->GetInteractor();
@@ -263,32 +318,124 @@ void MainWindow::loadAirwayModel()
     
     if (fileName.isEmpty()) return;
     
-    // 主程序负责文件读取
-    vtkSmartPointer<vtkPolyData> polyData;
-    std::string fileStr = fileName.toStdString();
+    if (!fileName.endsWith(".vtk", Qt::CaseInsensitive) &&
+        !fileName.endsWith(".vtp", Qt::CaseInsensitive) &&
+        !fileName.endsWith(".obj", Qt::CaseInsensitive)) {
+        QMessageBox::warning(this, "加载失败", "不支持的文件格式");
+        return;
+    }
     
-    if (fileName.endsWith(".vtk", Qt::CaseInsensitive)) {
-        vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
-        reader->SetFileName(fileStr.c_str());
-        reader->Update();
-        polyData = reader->GetOutput();
-    } else if (fileName.endsWith(".vtp", Qt::CaseInsensitive)) {
-        vtkSmartPointer<vtkXMLPolyDataReader> reader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
-        reader->SetFileName(fileStr.c_str());
-        reader->Update();
-        polyData = reader->GetOutput();
-    } else if (fileName.endsWith(".obj", Qt::CaseInsensitive)) {
-        vtkSmartPointer<vtkOBJReader> reader = vtkSmartPointer<vtkOBJReader>::New();
-        reader->SetFileName(fileStr.c_str());
-        reader->Update();
-        polyData = reader->GetOutput();
+    // 主程序负责文件读取（在静态库的工作线程上执行）
+    std::string fileStr = fileName.toStdString();
+    auto reader = [fileStr](vtkPolyData* output) -> bool {
+        vtkSmartPointer<vtkPolyDataAlgorithm> fileReader;
+        QString name = QString::fromStdString(fileStr);
+        
+        if (name.endsWith(".vtk", Qt::CaseInsensitive)) {
+            vtkSmartPointer<vtkPolyDataReader> vtkReader = vtkSmartPointer<vtkPolyDataReader>::New();
+            vtkReader->SetFileName(fileStr.c_str());
+            fileReader = vtkReader;
+        } else if (name.endsWith(".vtp", Qt::CaseInsensitive)) {
+            vtkSmartPointer<vtkXMLPolyDataReader> xmlReader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+            xmlReader->SetFileName(fileStr.c_str());
+            fileReader = xmlReader;
+        } else {
+            vtkSmartPointer<vtkOBJReader> objReader = vtkSmartPointer<vtkOBJReader>::New();
+            objReader->SetFileName(fileStr.c_str());
+            fileReader = objReader;
+        }
+        
+        fileReader->Update();
+        
+        // 读取结果交由静态库接管（共享缓冲区，不拷贝）
+        output->ShallowCopy(fileReader->GetOutput());
+        return output->GetNumberOfPoints() > 0;
+    };
+    
+    // 进度和完成回调都在UI线程的ProcessAsyncLoad中触发
+    auto progress = [this](double value, const std::string& stage) {
+        statusLabel->setText(QString("正在加载模型: %1% (%2)")
+                             .arg(static_cast<int>(value * 100))
+                             .arg(QString::fromStdString(stage)));
+    };
+    
+    auto finished = [this, fileName](bool success) {
+        onAsyncLoadFinished(fileName, success);
+    };
+    
+    setModelCache(fileStr);
+
+    // 加载期间当前模型保持可交互
+    if (bronchoscopyAPI->LoadAirwayModelAsync(reader, progress, finished)) {
+        asyncLoadTimer->start();
     } else {
+        QMessageBox::warning(this, "加载失败", "无法加载模型文件");
+        statusBar()->showMessage("模型加载失败", 3000);
+    }
+}
+
+void MainWindow::loadAirwayVolume()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+        "选择气道分割体数据",
+        "",
+        "体数据文件 (*.mha *.mhd *.nii *.nii.gz);;MetaImage文件 (*.mha *.mhd);;NIfTI文件 (*.nii *.nii.gz);;所有文件 (*)");
+    
+    if (fileName.isEmpty()) return;
+    
+    bool isMeta = fileName.endsWith(".mha", Qt::CaseInsensitive) || fileName.endsWith(".mhd", Qt::CaseInsensitive);
+    bool isNifti = fileName.endsWith(".nii", Qt::CaseInsensitive) || fileName.endsWith(".nii.gz", Qt::CaseInsensitive);
+    if (!isMeta && !isNifti) {
         QMessageBox::warning(this, "加载失败", "不支持的文件格式");
         return;
     }
     
-    // 传递数据给静态库
-    if (polyData && bronchoscopyAPI->LoadAirwayModel(polyData)) {
+    // 主程序负责文件读取，表面提取和预处理在静态库的工作线程上执行
+    std::string fileStr = fileName.toStdString();
+    auto reader = [fileStr, isMeta](vtkImageData* output) -> bool {
+        vtkSmartPointer<vtkImageAlgorithm> fileReader;
+        if (isMeta) {
+            vtkSmartPointer<vtkMetaImageReader> metaReader = vtkSmartPointer<vtkMetaImageReader>::New();
+            metaReader->SetFileName(fileStr.c_str());
+            fileReader = metaReader;
+        } else {
+            vtkSmartPointer<vtkNIFTIImageReader> niftiReader = vtkSmartPointer<vtkNIFTIImageReader>::New();
+            niftiReader->SetFileName(fileStr.c_str());
+            fileReader = niftiReader;
+        }
+        
+        fileReader->Update();
+        output->ShallowCopy(fileReader->GetOutput());
+        return output->GetNumberOfPoints() > 0;
+    };
+    
+    auto progress = [this](double value, const std::string& stage) {
+        statusLabel->setText(QString("正在提取气道表面: %1% (%2)")
+                             .arg(static_cast<int>(value * 100))
+                             .arg(QString::fromStdString(stage)));
+    };
+    
+    auto finished = [this, fileName](bool success) {
+        onAsyncLoadFinished(fileName, success);
+    };
+    
+    // 标签0：所有非零体素作为气道
+    bronchoscopyAPI->SetVolumeSurfaceSettings(0);
+    setModelCache(fileStr);
+    
+    if (bronchoscopyAPI->LoadAirwayVolumeAsync(reader, progress, finished)) {
+        asyncLoadTimer->start();
+    } else {
+        QMessageBox::warning(this, "加载失败", "无法加载体数据文件");
+        statusBar()->showMessage("体数据加载失败", 3000);
+    }
+}
+
+void MainWindow::onAsyncLoadFinished(const QString& fileName, bool success)
+{
+    asyncLoadTimer->stop();
+    
+    if (success) {
         statusBar()->showMessage(QString("成功加载模型: %1").arg(fileName), 3000);
         statusLabel->setText("模型已加载");
         
@@ -298,11 +445,31 @@ void MainWindow::loadAirwayModel()
         
         qDebug() << "Forced render after loading model";
     } else {
-        QMessageBox::warning(this, "加载失败", "无法加载模型文件");
-        statusBar()->showMessage("模型加载失败", 3000);
+        statusLabel->setText(bronchoscopyAPI->HasModel() ? "模型已加载" : "就绪");
+        statusBar()->showMessage("模型加载失败或已取消", 3000);
     }
 }
 
+void MainWindow::setModelCache(const std::string& fileStr)
+{
+    // 距离场、中心线等派生数据缓存在模型文件旁（<模型文件>.sdf等），内容与网格或参数不符时静态库会重新构建
+    // 回调在静态库的加载线程上调用（库保证不并发），只按值捕获文件名，不访问界面对象；
+    // 须在开始加载前设置，已加载的模型继续使用它加载时的回调
+    auto loadCache = [fileStr](const std::string& name, std::vector<unsigned char>& data) -> bool {
+        std::ifstream file(fileStr + "." + name, std::ios::binary);
+        if (!file) return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !data.empty();
+    };
+    auto storeCache = [fileStr](const std::string& name, const std::vector<unsigned char>& data) {
+        std::ofstream file(fileStr + "." + name, std::ios::binary | std::ios::trunc);
+        if (file) {
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+    };
+    bronchoscopyAPI->SetModelCache(loadCache, storeCache);
+}
+
 void MainWindow::loadCameraPath()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
@@ -354,10 +521,11 @@ void MainWindow::loadCameraPath()
     if (!positions.empty() && bronchoscopyAPI->LoadCameraPath(positions)) {
         int total = bronchoscopyAPI->GetTotalPathNodes();
         statusBar()->showMessage(QString("成功加载路径: %1 (%2个节点)").arg(fileName).arg(total), 3000);
-        statusLabel->setText(QString("路径: 1/%1").arg(total));
+        statusLabel->setText(pathStatusText(1, total));
         
         // 启用导航控制
         nextAct->setEnabled(true);
+        nextBifurcationAct->setEnabled(true);
         previousAct->setEnabled(true);
         resetAct->setEnabled(true);
         playAct->setEnabled(true);
@@ -371,6 +539,94 @@ void MainWindow::loadCameraPath()
     }
 }
 
+void MainWindow::loadCenterlinePath()
+{
+    if (!bronchoscopyAPI->LoadCenterlinePath()) {
+        QMessageBox::warning(this, "加载失败", "当前模型没有可用的中心线，请先加载模型");
+        return;
+    }
+    
+    int total = bronchoscopyAPI->GetTotalPathNodes();
+    statusBar()->showMessage(QString("已使用中心线路径 (%1个节点)").arg(total), 3000);
+    statusLabel->setText(pathStatusText(1, total));
+    
+    // 启用导航控制
+    nextAct->setEnabled(true);
+    nextBifurcationAct->setEnabled(true);
+    previousAct->setEnabled(true);
+    resetAct->setEnabled(true);
+    playAct->setEnabled(true);
+    
+    endoscopeWidget->GetRenderWindow()->Render();
+}
+
+void MainWindow::planRouteToTarget()
+{
+    bool ok = false;
+    QString text = QInputDialog::getText(this, "规划路线", "目标点坐标 (x, y, z):",
+                                         QLineEdit::Normal, QString(), &ok);
+    if (!ok) {
+        return;
+    }
+    
+    QStringList parts = text.split(QRegExp("[,\\s]+"), QString::SkipEmptyParts);
+    double target[3];
+    bool valid = parts.size() == 3;
+    for (int i = 0; valid && i < 3; i++) {
+        target[i] = parts[i].toDouble(&valid);
+    }
+    if (!valid) {
+        QMessageBox::warning(this, "规划失败", "请输入三个数值，如 12.5, -30, 80");
+        return;
+    }
+    
+    std::vector<double> positions;
+    double targetDistance = 0.0;
+    if (!bronchoscopyAPI->GetRouteToTarget(target, positions, targetDistance) ||
+        !bronchoscopyAPI->LoadCameraPath(positions)) {
+        QMessageBox::warning(this, "规划失败", "没有到达该目标的路线，请先加载模型");
+        return;
+    }
+    
+    int total = bronchoscopyAPI->GetTotalPathNodes();
+    statusBar()->showMessage(QString("已规划路线 (%1个节点，终点距目标 %2 mm)")
+                                 .arg(total).arg(targetDistance, 0, 'f', 1), 5000);
+    statusLabel->setText(pathStatusText(1, total));
+    
+    // 启用导航控制
+    nextAct->setEnabled(true);
+    nextBifurcationAct->setEnabled(true);
+    previousAct->setEnabled(true);
+    resetAct->setEnabled(true);
+    playAct->setEnabled(true);
+    
+    endoscopeWidget->GetRenderWindow()->Render();
+}
+
+QString MainWindow::pathStatusText(int current, int total) const
+{
+    QString text = QString("路径: %1/%2").arg(current).arg(total);
+    
+    // 动画过渡中当前节点已是目标节点，显示的是目标处的管径
+    double minRadius = 0.0, maxRadius = 0.0, meanRadius = 0.0;
+    if (bronchoscopyAPI->GetLumenRadius(current - 1, minRadius, maxRadius, meanRadius)) {
+        text += QString("  管径: %1 mm (%2-%3)")
+                    .arg(2.0 * meanRadius, 0, 'f', 1)
+                    .arg(2.0 * minRadius, 0, 'f', 1)
+                    .arg(2.0 * maxRadius, 0, 'f', 1);
+    }
+    
+    int branch = -1, generation = 0;
+    double distanceToBifurcation = -1.0;
+    if (bronchoscopyAPI->GetNodeBranch(current - 1, branch, generation, distanceToBifurcation)) {
+        text += QString("  第%1级支气管").arg(generation);
+        if (distanceToBifurcation >= 0.0) {
+            text += QString("  距分叉: %1 mm").arg(distanceToBifurcation, 0, 'f', 1);
+        }
+    }
+    return text;
+}
+
 void MainWindow::navigateNext()
 {
     // 如果正在动画中，跳过
@@ -381,7 +637,7 @@ void MainWindow::navigateNext()
     bronchoscopyAPI->MoveToNext();
     int current = bronchoscopyAPI->GetCurrentNodeIndex() + 1;
     int total = bronchoscopyAPI->GetTotalPathNodes();
-    statusLabel->setText(QString("路径: %1/%2").arg(current).arg(total));
+    statusLabel->setText(pathStatusText(current, total));
     
     // 调试输出
     qDebug() << "Current index:" << (current-1) << "Total nodes:" << total;
@@ -396,6 +652,26 @@ void MainWindow::navigateNext()
     }
 }
 
+void MainWindow::navigateNextBifurcation()
+{
+    // 如果正在动画中，跳过
+    if (isAnimating) {
+        return;
+    }
+    
+    if (!bronchoscopyAPI->MoveToNextBifurcation()) {
+        statusBar()->showMessage("前方没有分叉", 2000);
+        return;
+    }
+    int current = bronchoscopyAPI->GetCurrentNodeIndex() + 1;
+    int total = bronchoscopyAPI->GetTotalPathNodes();
+    statusLabel->setText(pathStatusText(current, total));
+    
+    // 启动动画定时器
+    isAnimating = true;
+    animationTimer->start();
+}
+
 void MainWindow::navigatePrevious()
 {
     // 如果正在动画中，跳过
@@ -406,7 +682,7 @@ void MainWindow::navigatePrevious()
     bronchoscopyAPI->MoveToPrevious();
     int current = bronchoscopyAPI->GetCurrentNodeIndex() + 1;
     int total = bronchoscopyAPI->GetTotalPathNodes();
-    statusLabel->setText(QString("路径: %1/%2").arg(current).arg(total));
+    statusLabel->setText(pathStatusText(current, total));
     
     // 启动动画定时器
     isAnimating = true;
@@ -417,7 +693,7 @@ void MainWindow::resetNavigation()
 {
     bronchoscopyAPI->MoveToFirst();
     int total = bronchoscopyAPI->GetTotalPathNodes();
-    statusLabel->setText(QString("路径: 1/%1").arg(total));
+    statusLabel->setText(pathStatusText(1, total));
     
     // 停止自动播放
     if (isPlaying) {
@@ -451,6 +727,9 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
         case Qt::Key_Down:
             if (previousAct->isEnabled()) navigatePrevious();
             break;
+        case Qt::Key_PageDown:
+            if (nextBifurcationAct->isEnabled()) navigateNextBifurcation();
+            break;
         case Qt::Key_Home:
             if (resetAct->isEnabled()) resetNavigation();
             break;
@@ -475,6 +754,12 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
                 }
             }
             break;
+        case Qt::Key_Escape:
+            // 取消正在进行的模型加载
+            if (bronchoscopyAPI->IsAsyncLoadPending()) {
+                bronchoscopyAPI->CancelAsyncLoad();
+            }
+            break;
         default:
             QMainWindow::keyPressEvent(event);
     }
@@ -11,6 +11,7 @@ namespace BronchoscopyLib {
     
     // 前向声明
     struct PathNode;
+    class DistanceField;
     
     /**
      * CameraController - 管理双相机系统
@@ -42,6 +43,7 @@ namespace BronchoscopyLib {
         
         // 相机参数设置
         void SetEndoscopeFOV(double angle);
+        double GetEndoscopeFOV() const;
         void SetEndoscopeViewUp(double x, double y, double z);
         
         // 获取相机状态（用于调试）
@@ -53,6 +55,15 @@ namespace BronchoscopyLib {
         void SetTransitionDuration(double seconds);
         bool IsTransitioning() const;
         
+        // 管腔约束：过渡中插值出的相机位置离壁距离小于clearance时，沿距离场梯度推回管腔内
+        // （节点之间线性插值在急弯处会穿出管壁）；默认关闭，没有距离场时不起作用
+        // 距离场查询为常数时间，每帧只做几次采样；间隙为世界坐标
+        static constexpr double DefaultLumenClearance = 0.5;
+        void SetLumenField(std::shared_ptr<const DistanceField> field);
+        void SetLumenConstraint(bool enable, double clearance = DefaultLumenClearance);
+        bool GetLumenConstraint() const;
+        double GetLumenClearance() const;
+        
         // 获取当前相机状态
         void GetCurrentEndoscopeState(PathNode* state) const;
         
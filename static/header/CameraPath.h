@@ -10,6 +10,10 @@ class vtkCellArray;
 
 namespace BronchoscopyLib {
 
+    class MeshBVH;
+    class ThreadPool;
+    class Centerline;
+
     // 路径节点结构
     struct PathNode {
         double position[3];     // 位置坐标
@@ -25,8 +29,30 @@ namespace BronchoscopyLib {
         }
     };
 
+    // 节点处的管腔半径：垂直于路径方向的一圈射线到管壁的距离（未命中的射线不计入）
+    struct LumenRadius {
+        float minimum;
+        float maximum;
+        float mean;
+        
+        LumenRadius() : minimum(0.0f), maximum(0.0f), mean(0.0f) {}
+    };
+
+    // 节点所在的气道分支（由中心线树得到）
+    struct NodeTopology {
+        int branch;                   // 中心线分支，-1为未知
+        int generation;               // 分叉级数，主气管为0
+        int nextBifurcation;          // 沿路径下一个进入新分支的节点（经过隆突），没有时为-1
+        float distanceToBifurcation;  // 沿路径到该节点的长度
+        
+        NodeTopology() : branch(-1), generation(-1), nextBifurcation(-1), distanceToBifurcation(0.0f) {}
+    };
+
     class CameraPath {
     public:
+        // 计算管腔半径剖面时每个节点的射线数
+        static const int DefaultProfileRays = 32;
+        
         CameraPath();
         ~CameraPath();
         
@@ -60,11 +86,37 @@ namespace BronchoscopyLib {
         void GetInterpolatedPosition(double t, double pos[3]) const;
         void GetInterpolatedDirection(double t, double dir[3]) const;
         
+        // 管腔半径剖面：对网格的BVH批量求交，各节点并行；结果按节点顺序保存，导航时直接查表
+        // 修改路径（AddPoint/Clear）后剖面失效，需要重新计算
+        bool ComputeLumenProfile(const MeshBVH& bvh, int rayCount = DefaultProfileRays,
+                                 ThreadPool* pool = nullptr);
+        void ClearLumenProfile();
+        bool HasLumenProfile() const { return !lumenProfile.empty(); }
+        const std::vector<LumenRadius>& GetLumenProfile() const { return lumenProfile; }
+        
+        // 无剖面、index越界或该节点的射线全部未命中时返回false
+        bool GetLumenRadius(int index, LumenRadius& radius) const;
+        
+        // 分支标注：每个节点取最近的中心线点所在的分支（各节点并行），分叉附近落到兄弟分支等
+        // 短暂跳变按树的相邻关系并入后一段；路径进入新分支的节点视为分叉处
+        // 与剖面一样按节点保存，修改路径后失效
+        bool ComputeTopology(const Centerline& centerline, ThreadPool* pool = nullptr);
+        void ClearTopology();
+        bool HasTopology() const { return !topology.empty(); }
+        const std::vector<NodeTopology>& GetTopology() const { return topology; }
+        
+        // 无标注或index越界时返回false
+        bool GetNodeTopology(int index, NodeTopology& node) const;
+        
     private:
         PathNode* head;
         PathNode* tail;
         PathNode* current;
         int nodeCount;
+        int currentIndex;
+        std::vector<PathNode*> nodeTable;       // 按序号索引节点，JumpTo为常数时间
+        std::vector<LumenRadius> lumenProfile;  // 为空或与节点一一对应
+        std::vector<NodeTopology> topology;     // 为空或与节点一一对应
         
         // 辅助函数
         void NormalizeVector(double vec[3]);
@@ -0,0 +1,101 @@
+#ifndef CENTERLINE_H
+#define CENTERLINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace BronchoscopyLib {
+
+    class DistanceField;
+    class ThreadPool;
+
+    /**
+     * Centerline - 气道中心线树
+     * 在距离场的体素网格上骨架化（TEASAR）：管腔体素做欧氏距离变换，按离壁距离加权的最短路径
+     * 从离根最远的体素逐条回溯到已有骨架，并排除路径周围管腔半径范围内的体素，直到覆盖整个管腔；
+     * 过短的末端分支被剪除，根放在平均半径最大的末端（气管开口）
+     * 体素采样和距离变换在线程池上并行；结果按固定间距重采样并平滑，构建后只读
+     */
+    class Centerline {
+    public:
+        // 提取参数（长度均为世界坐标）
+        struct Settings {
+            double voxelSize;             // 不大于0时使用距离场的体素尺寸
+            double invalidationScale;     // 路径周围排除半径 = scale * 离壁距离 + constant
+            double invalidationConstant;  // 不大于0时为2个体素
+            double minBranchRatio;        // 末端分支长度小于分叉处半径的此倍数时剪除
+            double sampleSpacing;         // 输出点间距，不大于0时为体素尺寸
+
+            Settings() : voxelSize(0.0), invalidationScale(1.5), invalidationConstant(0.0),
+                         minBranchRatio(2.0), sampleSpacing(0.0) {}
+
+            bool operator==(const Settings& other) const {
+                return voxelSize == other.voxelSize && invalidationScale == other.invalidationScale &&
+                       invalidationConstant == other.invalidationConstant &&
+                       minBranchRatio == other.minBranchRatio && sampleSpacing == other.sampleSpacing;
+            }
+            bool operator!=(const Settings& other) const { return !(*this == other); }
+        };
+
+        // 分支：两个分叉点（或末端）之间的中心线段
+        struct Branch {
+            int parent;                  // 父分支，根分支为-1
+            std::vector<int> children;
+            int generation;              // 分叉级数，根分支为0
+            std::vector<double> points;  // 连续存放的xyz，首点与父分支的末点重合
+            std::vector<double> radii;   // 各点处的管腔半径（到壁的距离）
+            double length;
+
+            Branch() : parent(-1), generation(0), length(0.0) {}
+
+            size_t GetPointCount() const { return radii.size(); }
+        };
+
+        Centerline();
+        ~Centerline();
+
+        Centerline(const Centerline&) = delete;
+        Centerline& operator=(const Centerline&) = delete;
+
+        // 从距离场提取；管腔体素过少时返回false。pool为空时串行执行
+        // cancelFlag在各分块和最短路径/TEASAR循环中定期检查，被置位时返回false且结果为空
+        bool Extract(const DistanceField& field, const Settings& settings = Settings(),
+                     ThreadPool* pool = nullptr, const std::atomic<bool>* cancelFlag = nullptr);
+
+        void Clear();
+        bool IsEmpty() const;
+
+        int GetBranchCount() const;
+        const Branch& GetBranch(int index) const;  // index须在[0, GetBranchCount())内
+        const std::vector<Branch>& GetBranches() const;
+
+        // 从根到指定分支末端的点序列（xyz连续存放，分叉点不重复），可直接作为相机路径
+        bool GetPathToBranch(int index, std::vector<double>& positions) const;
+
+        // 从根出发路径最长的末端分支；为空时返回-1
+        int GetFarthestLeafBranch() const;
+
+        double GetTotalLength() const;
+        double GetExtractMs() const;
+
+        // 提取时使用的参数和距离场（几何哈希、体素尺寸），用于判断缓存是否有效
+        const Settings& GetSettings() const;
+        unsigned long long GetGeometryHash() const;
+        double GetFieldVoxelSize() const;
+
+        // 序列化为字节序列（库不读写文件，由调用方保存）；按本机字节序
+        void Serialize(std::vector<unsigned char>& data) const;
+
+        // 从Serialize的结果恢复；格式或大小不符时返回false，当前内容不变
+        bool Deserialize(const unsigned char* data, size_t size);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // CENTERLINE_H
@@ -0,0 +1,77 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace BronchoscopyLib {
+
+    class MeshBVH;
+    class ThreadPool;
+
+    /**
+     * DistanceField - 气道管腔的窄带有符号距离场
+     * 网格表面附近（窄带内）按体素保存到最近表面的距离，管腔内为正、壁外为负；
+     * 窄带外只记录符号，查询结果截断为±窄带宽度
+     * 体素按8x8x8的块稀疏存储，只分配与窄带相交的块；每块多存一层相邻体素，
+     * 三线性插值只访问一个块，查询为常数时间且不访问三角形
+     * 构建后只读，可被多个线程同时查询
+     */
+    class DistanceField {
+    public:
+        DistanceField();
+        ~DistanceField();
+
+        DistanceField(const DistanceField&) = delete;
+        DistanceField& operator=(const DistanceField&) = delete;
+
+        // 自动选择时的默认值：最长边的体素数、窄带宽度（体素）
+        static const int DefaultResolution = 256;
+        static const int DefaultBandVoxels = 8;
+
+        // 用BVH的最近点查询构建，符号取最近三角形的朝向，最近点在边上或窄带外时取环绕数；pool为空时串行构建
+        // voxelSize不大于0时按包围盒最长边DefaultResolution个体素，bandWidth不大于0时为DefaultBandVoxels个体素
+        // cancelFlag被置位时在下一个分块处中止，返回false且结果为空
+        bool Build(const MeshBVH& bvh, double voxelSize = 0.0, double bandWidth = 0.0,
+                   ThreadPool* pool = nullptr, const std::atomic<bool>* cancelFlag = nullptr);
+
+        void Clear();
+        bool IsEmpty() const;
+
+        // 三线性插值的有符号距离；网格范围外视为壁外，返回-bandWidth
+        double Sample(const double point[3]) const;
+
+        // 同时返回距离的梯度（指向管腔内部方向，窄带内近似单位长度）
+        double SampleGradient(const double point[3], double gradient[3]) const;
+
+        double GetVoxelSize() const;
+        double GetBandWidth() const;
+        void GetBounds(double bounds[6]) const;
+
+        // 构建时请求的参数（自动选择时为0），用于判断缓存是否与当前设置一致
+        void GetRequestedSettings(double& voxelSize, double& bandWidth) const;
+
+        // 构建所用网格的几何哈希（MeshBVH::BuildStats::geometryHash）
+        unsigned long long GetGeometryHash() const;
+
+        size_t GetAllocatedBricks() const;
+        size_t GetTotalBricks() const;
+        size_t GetMemoryBytes() const;
+        double GetBuildMs() const;
+
+        // 序列化为字节序列（库不读写文件，由调用方保存）；按本机字节序
+        void Serialize(std::vector<unsigned char>& data) const;
+
+        // 从Serialize的结果恢复；格式或大小不符时返回false，当前内容不变
+        bool Deserialize(const unsigned char* data, size_t size);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // DISTANCE_FIELD_H
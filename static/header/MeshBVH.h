@@ -0,0 +1,108 @@
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// 前向声明VTK类
+class vtkPolyData;
+
+namespace BronchoscopyLib {
+
+    class ThreadPool;
+
+    /**
+     * MeshBVH - 三角网格的包围体层次，用于射线求交和最近点查询
+     * 按表面积启发式（分箱SAH）自顶向下构建，较大的子树在线程池上并行构建；
+     * 节点按深度优先顺序展平为32字节的数组（左孩子紧随父节点），三角形按叶子顺序重排并预存边向量，
+     * 遍历时的内存访问基本连续
+     * 内部使用单精度坐标；构建后只读，可被多个线程同时查询
+     */
+    class MeshBVH {
+    public:
+        // 射线：方向不要求单位长度，距离按世界坐标计算
+        struct Ray {
+            double origin[3];
+            double direction[3];
+            double maxDistance;  // 不大于0时不限制
+
+            Ray() : maxDistance(0.0) {
+                origin[0] = origin[1] = origin[2] = 0.0;
+                direction[0] = 0.0; direction[1] = 0.0; direction[2] = 1.0;
+            }
+        };
+
+        // 求交或最近点结果
+        struct Hit {
+            bool hit;
+            double distance;    // 沿射线的距离，最近点查询时为到表面的距离
+            double point[3];
+            double normal[3];   // 三角形的单位几何法线（按顶点环绕方向）
+            long long cellId;   // 网格中的单元编号（多边形按扇形三角化，子三角形共用单元编号）
+            double u, v;        // 子三角形内的重心坐标：point = (1-u-v)*p0 + u*p1 + v*p2
+
+            Hit() : hit(false), distance(-1.0), cellId(-1), u(0.0), v(0.0) {
+                point[0] = point[1] = point[2] = 0.0;
+                normal[0] = normal[1] = normal[2] = 0.0;
+            }
+        };
+
+        // 构建结果统计
+        struct BuildStats {
+            size_t triangles;
+            size_t nodes;
+            size_t leaves;
+            int maxDepth;
+            double sahCost;      // 按根节点表面积归一化的SAH代价（遍历代价1，求交代价1）
+            double buildMs;
+            size_t memoryBytes;  // 节点和三角形数据
+            unsigned long long geometryHash;  // 三角形坐标的哈希（按网格原顺序），用于校验派生数据的缓存
+            double signedVolume;  // 按法线方向计算的有符号体积，正值表示法线朝外（开口网格为近似值）
+
+            BuildStats() : triangles(0), nodes(0), leaves(0), maxDepth(0), sahCost(0.0),
+                           buildMs(0.0), memoryBytes(0), geometryHash(0), signedVolume(0.0) {}
+        };
+
+        MeshBVH();
+        ~MeshBVH();
+
+        MeshBVH(const MeshBVH&) = delete;
+        MeshBVH& operator=(const MeshBVH&) = delete;
+
+        // 从网格的多边形构建（三角形条带、线和顶点忽略）；pool为空时串行构建
+        // 没有可用的三角形时返回false；cancelFlag被置位时在下一个分块或子树处中止，返回false且结果为空
+        bool Build(vtkPolyData* mesh, ThreadPool* pool = nullptr, const std::atomic<bool>* cancelFlag = nullptr);
+
+        void Clear();
+        bool IsEmpty() const;
+
+        const BuildStats& GetBuildStats() const;
+        void GetBounds(double bounds[6]) const;
+
+        // 最近交点（双面求交）
+        bool Intersect(const Ray& ray, Hit& hit) const;
+
+        // 是否有任意交点（遮挡测试，找到第一个即返回）
+        bool IsOccluded(const Ray& ray) const;
+
+        // 批量求交：按块分配到线程池并行，hits与rays一一对应；pool为空时在调用线程执行
+        void IntersectBatch(const std::vector<Ray>& rays, std::vector<Hit>& hits,
+                            ThreadPool* pool = nullptr) const;
+
+        // 表面上离point最近的点，只搜索maxDistance以内（不大于0时不限制）
+        bool FindClosestPoint(const double point[3], double maxDistance, Hit& hit) const;
+
+        // 广义环绕数（层次偶极子近似）：法线朝外的封闭网格内为1、外为0，开口处平滑过渡，
+        // 用于判定开口网格的内外（以0.5为界，法线朝内时符号相反）
+        double GetWindingNumber(const double point[3]) const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // MESH_BVH_H
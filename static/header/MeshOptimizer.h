@@ -0,0 +1,94 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <atomic>
+#include <vector>
+
+// 前向声明VTK类
+class vtkPolyData;
+
+namespace BronchoscopyLib {
+
+    class ThreadPool;
+
+    /**
+     * MeshOptimizer - 网格预处理工具
+     * 提供与渲染器无关的网格重排算法，供ModelManager的预处理阶段调用
+     */
+    class MeshOptimizer {
+    public:
+        // 顶点缓存优化统计
+        struct VertexCacheStats {
+            double acmrBefore;      // 优化前ACMR（平均每三角形缓存未命中数）
+            double acmrAfter;       // 优化后ACMR
+            int cacheSize;          // 模拟的后变换缓存大小
+            long long triangles;    // 参与优化的三角形数
+
+            VertexCacheStats() : acmrBefore(0.0), acmrAfter(0.0), cacheSize(0), triangles(0) {}
+        };
+
+        // 模拟的GPU后变换缓存大小（FIFO，用于ACMR统计和排序评分）
+        static const int DefaultCacheSize = 32;
+
+        // 计算三角形索引序列在FIFO缓存下的ACMR
+        // indices: 每3个一组的三角形顶点索引
+        static double ComputeACMR(const std::vector<long long>& indices,
+                                  int vertexCount,
+                                  int cacheSize = DefaultCacheSize);
+
+        // 按顶点缓存局部性重排三角形（Forsyth线性时间算法）
+        // triangleOrder: 输出新顺序，triangleOrder[i]为第i个输出三角形的原编号
+        static void OptimizeTriangleOrder(const std::vector<long long>& indices,
+                                          int vertexCount,
+                                          std::vector<long long>& triangleOrder,
+                                          int cacheSize = DefaultCacheSize);
+
+        // 按首次使用顺序重编号顶点
+        // remap: 输出旧索引->新索引映射，未被引用的顶点排在最后
+        // 返回值: 被三角形引用的顶点数
+        static int ComputeFirstUseRemap(const std::vector<long long>& indices,
+                                        int vertexCount,
+                                        std::vector<long long>& remap);
+
+        // 对纯三角形网格执行完整的顶点缓存优化：三角形重排 + 顶点重编号
+        // 点数据和单元数据（法线等）随之重排，结果写入output
+        // 输入含非三角形单元、线或条带时返回false，output不变
+        static bool OptimizeVertexCache(vtkPolyData* input, vtkPolyData* output,
+                                        VertexCacheStats* stats = nullptr);
+        
+        // 紧凑网格中八面体编码法线数组的名称（2分量short，snorm16）
+        static const char* CompactNormalArrayName;
+        
+        // 八面体法线编码/解码（输入输出均为单位向量，编码结果在[-1, 1]范围）
+        static void EncodeOctahedralNormal(const float n[3], float encoded[2]);
+        static void DecodeOctahedralNormal(const float encoded[2], float n[3]);
+        
+        // 构建紧凑渲染网格：float32点坐标 + 八面体编码的snorm16法线
+        // 只保留点、多边形和法线，其余点数据/单元数据被丢弃
+        // 输入没有点法线时返回false
+        static bool BuildCompactMesh(vtkPolyData* input, vtkPolyData* output);
+        
+        // 按特征角计算点法线（等价于vtkPolyDataNormals的SplittingOn，但按顶点并行）
+        // 输入须为朝向一致的纯三角形网格；相邻面夹角大于featureAngle（度）的边视为锐边，
+        // 锐边两侧的顶点被复制，使两侧各自拥有独立法线
+        // 三角形顺序不变，新增的点追加在末尾；pool为空时串行执行
+        // 输入含非三角形单元、线或条带时返回false，output不变；cancelFlag被置位时在下一个分块处中止并返回false
+        static bool ComputeFeatureNormals(vtkPolyData* input, double featureAngle,
+                                          vtkPolyData* output, ThreadPool* pool = nullptr,
+                                          const std::atomic<bool>* cancelFlag = nullptr);
+        
+        // 合并重复顶点（替代vtkCleanPolyData的点合并）：坐标按容差量化到网格，
+        // 量化坐标相同的点并行插入无锁哈希表，每组保留编号最小的点（坐标和点数据取该点）；
+        // 随后一遍重映射三角形索引，同时丢弃重映射后有重复顶点的退化三角形和未被引用的点
+        // tolerance为包围盒对角线的比例（与vtkCleanPolyData一致），0为只合并坐标完全相同的点
+        // 完全重复的点总被合并；相距小于容差但落在不同网格单元的点不合并
+        // 三角形顺序不变，单元数据随之保留；pool为空时串行执行
+        // 输入含非三角形单元、线或条带时返回false，output不变；取消处理同ComputeFeatureNormals
+        static bool WeldVertices(vtkPolyData* input, double tolerance,
+                                 vtkPolyData* output, ThreadPool* pool = nullptr,
+                                 const std::atomic<bool>* cancelFlag = nullptr);
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // MESH_OPTIMIZER_H
@@ -1,15 +1,31 @@
 #ifndef MODEL_MANAGER_H
 #define MODEL_MANAGER_H
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
+
+#include "Centerline.h"
+#include "SurfaceExtractor.h"
 
 // 前向声明VTK类
 class vtkPolyData;
+class vtkImageData;
 class vtkActor;
 class vtkRenderer;
 
 namespace BronchoscopyLib {
     
+    class DistanceField;
+    class MeshBVH;
+    class ThreadPool;
+    class ShaderSystem;
+    
+    // 预处理结果（定义在ModelManager.cpp中）
+    struct PreparedModel;
+    
     /**
      * ModelManager - 管理3D模型的加载和显示
      * 负责气管模型的数据管理、Actor创建和渲染设置
@@ -19,12 +35,49 @@ namespace BronchoscopyLib {
         ModelManager();
         ~ModelManager();
         
-        // 加载模型数据（深拷贝，确保独立生命周期）
-        bool LoadModel(vtkPolyData* polyData);
+        // 加载模型数据
+        // adopt为false（默认）时深拷贝，确保独立生命周期
+        // adopt为true时接管调用方数据：浅拷贝共享点/单元/属性数组，不复制缓冲区，
+        // 调用方此后不得再修改该polyData（例如读取文件后直接交给库）
+        bool LoadModel(vtkPolyData* polyData, bool adopt = false);
+        
+        // 分步加载：LoadModel = CreatePreparedModel + PrepareModel + InstallPreparedModel
+        // 预处理进度回调，progress为0~1，stage为当前阶段名称
+        typedef std::function<void(double progress, const char* stage)> PreprocessProgress;
+        
+        // 快照当前预处理设置（渲染线程调用），之后的设置变化不影响该结果
+        std::shared_ptr<PreparedModel> CreatePreparedModel() const;
+        
+        // 执行预处理：清理、朝向统一、按特征角生成法线、可选的顶点缓存优化和紧凑化，最后构建BVH
+        // 各阶段输出被缓存在结果中，供之后的设置变化增量更新
+        // 不访问mapper和actor，可在工作线程调用；progress在调用线程上回调
+        // cancelFlag被置位时中止当前滤波器并返回false
+        static bool PrepareModel(PreparedModel& model, vtkPolyData* polyData, bool adopt,
+                                 const PreprocessProgress& progress = nullptr,
+                                 const std::atomic<bool>* cancelFlag = nullptr);
+        
+        // 由分割体数据提取表面（SurfaceExtractor，使用结果的线程池）后执行同样的预处理
+        // 提取占总进度的前一部分，阶段名称为"surface"
+        static bool PrepareModelFromVolume(PreparedModel& model, vtkImageData* volume,
+                                           const SurfaceExtractor::Settings& settings,
+                                           const PreprocessProgress& progress = nullptr,
+                                           const std::atomic<bool>* cancelFlag = nullptr);
+        
+        // 安装预处理结果，替换当前模型（渲染线程调用）
+        bool InstallPreparedModel(const std::shared_ptr<PreparedModel>& model);
         
         // 获取模型数据
         vtkPolyData* GetModelData() const;
         
+        // 预处理后用于渲染的网格（BVH的单元编号对应此网格的多边形）
+        vtkPolyData* GetRenderedData() const;
+        
+        // 内窥镜视图只绘制给定的三角形（渲染网格的单元编号），点和点数据与完整网格共享，只替换索引；
+        // 重新预处理后BVH不变（几何和三角形顺序未变）时沿用，否则恢复为完整网格
+        // 渲染网格含非三角形单元时不起作用；总览视图始终绘制完整网格
+        void SetEndoscopeVisibleCells(const std::vector<long long>& cells);
+        void ClearEndoscopeVisibleCells();
+        
         // 创建并返回用于不同渲染器的Actor
         vtkActor* CreateOverviewActor();
         vtkActor* CreateEndoscopeActor();
@@ -36,6 +89,15 @@ namespace BronchoscopyLib {
         // 添加Actor到渲染器
         void AddToRenderers(vtkRenderer* overviewRenderer, vtkRenderer* endoscopeRenderer);
         
+        // 模型actor使用的ShaderSystem（热重载等开发功能通过它访问）
+        // 由所属实例提供，不转移所有权；未设置时首次使用才创建自己的实例
+        void SetShaderSystem(ShaderSystem* shaderSystem);
+        ShaderSystem& GetShaderSystem() const;
+        
+        // shader变体缓存统计：命中/未命中次数，以及因已是目标变体而跳过修改的mapper次数
+        void GetShaderCacheStats(unsigned long& hits, unsigned long& misses, 
+                                 unsigned long& reusedMappers) const;
+        
         // 从渲染器移除Actor
         void RemoveFromRenderers(vtkRenderer* overviewRenderer, vtkRenderer* endoscopeRenderer);
         
@@ -46,11 +108,68 @@ namespace BronchoscopyLib {
         
         // 设置平滑度（特征角度，0-180度）
         // 180度 = 完全平滑，0度 = 保留所有边缘
+        // 已加载模型时只在缓存的清理/朝向统一结果上并行重新计算法线，不重新加载和清理
         void SetSmoothingAngle(double angle);
         
+        // 顶点缓存优化（可选预处理阶段，默认关闭）
+        // 开启后按GPU后变换缓存局部性重排三角形，并按首次使用顺序重编号顶点
+        void SetVertexCacheOptimization(bool enable);
+        bool GetVertexCacheOptimization() const;
+        
+        // 获取最近一次优化前后的ACMR（平均每三角形缓存未命中数）
+        // 未执行优化时返回false
+        bool GetVertexCacheStats(double& acmrBefore, double& acmrAfter) const;
+        
+        // 紧凑模式（默认关闭）：点坐标一次性转换为float32，法线八面体编码为2个snorm16，
+        // 预处理完成后只保留紧凑数据，双精度源副本和中间结果被释放
+        // 注意：开启后源模型即被紧凑数据替换，关闭紧凑模式不会恢复双精度坐标
+        void SetCompactMode(bool enable);
+        bool GetCompactMode() const;
+        
+        // 预处理各阶段保留的内存
+        struct StageMemory {
+            std::string stage;  // 阶段名称（source/cleaned/oriented/normals/vertex-cache/compact）
+            size_t bytes;       // 该阶段独占的字节数，与前面阶段共享的数组不重复计算
+        };
+        
+        // 获取当前模型各阶段缓存保留的内存（紧凑模式下中间阶段已释放，不再列出）
+        std::vector<StageMemory> GetMemoryUsage() const;
+        
         // 获取模型边界
         void GetModelBounds(double bounds[6]) const;
         
+        // 渲染网格的射线求交/最近点加速结构（预处理时并行构建，单元编号对应渲染网格）
+        // 持有返回的指针即可在任意线程查询，替换模型不影响已取得的实例；无模型时为空
+        std::shared_ptr<const MeshBVH> GetBVH() const;
+        
+        // 预处理使用的线程池（首次预处理时创建，之前为空），可供其他只读分析任务复用
+        ThreadPool* GetThreadPool() const;
+        
+        // 管腔的窄带有符号距离场（默认关闭，管腔内为正），在BVH之后并行构建
+        // 开启中心线提取时即使关闭也会构建（中心线由距离场提取）
+        // voxelSize/bandWidth不大于0时自动选择；已加载模型时只更新距离场
+        void SetDistanceField(bool enable, double voxelSize = 0.0, double bandWidth = 0.0);
+        bool GetDistanceFieldEnabled() const;
+        
+        // 当前模型的距离场，持有返回的指针即可在任意线程查询；未构建或无模型时为空
+        std::shared_ptr<const DistanceField> GetDistanceField() const;
+        
+        // 由距离场骨架化提取气道中心线树（默认关闭，开启时一并构建距离场）；已加载模型时只更新中心线
+        void SetCenterlineExtraction(bool enable, const Centerline::Settings& settings = Centerline::Settings());
+        bool GetCenterlineExtraction() const;
+        
+        // 当前模型的中心线，未开启、提取失败或无模型时为空
+        std::shared_ptr<const Centerline> GetCenterline() const;
+        
+        // 派生数据（距离场"sdf"、中心线"centerline"）的缓存：库不读写文件，
+        // 由调用方按名称读取/保存序列化数据（如存放在网格文件旁）
+        // 回调在执行预处理的线程上调用（异步加载为加载线程，同步加载和设置变化后的重新预处理为调用线程），
+        // 库保证同一ModelManager的回调不会并发调用；读取的数据几何哈希或参数不符时重新构建并保存
+        // 回调在加载开始时（CreatePreparedModel）随模型固定，之后调用SetCache只影响新的加载
+        typedef std::function<bool(const std::string& name, std::vector<unsigned char>& data)> CacheLoader;
+        typedef std::function<void(const std::string& name, const std::vector<unsigned char>& data)> CacheStore;
+        void SetCache(CacheLoader load, CacheStore store);
+        
         // 清理模型
         void ClearModel();
         
@@ -28,6 +28,7 @@ namespace BronchoscopyLib {
         void MoveToFirst();
         void MoveToLast();
         bool MoveToPosition(int index);
+        bool MoveToNextBifurcation();  // 查路径的分支标注，没有标注或前方没有分叉时返回false
         
         // 获取当前状态
         PathNode* GetCurrentNode() const;
@@ -0,0 +1,93 @@
+#ifndef PATH_VISIBILITY_H
+#define PATH_VISIBILITY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 前向声明VTK类
+class vtkPolyData;
+
+namespace BronchoscopyLib {
+
+    class CameraPath;
+    class MeshBVH;
+    class ThreadPool;
+
+    /**
+     * PathVisibility - 沿相机路径预计算的潜在可见集
+     * 渲染网格的三角形按质心递归中值划分为空间上紧凑的块（块内保持原三角形顺序）；
+     * 每个路径节点取节点本身及到前后相邻节点的1/4、1/2处共若干位姿，在覆盖视场（按最大宽高比取对角线并加余量）的
+     * 圆锥内均匀发射射线，射线在BVH上的最近交点所在块即为可见（被管壁遮挡的部分自然不会被命中），
+     * 再向相邻块扩展dilation圈以弥补射线间隙；结果按节点存为块位集
+     * 导航时相机最近节点到目标节点之间各节点的位集取并集，即覆盖过渡动画经过的位姿
+     * 注意：这是采样近似而非保守的可见性判定。张角小于射线间距的块（远处的细小分支、
+     * 与视线接近平行的管壁）可能没有射线命中，扩展只补上与命中块相邻的部分，
+     * 因此个别位姿下可能缺少少量三角形；默认的射线数和扩展圈数按此取得较大，
+     * 需要严格无遗漏时应关闭剔除
+     */
+    class PathVisibility {
+    public:
+        struct Settings {
+            int chunkTriangles;    // 每块的目标三角形数
+            int raysPerPose;       // 每个位姿的射线数
+            double viewAngle;      // 内窥镜相机的视场角（度，垂直方向）
+            double maxAspect;      // 视口的最大宽高比
+            double angleMargin;    // 圆锥半角的额外余量（度）
+            int dilation;          // 可见块向相邻块扩展的圈数
+            double positionTolerance;  // 视为仍在路径上的相机与路径折线的最大距离
+
+            Settings() : chunkTriangles(2048), raysPerPose(4096), viewAngle(60.0), maxAspect(2.0),
+                         angleMargin(5.0), dilation(2), positionTolerance(1.0) {}
+        };
+
+        PathVisibility();
+        ~PathVisibility();
+
+        PathVisibility(const PathVisibility&) = delete;
+        PathVisibility& operator=(const PathVisibility&) = delete;
+
+        // 对渲染网格（须与bvh对应、只含三角形）和路径计算各节点的可见块；pool为空时串行执行
+        // 网格含非三角形单元、BVH或路径为空时返回false；cancelFlag被置位时在下一个节点处中止，返回false且结果为空
+        // 只读取网格、BVH和路径，可在工作线程调用（调用方须保证构建期间它们不被修改）
+        bool Build(vtkPolyData* mesh, std::shared_ptr<const MeshBVH> bvh, const CameraPath& path,
+                   const Settings& settings, ThreadPool* pool = nullptr,
+                   const std::atomic<bool>* cancelFlag = nullptr);
+
+        void Clear();
+        bool IsEmpty() const;
+
+        // 构建所用的BVH和设置，用于判断网格或相机参数变化后是否需要重建
+        std::shared_ptr<const MeshBVH> GetBVH() const;
+        const Settings& GetSettings() const;
+
+        int GetChunkCount() const;
+        int GetNodeCount() const;
+        size_t GetTriangleCount() const;
+
+        // 离position最近的路径节点（无数据时为-1）
+        int FindNearestNode(const double position[3]) const;
+
+        // 相机位姿是否在采样覆盖范围内：离路径折线不超过positionTolerance，且视线与该处插值方向的夹角
+        // 不超过angleMargin；用户交互等使相机离开路径时可见集不再可靠，应绘制完整网格
+        bool IsPoseCovered(const double position[3], const double direction[3]) const;
+
+        // 节点范围[first, last]（可颠倒）内各节点可见块的并集，每位对应一个块
+        void GetVisibleChunks(int first, int last, std::vector<uint64_t>& bits) const;
+
+        // 位集中各块的三角形（网格单元编号，按块顺序，块内升序）及其总数
+        void GetVisibleCells(const std::vector<uint64_t>& bits, std::vector<long long>& cells) const;
+        size_t CountVisibleTriangles(const std::vector<uint64_t>& bits) const;
+
+        // 各节点可见三角形占全部三角形的平均比例
+        double GetAverageVisibleFraction() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // PATH_VISIBILITY_H
@@ -0,0 +1,62 @@
+#ifndef POST_PROCESSOR_H
+#define POST_PROCESSOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// 前向声明VTK类
+class vtkRenderer;
+
+namespace BronchoscopyLib {
+
+    /**
+     * PostProcessor - 渲染器的后处理通道链
+     * 场景先渲染到离屏纹理，再依次经过各个全屏通道，最后一个通道输出到渲染器视口
+     * 通道是完整的GLSL程序（VTK风格：//VTK::System::Dec、attribute vertexMC/tcoordMC、
+     * gl_FragData[0]），输入纹理为screenTexture，纹理尺寸为screenSize
+     */
+    class PostProcessor {
+    public:
+        // 单个通道最近的耗时（场景渲染本身记为"scene"）
+        struct PassTiming {
+            std::string name;
+            double cpuMs;   // 提交该通道的CPU时间
+            double gpuMs;   // GPU执行时间（计时器查询结果延迟几帧可用，不可用时为-1）
+            bool gpuUpdated;  // gpuMs是否为最近一帧新取得的结果（用于统计时不重复计入）
+
+            PassTiming() : cpuMs(0.0), gpuMs(-1.0), gpuUpdated(false) {}
+        };
+
+        PostProcessor();
+        ~PostProcessor();
+
+        PostProcessor(const PostProcessor&) = delete;
+        PostProcessor& operator=(const PostProcessor&) = delete;
+
+        // 安装到渲染器（替换其默认渲染流程，原有的渲染步骤作为场景通道）
+        bool Attach(vtkRenderer* renderer);
+
+        // 恢复渲染器的默认渲染流程并释放图形资源
+        void Detach();
+
+        bool IsAttached() const;
+
+        // 添加通道（同名通道被替换），按添加顺序执行
+        bool AddPass(const std::string& name, const std::string& vertexSource,
+                     const std::string& fragmentSource);
+        void RemovePass(const std::string& name);
+        bool HasPass(const std::string& name) const;
+        size_t GetPassCount() const;
+
+        // 获取最近一帧各通道的耗时
+        std::vector<PassTiming> GetTimings() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // POST_PROCESSOR_H
@@ -0,0 +1,67 @@
+#ifndef RENDER_PROFILER_H
+#define RENDER_PROFILER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PostProcessor.h"
+#include "RenderStats.h"
+
+// 前向声明VTK类
+class vtkProp;
+class vtkRenderer;
+class vtkRenderStepsPass;
+
+namespace BronchoscopyLib {
+
+    /**
+     * RenderProfiler - 单个渲染器的逐帧计时
+     * Instrument把渲染步骤（不透明、半透明、体、覆盖层）替换为计时版本，
+     * 渲染流程由调用者安装（见RenderingEngine）；每帧向RenderStats记录以下计时项（name为视图名）：
+     *   name/frame                 整帧
+     *   name/step/<步骤>           各渲染步骤
+     *   name/actor/<标签>          各actor的不透明和半透明几何（同标签的actor合并）
+     *   name/post/<通道>           后处理通道（由PassTimingSource提供）
+     */
+    class RenderProfiler {
+    public:
+        // actor标签（如shader变体名），返回空字符串时使用VTK类名
+        typedef std::function<std::string(vtkProp*)> PropLabeler;
+
+        // 后处理通道最近一帧的耗时
+        typedef std::function<std::vector<PostProcessor::PassTiming>(vtkRenderer*)> PassTimingSource;
+
+        RenderProfiler(const std::string& name, std::shared_ptr<RenderStats> stats);
+        ~RenderProfiler();
+
+        RenderProfiler(const RenderProfiler&) = delete;
+        RenderProfiler& operator=(const RenderProfiler&) = delete;
+
+        // 观察渲染器的帧开始和结束（整帧计时、写入本帧的actor和后处理耗时）
+        bool Attach(vtkRenderer* renderer);
+
+        // 把渲染步骤替换为计时版本；半透明步骤已包在深度剥离或OIT通道中时，替换其内层几何通道
+        void Instrument(vtkRenderStepsPass* steps);
+
+        // 移除观察者并释放计时器（已装入计时步骤的渲染流程由调用者替换）
+        void Detach();
+
+        bool IsAttached() const;
+
+        void SetPropLabeler(PropLabeler labeler);
+        void SetPassTimingSource(PassTimingSource source);
+
+        // 计时器查询不可用时（软件渲染）在每个区段前后glFinish，使CPU时间反映实际执行（默认开启）
+        // 须在Instrument之前设置
+        void SetSynchronousFallback(bool enable);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // RENDER_PROFILER_H
@@ -0,0 +1,63 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BronchoscopyLib {
+
+    /**
+     * RenderStats - 渲染耗时的滚动统计
+     * 每个计时项（如"endoscope/actor/endoscope+tissue+vignette"）保留最近capacity帧的样本，
+     * 汇总时计算均值、最小、最大和95分位；记录和读取可在不同线程进行
+     */
+    class RenderStats {
+    public:
+        // 一个计时项的汇总（毫秒）；GPU时间不可用时gpuSamples为0，各GPU值为-1
+        struct Summary {
+            std::string name;
+            size_t samples;
+            double cpuLast;
+            double cpuMean;
+            double cpuMin;
+            double cpuMax;
+            double cpuP95;
+            size_t gpuSamples;
+            double gpuLast;
+            double gpuMean;
+            double gpuMax;
+            double gpuP95;
+
+            Summary() : samples(0), cpuLast(0.0), cpuMean(0.0), cpuMin(0.0), cpuMax(0.0), cpuP95(0.0),
+                        gpuSamples(0), gpuLast(-1.0), gpuMean(-1.0), gpuMax(-1.0), gpuP95(-1.0) {}
+        };
+
+        explicit RenderStats(size_t capacity = 120);
+        ~RenderStats();
+
+        RenderStats(const RenderStats&) = delete;
+        RenderStats& operator=(const RenderStats&) = delete;
+
+        // 每项保留的样本数（缩小时丢弃最旧的样本）
+        void SetCapacity(size_t capacity);
+        size_t GetCapacity() const;
+
+        // 记录一个样本；gpuMs小于0表示本次没有GPU结果（计时器查询不可用或结果尚未就绪）
+        void Record(const std::string& name, double cpuMs, double gpuMs = -1.0);
+
+        // 按名称排序的全部汇总
+        std::vector<Summary> GetSummaries() const;
+        bool GetSummary(const std::string& name, Summary& summary) const;
+
+        void Clear();
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // RENDER_STATS_H
@@ -1,8 +1,12 @@
 #ifndef RENDERING_ENGINE_H
 #define RENDERING_ENGINE_H
 
+#include <functional>
 #include <memory>
 
+#include "RenderProfiler.h"
+#include "RenderStats.h"
+
 // 前向声明VTK类
 class vtkRenderer;
 class vtkRenderWindow;
@@ -17,6 +21,13 @@ namespace BronchoscopyLib {
      */
     class RenderingEngine {
     public:
+        // 全局视图的半透明渲染策略（气管模型和路径管都是半透明的）
+        enum TransparencyMode {
+            TRANSPARENCY_BLEND,          // 按绘制顺序混合：开销最低，扭曲的气管会出现排序错误
+            TRANSPARENCY_DEPTH_PEELING,  // 双向深度剥离：结果精确，开销随剥离层数增加
+            TRANSPARENCY_WEIGHTED_OIT    // 加权混合OIT：单遍、与顺序无关，颜色为近似值
+        };
+        
         RenderingEngine();
         ~RenderingEngine();
         
@@ -51,9 +62,46 @@ namespace BronchoscopyLib {
         // 交互器设置
         void SetupInteractors();
         
+        // 用户开始在内窥镜窗口中拖动或缩放相机时的回调（交互样式的StartInteractionEvent）
+        using InteractionCallback = std::function<void()>;
+        void SetEndoscopeInteractionCallback(InteractionCallback callback);
+        
         // 视口设置
         void SetViewport(int view, double xmin, double ymin, double xmax, double ymax);
         
+        // 半透明策略（默认TRANSPARENCY_BLEND），只作用于全局视图
+        // 每帧的全局视图耗时按当前策略记入统计项"overview/transparency/<策略名>"
+        void SetTransparencyMode(TransparencyMode mode);
+        TransparencyMode GetTransparencyMode() const;
+        static const char* GetTransparencyModeName(TransparencyMode mode);
+        
+        // 深度剥离的层数上限，以及剩余片段比例低于occlusionRatio时提前结束（0表示剥离完所有层）
+        void SetDepthPeelingBudget(int maxPeels, double occlusionRatio = 0.0);
+        
+        // 内窥镜视图动态分辨率（默认关闭）：相机运动时以缩小的分辨率渲染再放大，
+        // 比例在[minScale, 1]内自动调整使帧耗时接近frameMs；停止运动后恢复全分辨率
+        void SetDynamicResolution(bool enable);
+        bool IsDynamicResolutionEnabled() const;
+        void SetDynamicResolutionTarget(double frameMs, double minScale = 0.5);
+        
+        // 由相机过渡驱动；返回是否刚停止运动且需要重新渲染一帧全分辨率画面
+        bool SetEndoscopeMoving(bool moving);
+        bool IsEndoscopeMoving() const;
+        
+        // 当前内窥镜视图的渲染比例（静止或未启用时为1）
+        double GetEndoscopeResolutionScale() const;
+        
+        // 性能分析（默认关闭）：两个视图按渲染步骤、actor和后处理通道计时，
+        // 结果写入滚动统计（计时项以"overview/"或"endoscope/"开头，见RenderProfiler）
+        void SetProfilingEnabled(bool enable);
+        bool IsProfilingEnabled() const;
+        
+        // actor标签和后处理耗时来源（在启用前后设置均可）
+        void SetProfilingLabeler(RenderProfiler::PropLabeler labeler);
+        void SetProfilingPassSource(RenderProfiler::PassTimingSource source);
+        
+        std::shared_ptr<RenderStats> GetRenderStats() const;
+        
         // 获取渲染状态
         bool IsInitialized() const;
         
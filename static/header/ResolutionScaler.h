@@ -0,0 +1,56 @@
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+#include <memory>
+
+// 前向声明VTK类
+class vtkRenderPass;
+class vtkWindow;
+
+namespace BronchoscopyLib {
+
+    /**
+     * ResolutionScaler - 运动时的动态分辨率渲染
+     * 运动期间场景渲染到按比例缩小的离屏目标，再线性放大到渲染器视口；
+     * 停止运动后的下一帧恢复全分辨率渲染
+     * 缩放比例按每帧场景耗时自动调整，使运动帧耗时接近目标帧时间（像素数与比例的平方成正比）
+     */
+    class ResolutionScaler {
+    public:
+        ResolutionScaler();
+        ~ResolutionScaler();
+
+        ResolutionScaler(const ResolutionScaler&) = delete;
+        ResolutionScaler& operator=(const ResolutionScaler&) = delete;
+
+        // 被包装的场景通道（为空时使用默认渲染步骤）
+        void SetScenePass(vtkRenderPass* scene);
+        vtkRenderPass* GetScenePass() const;
+
+        // 安装到渲染器的渲染通道（对象生命周期内不变）
+        vtkRenderPass* GetPass() const;
+
+        // 相机是否在运动（只在运动时缩放）
+        void SetMoving(bool moving);
+        bool IsMoving() const;
+
+        // 目标帧时间（毫秒，默认16.7）
+        void SetTargetFrameTime(double frameMs);
+        double GetTargetFrameTime() const;
+
+        // 缩放比例范围（默认0.5到1.0，限制在0.1到1.0之间）
+        void SetScaleRange(double minScale, double maxScale);
+
+        // 下一个运动帧使用的缩放比例
+        double GetScale() const;
+
+        void ReleaseGraphicsResources(vtkWindow* window);
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // RESOLUTION_SCALER_H
@@ -0,0 +1,64 @@
+#ifndef ROUTE_PLANNER_H
+#define ROUTE_PLANNER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace BronchoscopyLib {
+
+    class Centerline;
+
+    /**
+     * RoutePlanner - 到目标点（如结节）的最短可行路线
+     * 中心线的采样点连成图（分叉点为多个分支共享的节点），从根（气管开口）出发做一次Dijkstra，
+     * 管腔半径小于设定值（镜身半径）的节点不可通过（开口段除外，那里的离壁距离是到开口边缘的距离）；所有节点的路线长度和前驱预先算好，
+     * 每次查询只需找离目标最近的可达节点并沿前驱回溯，目标变化时可即时重算
+     * 目标通常在管腔外，路线终点为可达节点中离目标最近者
+     */
+    class RoutePlanner {
+    public:
+        // 规划结果
+        struct Route {
+            std::vector<double> positions;  // 从根到终点的点序列（xyz连续存放），可直接作为相机路径
+            double length;                  // 沿中心线的路线长度
+            double targetDistance;          // 终点到目标的直线距离
+            double narrowestRadius;         // 沿途最小管腔半径
+            int branch;                     // 终点所在的中心线分支
+
+            Route() : length(0.0), targetDistance(0.0), narrowestRadius(0.0), branch(-1) {}
+        };
+
+        RoutePlanner();
+        ~RoutePlanner();
+
+        RoutePlanner(const RoutePlanner&) = delete;
+        RoutePlanner& operator=(const RoutePlanner&) = delete;
+
+        // 由中心线建图并计算从根出发的距离；中心线为空时返回false
+        bool Build(std::shared_ptr<const Centerline> centerline);
+
+        void Clear();
+        bool IsEmpty() const;
+
+        // 建图所用的中心线，用于判断是否需要重建
+        std::shared_ptr<const Centerline> GetCenterline() const;
+
+        // 可通过的最小管腔半径（0为不限制）；变化时重新计算从根出发的距离
+        void SetMinRadius(double radius);
+        double GetMinRadius() const;
+
+        // 规划到目标点的路线（至少两个点）；气管开口段之后即小于限制时返回false
+        bool PlanRoute(const double target[3], Route& route) const;
+
+        size_t GetNodeCount() const;
+        size_t GetReachableCount() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // ROUTE_PLANNER_H
@@ -15,6 +15,7 @@ namespace BronchoscopyLib {
     class RenderingEngine;
     class NavigationController;
     struct PathNode;
+    struct PreparedModel;
     
     /**
      * SceneManager - 场景协调管理器
@@ -55,9 +56,24 @@ namespace BronchoscopyLib {
         void ResetToDefaultView();
         
         // 协调操作
-        bool OnModelLoaded(vtkPolyData* polyData);
+        bool OnModelLoaded(vtkPolyData* polyData, bool adopt = false);
+        bool OnModelPrepared(const std::shared_ptr<PreparedModel>& model);  // 安装异步预处理完成的模型
         void OnPathLoaded();
         void OnNavigationChanged(PathNode* node, int index);
+        void OnDerivedDataChanged();  // 距离场、中心线重建或关闭后更新相机的管腔约束和路径的分支标注
+        
+        // 沿路径的可见性剔除（默认关闭）：开启后按路径预计算各节点的潜在可见块，
+        // 内窥镜视图只绘制相机最近节点到当前目标节点之间各节点可见块的并集；
+        // 预计算在模型的线程池上进行，模型、路径或视场角变化后重新提交，完成前绘制完整网格
+        void SetVisibilityCulling(bool enable);
+        bool GetVisibilityCulling() const;
+        
+        // 换入已完成的后台可见集并按当前导航节点应用（渲染线程定期调用；导航更新时也会检查）
+        // 返回是否换入，调用方据此重新渲染
+        bool ProcessPathVisibility();
+        
+        // 内窥镜视图当前绘制的三角形占全部三角形的比例（未剔除时为1）
+        double GetEndoscopeVisibleFraction() const;
         
         // 渲染触发
         void RequestRender();
@@ -75,6 +91,24 @@ namespace BronchoscopyLib {
         void PrintSceneInfo() const;
         
     private:
+        // 将当前模型的Actor加入渲染器并重置相机
+        void AddModelToScene();
+        
+        // 模型或路径变化后重新计算路径各节点的管腔半径剖面
+        void UpdateLumenProfile();
+        
+        // 中心线或路径变化后重新标注路径各节点所在的分支
+        void UpdatePathTopology();
+        
+        // 按当前渲染网格、路径和视场角在线程池上重新计算可见集（剔除开启时），取消尚未完成的构建
+        void UpdatePathVisibility();
+        
+        // 为导航目标节点选择内窥镜视图的可见三角形
+        void ApplyPathVisibility(const PathNode* node, int index);
+        
+        // 用户在内窥镜窗口中移动相机：离开路径位姿后可见集不再可靠，改为绘制完整网格
+        void OnEndoscopeInteraction();
+        
         class Impl;
         std::unique_ptr<Impl> pImpl;
     };
@@ -0,0 +1,48 @@
+#ifndef SECTION_TIMER_H
+#define SECTION_TIMER_H
+
+#include <memory>
+
+namespace BronchoscopyLib {
+
+    /**
+     * SectionTimer - 渲染区段的CPU和GPU计时
+     * GPU时间使用计时器查询，结果延迟几帧可用（每个计时器同时只有一次查询在途）；
+     * 驱动不支持计时器查询时（如部分软件渲染）只有CPU时间，可选在区段前后glFinish，
+     * 使CPU时间包含实际执行时间而不只是提交时间
+     * Begin/End必须在渲染线程、OpenGL上下文为当前时调用
+     */
+    class SectionTimer {
+    public:
+        SectionTimer();
+        ~SectionTimer();
+
+        SectionTimer(const SectionTimer&) = delete;
+        SectionTimer& operator=(const SectionTimer&) = delete;
+
+        // 计时器查询不可用时同步执行（默认关闭，同步会降低帧率，只用于分析）
+        void SetSynchronousFallback(bool enable);
+
+        void Begin();
+        void End();
+
+        // 最近一个区段的CPU时间
+        double GetCpuMs() const;
+
+        // 最近一次取得的GPU时间（不可用时为-1），以及最近一次Begin是否取得了新结果
+        double GetGpuMs() const;
+        bool HasNewGpuResult() const;
+
+        // 首次Begin后可知；之前返回false
+        bool IsGpuTimingAvailable() const;
+
+        void ReleaseGraphicsResources();
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // SECTION_TIMER_H
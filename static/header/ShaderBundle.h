@@ -0,0 +1,118 @@
+#ifndef SHADER_BUNDLE_H
+#define SHADER_BUNDLE_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace BronchoscopyLib {
+
+    /**
+     * ShaderBundle - 编译进库的shader替换表和预先合并的变体
+     * 构建时由tools/EmbedShaders预解析shaders/目录，并按ShaderPermutations的规则
+     * 合并、校验全部变体（EmbeddedShaders.cpp），运行时无需查找目录、解析文件或合并；
+     * 解析器与ShaderSystem的磁盘加载共用
+     */
+    namespace ShaderBundle {
+
+        // 一条预解析的替换（code包含替换点的标签行本身）
+        struct Replacement {
+            const char* tag;
+            bool before;
+            const char* code;
+        };
+
+        // 一个shader文件（路径相对于shaders/，如"view/endoscope.frag"）
+        // 替换格式的文件提供预解析的replacements；完整程序（如后处理shader）只有source
+        struct File {
+            const char* path;
+            const Replacement* replacements;
+            size_t replacementCount;
+            const char* source;  // 文件原文
+        };
+
+        // 获取编译进库的全部文件（构建时生成，需定义BRONCHOSCOPY_EMBEDDED_SHADERS）
+        const File* GetFiles(size_t& count);
+        
+        // 预先合并的变体中的一条替换
+        struct VariantReplacement {
+            bool fragment;
+            const char* tag;
+            bool before;
+            const char* code;
+        };
+        
+        // 预先合并的变体，键与ShaderPermutations::Key一致
+        struct Variant {
+            int view;
+            int material;
+            unsigned features;
+            const VariantReplacement* replacements;
+            size_t replacementCount;
+            const char* const* sources;  // 组成变体的文件（热重载时据此找到受影响的变体）
+            size_t sourceCount;
+        };
+        
+        // 获取构建时生成的全部变体
+        const Variant* GetVariants(size_t& count);
+
+        // 解析结果
+        struct ParsedReplacement {
+            std::string tag;
+            bool before;
+            std::string code;
+        };
+
+        // 解析shader替换文件格式：
+        //   # 注释
+        //   //VTK::Tag BEFORE|AFTER
+        //   <替换代码，通常以相同的标签行开头>
+        //   END_REPLACEMENT
+        inline std::vector<ParsedReplacement> Parse(std::istream& stream) {
+            std::vector<ParsedReplacement> replacements;
+
+            // 兼容CRLF换行
+            auto readLine = [&stream](std::string& line) -> bool {
+                if (!std::getline(stream, line)) return false;
+                if (!line.empty() && line[line.size() - 1] == '\r') {
+                    line.erase(line.size() - 1);
+                }
+                return true;
+            };
+
+            std::string line;
+            while (readLine(line)) {
+                // 跳过空行和#注释
+                if (line.empty() || line[0] == '#') continue;
+
+                // 其他//开头的行视为普通注释，忽略
+                if (line.find("//VTK::") != 0) continue;
+
+                // 查找空格分隔标签和BEFORE/AFTER
+                size_t spacePos = line.find(' ');
+                if (spacePos == std::string::npos) continue;
+
+                ParsedReplacement replacement;
+                replacement.tag = line.substr(0, spacePos);
+                replacement.before = (line.substr(spacePos + 1) == "BEFORE");
+
+                // 读取下一行（应该是相同的标签作为替换点），继续读取直到END_REPLACEMENT
+                if (!readLine(line)) break;
+                std::string code = line + "\n";  // 包含标签行本身
+                while (readLine(line)) {
+                    if (line == "END_REPLACEMENT") break;
+                    code += line + "\n";
+                }
+                replacement.code = code;
+                replacements.push_back(replacement);
+            }
+
+            return replacements;
+        }
+
+    } // namespace ShaderBundle
+
+} // namespace BronchoscopyLib
+
+#endif // SHADER_BUNDLE_H
@@ -0,0 +1,66 @@
+#ifndef SHADER_PARAMETERS_H
+#define SHADER_PARAMETERS_H
+
+#include <map>
+#include <string>
+
+// 前向声明VTK类
+class vtkShaderProgram;
+
+namespace BronchoscopyLib {
+
+    /**
+     * ShaderParameters - 类型化的shader uniform参数块
+     * 按名称保存float/vec2/vec3/vec4/int值，上传时只设置程序中实际使用的uniform；
+     * 修改参数只改变uniform的值，不改变shader源码，不会触发VTK重新编译
+     */
+    class ShaderParameters {
+    public:
+        enum Type {
+            FLOAT,
+            VEC2,
+            VEC3,
+            VEC4,
+            INT
+        };
+
+        ShaderParameters();
+
+        void SetFloat(const std::string& name, float value);
+        void SetVec2(const std::string& name, float x, float y);
+        void SetVec3(const std::string& name, float x, float y, float z);
+        void SetVec4(const std::string& name, float x, float y, float z, float w);
+        void SetInt(const std::string& name, int value);
+
+        // 读取参数（不存在或类型不符时返回false）
+        bool GetFloat(const std::string& name, float& value) const;
+        bool GetInt(const std::string& name, int& value) const;
+        bool Get(const std::string& name, Type& type, float values[4]) const;
+
+        bool Has(const std::string& name) const;
+        void Remove(const std::string& name);
+        void Clear();
+        size_t GetCount() const;
+
+        // 每次修改递增，用于判断程序中的uniform是否需要重新上传
+        unsigned long GetVersion() const;
+
+        // 上传到当前绑定的shader程序，程序未使用的参数跳过，返回设置的uniform数
+        int Upload(vtkShaderProgram* program) const;
+
+    private:
+        struct Value {
+            Type type;
+            float values[4];
+            int intValue;
+        };
+
+        void Set(const std::string& name, Type type, float x, float y, float z, float w);
+
+        std::map<std::string, Value> values;
+        unsigned long version;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // SHADER_PARAMETERS_H
@@ -0,0 +1,362 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include "ShaderSystem.h"
+
+#include <cctype>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace BronchoscopyLib {
+
+    /**
+     * ShaderPermutations - shader变体的排列规则
+     * 变体键为(视图, 材质, 特性位)；组成文件按视图、效果、材质的顺序合并，
+     * 特性以预处理宏写入片段shader的声明段，shader文件用#ifdef选择代码
+     * 构建时tools/EmbedShaders按这里的规则枚举、合并并校验全部变体，编译进库，
+     * 运行时按键直接取用；使用磁盘覆盖目录（开发、热重载）时运行时按相同规则合并
+     */
+    namespace ShaderPermutations {
+
+        // 变体中的一条替换
+        struct Replacement {
+            bool fragment;      // 片段shader（否则为顶点shader）
+            std::string tag;
+            bool before;
+            std::string code;   // 包含替换点的标签行本身
+
+            Replacement() : fragment(false), before(false) {}
+        };
+
+        // 变体键
+        struct Key {
+            int view;
+            int material;
+            unsigned features;
+
+            Key(int v = 0, int m = 0, unsigned f = 0) : view(v), material(m), features(f) {}
+
+            bool operator<(const Key& other) const {
+                return std::tie(view, material, features) <
+                       std::tie(other.view, other.material, other.features);
+            }
+            bool operator==(const Key& other) const {
+                return view == other.view && material == other.material && features == other.features;
+            }
+        };
+
+        const unsigned kFeatureCount = 4;
+
+        // 特性对应的预处理宏名
+        inline const char* GetFeatureDefine(unsigned feature) {
+            switch (feature) {
+                case ShaderSystem::FEATURE_VIGNETTE: return "FEATURE_VIGNETTE";
+                case ShaderSystem::FEATURE_FRESNEL:  return "FEATURE_FRESNEL";
+                case ShaderSystem::FEATURE_FOG:      return "FEATURE_FOG";
+                case ShaderSystem::FEATURE_PBR:      return "FEATURE_PBR";
+                default:                             return nullptr;
+            }
+        }
+
+        // 由配置推导特性
+        inline unsigned GetFeatures(const ShaderSystem::ShaderConfig& config) {
+            unsigned features = 0;
+            if (config.view == ShaderSystem::VIEW_ENDOSCOPE ||
+                config.view == ShaderSystem::VIEW_REALISTIC_ENDOSCOPE) {
+                features |= ShaderSystem::FEATURE_VIGNETTE;
+            }
+            if (config.effect == ShaderSystem::FRESNEL) features |= ShaderSystem::FEATURE_FRESNEL;
+            if (config.effect == ShaderSystem::FOG) features |= ShaderSystem::FEATURE_FOG;
+            if (config.material == ShaderSystem::MATERIAL_PBR_TISSUE) features |= ShaderSystem::FEATURE_PBR;
+            return features;
+        }
+
+        // 基础shader不产生替换（VTK自带的着色即为基础），PHONG即VTK默认光照，二者不影响变体
+        inline Key MakeKey(const ShaderSystem::ShaderConfig& config) {
+            return Key(config.view, config.material, GetFeatures(config));
+        }
+
+        // 视图shader文件
+        inline std::vector<std::string> GetViewFiles(int view) {
+            switch (view) {
+                case ShaderSystem::VIEW_ENDOSCOPE:
+                    return { "view/endoscope.vert", "view/endoscope.frag" };
+                case ShaderSystem::VIEW_OVERVIEW:
+                    return { "view/overview.vert", "view/overview.frag" };
+                case ShaderSystem::VIEW_REALISTIC_ENDOSCOPE:
+                    return { "view/realistic_endoscope.frag" };
+                default:
+                    return {};
+            }
+        }
+
+        // 材质shader文件
+        inline std::vector<std::string> GetMaterialFiles(int material) {
+            switch (material) {
+                case ShaderSystem::MATERIAL_TISSUE:
+                    return { "material/tissue.vert", "material/tissue.frag" };
+                case ShaderSystem::MATERIAL_PBR_TISSUE:
+                    return { "material/pbr_tissue.frag" };
+                default:
+                    return {};
+            }
+        }
+
+        // 表面效果（菲涅尔、雾）共用一个文件，按特性宏选择
+        inline std::vector<std::string> GetEffectFiles(unsigned features) {
+            if (features & (ShaderSystem::FEATURE_FRESNEL | ShaderSystem::FEATURE_FOG)) {
+                return { "effect/surface_effects.frag" };
+            }
+            return {};
+        }
+
+        // 组成变体的全部文件，按合并顺序
+        inline std::vector<std::string> GetSourceFiles(const Key& key) {
+            std::vector<std::string> files = GetViewFiles(key.view);
+            for (const auto& file : GetEffectFiles(key.features)) files.push_back(file);
+            for (const auto& file : GetMaterialFiles(key.material)) files.push_back(file);
+            return files;
+        }
+
+        inline bool IsFragmentFile(const std::string& path) {
+            const std::string suffix = ".frag";
+            return path.size() >= suffix.size() &&
+                   path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        // 将替换合并进变体
+        // VTK按(类型, 标签, BEFORE/AFTER)保存替换，同键的后者会覆盖前者，因此在这里合并：
+        // 已有代码保留了标签时按VTK的顺序替换语义嵌套，否则（如声明）直接拼接
+        inline void Merge(std::vector<Replacement>& merged, const Replacement& replacement) {
+            for (auto& existing : merged) {
+                if (existing.fragment != replacement.fragment ||
+                    existing.tag != replacement.tag ||
+                    existing.before != replacement.before) {
+                    continue;
+                }
+
+                std::string code = replacement.code;
+
+                // Impl段放入独立作用域，避免与已有代码的局部变量重名
+                if (replacement.tag.find("::Impl") != std::string::npos) {
+                    std::string tagLine = replacement.tag + "\n";
+                    if (code.compare(0, tagLine.size(), tagLine) == 0) {
+                        code = tagLine + "  {\n" + code.substr(tagLine.size()) + "  }\n";
+                    } else {
+                        code = "  {\n" + code + "  }\n";
+                    }
+                }
+
+                size_t tagPos = existing.code.find(replacement.tag);
+                if (tagPos != std::string::npos) {
+                    existing.code.replace(tagPos, replacement.tag.size(), code);
+                } else {
+                    existing.code += code;
+                }
+                return;
+            }
+
+            merged.push_back(replacement);
+        }
+
+        // 特性宏写入片段shader的System::Dec段，紧随标签行
+        // （VTK在标签处插入#version，宏必须位于其后）
+        inline void InsertDefines(std::vector<Replacement>& replacements, unsigned features) {
+            std::string defines;
+            for (unsigned i = 0; i < kFeatureCount; ++i) {
+                unsigned feature = 1u << i;
+                if (features & feature) {
+                    defines += std::string("#define ") + GetFeatureDefine(feature) + "\n";
+                }
+            }
+            if (defines.empty()) return;
+
+            const std::string tag = "//VTK::System::Dec";
+            for (auto& replacement : replacements) {
+                if (!replacement.fragment || replacement.tag != tag || replacement.before) continue;
+
+                size_t tagPos = replacement.code.find(tag);
+                if (tagPos == std::string::npos) {
+                    replacement.code = defines + replacement.code;
+                    return;
+                }
+                size_t lineEnd = replacement.code.find('\n', tagPos);
+                if (lineEnd == std::string::npos) {
+                    replacement.code += "\n";
+                    lineEnd = replacement.code.size() - 1;
+                }
+                replacement.code.insert(lineEnd + 1, defines);
+                return;
+            }
+
+            Replacement declarations;
+            declarations.fragment = true;
+            declarations.tag = tag;
+            declarations.before = false;
+            declarations.code = tag + "\n" + defines;
+            replacements.push_back(declarations);
+        }
+
+        // 读取单个文件的替换（由调用者提供：构建时解析文件，运行时使用缓存）
+        typedef std::function<std::vector<Replacement>(const std::string& path)> FileLoader;
+
+        // 合并变体：文件依次合并（后合并的文件嵌套在先合并的同名标签处，即先执行），再写入特性宏
+        inline std::vector<Replacement> Compose(const Key& key, const FileLoader& loadFile) {
+            std::vector<Replacement> merged;
+            for (const auto& path : GetSourceFiles(key)) {
+                for (auto replacement : loadFile(path)) {
+                    replacement.fragment = IsFragmentFile(path);
+                    Merge(merged, replacement);
+                }
+            }
+            InsertDefines(merged, key.features);
+            return merged;
+        }
+
+        // 全部可能出现的变体键（构建时枚举）
+        inline std::vector<Key> EnumerateKeys() {
+            std::set<Key> keys;
+            for (int view = ShaderSystem::VIEW_NONE; view <= ShaderSystem::VIEW_REALISTIC_ENDOSCOPE; ++view) {
+                for (int effect = ShaderSystem::EFFECT_NONE; effect <= ShaderSystem::FOG; ++effect) {
+                    for (int material = ShaderSystem::MATERIAL_NONE;
+                         material <= ShaderSystem::MATERIAL_PBR_TISSUE; ++material) {
+                        ShaderSystem::ShaderConfig config(ShaderSystem::SURFACE,
+                                                          static_cast<ShaderSystem::EffectShader>(effect),
+                                                          static_cast<ShaderSystem::ViewShader>(view),
+                                                          static_cast<ShaderSystem::MaterialShader>(material));
+                        keys.insert(MakeKey(config));
+                    }
+                }
+            }
+            return std::vector<Key>(keys.begin(), keys.end());
+        }
+
+        inline std::string Describe(const Key& key) {
+            std::ostringstream text;
+            text << "view " << key.view << ", material " << key.material << ", features";
+            if (key.features == 0) text << " none";
+            for (unsigned i = 0; i < kFeatureCount; ++i) {
+                if (key.features & (1u << i)) text << " " << GetFeatureDefine(1u << i);
+            }
+            return text.str();
+        }
+
+        // 简短的变体名称，由视图和材质文件名及特性组成，如"endoscope+tissue+vignette"
+        // （用于性能统计等按变体汇总的场合）
+        inline std::string GetLabel(const Key& key) {
+            std::vector<std::string> files = GetViewFiles(key.view);
+            std::vector<std::string> materialFiles = GetMaterialFiles(key.material);
+            if (!materialFiles.empty()) files.push_back(materialFiles.front());
+
+            std::string label;
+            std::set<std::string> stems;
+            for (const auto& file : files) {
+                size_t slash = file.find_last_of('/');
+                size_t start = (slash == std::string::npos) ? 0 : slash + 1;
+                std::string stem = file.substr(start, file.find_last_of('.') - start);
+                if (!stems.insert(stem).second) continue;
+                label += (label.empty() ? "" : "+") + stem;
+            }
+            if (label.empty()) label = "default";
+
+            for (unsigned i = 0; i < kFeatureCount; ++i) {
+                if (!(key.features & (1u << i))) continue;
+                std::string name = std::string(GetFeatureDefine(1u << i)).substr(std::string("FEATURE_").size());
+                for (auto& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                label += "+" + name;
+            }
+            return label;
+        }
+
+        // 校验合并后的变体，返回错误描述（为空表示通过）：
+        //   System::Dec段必须保留标签行（否则VTK无法插入#version）；
+        //   条件编译必须配对，只能引用已知的特性宏；
+        //   在该变体中生效的代码里，同一阶段不能重复声明同名uniform（视图与材质冲突）
+        inline std::vector<std::string> Validate(const Key& key, const std::vector<Replacement>& replacements) {
+            std::vector<std::string> errors;
+            std::set<std::string> uniforms[2];
+            const std::string prefix = Describe(key) + ": ";
+
+            for (const auto& replacement : replacements) {
+                const std::string where = prefix + (replacement.fragment ? "fragment " : "vertex ") +
+                                          replacement.tag + ": ";
+
+                if (replacement.tag == "//VTK::System::Dec" &&
+                    replacement.code.find(replacement.tag) == std::string::npos) {
+                    errors.push_back(where + "replacement drops the tag line");
+                }
+
+                // (外层是否生效, 本层条件)
+                std::vector<std::pair<bool, bool>> conditions;
+                bool active = true;
+
+                std::istringstream stream(replacement.code);
+                std::string line;
+                while (std::getline(stream, line)) {
+                    size_t start = line.find_first_not_of(" \t");
+                    if (start == std::string::npos) continue;
+                    std::istringstream words(line.substr(start));
+                    std::string word;
+                    words >> word;
+
+                    if (word == "#ifdef" || word == "#ifndef") {
+                        std::string name;
+                        words >> name;
+                        bool defined = false;
+                        if (name.compare(0, 8, "FEATURE_") == 0) {
+                            bool known = false;
+                            for (unsigned i = 0; i < kFeatureCount; ++i) {
+                                if (name == GetFeatureDefine(1u << i)) {
+                                    known = true;
+                                    defined = (key.features & (1u << i)) != 0;
+                                }
+                            }
+                            if (!known) errors.push_back(where + "unknown feature macro " + name);
+                        }
+                        bool condition = (word == "#ifdef") ? defined : !defined;
+                        conditions.push_back(std::make_pair(active, condition));
+                        active = active && condition;
+                    } else if (word == "#if") {
+                        // 其他表达式不求值，视为生效
+                        conditions.push_back(std::make_pair(active, true));
+                    } else if (word == "#else") {
+                        if (conditions.empty()) {
+                            errors.push_back(where + "#else without #if");
+                            continue;
+                        }
+                        active = conditions.back().first && !conditions.back().second;
+                    } else if (word == "#endif") {
+                        if (conditions.empty()) {
+                            errors.push_back(where + "#endif without #if");
+                            continue;
+                        }
+                        active = conditions.back().first;
+                        conditions.pop_back();
+                    } else if (word == "uniform" && active) {
+                        std::string type;
+                        std::string name;
+                        words >> type >> name;
+                        name = name.substr(0, name.find_first_of("[=;"));
+                        if (!name.empty() && !uniforms[replacement.fragment].insert(name).second) {
+                            errors.push_back(where + "uniform " + name + " declared more than once");
+                        }
+                    }
+                }
+
+                if (!conditions.empty()) {
+                    errors.push_back(where + "unterminated #if");
+                }
+            }
+
+            return errors;
+        }
+
+    } // namespace ShaderPermutations
+
+} // namespace BronchoscopyLib
+
+#endif // SHADER_PERMUTATIONS_H
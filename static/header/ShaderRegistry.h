@@ -0,0 +1,88 @@
+#ifndef SHADER_REGISTRY_H
+#define SHADER_REGISTRY_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ShaderPermutations.h"
+
+namespace BronchoscopyLib {
+
+    /**
+     * ShaderRegistry - 线程安全的shader文件和变体缓存
+     * 保存编译进库的替换表、从磁盘覆盖目录读取的文件以及合并好的变体，不涉及任何VTK对象；
+     * 可由多个ShaderSystem（多个BronchoscopyAPI实例）共享，各实例可在不同线程上并行初始化
+     * 缓存读取（变体命中）使用共享锁并发进行，只有首次合并或替换文件时独占
+     */
+    class ShaderRegistry {
+    public:
+        typedef ShaderPermutations::Replacement Replacement;
+        typedef std::map<std::string, std::vector<Replacement>> FileReplacements;
+
+        // 一个变体键（视图、材质、特性）合并后的替换集合，创建后不再修改
+        struct Variant {
+            unsigned long id;  // 进程内唯一，用于判断mapper当前是否已应用该变体
+            ShaderSystem::ShaderConfig config;
+            std::vector<std::string> sources;  // 组成该变体的shader文件，热重载时据此找到受影响的变体
+            std::vector<Replacement> replacements;
+        };
+
+        ShaderRegistry();
+        ~ShaderRegistry();
+
+        ShaderRegistry(const ShaderRegistry&) = delete;
+        ShaderRegistry& operator=(const ShaderRegistry&) = delete;
+
+        // 加载编译进库的shader（可重复调用）；库未嵌入shader时查找磁盘上的shaders目录
+        bool Initialize();
+        bool IsInitialized() const;
+        bool HasEmbeddedShaders() const;
+
+        // 磁盘覆盖目录（为空时只使用编译进库的shader），调用者负责之后重新加载已使用的文件
+        // 只有目录中实际存在的文件从磁盘读取；组成文件都未被覆盖的变体仍直接使用构建时合并好的版本
+        bool SetOverridePath(const std::string& path);
+        std::string GetOverridePath() const;
+
+        // 在常见的相对位置查找shaders目录，找不到时返回空字符串
+        std::string FindShaderRoot() const;
+
+        // 获取变体（未缓存时合并并缓存）；配置无效时返回nullptr
+        std::shared_ptr<const Variant> GetVariant(const ShaderSystem::ShaderConfig& config);
+
+        // 只查找已缓存的变体
+        std::shared_ptr<const Variant> FindVariant(const ShaderSystem::ShaderConfig& config) const;
+
+        // 单个文件的替换（首次使用时读取并缓存）
+        std::vector<Replacement> GetReplacements(const std::string& path);
+
+        // 完整shader程序的源码（如后处理通道）
+        std::string LoadShaderFile(const std::string& path);
+
+        // 热重载支持
+        // 已使用的文件：读取过的文件和缓存变体的组成文件
+        std::vector<std::string> GetUsedFiles() const;
+        // 按当前来源（磁盘覆盖优先）重新读取文件，不修改缓存
+        FileReplacements ReadFiles(const std::vector<std::string>& paths) const;
+        // 缓存中的文件内容（用于编译失败时回滚，未缓存的文件不返回）
+        FileReplacements GetCachedFiles(const std::vector<std::string>& paths) const;
+        // 替换文件内容并重新合并使用这些文件的变体，返回 旧变体id -> 新变体
+        std::map<unsigned long, std::shared_ptr<const Variant>> ReplaceFiles(const FileReplacements& files);
+        // 清空完整程序的源码缓存
+        void ClearSourceCache();
+
+        // 解析磁盘上的shader替换文件（不访问缓存，可在任意线程调用）
+        static std::vector<Replacement> ParseShaderFile(const std::string& fullPath);
+
+        // 缓存统计
+        void GetStats(unsigned long& hits, unsigned long& misses, size_t& variantCount) const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // SHADER_REGISTRY_H
@@ -5,6 +5,9 @@
 #include <vector>
 #include <memory>
 
+#include "PostProcessor.h"
+#include "ShaderParameters.h"
+
 // 前向声明VTK类
 class vtkActor;
 class vtkOpenGLPolyDataMapper;
@@ -12,9 +15,11 @@ class vtkRenderer;
 
 namespace BronchoscopyLib {
     
+    class ShaderRegistry;
+    
     /**
      * ShaderSystem - Shader管理系统
-     * 从主程序的shaders文件夹加载和管理shader
+     * 默认使用构建时编译进库的shaders/替换表，可选从磁盘目录覆盖
      */
     class ShaderSystem {
     public:
@@ -54,46 +59,125 @@ namespace BronchoscopyLib {
             MATERIAL_PBR_TISSUE   // PBR组织材质（基于物理的渲染）
         };
         
-        // Shader配置
+        // 变体特性：生成的变体源码中定义同名预处理宏（#define FEATURE_FOG等），
+        // shader文件用#ifdef选择代码；由ShaderConfig推导（见ShaderPermutations::GetFeatures）
+        enum ShaderFeature {
+            FEATURE_VIGNETTE = 1 << 0,  // 暗角（内窥镜视图）
+            FEATURE_FRESNEL  = 1 << 1,  // 菲涅尔轮廓光（EFFECT FRESNEL）
+            FEATURE_FOG      = 1 << 2,  // 深度雾（EFFECT FOG）
+            FEATURE_PBR      = 1 << 3   // PBR材质（自带色调映射，视图跳过自身的色调映射）
+        };
+        
+        // Shader配置（推导出相同变体键的配置共用同一个shader变体）
         struct ShaderConfig {
             BaseShader base;
             EffectShader effect;
             ViewShader view;
+            MaterialShader material;
             
             ShaderConfig(BaseShader b = SURFACE, 
                         EffectShader e = EFFECT_NONE, 
-                        ViewShader v = VIEW_NONE) 
-                : base(b), effect(e), view(v) {}
+                        ViewShader v = VIEW_NONE,
+                        MaterialShader m = MATERIAL_NONE) 
+                : base(b), effect(e), view(v), material(m) {}
+        };
+        
+        // 变体缓存统计
+        struct VariantCacheStats {
+            unsigned long hits;          // 命中已组合的变体
+            unsigned long misses;        // 首次组合变体（解析并合并替换）
+            unsigned long reusedMappers; // mapper已是该变体，跳过重新应用（不触发shader重建）
+            size_t variantCount;         // 已缓存的变体数
+            
+            VariantCacheStats() : hits(0), misses(0), reusedMappers(0), variantCount(0) {}
         };
         
-        ShaderSystem();
+        // registry为空时创建自己的注册表；传入同一个注册表的多个实例共享已解析的文件和变体
+        explicit ShaderSystem(std::shared_ptr<ShaderRegistry> registry = nullptr);
         ~ShaderSystem();
         
-        // 初始化系统，自动查找shader路径
+        // 初始化系统：加载编译进库的shader
+        // 库未嵌入shader时（BRONCHOSCOPY_EMBED_SHADERS=OFF）才自动查找磁盘上的shaders目录
         bool Initialize();
         
-        // 应用shader组合到actor
+        // shader文件和变体缓存（线程安全，可在实例间共享）
+        // 更换注册表后，已应用的mapper在下次ApplyShader时换用新注册表的变体
+        std::shared_ptr<ShaderRegistry> GetRegistry() const;
+        void SetRegistry(std::shared_ptr<ShaderRegistry> registry);
+        
+        // 设置磁盘覆盖目录（结构同shaders/），其中存在的文件优先于编译进库的版本
+        // 传入空字符串关闭覆盖；已组合的变体会失效，下次应用时重新组合
+        bool SetShaderOverridePath(const std::string& path);
+        
+        // 库中是否编译了shader
+        bool HasEmbeddedShaders() const;
+        
+        // 应用shader变体到actor
+        // 视图和材质的替换在首次使用时合并为一个变体并缓存，之后在所有actor间共享；
+        // mapper已是该变体时不做任何修改，避免VTK重建shader程序
         bool ApplyShader(vtkActor* actor, const ShaderConfig& config);
         
         // 应用shader到mapper（更底层的接口）
         bool ApplyShaderToMapper(vtkOpenGLPolyDataMapper* mapper, 
                                  const ShaderConfig& config);
         
-        // 应用材质shader
+        // mapper当前是否已是该变体（此时ApplyShaderToMapper不会修改mapper）
+        bool HasVariant(vtkOpenGLPolyDataMapper* mapper, const ShaderConfig& config) const;
+        
+        // 获取变体缓存统计
+        VariantCacheStats GetVariantCacheStats() const;
+        
+        // actor当前shader变体的简短名称（如"endoscope+tissue+vignette"），
+        // 未应用变体时为空；用于按变体汇总渲染耗时
+        std::string GetShaderLabel(vtkActor* actor) const;
+        
+        // 运行时参数块：shader中声明为uniform的参数（如exposure、roughness）
+        // 在mapper的UpdateShaderEvent中上传给当前程序，每帧每个程序最多上传一次；
+        // 修改参数不重新组合变体，也不会触发shader重新编译
+        // 每帧参数对所有变体生效；材质参数只上传给使用该材质的mapper（同名时优先）
+        // 内置参数viewport（vec4：当前GL视口的原点和尺寸，像素）在上传时自动设置
+        ShaderParameters& GetFrameParameters();
+        ShaderParameters& GetMaterialParameters(MaterialShader material);
+        
+        // 渲染器每次开始渲染时开始新的一帧（参数重新上传）
+        // 未关联渲染器时参数只在修改或视口变化后上传
+        void AttachRenderer(vtkRenderer* renderer);
+        void DetachRenderer(vtkRenderer* renderer);
+        
+        // 单独叠加材质shader（会覆盖同标签的视图替换，建议改用ShaderConfig::material）
         bool ApplyMaterialShader(vtkActor* actor, MaterialShader material);
         bool ApplyMaterialShaderToMapper(vtkOpenGLPolyDataMapper* mapper, 
                                          MaterialShader material);
         
-        // 应用后处理到渲染器
+        // 应用后处理到渲染器：场景渲染到离屏纹理后经过全屏通道输出（见PostProcessor）
+        // 同一渲染器多次调用会追加不同的通道；POST_NONE移除该渲染器的全部后处理
         bool ApplyPostProcessing(vtkRenderer* renderer, PostShader postEffect);
         
-        // 重新加载所有shader（开发时热重载）
+        // 渲染器最近一帧的场景渲染和各后处理通道耗时（未启用后处理时为空）
+        std::vector<PostProcessor::PassTiming> GetPostProcessingTimings(vtkRenderer* renderer) const;
+        
+        // 重新读取所有已使用的shader文件，并更新已应用变体的mapper（之后需调用VerifyReload）
         bool ReloadAllShaders();
         
+        // 文件监视热重载（开发用，Linux inotify）
+        // 监视directory（为空时使用当前覆盖目录或查找shaders目录）并将其设为覆盖目录；
+        // 文件变化经防抖后在监视线程上只重新解析该文件，不阻塞渲染线程
+        bool StartHotReload(const std::string& directory = "");
+        void StopHotReload();
+        bool IsHotReloadActive() const;
+        
+        // 渲染线程调用：应用已解析好的变化文件，只重新组合使用这些文件的变体、
+        // 只更新使用这些变体的mapper，返回更新的mapper数
+        int ApplyPendingReloads();
+        
+        // 应用重载后渲染一帧再调用：若shader编译失败则报告错误并恢复上一个可用版本，
+        // 返回false时需再渲染一次
+        bool VerifyReload();
+        
         // 检查系统是否初始化
         bool IsInitialized() const;
         
-        // 获取shader根路径
+        // 获取磁盘shader根路径（未使用磁盘覆盖时为空）
         std::string GetShaderRootPath() const;
         
     private:
@@ -0,0 +1,44 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace BronchoscopyLib {
+
+    /**
+     * ShaderWatcher - 监视shader目录树中的.vert/.frag文件变化
+     * Linux上使用inotify，在独立的后台线程中等待事件；
+     * 同一文件的连续写入合并（防抖），静默debounceMs毫秒后才回调一次
+     * 其他平台上Start返回false
+     */
+    class ShaderWatcher {
+    public:
+        // 文件变化回调，在监视线程上调用，relativePath相对于监视根目录（如"view/endoscope.frag"）
+        typedef std::function<void(const std::string& relativePath)> ChangeCallback;
+
+        ShaderWatcher();
+
+        // 停止监视并等待后台线程退出
+        ~ShaderWatcher();
+
+        ShaderWatcher(const ShaderWatcher&) = delete;
+        ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+        // 开始监视rootPath及其子目录（已在监视时先停止）
+        bool Start(const std::string& rootPath, ChangeCallback callback, int debounceMs = 150);
+
+        // 停止监视
+        void Stop();
+
+        bool IsRunning() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // SHADER_WATCHER_H
@@ -0,0 +1,43 @@
+#ifndef SURFACE_EXTRACTOR_H
+#define SURFACE_EXTRACTOR_H
+
+#include <atomic>
+
+// 前向声明VTK类
+class vtkImageData;
+class vtkPolyData;
+
+namespace BronchoscopyLib {
+
+    class ThreadPool;
+
+    /**
+     * SurfaceExtractor - 由气道分割体数据直接生成表面网格
+     * 标签体素裁剪到包围盒后转为0/1场，可选高斯平滑后用移动立方体提取0.5等值面：
+     * 按z层并行，先统计每行的交点和三角形数，前缀和确定编号后再并行写出，
+     * 相邻立方体共享的边只生成一个顶点，输出即为焊接好的封闭网格（体数据边界处补零封口）
+     * 立方体的三角形表在首次使用时生成：面上的歧义一律按分开标签角点处理，相邻立方体一致，网格无裂缝；
+     * 交点环三角化时弦不落在立方体面上，每条边恰属于两个三角形，输出为方向一致的流形网格
+     * 之后可选Taubin平滑（不收缩，按顶点并行）和二次误差削减（vtkQuadricDecimation）
+     */
+    class SurfaceExtractor {
+    public:
+        struct Settings {
+            int label;                 // 气道的标签值，0为所有非零体素
+            double gaussianSigma;      // 提取前平滑0/1场的高斯标准差（体素），0为不平滑（顶点在体素边中点，呈台阶状）
+            int smoothingIterations;   // Taubin平滑次数（每次一对收缩/膨胀步），0为不平滑
+            double decimation;         // 三角形削减比例（0~1），0为不削减
+
+            Settings() : label(0), gaussianSigma(0.7), smoothingIterations(10), decimation(0.0) {}
+        };
+
+        // 提取标签的表面，写入output（点和三角形）；使用第一个标量分量，坐标为origin + 索引 * spacing
+        // 体数据无标量或没有该标签的体素时返回false，output不变；pool为空时串行执行
+        // cancelFlag在各阶段之间检查，被置位时返回false
+        static bool Extract(vtkImageData* volume, const Settings& settings, vtkPolyData* output,
+                            ThreadPool* pool = nullptr, const std::atomic<bool>* cancelFlag = nullptr);
+    };
+
+} // namespace BronchoscopyLib
+
+#endif // SURFACE_EXTRACTOR_H
@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace BronchoscopyLib {
+    
+    /**
+     * ThreadPool - 固定大小的工作线程池
+     * 用于模型预处理等耗时任务，避免阻塞UI/渲染线程
+     * 任务按提交顺序（FIFO）取出执行，不访问任何渲染对象
+     */
+    class ThreadPool {
+    public:
+        // threadCount为0时使用硬件并发数
+        explicit ThreadPool(unsigned int threadCount = 0);
+        
+        // 等待已提交的任务全部执行完毕后退出工作线程
+        ~ThreadPool();
+        
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        
+        // 提交任务（在某个工作线程上执行）
+        void Submit(std::function<void()> task);
+        
+        // 阻塞直到队列为空且没有正在执行的任务
+        void WaitIdle();
+        
+        // 将[0, count)按grain大小分块并行执行body(begin, end)，返回时全部完成
+        // 调用线程也参与执行，因此可以在本线程池的任务中嵌套调用而不会死锁
+        void ParallelFor(size_t count, size_t grain,
+                         const std::function<void(size_t begin, size_t end)>& body);
+        
+        // 工作线程数
+        unsigned int GetThreadCount() const;
+        
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+    
+} // namespace BronchoscopyLib
+
+#endif // THREAD_POOL_H
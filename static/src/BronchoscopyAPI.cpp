@@ -1,25 +1,67 @@
 #include "BronchoscopyAPI.h"
 #include "CameraController.h"
+#include "Centerline.h"
+#include "RoutePlanner.h"
+#include "DistanceField.h"
+#include "MeshBVH.h"
 #include "ModelManager.h"
 #include "PathVisualization.h"
 #include "RenderingEngine.h"
 #include "NavigationController.h"
 #include "SceneManager.h"
 #include "CameraPath.h"
+#include "ShaderSystem.h"
+#include "ThreadPool.h"
 
 // VTK headers
+#include <vtkActor.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <vtkPolyData.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <mutex>
 
 namespace BronchoscopyLib {
     
+    // Shared between the UI thread and the worker running one async load
+    struct AsyncLoadState {
+        std::atomic<bool> cancelled;
+        std::atomic<bool> finished;
+        bool success;  // written by the worker before finished is set
+        
+        // Latest progress, published by the worker
+        std::mutex progressMutex;
+        double progress;
+        std::string stage;
+        double reportedProgress;  // last value delivered to the callback (UI thread only)
+        
+        std::shared_ptr<PreparedModel> model;
+        BronchoscopyAPI::LoadProgressCallback progressCallback;
+        BronchoscopyAPI::LoadFinishedCallback finishedCallback;
+        
+        AsyncLoadState() : cancelled(false), finished(false), success(false),
+                           progress(0.0), reportedProgress(-1.0) {
+        }
+        
+        void SetProgress(double value, const std::string& stageName) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            progress = value;
+            stage = stageName;
+        }
+    };
+    
     class BronchoscopyAPI::Impl {
     public:
+        // Shader state of this instance; declared first so it outlives the actors using it
+        std::unique_ptr<ShaderSystem> shaderSystem;
+        
         // All modules
         std::unique_ptr<CameraController> cameraController;
         std::unique_ptr<ModelManager> modelManager;
@@ -28,14 +70,31 @@ namespace BronchoscopyLib {
         std::unique_ptr<NavigationController> navigationController;
         std::unique_ptr<SceneManager> sceneManager;
         
-        Impl() {
+        // Async loading (created on first use; a single thread, so loads run one at a time)
+        std::shared_ptr<AsyncLoadState> asyncLoad;
+        std::unique_ptr<ThreadPool> loaderPool;
+        
+        // Surface extraction settings for segmentation volumes
+        SurfaceExtractor::Settings volumeSurfaceSettings;
+        
+        // Route planning over the centerline (rebuilt when the model's centerline changes)
+        std::unique_ptr<RoutePlanner> routePlanner;
+        
+        bool fxaaEnabled;
+        
+        Impl() : fxaaEnabled(false) {
+            shaderSystem = std::make_unique<ShaderSystem>();
+            shaderSystem->Initialize();
+            
             // Create all modules
             cameraController = std::make_unique<CameraController>();
             modelManager = std::make_unique<ModelManager>();
+            modelManager->SetShaderSystem(shaderSystem.get());
             pathVisualization = std::make_unique<PathVisualization>();
             renderingEngine = std::make_unique<RenderingEngine>();
             navigationController = std::make_unique<NavigationController>();
             sceneManager = std::make_unique<SceneManager>();
+            routePlanner = std::make_unique<RoutePlanner>();
             
             // Set up SceneManager with all modules
             sceneManager->SetCameraController(cameraController.get());
@@ -43,11 +102,53 @@ namespace BronchoscopyLib {
             sceneManager->SetPathVisualization(pathVisualization.get());
             sceneManager->SetRenderingEngine(renderingEngine.get());
             sceneManager->SetNavigationController(navigationController.get());
+            
+            // Profiling labels actors by shader variant and picks up post-processing timings
+            ShaderSystem* shaders = shaderSystem.get();
+            renderingEngine->SetProfilingLabeler([shaders](vtkProp* prop) {
+                return shaders->GetShaderLabel(vtkActor::SafeDownCast(prop));
+            });
+            renderingEngine->SetProfilingPassSource([shaders](vtkRenderer* renderer) {
+                return shaders->GetPostProcessingTimings(renderer);
+            });
+        }
+        
+        ~Impl() {
+            // Stop the running load before the pool joins its workers
+            if (asyncLoad) {
+                asyncLoad->cancelled = true;
+            }
+            loaderPool.reset();
+            
+            // Remove the passes from our renderers while both are still alive
+            if (fxaaEnabled) {
+                shaderSystem->ApplyPostProcessing(renderingEngine->GetOverviewRenderer(), ShaderSystem::POST_NONE);
+                shaderSystem->ApplyPostProcessing(renderingEngine->GetEndoscopeRenderer(), ShaderSystem::POST_NONE);
+            }
         }
         
         void UpdateViews() {
             sceneManager->UpdateScene();
         }
+        
+        // Registers a new async load with a snapshot of the preprocessing settings;
+        // the caller cancels the previous load first and submits the worker
+        std::shared_ptr<AsyncLoadState> BeginAsyncLoad(const LoadProgressCallback& progress,
+                                                       const LoadFinishedCallback& finished) {
+            // One loader thread: a cancelled load still runs until its next cancellation check,
+            // and the next load queues behind it instead of holding a second mesh in memory.
+            // Parallel stages inside a load use the model manager's preprocessing pool.
+            if (!loaderPool) {
+                loaderPool = std::make_unique<ThreadPool>(1);
+            }
+            
+            std::shared_ptr<AsyncLoadState> state = std::make_shared<AsyncLoadState>();
+            state->model = modelManager->CreatePreparedModel();
+            state->progressCallback = progress;
+            state->finishedCallback = finished;
+            asyncLoad = state;
+            return state;
+        }
     };
     
     BronchoscopyAPI::BronchoscopyAPI() : pImpl(std::make_unique<Impl>()) {
@@ -62,14 +163,14 @@ namespace BronchoscopyLib {
         std::cout << "BronchoscopyAPI initialized" << std::endl;
     }
     
-    bool BronchoscopyAPI::LoadAirwayModel(vtkPolyData* polyData) {
+    bool BronchoscopyAPI::LoadAirwayModel(vtkPolyData* polyData, bool adopt) {
         if (!polyData) {
             std::cerr << "BronchoscopyAPI: Invalid model data" << std::endl;
             return false;
         }
         
         // Load model through SceneManager
-        bool success = pImpl->sceneManager->OnModelLoaded(polyData);
+        bool success = pImpl->sceneManager->OnModelLoaded(polyData, adopt);
         
         if (success) {
             // Render
@@ -79,6 +180,232 @@ namespace BronchoscopyLib {
         return success;
     }
     
+    void BronchoscopyAPI::SetVertexCacheOptimization(bool enable) {
+        pImpl->modelManager->SetVertexCacheOptimization(enable);
+        
+        if (pImpl->modelManager->HasModel()) {
+            Render();
+        }
+    }
+    
+    bool BronchoscopyAPI::GetVertexCacheStats(double& acmrBefore, double& acmrAfter) const {
+        return pImpl->modelManager->GetVertexCacheStats(acmrBefore, acmrAfter);
+    }
+    
+    void BronchoscopyAPI::SetCompactMode(bool enable) {
+        pImpl->modelManager->SetCompactMode(enable);
+        
+        if (pImpl->modelManager->HasModel()) {
+            Render();
+        }
+    }
+    
+    void BronchoscopyAPI::GetModelMemoryUsage(std::vector<std::string>& stages, 
+                                              std::vector<size_t>& bytes) const {
+        stages.clear();
+        bytes.clear();
+        
+        for (const auto& entry : pImpl->modelManager->GetMemoryUsage()) {
+            stages.push_back(entry.stage);
+            bytes.push_back(entry.bytes);
+        }
+    }
+    
+    void BronchoscopyAPI::GetShaderCacheStats(unsigned long& hits, unsigned long& misses,
+                                              unsigned long& reused) const {
+        pImpl->modelManager->GetShaderCacheStats(hits, misses, reused);
+    }
+    
+    void BronchoscopyAPI::ShareShaderCache(const BronchoscopyAPI& other) {
+        if (&other == this) {
+            return;
+        }
+        pImpl->shaderSystem->SetRegistry(other.pImpl->shaderSystem->GetRegistry());
+    }
+    
+    bool BronchoscopyAPI::EnableShaderHotReload(const std::string& directory) {
+        return pImpl->modelManager->GetShaderSystem().StartHotReload(directory);
+    }
+    
+    void BronchoscopyAPI::DisableShaderHotReload() {
+        pImpl->modelManager->GetShaderSystem().StopHotReload();
+    }
+    
+    int BronchoscopyAPI::ProcessShaderHotReload() {
+        ShaderSystem& shaderSystem = pImpl->modelManager->GetShaderSystem();
+        
+        int updatedMappers = shaderSystem.ApplyPendingReloads();
+        if (updatedMappers > 0) {
+            // 渲染一帧触发编译，失败时恢复上一个可用版本后重新渲染
+            Render();
+            if (!shaderSystem.VerifyReload()) {
+                Render();
+            }
+        }
+        return updatedMappers;
+    }
+    
+    bool BronchoscopyAPI::LoadAirwayModelAsync(ModelReader reader,
+                                               LoadProgressCallback progress,
+                                               LoadFinishedCallback finished) {
+        if (!reader) {
+            std::cerr << "BronchoscopyAPI: Invalid model reader" << std::endl;
+            return false;
+        }
+        
+        CancelAsyncLoad();
+        std::shared_ptr<AsyncLoadState> state = pImpl->BeginAsyncLoad(progress, finished);
+        
+        // Share of the overall progress taken by the host reader
+        const double readShare = 0.3;
+        
+        pImpl->loaderPool->Submit([state, reader, readShare]() {
+            state->SetProgress(0.0, "reading");
+            
+            vtkSmartPointer<vtkPolyData> source = vtkSmartPointer<vtkPolyData>::New();
+            bool ok = reader(source) && !state->cancelled;
+            
+            if (ok) {
+                ok = ModelManager::PrepareModel(*state->model, source, true,
+                    [state, readShare](double value, const char* stage) {
+                        state->SetProgress(readShare + (1.0 - readShare) * value, stage);
+                    },
+                    &state->cancelled);
+            }
+            
+            state->success = ok && !state->cancelled;
+            state->finished = true;
+        });
+        
+        std::cout << "BronchoscopyAPI: Async model load started" << std::endl;
+        return true;
+    }
+    
+    void BronchoscopyAPI::SetVolumeSurfaceSettings(int label, double gaussianSigma,
+                                                   int smoothingIterations, double decimation) {
+        SurfaceExtractor::Settings& settings = pImpl->volumeSurfaceSettings;
+        settings.label = label;
+        settings.gaussianSigma = std::max(0.0, gaussianSigma);
+        settings.smoothingIterations = std::max(0, smoothingIterations);
+        settings.decimation = std::min(std::max(decimation, 0.0), 0.99);
+    }
+    
+    bool BronchoscopyAPI::LoadAirwayVolume(vtkImageData* volume) {
+        if (!volume) {
+            std::cerr << "BronchoscopyAPI: Invalid volume (null)" << std::endl;
+            return false;
+        }
+        
+        std::shared_ptr<PreparedModel> model = pImpl->modelManager->CreatePreparedModel();
+        if (!ModelManager::PrepareModelFromVolume(*model, volume, pImpl->volumeSurfaceSettings) ||
+            !pImpl->sceneManager->OnModelPrepared(model)) {
+            std::cerr << "BronchoscopyAPI: Failed to load airway volume" << std::endl;
+            return false;
+        }
+        
+        Render();
+        return true;
+    }
+    
+    bool BronchoscopyAPI::LoadAirwayVolumeAsync(VolumeReader reader,
+                                                LoadProgressCallback progress,
+                                                LoadFinishedCallback finished) {
+        if (!reader) {
+            std::cerr << "BronchoscopyAPI: Invalid volume reader" << std::endl;
+            return false;
+        }
+        
+        CancelAsyncLoad();
+        std::shared_ptr<AsyncLoadState> state = pImpl->BeginAsyncLoad(progress, finished);
+        const SurfaceExtractor::Settings settings = pImpl->volumeSurfaceSettings;
+        
+        // Volumes take longer to read than meshes relative to the rest of the work
+        const double readShare = 0.2;
+        
+        pImpl->loaderPool->Submit([state, reader, settings, readShare]() {
+            state->SetProgress(0.0, "reading");
+            
+            vtkSmartPointer<vtkImageData> volume = vtkSmartPointer<vtkImageData>::New();
+            bool ok = reader(volume) && !state->cancelled;
+            
+            if (ok) {
+                ok = ModelManager::PrepareModelFromVolume(*state->model, volume, settings,
+                    [state, readShare](double value, const char* stage) {
+                        state->SetProgress(readShare + (1.0 - readShare) * value, stage);
+                    },
+                    &state->cancelled);
+            }
+            
+            state->success = ok && !state->cancelled;
+            state->finished = true;
+        });
+        
+        std::cout << "BronchoscopyAPI: Async volume load started" << std::endl;
+        return true;
+    }
+    
+    void BronchoscopyAPI::CancelAsyncLoad() {
+        std::shared_ptr<AsyncLoadState> state = pImpl->asyncLoad;
+        if (!state) return;
+        
+        // The worker notices the flag at the next filter progress event and
+        // its result is discarded; the finished callback reports failure
+        state->cancelled = true;
+        pImpl->asyncLoad.reset();
+        
+        if (state->finishedCallback) {
+            state->finishedCallback(false);
+        }
+        
+        std::cout << "BronchoscopyAPI: Async model load cancelled" << std::endl;
+    }
+    
+    bool BronchoscopyAPI::IsAsyncLoadPending() const {
+        return pImpl->asyncLoad != nullptr;
+    }
+    
+    void BronchoscopyAPI::ProcessAsyncLoad() {
+        // Visibility sets built in the background are swapped in on the same pump
+        if (pImpl->sceneManager->ProcessPathVisibility()) {
+            Render();
+        }
+        
+        std::shared_ptr<AsyncLoadState> state = pImpl->asyncLoad;
+        if (!state) return;
+        
+        // Deliver progress on the calling thread
+        if (state->progressCallback) {
+            double value;
+            std::string stage;
+            {
+                std::lock_guard<std::mutex> lock(state->progressMutex);
+                value = state->progress;
+                stage = state->stage;
+            }
+            if (value != state->reportedProgress) {
+                state->reportedProgress = value;
+                state->progressCallback(value, stage);
+            }
+        }
+        
+        if (!state->finished) return;
+        
+        pImpl->asyncLoad.reset();
+        
+        // Swap in the finished geometry in one step on the render thread
+        bool success = state->success && pImpl->sceneManager->OnModelPrepared(state->model);
+        if (success) {
+            Render();
+        }
+        
+        std::cout << "BronchoscopyAPI: Async model load " 
+                 << (success ? "finished" : "failed") << std::endl;
+        
+        if (state->finishedCallback) {
+            state->finishedCallback(success);
+        }
+    }
+    
     bool BronchoscopyAPI::LoadCameraPath(const std::vector<double>& positions) {
         if (positions.empty()) {
             std::cerr << "BronchoscopyAPI: Empty path data" << std::endl;
@@ -209,6 +536,27 @@ namespace BronchoscopyLib {
         Render();
     }
     
+    void BronchoscopyAPI::SetModelSmoothingAngle(double degrees) {
+        pImpl->modelManager->SetSmoothingAngle(degrees);
+        
+        if (pImpl->modelManager->HasModel()) {
+            Render();
+        }
+    }
+    
+    void BronchoscopyAPI::SetVisibilityCulling(bool enable) {
+        pImpl->sceneManager->SetVisibilityCulling(enable);
+        Render();
+    }
+    
+    bool BronchoscopyAPI::GetVisibilityCulling() const {
+        return pImpl->sceneManager->GetVisibilityCulling();
+    }
+    
+    double BronchoscopyAPI::GetEndoscopeVisibleFraction() const {
+        return pImpl->sceneManager->GetEndoscopeVisibleFraction();
+    }
+    
     void BronchoscopyAPI::ResetCameras() {
         pImpl->sceneManager->ResetCameras();
     }
@@ -225,6 +573,177 @@ namespace BronchoscopyLib {
         return pImpl->sceneManager->HasPath();
     }
     
+    bool BronchoscopyAPI::CastRay(const double origin[3], const double direction[3], double hitPoint[3],
+                                  double& distance, double maxDistance) const {
+        std::shared_ptr<const MeshBVH> bvh = pImpl->modelManager->GetBVH();
+        if (!bvh) {
+            return false;
+        }
+        
+        MeshBVH::Ray ray;
+        for (int i = 0; i < 3; i++) {
+            ray.origin[i] = origin[i];
+            ray.direction[i] = direction[i];
+        }
+        ray.maxDistance = maxDistance;
+        
+        MeshBVH::Hit hit;
+        if (!bvh->Intersect(ray, hit)) {
+            return false;
+        }
+        for (int i = 0; i < 3; i++) {
+            hitPoint[i] = hit.point[i];
+        }
+        distance = hit.distance;
+        return true;
+    }
+    
+    bool BronchoscopyAPI::GetClosestSurfacePoint(const double point[3], double closest[3], double& distance) const {
+        std::shared_ptr<const MeshBVH> bvh = pImpl->modelManager->GetBVH();
+        MeshBVH::Hit hit;
+        if (!bvh || !bvh->FindClosestPoint(point, 0.0, hit)) {
+            return false;
+        }
+        for (int i = 0; i < 3; i++) {
+            closest[i] = hit.point[i];
+        }
+        distance = hit.distance;
+        return true;
+    }
+    
+    bool BronchoscopyAPI::GetLumenRadius(int index, double& minRadius, double& maxRadius, double& meanRadius) const {
+        CameraPath* path = pImpl->pathVisualization->GetCameraPath();
+        if (!path) {
+            return false;
+        }
+        if (index < 0) {
+            index = pImpl->navigationController->GetCurrentIndex();
+        }
+        
+        LumenRadius radius;
+        if (!path->GetLumenRadius(index, radius)) {
+            return false;
+        }
+        minRadius = radius.minimum;
+        maxRadius = radius.maximum;
+        meanRadius = radius.mean;
+        return true;
+    }
+    
+    void BronchoscopyAPI::SetDistanceField(bool enable, double voxelSize, double bandWidth) {
+        pImpl->modelManager->SetDistanceField(enable, voxelSize, bandWidth);
+        pImpl->sceneManager->OnDerivedDataChanged();
+    }
+    
+    void BronchoscopyAPI::SetLumenConstraint(bool enable, double clearance) {
+        pImpl->cameraController->SetLumenConstraint(enable, clearance);
+        
+        // The constraint samples the distance field; build it if nothing else asked for it
+        if (enable && !pImpl->modelManager->GetDistanceFieldEnabled()) {
+            SetDistanceField(true);
+        }
+    }
+    
+    bool BronchoscopyAPI::GetWallDistance(const double point[3], double& distance, double gradient[3]) const {
+        std::shared_ptr<const DistanceField> field = pImpl->modelManager->GetDistanceField();
+        if (!field) {
+            return false;
+        }
+        
+        if (gradient) {
+            distance = field->SampleGradient(point, gradient);
+        } else {
+            distance = field->Sample(point);
+        }
+        return true;
+    }
+    
+    void BronchoscopyAPI::SetCenterlineExtraction(bool enable) {
+        pImpl->modelManager->SetCenterlineExtraction(enable);
+        pImpl->sceneManager->OnDerivedDataChanged();
+    }
+    
+    int BronchoscopyAPI::GetCenterlineBranchCount() const {
+        std::shared_ptr<const Centerline> centerline = pImpl->modelManager->GetCenterline();
+        return centerline ? centerline->GetBranchCount() : 0;
+    }
+    
+    bool BronchoscopyAPI::GetCenterlineBranch(int index, std::vector<double>& points, std::vector<double>& radii,
+                                              int& parent) const {
+        std::shared_ptr<const Centerline> centerline = pImpl->modelManager->GetCenterline();
+        if (!centerline || index < 0 || index >= centerline->GetBranchCount()) {
+            return false;
+        }
+        
+        const Centerline::Branch& branch = centerline->GetBranch(index);
+        points = branch.points;
+        radii = branch.radii;
+        parent = branch.parent;
+        return true;
+    }
+    
+    bool BronchoscopyAPI::GetCenterlinePath(int branch, std::vector<double>& positions) const {
+        std::shared_ptr<const Centerline> centerline = pImpl->modelManager->GetCenterline();
+        if (!centerline) {
+            return false;
+        }
+        if (branch < 0) {
+            branch = centerline->GetFarthestLeafBranch();
+        }
+        return centerline->GetPathToBranch(branch, positions);
+    }
+    
+    bool BronchoscopyAPI::LoadCenterlinePath(int branch) {
+        std::vector<double> positions;
+        if (!GetCenterlinePath(branch, positions)) {
+            std::cerr << "BronchoscopyAPI: No centerline for branch " << branch << std::endl;
+            return false;
+        }
+        return LoadCameraPath(positions);
+    }
+    
+    void BronchoscopyAPI::SetScopeRadius(double radius) {
+        pImpl->routePlanner->SetMinRadius(radius);
+    }
+    
+    double BronchoscopyAPI::GetScopeRadius() const {
+        return pImpl->routePlanner->GetMinRadius();
+    }
+    
+    bool BronchoscopyAPI::GetRouteToTarget(const double target[3], std::vector<double>& positions,
+                                           double& targetDistance) const {
+        std::shared_ptr<const Centerline> centerline = pImpl->modelManager->GetCenterline();
+        if (!centerline) {
+            return false;
+        }
+        if (pImpl->routePlanner->GetCenterline() != centerline) {
+            pImpl->routePlanner->Build(centerline);
+        }
+        
+        RoutePlanner::Route route;
+        if (!pImpl->routePlanner->PlanRoute(target, route)) {
+            return false;
+        }
+        positions.swap(route.positions);
+        targetDistance = route.targetDistance;
+        return true;
+    }
+    
+    bool BronchoscopyAPI::LoadRouteToTarget(const double target[3]) {
+        std::vector<double> positions;
+        double targetDistance = 0.0;
+        if (!GetRouteToTarget(target, positions, targetDistance)) {
+            std::cerr << "BronchoscopyAPI: No route to target (" << target[0] << ", " << target[1]
+                     << ", " << target[2] << ")" << std::endl;
+            return false;
+        }
+        return LoadCameraPath(positions);
+    }
+    
+    void BronchoscopyAPI::SetModelCache(ModelCacheLoader load, ModelCacheStore store) {
+        pImpl->modelManager->SetCache(load, store);
+    }
+    
     // 新增：自动播放控制
     void BronchoscopyAPI::StartAutoPlay(int intervalMs) {
         pImpl->navigationController->StartAutoPlay(intervalMs);
@@ -262,6 +781,39 @@ namespace BronchoscopyLib {
         return pImpl->navigationController->GetLoopMode();
     }
     
+    bool BronchoscopyAPI::MoveToNextBifurcation() {
+        if (!pImpl->navigationController->MoveToNextBifurcation()) {
+            return false;
+        }
+        
+        PathNode* targetNode = pImpl->navigationController->GetCurrentNode();
+        if (targetNode) {
+            pImpl->cameraController->StartTransition(targetNode);
+        }
+        pImpl->UpdateViews();
+        return true;
+    }
+    
+    bool BronchoscopyAPI::GetNodeBranch(int index, int& branch, int& generation,
+                                        double& distanceToBifurcation) const {
+        CameraPath* path = pImpl->pathVisualization->GetCameraPath();
+        if (!path) {
+            return false;
+        }
+        if (index < 0) {
+            index = pImpl->navigationController->GetCurrentIndex();
+        }
+        
+        NodeTopology topology;
+        if (!path->GetNodeTopology(index, topology)) {
+            return false;
+        }
+        branch = topology.branch;
+        generation = topology.generation;
+        distanceToBifurcation = topology.nextBifurcation >= 0 ? topology.distanceToBifurcation : -1.0;
+        return true;
+    }
+    
     // 新增：进度控制
     bool BronchoscopyAPI::MoveToPosition(int index) {
         bool result = pImpl->navigationController->MoveToPosition(index);
@@ -285,10 +837,12 @@ namespace BronchoscopyLib {
     
     // 新增：场景管理
     void BronchoscopyAPI::ClearScene() {
+        CancelAsyncLoad();
         pImpl->sceneManager->ClearScene();
     }
     
     void BronchoscopyAPI::ClearModel() {
+        CancelAsyncLoad();
         pImpl->sceneManager->ClearModel();
     }
     
@@ -311,14 +865,165 @@ namespace BronchoscopyLib {
         Render();
     }
     
+    void BronchoscopyAPI::SetFXAA(bool enable) {
+        ShaderSystem& shaderSystem = pImpl->modelManager->GetShaderSystem();
+        ShaderSystem::PostShader effect = enable ? ShaderSystem::POST_FXAA : ShaderSystem::POST_NONE;
+        
+        shaderSystem.ApplyPostProcessing(pImpl->renderingEngine->GetOverviewRenderer(), effect);
+        shaderSystem.ApplyPostProcessing(pImpl->renderingEngine->GetEndoscopeRenderer(), effect);
+        pImpl->fxaaEnabled = enable;
+        
+        Render();
+    }
+    
+    bool BronchoscopyAPI::GetFXAA() const {
+        return pImpl->fxaaEnabled;
+    }
+    
+    void BronchoscopyAPI::GetPostProcessingTimings(std::vector<std::string>& passes,
+                                                   std::vector<double>& cpuMs,
+                                                   std::vector<double>& gpuMs) const {
+        passes.clear();
+        cpuMs.clear();
+        gpuMs.clear();
+        
+        ShaderSystem& shaderSystem = pImpl->modelManager->GetShaderSystem();
+        const std::pair<const char*, vtkRenderer*> views[2] = {
+            std::make_pair("overview/", pImpl->renderingEngine->GetOverviewRenderer()),
+            std::make_pair("endoscope/", pImpl->renderingEngine->GetEndoscopeRenderer())
+        };
+        
+        for (const auto& view : views) {
+            for (const auto& timing : shaderSystem.GetPostProcessingTimings(view.second)) {
+                passes.push_back(view.first + timing.name);
+                cpuMs.push_back(timing.cpuMs);
+                gpuMs.push_back(timing.gpuMs);
+            }
+        }
+    }
+    
+    void BronchoscopyAPI::SetTransparencyMode(TransparencyMode mode) {
+        pImpl->renderingEngine->SetTransparencyMode(static_cast<RenderingEngine::TransparencyMode>(mode));
+        Render();
+    }
+    
+    BronchoscopyAPI::TransparencyMode BronchoscopyAPI::GetTransparencyMode() const {
+        return static_cast<TransparencyMode>(pImpl->renderingEngine->GetTransparencyMode());
+    }
+    
+    void BronchoscopyAPI::SetDepthPeelingBudget(int maxPeels, double occlusionRatio) {
+        pImpl->renderingEngine->SetDepthPeelingBudget(maxPeels, occlusionRatio);
+        if (GetTransparencyMode() == TRANSPARENCY_DEPTH_PEELING) {
+            Render();
+        }
+    }
+    
+    void BronchoscopyAPI::SetDynamicResolution(bool enable, double targetFrameMs, double minScale) {
+        pImpl->renderingEngine->SetDynamicResolutionTarget(targetFrameMs, minScale);
+        pImpl->renderingEngine->SetDynamicResolution(enable);
+    }
+    
+    bool BronchoscopyAPI::GetDynamicResolution() const {
+        return pImpl->renderingEngine->IsDynamicResolutionEnabled();
+    }
+    
+    double BronchoscopyAPI::GetDynamicResolutionScale() const {
+        return pImpl->renderingEngine->GetEndoscopeResolutionScale();
+    }
+    
+    bool BronchoscopyAPI::GetTransparencyFrameTime(TransparencyMode mode, double& cpuMs, double& gpuMs) const {
+        std::string series = std::string("overview/transparency/") + RenderingEngine::GetTransparencyModeName(
+            static_cast<RenderingEngine::TransparencyMode>(mode));
+        
+        RenderStats::Summary summary;
+        if (!pImpl->renderingEngine->GetRenderStats()->GetSummary(series, summary)) {
+            cpuMs = -1.0;
+            gpuMs = -1.0;
+            return false;
+        }
+        cpuMs = summary.cpuMean;
+        gpuMs = summary.gpuMean;
+        return true;
+    }
+    
+    void BronchoscopyAPI::SetRenderProfiling(bool enable) {
+        pImpl->renderingEngine->SetProfilingEnabled(enable);
+    }
+    
+    bool BronchoscopyAPI::GetRenderProfiling() const {
+        return pImpl->renderingEngine->IsProfilingEnabled();
+    }
+    
+    void BronchoscopyAPI::SetRenderProfileWindow(size_t frames) {
+        pImpl->renderingEngine->GetRenderStats()->SetCapacity(frames);
+    }
+    
+    void BronchoscopyAPI::GetRenderProfile(std::vector<std::string>& series,
+                                           std::vector<double>& cpuMeanMs, std::vector<double>& cpuP95Ms,
+                                           std::vector<double>& gpuMeanMs, std::vector<double>& gpuP95Ms) const {
+        series.clear();
+        cpuMeanMs.clear();
+        cpuP95Ms.clear();
+        gpuMeanMs.clear();
+        gpuP95Ms.clear();
+        
+        for (const auto& summary : pImpl->renderingEngine->GetRenderStats()->GetSummaries()) {
+            series.push_back(summary.name);
+            cpuMeanMs.push_back(summary.cpuMean);
+            cpuP95Ms.push_back(summary.cpuP95);
+            gpuMeanMs.push_back(summary.gpuMean);
+            gpuP95Ms.push_back(summary.gpuP95);
+        }
+    }
+    
+    void BronchoscopyAPI::ResetRenderProfile() {
+        pImpl->renderingEngine->GetRenderStats()->Clear();
+    }
+    
+    void BronchoscopyAPI::SetEndoscopeImaging(double exposure, double contrast, double vignette) {
+        ShaderParameters& parameters = pImpl->modelManager->GetShaderSystem().GetFrameParameters();
+        parameters.SetFloat("exposure", static_cast<float>(exposure));
+        parameters.SetFloat("contrast", static_cast<float>(contrast));
+        parameters.SetFloat("vignette", static_cast<float>(vignette));
+        
+        Render();
+    }
+    
+    void BronchoscopyAPI::SetTissueMaterial(double roughness, double metallic, 
+                                            double subsurface, double clearcoat) {
+        ShaderParameters& parameters = pImpl->modelManager->GetShaderSystem()
+            .GetMaterialParameters(ShaderSystem::MATERIAL_TISSUE);
+        parameters.SetFloat("roughness", static_cast<float>(roughness));
+        parameters.SetFloat("metallic", static_cast<float>(metallic));
+        parameters.SetFloat("subsurface", static_cast<float>(subsurface));
+        parameters.SetFloat("clearcoat", static_cast<float>(clearcoat));
+        
+        Render();
+    }
+    
+    void BronchoscopyAPI::SetShaderParameter(const std::string& name, double value) {
+        if (name.empty()) return;
+        
+        pImpl->modelManager->GetShaderSystem().GetFrameParameters()
+            .SetFloat(name, static_cast<float>(value));
+        
+        Render();
+    }
+    
     // Animation control
     bool BronchoscopyAPI::UpdateAnimation() {
         // 更新相机动画过渡
         bool isAnimating = pImpl->cameraController->UpdateTransition();
         
+        // Only an active camera transition drives dynamic resolution (a paused or idle autoplay
+        // must not keep the view degraded); once it stops, redraw at full resolution
+        bool stopped = pImpl->renderingEngine->SetEndoscopeMoving(isAnimating);
+        
         // 如果正在动画，更新场景
         if (isAnimating) {
             pImpl->UpdateViews();
+        } else if (stopped) {
+            pImpl->renderingEngine->RenderEndoscope();
         }
         
         return isAnimating;
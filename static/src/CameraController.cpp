@@ -1,5 +1,6 @@
 #include "CameraController.h"
 #include "CameraPath.h"
+#include "DistanceField.h"
 
 // VTK头文件
 #include <vtkSmartPointer.h>
@@ -18,6 +19,13 @@
 
 namespace BronchoscopyLib {
     
+    namespace {
+        
+        // 推回管腔的牛顿迭代次数上限（管腔比2倍间隙还窄时不收敛，取离壁最远的位置）
+        const int MaxClampIterations = 4;
+        
+    } // namespace
+    
     class CameraController::Impl {
     public:
         // 相机对象
@@ -40,15 +48,45 @@ namespace BronchoscopyLib {
         PathNode transitionTargetNode;  // 动画目标状态
         std::chrono::steady_clock::time_point transitionStartTime;
         
+        // 管腔约束
+        std::shared_ptr<const DistanceField> lumenField;
+        bool lumenConstraint;
+        double lumenClearance;
+        
         Impl() : overviewRenderer(nullptr), endoscopeRenderer(nullptr), 
                  endoscopeFOV(60.0),
-                 isTransitioning(false), transitionProgress(0.0), transitionDuration(0.5) {
+                 isTransitioning(false), transitionProgress(0.0), transitionDuration(0.5),
+                 lumenConstraint(false), lumenClearance(DefaultLumenClearance) {
             // 默认向上方向
             endoscopeViewUp[0] = 0.0;
             endoscopeViewUp[1] = 1.0;
             endoscopeViewUp[2] = 0.0;
         }
         
+        // 离壁距离小于间隙时沿梯度做牛顿迭代：d(p + s*g/|g|) ≈ d + s*|g|
+        void ClampToLumen(double position[3]) const {
+            if (!lumenConstraint || !lumenField) return;
+            
+            double point[3] = { position[0], position[1], position[2] };
+            double bestDistance = 0.0;
+            for (int iteration = 0; iteration < MaxClampIterations; iteration++) {
+                double gradient[3];
+                double distance = lumenField->SampleGradient(point, gradient);
+                if (iteration == 0 || distance > bestDistance) {
+                    bestDistance = distance;
+                    for (int i = 0; i < 3; i++) position[i] = point[i];
+                }
+                if (distance >= lumenClearance) break;
+                
+                // 窄带外梯度为0，无法判断管腔方向
+                double length2 = vtkMath::Dot(gradient, gradient);
+                if (length2 < 1e-12) break;
+                
+                double step = (lumenClearance - distance) / length2;
+                for (int i = 0; i < 3; i++) point[i] += gradient[i] * step;
+            }
+        }
+        
         // 缓动函数：平滑的加速和减速
         double EaseInOutCubic(double t) {
             if (t < 0.5) {
@@ -261,6 +299,10 @@ namespace BronchoscopyLib {
         }
     }
     
+    double CameraController::GetEndoscopeFOV() const {
+        return pImpl->endoscopeFOV;
+    }
+    
     void CameraController::SetEndoscopeViewUp(double x, double y, double z) {
         pImpl->endoscopeViewUp[0] = x;
         pImpl->endoscopeViewUp[1] = y;
@@ -362,6 +404,9 @@ namespace BronchoscopyLib {
                            easedProgress, 
                            interpolatedDir);
         
+        // 管腔约束
+        pImpl->ClampToLumen(interpolatedPos);
+        
         // 更新相机
         UpdateEndoscopeCamera(interpolatedPos, interpolatedDir);
         
@@ -378,6 +423,23 @@ namespace BronchoscopyLib {
         return pImpl->isTransitioning;
     }
     
+    void CameraController::SetLumenField(std::shared_ptr<const DistanceField> field) {
+        pImpl->lumenField = field;
+    }
+    
+    void CameraController::SetLumenConstraint(bool enable, double clearance) {
+        pImpl->lumenConstraint = enable;
+        pImpl->lumenClearance = std::max(clearance, 0.0);
+    }
+    
+    bool CameraController::GetLumenConstraint() const {
+        return pImpl->lumenConstraint;
+    }
+    
+    double CameraController::GetLumenClearance() const {
+        return pImpl->lumenClearance;
+    }
+    
     void CameraController::GetCurrentEndoscopeState(PathNode* state) const {
         if (!state || !pImpl->endoscopeCamera) return;
         
@@ -1,6 +1,12 @@
 #include "CameraPath.h"
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+#include "Centerline.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 // VTK头文件
 #include <vtkSmartPointer.h>
@@ -14,8 +20,15 @@
 
 namespace BronchoscopyLib {
 
+    namespace {
+
+        // 分支标注中短于此节点数、两侧为同一分支的跳变视为抖动
+        const int MinBranchRunNodes = 3;
+
+    } // namespace
+
     CameraPath::CameraPath() 
-        : head(nullptr), tail(nullptr), current(nullptr), nodeCount(0) {
+        : head(nullptr), tail(nullptr), current(nullptr), nodeCount(0), currentIndex(-1) {
     }
 
     CameraPath::~CameraPath() {
@@ -31,6 +44,10 @@ namespace BronchoscopyLib {
         }
         head = tail = current = nullptr;
         nodeCount = 0;
+        currentIndex = -1;
+        nodeTable.clear();
+        lumenProfile.clear();
+        topology.clear();
     }
 
     void CameraPath::AddPoint(double x, double y, double z, 
@@ -55,6 +72,7 @@ namespace BronchoscopyLib {
         // 更新链表
         if (head == nullptr) {
             head = tail = current = newNode;
+            currentIndex = 0;
         } else {
             tail->next = newNode;
             newNode->prev = tail;
@@ -62,11 +80,15 @@ namespace BronchoscopyLib {
         }
         
         nodeCount++;
+        nodeTable.push_back(newNode);
+        lumenProfile.clear();
+        topology.clear();
     }
 
     bool CameraPath::MoveNext() {
         if (current != nullptr && current->next != nullptr) {
             current = current->next;
+            currentIndex++;
             return true;
         }
         return false;
@@ -75,6 +97,7 @@ namespace BronchoscopyLib {
     bool CameraPath::MovePrevious() {
         if (current != nullptr && current->prev != nullptr) {
             current = current->prev;
+            currentIndex--;
             return true;
         }
         return false;
@@ -82,6 +105,7 @@ namespace BronchoscopyLib {
 
     void CameraPath::Reset() {
         current = head;
+        currentIndex = head ? 0 : -1;
     }
 
     bool CameraPath::JumpTo(int index) {
@@ -89,25 +113,13 @@ namespace BronchoscopyLib {
             return false;
         }
         
-        current = head;
-        for (int i = 0; i < index && current != nullptr; i++) {
-            current = current->next;
-        }
-        
-        return current != nullptr;
+        current = nodeTable[index];
+        currentIndex = index;
+        return true;
     }
 
     int CameraPath::GetCurrentIndex() const {
-        if (current == nullptr) return -1;
-        
-        int index = 0;
-        PathNode* node = head;
-        while (node != nullptr && node != current) {
-            node = node->next;
-            index++;
-        }
-        
-        return index;
+        return currentIndex;
     }
 
     bool CameraPath::IsAtEnd() const {
@@ -263,6 +275,204 @@ namespace BronchoscopyLib {
         }
     }
 
+    bool CameraPath::ComputeLumenProfile(const MeshBVH& bvh, int rayCount, ThreadPool* pool) {
+        lumenProfile.clear();
+        if (nodeCount == 0 || bvh.IsEmpty() || rayCount < 3) {
+            return false;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        // 每个节点一圈射线：在垂直于节点方向的平面内均匀分布
+        std::vector<MeshBVH::Ray> rays(static_cast<size_t>(nodeCount) * rayCount);
+        size_t ray = 0;
+        for (PathNode* node = head; node != nullptr; node = node->next) {
+            // 方向为零（重合的相邻节点）时任取一个平面
+            static const double fallback[3] = { 0.0, 0.0, 1.0 };
+            const double* d = node->direction;
+            if (d[0] == 0.0 && d[1] == 0.0 && d[2] == 0.0) {
+                d = fallback;
+            }
+            double helper[3] = { 1.0, 0.0, 0.0 };
+            if (std::abs(d[0]) > 0.9) {
+                helper[0] = 0.0;
+                helper[1] = 1.0;
+            }
+            double u[3] = { d[1] * helper[2] - d[2] * helper[1],
+                            d[2] * helper[0] - d[0] * helper[2],
+                            d[0] * helper[1] - d[1] * helper[0] };
+            NormalizeVector(u);
+            double w[3] = { d[1] * u[2] - d[2] * u[1],
+                            d[2] * u[0] - d[0] * u[2],
+                            d[0] * u[1] - d[1] * u[0] };
+            
+            for (int k = 0; k < rayCount; k++, ray++) {
+                double angle = 2.0 * 3.14159265358979323846 * k / rayCount;
+                double c = std::cos(angle), s = std::sin(angle);
+                for (int i = 0; i < 3; i++) {
+                    rays[ray].origin[i] = node->position[i];
+                    rays[ray].direction[i] = c * u[i] + s * w[i];
+                }
+            }
+        }
+        
+        std::vector<MeshBVH::Hit> hits;
+        bvh.IntersectBatch(rays, hits, pool);
+        
+        lumenProfile.resize(nodeCount);
+        int missingNodes = 0;
+        for (int index = 0; index < nodeCount; index++) {
+            float minimum = 0.0f, maximum = 0.0f;
+            double sum = 0.0;
+            int count = 0;
+            for (int k = 0; k < rayCount; k++) {
+                const MeshBVH::Hit& hit = hits[static_cast<size_t>(index) * rayCount + k];
+                if (!hit.hit) continue;
+                
+                float distance = static_cast<float>(hit.distance);
+                minimum = count == 0 ? distance : std::min(minimum, distance);
+                maximum = count == 0 ? distance : std::max(maximum, distance);
+                sum += distance;
+                count++;
+            }
+            
+            LumenRadius& radius = lumenProfile[index];
+            if (count > 0) {
+                radius.minimum = minimum;
+                radius.maximum = maximum;
+                radius.mean = static_cast<float>(sum / count);
+            } else {
+                missingNodes++;
+            }
+        }
+        
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "CameraPath: Lumen profile for " << nodeCount << " nodes (" << rayCount
+                 << " rays each, " << missingNodes << " without hits) in " << elapsedMs << " ms" << std::endl;
+        return true;
+    }
+
+    void CameraPath::ClearLumenProfile() {
+        lumenProfile.clear();
+    }
+
+    bool CameraPath::GetLumenRadius(int index, LumenRadius& radius) const {
+        if (index < 0 || index >= static_cast<int>(lumenProfile.size()) || lumenProfile[index].mean <= 0.0f) {
+            return false;
+        }
+        radius = lumenProfile[index];
+        return true;
+    }
+
+    bool CameraPath::ComputeTopology(const Centerline& centerline, ThreadPool* pool) {
+        topology.clear();
+        if (nodeCount == 0 || centerline.IsEmpty()) {
+            return false;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        // 中心线点展平（分叉点属于父分支，父分支排在前面）
+        const std::vector<Centerline::Branch>& branches = centerline.GetBranches();
+        std::vector<double> points;
+        std::vector<int> pointBranch;
+        for (size_t b = 0; b < branches.size(); b++) {
+            size_t first = branches[b].parent >= 0 ? 1 : 0;
+            for (size_t i = first; i < branches[b].GetPointCount(); i++) {
+                points.insert(points.end(), &branches[b].points[i * 3], &branches[b].points[i * 3] + 3);
+                pointBranch.push_back(static_cast<int>(b));
+            }
+        }
+        
+        // 最近的中心线点
+        std::vector<int> labels(nodeCount, -1);
+        auto label = [&](size_t begin, size_t end) {
+            for (size_t index = begin; index < end; index++) {
+                const double* p = nodeTable[index]->position;
+                double best = std::numeric_limits<double>::max();
+                for (size_t i = 0; i < pointBranch.size(); i++) {
+                    double dx = points[i * 3] - p[0];
+                    double dy = points[i * 3 + 1] - p[1];
+                    double dz = points[i * 3 + 2] - p[2];
+                    double d2 = dx * dx + dy * dy + dz * dz;
+                    if (d2 < best) {
+                        best = d2;
+                        labels[index] = pointBranch[i];
+                    }
+                }
+            }
+        };
+        if (pool) {
+            pool->ParallelFor(nodeCount, 16, label);
+        } else {
+            label(0, nodeCount);
+        }
+        
+        // 短跳变并入后一段：两侧为同一分支，或两侧本就相邻（父子），跳变只是分叉处落到了兄弟分支
+        auto adjacent = [&branches](int a, int b) {
+            return branches[a].parent == b || branches[b].parent == a;
+        };
+        int runStart = 0;
+        while (runStart < nodeCount) {
+            int runEnd = runStart;
+            while (runEnd < nodeCount && labels[runEnd] == labels[runStart]) runEnd++;
+            if (runStart > 0 && runEnd < nodeCount && runEnd - runStart < MinBranchRunNodes &&
+                (labels[runStart - 1] == labels[runEnd] || adjacent(labels[runStart - 1], labels[runEnd]))) {
+                std::fill(labels.begin() + runStart, labels.begin() + runEnd, labels[runEnd]);
+                // 与前一段合并后从前一段的起点重新扫描
+                while (runStart > 0 && labels[runStart - 1] == labels[runEnd]) runStart--;
+                continue;
+            }
+            runStart = runEnd;
+        }
+        
+        // 从末尾向前扫描：下一个分叉节点和沿路径的距离
+        topology.resize(nodeCount);
+        int nextBifurcation = -1;
+        double distance = 0.0;
+        int bifurcations = 0;
+        for (int index = nodeCount - 1; index >= 0; index--) {
+            NodeTopology& node = topology[index];
+            node.branch = labels[index];
+            node.generation = branches[labels[index]].generation;
+            
+            if (index + 1 < nodeCount) {
+                const double* a = nodeTable[index]->position;
+                const double* b = nodeTable[index + 1]->position;
+                double step = std::sqrt((b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1]) +
+                                        (b[2] - a[2]) * (b[2] - a[2]));
+                if (labels[index + 1] != labels[index]) {
+                    nextBifurcation = index + 1;
+                    distance = step;
+                    bifurcations++;
+                } else {
+                    distance += step;
+                }
+            }
+            node.nextBifurcation = nextBifurcation;
+            node.distanceToBifurcation = nextBifurcation >= 0 ? static_cast<float>(distance) : 0.0f;
+        }
+        
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "CameraPath: Topology for " << nodeCount << " nodes (" << bifurcations
+                 << " bifurcations) in " << elapsedMs << " ms" << std::endl;
+        return true;
+    }
+
+    void CameraPath::ClearTopology() {
+        topology.clear();
+    }
+
+    bool CameraPath::GetNodeTopology(int index, NodeTopology& node) const {
+        if (index < 0 || index >= static_cast<int>(topology.size())) {
+            return false;
+        }
+        node = topology[index];
+        return true;
+    }
+
     void CameraPath::NormalizeVector(double vec[3]) {
         double length = std::sqrt(vec[0]*vec[0] + vec[1]*vec[1] + vec[2]*vec[2]);
         if (length > 0.0) {
@@ -0,0 +1,812 @@
+#include "Centerline.h"
+#include "DistanceField.h"
+#include "ThreadPool.h"
+
+// Standard headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 管腔体素少于此数时认为提取失败
+        const size_t MinLumenVoxels = 64;
+
+        // 网格体素数上限（体素尺寸相对模型过小）
+        const size_t MaxGridVoxels = size_t(1) << 26;
+
+        // 最短路径和TEASAR循环中每处理这么多（减一）个体素检查一次取消标志
+        const size_t CancelCheckInterval = (size_t(1) << 16) - 1;
+
+        // 中心化代价：1 + PenaltyScale * (1 - 离壁距离/最大离壁距离)^PenaltyPower（TEASAR的取值）
+        const double PenaltyScale = 5000.0;
+        const int PenaltyPower = 16;
+
+        // 输出前的拉普拉斯平滑次数（消除体素路径的台阶）
+        const int SmoothingIterations = 4;
+
+        // 剪枝最多进行的轮数（剪除后分叉可能退化，暴露出新的末端分支）
+        const int MaxPruneRounds = 8;
+
+        const float Unreached = std::numeric_limits<float>::max();
+
+        // 序列化格式
+        const char FormatMagic[4] = { 'B', 'S', 'C', 'L' };
+        const uint32_t FormatVersion = 1;
+
+        template <typename T>
+        void Append(std::vector<unsigned char>& data, const T* values, size_t count) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+            data.insert(data.end(), bytes, bytes + sizeof(T) * count);
+        }
+
+        // 顺序读取，越界时返回false
+        struct Reader {
+            const unsigned char* data;
+            size_t size;
+            size_t offset;
+
+            template <typename T>
+            bool Read(T* values, size_t count) {
+                size_t bytes = sizeof(T) * count;
+                if (count > size || bytes > size - offset) return false;
+                std::memcpy(values, data + offset, bytes);
+                offset += bytes;
+                return true;
+            }
+        };
+
+        // 一维平方距离变换（Felzenszwalb-Huttenlocher下包络）；f为Unreached的位置不是站点
+        // v、z为工作缓冲区，大小至少为n和n+1
+        void DistanceTransform1D(const float* f, int n, float* d, int* v, double* z) {
+            int k = -1;
+            for (int q = 0; q < n; q++) {
+                if (f[q] == Unreached) continue;
+
+                double s = 0.0;
+                while (k >= 0) {
+                    s = ((f[q] + double(q) * q) - (f[v[k]] + double(v[k]) * v[k])) / (2.0 * (q - v[k]));
+                    if (s <= z[k]) {
+                        k--;
+                    } else {
+                        break;
+                    }
+                }
+                if (k < 0) {
+                    k = 0;
+                    v[0] = q;
+                    z[0] = -std::numeric_limits<double>::infinity();
+                } else {
+                    k++;
+                    v[k] = q;
+                    z[k] = s;
+                }
+                z[k + 1] = std::numeric_limits<double>::infinity();
+            }
+
+            if (k < 0) {
+                std::fill(d, d + n, Unreached);
+                return;
+            }
+            for (int q = 0, j = 0; q < n; q++) {
+                while (z[j + 1] < q) j++;
+                double offset = q - v[j];
+                d[q] = static_cast<float>(offset * offset + f[v[j]]);
+            }
+        }
+
+        // 体素骨架图上的一段分支（节点序号）
+        struct NodeBranch {
+            std::vector<int> nodes;
+            int parent;
+            std::vector<int> children;
+        };
+
+        // 骨架图：节点为体素，边连接路径上相邻的体素，构成一棵树
+        struct SkeletonGraph {
+            std::vector<int32_t> voxel;                // 节点对应的管腔体素
+            std::vector<std::vector<int>> adjacency;
+
+            int AddNode(int32_t lumenVoxel) {
+                voxel.push_back(lumenVoxel);
+                adjacency.emplace_back();
+                return static_cast<int>(voxel.size()) - 1;
+            }
+
+            void Connect(int a, int b) {
+                adjacency[a].push_back(b);
+                adjacency[b].push_back(a);
+            }
+
+            int Degree(int node) const {
+                return static_cast<int>(adjacency[node].size());
+            }
+
+            // 从root出发，在度不为2的节点处切分为分支（先序）
+            void BuildBranches(int root, std::vector<NodeBranch>& branches) const {
+                branches.clear();
+
+                struct Pending { int start; int next; int parent; };
+                std::vector<Pending> stack;
+                for (auto it = adjacency[root].rbegin(); it != adjacency[root].rend(); ++it) {
+                    stack.push_back({ root, *it, -1 });
+                }
+
+                while (!stack.empty()) {
+                    Pending pending = stack.back();
+                    stack.pop_back();
+
+                    NodeBranch branch;
+                    branch.parent = pending.parent;
+                    branch.nodes.push_back(pending.start);
+                    int previous = pending.start;
+                    int current = pending.next;
+                    while (true) {
+                        branch.nodes.push_back(current);
+                        if (Degree(current) != 2) break;
+                        int next = adjacency[current][0] == previous ? adjacency[current][1] : adjacency[current][0];
+                        previous = current;
+                        current = next;
+                    }
+
+                    int index = static_cast<int>(branches.size());
+                    if (branch.parent >= 0) {
+                        branches[branch.parent].children.push_back(index);
+                    }
+                    branches.push_back(branch);
+
+                    const std::vector<int>& neighbors = adjacency[current];
+                    for (auto it = neighbors.rbegin(); it != neighbors.rend(); ++it) {
+                        if (*it != previous) {
+                            stack.push_back({ current, *it, index });
+                        }
+                    }
+                }
+            }
+        };
+
+        // 沿折线的累计弧长
+        double PolylineLength(const std::vector<double>& points) {
+            double length = 0.0;
+            for (size_t i = 3; i < points.size(); i += 3) {
+                double dx = points[i] - points[i - 3];
+                double dy = points[i + 1] - points[i - 2];
+                double dz = points[i + 2] - points[i - 1];
+                length += std::sqrt(dx * dx + dy * dy + dz * dz);
+            }
+            return length;
+        }
+
+        // 按弧长等间距重采样（保留两个端点），半径线性插值
+        void Resample(const std::vector<double>& points, const std::vector<double>& radii, double spacing,
+                      std::vector<double>& outPoints, std::vector<double>& outRadii) {
+            size_t count = radii.size();
+            std::vector<double> arc(count, 0.0);
+            for (size_t i = 1; i < count; i++) {
+                double dx = points[i * 3] - points[i * 3 - 3];
+                double dy = points[i * 3 + 1] - points[i * 3 - 2];
+                double dz = points[i * 3 + 2] - points[i * 3 - 1];
+                arc[i] = arc[i - 1] + std::sqrt(dx * dx + dy * dy + dz * dz);
+            }
+
+            double length = arc[count - 1];
+            int segments = std::max(1, static_cast<int>(std::lround(length / spacing)));
+            outPoints.clear();
+            outRadii.clear();
+            outPoints.reserve((segments + 1) * 3);
+            outRadii.reserve(segments + 1);
+
+            size_t j = 0;
+            for (int s = 0; s <= segments; s++) {
+                double target = length * s / segments;
+                while (j + 2 < count && arc[j + 1] < target) j++;
+                double span = arc[j + 1] - arc[j];
+                double t = span > 0.0 ? std::min(std::max((target - arc[j]) / span, 0.0), 1.0) : 0.0;
+                if (s == segments) {
+                    j = count - 2;
+                    t = 1.0;
+                }
+                for (int a = 0; a < 3; a++) {
+                    outPoints.push_back(points[j * 3 + a] + (points[(j + 1) * 3 + a] - points[j * 3 + a]) * t);
+                }
+                outRadii.push_back(radii[j] + (radii[j + 1] - radii[j]) * t);
+            }
+        }
+
+    } // namespace
+
+    class Centerline::Impl {
+    public:
+        std::vector<Branch> branches;
+        Settings settings;
+        unsigned long long geometryHash;
+        double fieldVoxelSize;
+        double extractMs;
+
+        Impl() : geometryHash(0), fieldVoxelSize(0.0), extractMs(0.0) {}
+
+        void Reset() {
+            branches.clear();
+            settings = Settings();
+            geometryHash = 0;
+            fieldVoxelSize = 0.0;
+            extractMs = 0.0;
+        }
+
+        // 由父分支关系补全子分支、级数和长度（父分支须排在子分支之前）
+        bool Link() {
+            for (size_t i = 0; i < branches.size(); i++) {
+                Branch& branch = branches[i];
+                branch.children.clear();
+                branch.length = PolylineLength(branch.points);
+                if (branch.parent >= static_cast<int>(i) || branch.parent < -1) {
+                    return false;
+                }
+                if (branch.parent >= 0) {
+                    branches[branch.parent].children.push_back(static_cast<int>(i));
+                    branch.generation = branches[branch.parent].generation + 1;
+                } else {
+                    branch.generation = 0;
+                }
+            }
+            return true;
+        }
+    };
+
+    Centerline::Centerline() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    Centerline::~Centerline() = default;
+
+    bool Centerline::Extract(const DistanceField& field, const Settings& settings, ThreadPool* pool,
+                             const std::atomic<bool>* cancelFlag) {
+        Clear();
+        if (field.IsEmpty()) {
+            std::cerr << "Centerline: Empty distance field" << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto cancelled = [cancelFlag]() {
+            return cancelFlag && cancelFlag->load();
+        };
+
+        // 按分块执行，取消后跳过尚未开始的分块
+        auto parallelFor = [pool, &cancelled](size_t count, size_t grain,
+                                              const std::function<void(size_t, size_t)>& body) {
+            auto guarded = [&](size_t begin, size_t end) {
+                if (!cancelled()) body(begin, end);
+            };
+            if (pool) {
+                pool->ParallelFor(count, grain, guarded);
+            } else {
+                for (size_t begin = 0; begin < count; begin += grain) {
+                    guarded(begin, std::min(count, begin + grain));
+                }
+            }
+        };
+
+        // 网格覆盖距离场范围，采样点位于origin + i * voxel
+        double fieldBounds[6];
+        field.GetBounds(fieldBounds);
+        double voxel = settings.voxelSize > 0.0 ? settings.voxelSize : field.GetVoxelSize();
+        double origin[3];
+        int dims[3];
+        size_t total = 1;
+        for (int a = 0; a < 3; a++) {
+            origin[a] = fieldBounds[a * 2];
+            dims[a] = static_cast<int>((fieldBounds[a * 2 + 1] - fieldBounds[a * 2]) / voxel) + 1;
+            total *= static_cast<size_t>(dims[a]);
+        }
+        if (dims[0] < 3 || dims[1] < 3 || dims[2] < 3 || total > MaxGridVoxels) {
+            std::cerr << "Centerline: Unsupported grid " << dims[0] << "x" << dims[1] << "x" << dims[2]
+                     << " for voxel size " << voxel << std::endl;
+            return false;
+        }
+        const size_t strideY = dims[0];
+        const size_t strideZ = strideY * dims[1];
+
+        // 1. 采样管腔内外（网格最外层固定为壁外，邻域访问无需边界检查）
+        std::vector<float> squared(total, 0.0f);
+        parallelFor(dims[2], 1, [&](size_t begin, size_t end) {
+            for (size_t z = begin; z < end; z++) {
+                for (int y = 0; y < dims[1]; y++) {
+                    for (int x = 0; x < dims[0]; x++) {
+                        bool border = x == 0 || y == 0 || z == 0 ||
+                                      x == dims[0] - 1 || y == dims[1] - 1 || z == size_t(dims[2] - 1);
+                        double p[3] = { origin[0] + x * voxel, origin[1] + y * voxel, origin[2] + z * voxel };
+                        if (!border && field.Sample(p) > 0.0) {
+                            squared[z * strideZ + y * strideY + x] = Unreached;
+                        }
+                    }
+                }
+            }
+        });
+        if (cancelled()) return false;
+
+        // 2. 管腔体素到最近壁外体素的平方欧氏距离（体素单位），按轴分三遍，每遍各行并行
+        for (int axis = 0; axis < 3; axis++) {
+            const int length = dims[axis];
+            const size_t stride = axis == 0 ? 1 : (axis == 1 ? strideY : strideZ);
+            const int otherA = axis == 0 ? 1 : 0;
+            const int otherB = axis == 2 ? 1 : 2;
+            const size_t strideA = otherA == 0 ? 1 : strideY;
+            const size_t strideB = otherB == 1 ? strideY : strideZ;
+            const size_t lines = static_cast<size_t>(dims[otherA]) * dims[otherB];
+
+            parallelFor(lines, 64, [&](size_t begin, size_t end) {
+                std::vector<float> f(length), d(length);
+                std::vector<int> v(length);
+                std::vector<double> zBuffer(length + 1);
+                for (size_t line = begin; line < end; line++) {
+                    size_t base = (line % dims[otherA]) * strideA + (line / dims[otherA]) * strideB;
+                    for (int i = 0; i < length; i++) {
+                        f[i] = squared[base + i * stride];
+                    }
+                    DistanceTransform1D(f.data(), length, d.data(), v.data(), zBuffer.data());
+                    for (int i = 0; i < length; i++) {
+                        squared[base + i * stride] = d[i];
+                    }
+                }
+            });
+            if (cancelled()) return false;
+        }
+
+        // 3. 压缩为管腔体素列表
+        std::vector<int32_t> lumenIndex(total, -1);
+        std::vector<size_t> lumenVoxels;
+        std::vector<float> wallDistance;  // 离壁距离（体素单位）
+        for (size_t i = 0; i < total; i++) {
+            if (squared[i] > 0.0f) {
+                lumenIndex[i] = static_cast<int32_t>(lumenVoxels.size());
+                lumenVoxels.push_back(i);
+                wallDistance.push_back(std::sqrt(squared[i]));
+            }
+        }
+        std::vector<float>().swap(squared);
+
+        const size_t lumenCount = lumenVoxels.size();
+        if (lumenCount < MinLumenVoxels || lumenCount > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+            std::cerr << "Centerline: Too few lumen voxels (" << lumenCount << ")" << std::endl;
+            return false;
+        }
+
+        // 以离壁最远的体素为临时根（通常在气管内）
+        int32_t root = static_cast<int32_t>(
+            std::max_element(wallDistance.begin(), wallDistance.end()) - wallDistance.begin());
+        const double maxWallDistance = wallDistance[root];
+
+        // 26邻域
+        struct Neighbor { long long offset; float length; };
+        std::vector<Neighbor> neighbors;
+        for (int dz = -1; dz <= 1; dz++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (dx == 0 && dy == 0 && dz == 0) continue;
+                    Neighbor neighbor;
+                    neighbor.offset = dz * static_cast<long long>(strideZ) + dy * static_cast<long long>(strideY) + dx;
+                    neighbor.length = std::sqrt(static_cast<float>(dx * dx + dy * dy + dz * dz));
+                    neighbors.push_back(neighbor);
+                }
+            }
+        }
+
+        // 4. 从根出发的两次最短路径（并行）：
+        //    按中心化代价加权的路径树用于回溯骨架，未加权的测地距离用于选择最远的目标
+        std::vector<float> penalty(lumenCount);
+        for (size_t i = 0; i < lumenCount; i++) {
+            penalty[i] = static_cast<float>(
+                1.0 + PenaltyScale * std::pow(1.0 - wallDistance[i] / maxWallDistance, PenaltyPower));
+        }
+
+        std::vector<int32_t> parent(lumenCount, -1);
+        std::vector<float> geodesic(lumenCount, Unreached);
+        auto shortestPaths = [&](bool weighted, std::vector<float>& distance, std::vector<int32_t>* tree) {
+            typedef std::pair<float, int32_t> Entry;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+            distance[root] = 0.0f;
+            queue.push(Entry(0.0f, root));
+
+            size_t visited = 0;
+            while (!queue.empty()) {
+                if ((++visited & CancelCheckInterval) == 0 && cancelled()) return;
+                
+                Entry entry = queue.top();
+                queue.pop();
+                int32_t current = entry.second;
+                if (entry.first > distance[current]) continue;
+
+                size_t gridIndex = lumenVoxels[current];
+                for (const Neighbor& neighbor : neighbors) {
+                    int32_t next = lumenIndex[gridIndex + neighbor.offset];
+                    if (next < 0) continue;
+
+                    float step = weighted ? neighbor.length * 0.5f * (penalty[current] + penalty[next])
+                                          : neighbor.length;
+                    float candidate = entry.first + step;
+                    if (candidate < distance[next]) {
+                        distance[next] = candidate;
+                        if (tree) (*tree)[next] = current;
+                        queue.push(Entry(candidate, next));
+                    }
+                }
+            }
+        };
+        parallelFor(2, 1, [&](size_t begin, size_t end) {
+            for (size_t task = begin; task < end; task++) {
+                if (task == 0) {
+                    std::vector<float> cost(lumenCount, Unreached);
+                    shortestPaths(true, cost, &parent);
+                } else {
+                    shortestPaths(false, geodesic, nullptr);
+                }
+            }
+        });
+        if (cancelled()) return false;
+
+        // 5. TEASAR：按测地距离从远到近选择尚未覆盖的体素，沿路径树回溯到已有骨架，
+        //    并排除路径周围管腔半径范围内的体素
+        std::vector<unsigned char> covered(lumenCount, 0);
+        std::vector<int32_t> order;
+        order.reserve(lumenCount);
+        for (size_t i = 0; i < lumenCount; i++) {
+            if (geodesic[i] == Unreached) {
+                covered[i] = 1;  // 与根不连通的碎片
+            } else {
+                order.push_back(static_cast<int32_t>(i));
+            }
+        }
+        std::sort(order.begin(), order.end(), [&geodesic](int32_t a, int32_t b) {
+            return geodesic[a] > geodesic[b];
+        });
+
+        double coverConstant = settings.invalidationConstant > 0.0 ? settings.invalidationConstant / voxel : 2.0;
+        auto cover = [&](int32_t center) {
+            size_t gridIndex = lumenVoxels[center];
+            int cx = static_cast<int>(gridIndex % strideY);
+            int cy = static_cast<int>((gridIndex / strideY) % dims[1]);
+            int cz = static_cast<int>(gridIndex / strideZ);
+            double radius = settings.invalidationScale * wallDistance[center] + coverConstant;
+            int extent = static_cast<int>(radius);
+            double radiusSquared = radius * radius;
+
+            for (int z = std::max(cz - extent, 1); z <= std::min(cz + extent, dims[2] - 2); z++) {
+                for (int y = std::max(cy - extent, 1); y <= std::min(cy + extent, dims[1] - 2); y++) {
+                    double dyz = double(z - cz) * (z - cz) + double(y - cy) * (y - cy);
+                    if (dyz > radiusSquared) continue;
+                    int reach = static_cast<int>(std::sqrt(radiusSquared - dyz));
+                    size_t row = z * strideZ + y * strideY;
+                    for (int x = std::max(cx - reach, 1); x <= std::min(cx + reach, dims[0] - 2); x++) {
+                        int32_t index = lumenIndex[row + x];
+                        if (index >= 0) covered[index] = 1;
+                    }
+                }
+            }
+        };
+
+        SkeletonGraph graph;
+        std::vector<int32_t> skeletonNode(lumenCount, -1);
+        skeletonNode[root] = graph.AddNode(root);
+        cover(root);
+
+        std::vector<int32_t> path;
+        size_t visited = 0;
+        for (int32_t target : order) {
+            if ((++visited & CancelCheckInterval) == 0 && cancelled()) return false;
+            if (covered[target]) continue;
+
+            path.clear();
+            int32_t current = target;
+            while (skeletonNode[current] < 0) {
+                path.push_back(current);
+                current = parent[current];
+            }
+
+            int previous = skeletonNode[current];
+            for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                int node = graph.AddNode(*it);
+                skeletonNode[*it] = node;
+                graph.Connect(previous, node);
+                previous = node;
+            }
+            for (int32_t voxelIndex : path) {
+                cover(voxelIndex);
+            }
+        }
+
+        // 6. 剪除短于分叉处半径若干倍的末端分支
+        auto nodeWallDistance = [&](int node) {
+            return static_cast<double>(wallDistance[graph.voxel[node]]);
+        };
+        auto stepLength = [&](int a, int b) {
+            size_t ga = lumenVoxels[graph.voxel[a]], gb = lumenVoxels[graph.voxel[b]];
+            long long dx = static_cast<long long>(ga % strideY) - static_cast<long long>(gb % strideY);
+            long long dy = static_cast<long long>((ga / strideY) % dims[1]) - static_cast<long long>((gb / strideY) % dims[1]);
+            long long dz = static_cast<long long>(ga / strideZ) - static_cast<long long>(gb / strideZ);
+            return std::sqrt(static_cast<double>(dx * dx + dy * dy + dz * dz));
+        };
+
+        int rootNode = skeletonNode[root];
+        std::vector<NodeBranch> nodeBranches;
+        int pruned = 0;
+        for (int round = 0; round < MaxPruneRounds; round++) {
+            graph.BuildBranches(rootNode, nodeBranches);
+
+            bool changed = false;
+            for (const NodeBranch& branch : nodeBranches) {
+                int first = branch.nodes.front();
+                int last = branch.nodes.back();
+                if (!branch.children.empty() || graph.Degree(last) != 1 || graph.Degree(first) < 3) continue;
+
+                double length = 0.0;
+                for (size_t i = 1; i < branch.nodes.size(); i++) {
+                    length += stepLength(branch.nodes[i - 1], branch.nodes[i]);
+                }
+                if (length >= settings.minBranchRatio * nodeWallDistance(first)) continue;
+
+                // 断开与分叉点的连接，其余节点不再可达
+                std::vector<int>& firstAdjacency = graph.adjacency[first];
+                firstAdjacency.erase(std::find(firstAdjacency.begin(), firstAdjacency.end(), branch.nodes[1]));
+                pruned++;
+                changed = true;
+            }
+            if (!changed) break;
+        }
+
+        // 7. 根放在平均半径最大的末端分支的末端（气管开口）
+        graph.BuildBranches(rootNode, nodeBranches);
+        double widest = -1.0;
+        for (const NodeBranch& branch : nodeBranches) {
+            int last = branch.nodes.back();
+            if (graph.Degree(last) != 1) continue;
+
+            double sum = 0.0;
+            for (int node : branch.nodes) {
+                sum += nodeWallDistance(node);
+            }
+            double mean = sum / branch.nodes.size();
+            if (mean > widest) {
+                widest = mean;
+                rootNode = last;
+            }
+        }
+        if (graph.Degree(rootNode) == 0) {
+            std::cerr << "Centerline: Skeleton has a single voxel" << std::endl;
+            return false;
+        }
+        graph.BuildBranches(rootNode, nodeBranches);
+
+        // 8. 转换到世界坐标：平滑、重采样，半径在窄带内取距离场的值
+        double spacing = settings.sampleSpacing > 0.0 ? settings.sampleSpacing : voxel;
+        double band = field.GetBandWidth();
+        std::vector<Branch>& output = pImpl->branches;
+        output.resize(nodeBranches.size());
+        parallelFor(nodeBranches.size(), 4, [&](size_t begin, size_t end) {
+            std::vector<double> points, radii, smoothed;
+            for (size_t b = begin; b < end; b++) {
+                const NodeBranch& source = nodeBranches[b];
+                size_t count = source.nodes.size();
+                points.resize(count * 3);
+                radii.resize(count);
+                for (size_t i = 0; i < count; i++) {
+                    size_t gridIndex = lumenVoxels[graph.voxel[source.nodes[i]]];
+                    points[i * 3] = origin[0] + (gridIndex % strideY) * voxel;
+                    points[i * 3 + 1] = origin[1] + ((gridIndex / strideY) % dims[1]) * voxel;
+                    points[i * 3 + 2] = origin[2] + (gridIndex / strideZ) * voxel;
+                    // 到最近壁外体素中心的距离比到壁面约多半个体素
+                    radii[i] = std::max(nodeWallDistance(source.nodes[i]) - 0.5, 0.5) * voxel;
+                }
+
+                // 端点（分叉点）固定，保证子分支与父分支相接
+                for (int iteration = 0; iteration < SmoothingIterations && count > 2; iteration++) {
+                    smoothed = points;
+                    for (size_t i = 1; i + 1 < count; i++) {
+                        for (int a = 0; a < 3; a++) {
+                            smoothed[i * 3 + a] = 0.5 * points[i * 3 + a] +
+                                                  0.25 * (points[(i - 1) * 3 + a] + points[(i + 1) * 3 + a]);
+                        }
+                    }
+                    points.swap(smoothed);
+                }
+
+                Branch& branch = output[b];
+                branch.parent = source.parent;
+                Resample(points, radii, spacing, branch.points, branch.radii);
+
+                for (size_t i = 0; i < branch.radii.size(); i++) {
+                    double value = field.Sample(&branch.points[i * 3]);
+                    if (value > 0.0 && value < band) {
+                        branch.radii[i] = value;
+                    }
+                }
+            }
+        });
+        if (cancelled()) {
+            Clear();
+            return false;
+        }
+        pImpl->Link();
+
+        pImpl->settings = settings;
+        pImpl->geometryHash = field.GetGeometryHash();
+        pImpl->fieldVoxelSize = field.GetVoxelSize();
+        pImpl->extractMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Centerline: Extracted " << output.size() << " branches (" << pruned << " pruned), length "
+                 << GetTotalLength() << ", " << lumenCount << " lumen voxels, "
+                 << pImpl->extractMs << " ms" << std::endl;
+        return true;
+    }
+
+    void Centerline::Clear() {
+        pImpl->Reset();
+    }
+
+    bool Centerline::IsEmpty() const {
+        return pImpl->branches.empty();
+    }
+
+    int Centerline::GetBranchCount() const {
+        return static_cast<int>(pImpl->branches.size());
+    }
+
+    const Centerline::Branch& Centerline::GetBranch(int index) const {
+        return pImpl->branches[index];
+    }
+
+    const std::vector<Centerline::Branch>& Centerline::GetBranches() const {
+        return pImpl->branches;
+    }
+
+    bool Centerline::GetPathToBranch(int index, std::vector<double>& positions) const {
+        positions.clear();
+        if (index < 0 || index >= GetBranchCount()) {
+            return false;
+        }
+
+        std::vector<int> chain;
+        for (int branch = index; branch >= 0; branch = pImpl->branches[branch].parent) {
+            chain.push_back(branch);
+        }
+
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            const std::vector<double>& points = pImpl->branches[*it].points;
+            size_t skip = positions.empty() ? 0 : 3;  // 分叉点已是父分支的末点
+            positions.insert(positions.end(), points.begin() + skip, points.end());
+        }
+        return true;
+    }
+
+    int Centerline::GetFarthestLeafBranch() const {
+        // 父分支排在子分支之前，按顺序累加即得到从根出发的路径长度
+        const std::vector<Branch>& branches = pImpl->branches;
+        std::vector<double> reach(branches.size(), 0.0);
+        int farthest = -1;
+        for (size_t i = 0; i < branches.size(); i++) {
+            const Branch& branch = branches[i];
+            reach[i] = branch.length + (branch.parent >= 0 ? reach[branch.parent] : 0.0);
+            if (branch.children.empty() && (farthest < 0 || reach[i] > reach[farthest])) {
+                farthest = static_cast<int>(i);
+            }
+        }
+        return farthest;
+    }
+
+    double Centerline::GetTotalLength() const {
+        double length = 0.0;
+        for (const Branch& branch : pImpl->branches) {
+            length += branch.length;
+        }
+        return length;
+    }
+
+    double Centerline::GetExtractMs() const {
+        return pImpl->extractMs;
+    }
+
+    const Centerline::Settings& Centerline::GetSettings() const {
+        return pImpl->settings;
+    }
+
+    unsigned long long Centerline::GetGeometryHash() const {
+        return pImpl->geometryHash;
+    }
+
+    double Centerline::GetFieldVoxelSize() const {
+        return pImpl->fieldVoxelSize;
+    }
+
+    void Centerline::Serialize(std::vector<unsigned char>& data) const {
+        const Impl& centerline = *pImpl;
+        data.clear();
+
+        uint64_t hash = centerline.geometryHash;
+        const Settings& settings = centerline.settings;
+        double values[6] = { centerline.fieldVoxelSize, settings.voxelSize, settings.invalidationScale,
+                             settings.invalidationConstant, settings.minBranchRatio, settings.sampleSpacing };
+        uint32_t branchCount = static_cast<uint32_t>(centerline.branches.size());
+
+        Append(data, FormatMagic, 4);
+        Append(data, &FormatVersion, 1);
+        Append(data, &hash, 1);
+        Append(data, values, 6);
+        Append(data, &branchCount, 1);
+        for (const Branch& branch : centerline.branches) {
+            int32_t parent = branch.parent;
+            uint32_t pointCount = static_cast<uint32_t>(branch.radii.size());
+            Append(data, &parent, 1);
+            Append(data, &pointCount, 1);
+            Append(data, branch.points.data(), branch.points.size());
+            Append(data, branch.radii.data(), branch.radii.size());
+        }
+    }
+
+    bool Centerline::Deserialize(const unsigned char* data, size_t size) {
+        if (!data) return false;
+
+        Reader reader = { data, size, 0 };
+        char magic[4];
+        uint32_t version = 0;
+        uint64_t hash = 0;
+        double values[6];
+        uint32_t branchCount = 0;
+
+        if (!reader.Read(magic, 4) || std::memcmp(magic, FormatMagic, 4) != 0 ||
+            !reader.Read(&version, 1) || version != FormatVersion) {
+            std::cerr << "Centerline: Unrecognized data format" << std::endl;
+            return false;
+        }
+        if (!reader.Read(&hash, 1) || !reader.Read(values, 6) || !reader.Read(&branchCount, 1)) {
+            std::cerr << "Centerline: Truncated data" << std::endl;
+            return false;
+        }
+
+        Impl loaded;
+        for (uint32_t i = 0; i < branchCount; i++) {
+            int32_t parent = -1;
+            uint32_t pointCount = 0;
+            if (!reader.Read(&parent, 1) || !reader.Read(&pointCount, 1) || pointCount < 2 ||
+                pointCount > (size - reader.offset) / (sizeof(double) * 4)) {
+                std::cerr << "Centerline: Truncated data" << std::endl;
+                return false;
+            }
+
+            Branch branch;
+            branch.parent = parent;
+            branch.points.resize(pointCount * 3);
+            branch.radii.resize(pointCount);
+            if (!reader.Read(branch.points.data(), branch.points.size()) ||
+                !reader.Read(branch.radii.data(), branch.radii.size())) {
+                return false;
+            }
+            loaded.branches.push_back(std::move(branch));
+        }
+        if (!loaded.Link()) {
+            std::cerr << "Centerline: Corrupted branch hierarchy" << std::endl;
+            return false;
+        }
+
+        Impl& centerline = *pImpl;
+        centerline.branches.swap(loaded.branches);
+        centerline.geometryHash = hash;
+        centerline.fieldVoxelSize = values[0];
+        centerline.settings.voxelSize = values[1];
+        centerline.settings.invalidationScale = values[2];
+        centerline.settings.invalidationConstant = values[3];
+        centerline.settings.minBranchRatio = values[4];
+        centerline.settings.sampleSpacing = values[5];
+        centerline.extractMs = 0.0;
+        return true;
+    }
+
+} // namespace BronchoscopyLib
@@ -0,0 +1,474 @@
+#include "DistanceField.h"
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+
+// Standard headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 块的边长（体素）；每块保存(BrickSize+1)^3个采样，与相邻块共享边界一层
+        const int BrickSize = 8;
+        const int BrickSamples = BrickSize + 1;
+        const int BrickValues = BrickSamples * BrickSamples * BrickSamples;
+
+        // 未分配块的块表取值（分配的块为其在数据中的序号）
+        const int32_t FarInside = -1;   // 窄带外、管腔内
+        const int32_t FarOutside = -2;  // 窄带外、壁外
+
+        // 最近点的重心坐标都大于此值时视为在三角形内部
+        const double FaceInteriorEpsilon = 1e-4;
+
+        // 块表超过此大小时拒绝构建（体素尺寸相对模型过小）
+        const size_t MaxTotalBricks = size_t(1) << 26;
+
+        // 序列化格式
+        const char FormatMagic[4] = { 'B', 'S', 'D', 'F' };
+        const uint32_t FormatVersion = 1;
+
+        template <typename T>
+        void Append(std::vector<unsigned char>& data, const T* values, size_t count) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+            data.insert(data.end(), bytes, bytes + sizeof(T) * count);
+        }
+
+        // 顺序读取，越界时返回false
+        struct Reader {
+            const unsigned char* data;
+            size_t size;
+            size_t offset;
+
+            template <typename T>
+            bool Read(T* values, size_t count) {
+                size_t bytes = sizeof(T) * count;
+                if (count > size || bytes > size - offset) return false;
+                std::memcpy(values, data + offset, bytes);
+                offset += bytes;
+                return true;
+            }
+        };
+
+    } // namespace
+
+    class DistanceField::Impl {
+    public:
+        double origin[3];
+        double voxelSize;
+        double inverseVoxelSize;
+        double bandWidth;
+        int brickDims[3];
+        int sampleMax[3];              // 各轴最大的体素坐标（块数 * BrickSize）
+        std::vector<int32_t> bricks;   // 块表（x最快）
+        std::vector<float> values;     // 已分配块的采样，每块BrickValues个（x最快）
+
+        double requestedVoxelSize;
+        double requestedBandWidth;
+        unsigned long long geometryHash;
+        double buildMs;
+
+        Impl() : voxelSize(0.0), inverseVoxelSize(0.0), bandWidth(0.0),
+                 requestedVoxelSize(0.0), requestedBandWidth(0.0), geometryHash(0), buildMs(0.0) {
+            Reset();
+        }
+
+        void Reset() {
+            origin[0] = origin[1] = origin[2] = 0.0;
+            brickDims[0] = brickDims[1] = brickDims[2] = 0;
+            sampleMax[0] = sampleMax[1] = sampleMax[2] = 0;
+            voxelSize = inverseVoxelSize = bandWidth = 0.0;
+            requestedVoxelSize = requestedBandWidth = 0.0;
+            geometryHash = 0;
+            buildMs = 0.0;
+            bricks.clear();
+            values.clear();
+        }
+
+        size_t BrickIndex(int bx, int by, int bz) const {
+            return (static_cast<size_t>(bz) * brickDims[1] + by) * brickDims[0] + bx;
+        }
+
+        void UpdateDerived() {
+            inverseVoxelSize = voxelSize > 0.0 ? 1.0 / voxelSize : 0.0;
+            for (int a = 0; a < 3; a++) {
+                sampleMax[a] = brickDims[a] * BrickSize;
+            }
+        }
+
+        // 三线性插值；gradient不为空时同时计算梯度
+        double Sample(const double point[3], double* gradient) const {
+            if (gradient) {
+                gradient[0] = gradient[1] = gradient[2] = 0.0;
+            }
+            if (bricks.empty()) {
+                return -bandWidth;
+            }
+
+            // 所在插值单元及单元内的位置
+            int cell[3];
+            double t[3];
+            for (int a = 0; a < 3; a++) {
+                double g = (point[a] - origin[a]) * inverseVoxelSize;
+                if (!(g >= 0.0 && g <= sampleMax[a])) {
+                    return -bandWidth;
+                }
+                cell[a] = std::min(static_cast<int>(g), sampleMax[a] - 1);
+                t[a] = g - cell[a];
+            }
+
+            int32_t brick = bricks[BrickIndex(cell[0] / BrickSize, cell[1] / BrickSize, cell[2] / BrickSize)];
+            if (brick < 0) {
+                return brick == FarInside ? bandWidth : -bandWidth;
+            }
+
+            // 单元的8个角都在同一块内（块多存一层边界采样）
+            int lx = cell[0] % BrickSize, ly = cell[1] % BrickSize, lz = cell[2] % BrickSize;
+            const float* v = &values[static_cast<size_t>(brick) * BrickValues +
+                                     (lz * BrickSamples + ly) * BrickSamples + lx];
+            const int dy = BrickSamples;
+            const int dz = BrickSamples * BrickSamples;
+            double c000 = v[0],       c100 = v[1];
+            double c010 = v[dy],      c110 = v[dy + 1];
+            double c001 = v[dz],      c101 = v[dz + 1];
+            double c011 = v[dz + dy], c111 = v[dz + dy + 1];
+
+            double c00 = c000 + (c100 - c000) * t[0];
+            double c10 = c010 + (c110 - c010) * t[0];
+            double c01 = c001 + (c101 - c001) * t[0];
+            double c11 = c011 + (c111 - c011) * t[0];
+            double c0 = c00 + (c10 - c00) * t[1];
+            double c1 = c01 + (c11 - c01) * t[1];
+
+            if (gradient) {
+                double gx0 = (c100 - c000) + ((c110 - c010) - (c100 - c000)) * t[1];
+                double gx1 = (c101 - c001) + ((c111 - c011) - (c101 - c001)) * t[1];
+                gradient[0] = (gx0 + (gx1 - gx0) * t[2]) * inverseVoxelSize;
+                gradient[1] = ((c10 - c00) + ((c11 - c01) - (c10 - c00)) * t[2]) * inverseVoxelSize;
+                gradient[2] = (c1 - c0) * inverseVoxelSize;
+            }
+            return c0 + (c1 - c0) * t[2];
+        }
+    };
+
+    DistanceField::DistanceField() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    DistanceField::~DistanceField() = default;
+
+    bool DistanceField::Build(const MeshBVH& bvh, double voxelSize, double bandWidth, ThreadPool* pool,
+                              const std::atomic<bool>* cancelFlag) {
+        Clear();
+        if (bvh.IsEmpty()) {
+            std::cerr << "DistanceField: Empty BVH" << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        double bounds[6];
+        bvh.GetBounds(bounds);
+        double maxExtent = std::max(bounds[1] - bounds[0], std::max(bounds[3] - bounds[2], bounds[5] - bounds[4]));
+        double voxel = voxelSize > 0.0 ? voxelSize : maxExtent / DefaultResolution;
+        double band = bandWidth > 0.0 ? bandWidth : DefaultBandVoxels * voxel;
+        if (!(voxel > 0.0) || !(band > 0.0)) {
+            std::cerr << "DistanceField: Invalid voxel size " << voxel << std::endl;
+            return false;
+        }
+
+        // 网格包围盒向外扩展一个窄带，保证表面附近的插值单元都在网格内
+        Impl& field = *pImpl;
+        double padding = band + voxel;
+        size_t totalBricks = 1;
+        for (int a = 0; a < 3; a++) {
+            field.origin[a] = bounds[a * 2] - padding;
+            double extent = bounds[a * 2 + 1] - bounds[a * 2] + 2.0 * padding;
+            field.brickDims[a] = std::max(1, static_cast<int>(std::ceil(extent / (voxel * BrickSize))));
+            totalBricks *= static_cast<size_t>(field.brickDims[a]);
+        }
+        if (totalBricks > MaxTotalBricks) {
+            std::cerr << "DistanceField: Voxel size " << voxel << " too small for model extent "
+                     << maxExtent << std::endl;
+            Clear();
+            return false;
+        }
+        field.voxelSize = voxel;
+        field.bandWidth = band;
+        field.requestedVoxelSize = std::max(voxelSize, 0.0);
+        field.requestedBandWidth = std::max(bandWidth, 0.0);
+        field.geometryHash = bvh.GetBuildStats().geometryHash;
+        field.UpdateDerived();
+
+        auto cancelled = [cancelFlag]() {
+            return cancelFlag && cancelFlag->load();
+        };
+
+        // 按分块执行，取消后跳过尚未开始的分块
+        auto parallelFor = [pool, &cancelled](size_t count, size_t grain,
+                                              const std::function<void(size_t, size_t)>& body) {
+            auto guarded = [&](size_t begin, size_t end) {
+                if (!cancelled()) body(begin, end);
+            };
+            if (pool) {
+                pool->ParallelFor(count, grain, guarded);
+            } else {
+                for (size_t begin = 0; begin < count; begin += grain) {
+                    guarded(begin, std::min(count, begin + grain));
+                }
+            }
+        };
+
+        // 内外判定：最近点在三角形内部时看点在法线哪一侧（法线按网格朝向统一为朝外）；
+        // 最近点在边或顶点上（含开口边缘）时法线不可靠，改用环绕数
+        double orientation = bvh.GetBuildStats().signedVolume >= 0.0 ? 1.0 : -1.0;
+        auto isInside = [&bvh, orientation](const double p[3], const MeshBVH::Hit* hit) {
+            if (hit && hit->u > FaceInteriorEpsilon && hit->v > FaceInteriorEpsilon &&
+                1.0 - hit->u - hit->v > FaceInteriorEpsilon) {
+                double side = 0.0;
+                for (int a = 0; a < 3; a++) {
+                    side += (p[a] - hit->point[a]) * hit->normal[a];
+                }
+                return side * orientation < 0.0;
+            }
+            return bvh.GetWindingNumber(p) * orientation > 0.5;
+        };
+
+        auto brickOrigin = [&field](size_t index, double p[3]) {
+            size_t bx = index % field.brickDims[0];
+            size_t by = (index / field.brickDims[0]) % field.brickDims[1];
+            size_t bz = index / (static_cast<size_t>(field.brickDims[0]) * field.brickDims[1]);
+            p[0] = field.origin[0] + bx * BrickSize * field.voxelSize;
+            p[1] = field.origin[1] + by * BrickSize * field.voxelSize;
+            p[2] = field.origin[2] + bz * BrickSize * field.voxelSize;
+        };
+
+        // 1. 分类：与窄带相交的块待分配，其余块只记录块中心的符号
+        field.bricks.assign(totalBricks, FarOutside);
+        std::vector<unsigned char> allocate(totalBricks, 0);
+        double halfDiagonal = std::sqrt(3.0) * 0.5 * BrickSize * voxel;
+        parallelFor(totalBricks, 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                double center[3];
+                brickOrigin(i, center);
+                for (int a = 0; a < 3; a++) {
+                    center[a] += 0.5 * BrickSize * voxel;
+                }
+
+                MeshBVH::Hit hit;
+                if (bvh.FindClosestPoint(center, halfDiagonal + band, hit)) {
+                    allocate[i] = 1;
+                } else {
+                    field.bricks[i] = isInside(center, nullptr) ? FarInside : FarOutside;
+                }
+            }
+        });
+        if (cancelled()) {
+            Clear();
+            return false;
+        }
+
+        std::vector<size_t> allocated;
+        for (size_t i = 0; i < totalBricks; i++) {
+            if (allocate[i]) {
+                field.bricks[i] = static_cast<int32_t>(allocated.size());
+                allocated.push_back(i);
+            }
+        }
+
+        // 2. 计算已分配块的采样；窄带外的采样只需要符号
+        field.values.resize(allocated.size() * BrickValues);
+        parallelFor(allocated.size(), 4, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) {
+                double base[3];
+                brickOrigin(allocated[k], base);
+                float* out = &field.values[k * BrickValues];
+
+                for (int z = 0; z < BrickSamples; z++) {
+                    for (int y = 0; y < BrickSamples; y++) {
+                        for (int x = 0; x < BrickSamples; x++) {
+                            double p[3] = { base[0] + x * voxel, base[1] + y * voxel, base[2] + z * voxel };
+                            MeshBVH::Hit hit;
+                            if (bvh.FindClosestPoint(p, band, hit)) {
+                                double distance = std::min(hit.distance, band);
+                                *out++ = static_cast<float>(isInside(p, &hit) ? distance : -distance);
+                            } else {
+                                *out++ = static_cast<float>(isInside(p, nullptr) ? band : -band);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        if (cancelled()) {
+            Clear();
+            return false;
+        }
+
+        field.buildMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "DistanceField: Built " << field.brickDims[0] * BrickSize << "x"
+                 << field.brickDims[1] * BrickSize << "x" << field.brickDims[2] * BrickSize
+                 << " grid, voxel " << voxel << ", band " << band << ", "
+                 << allocated.size() << "/" << totalBricks << " bricks, "
+                 << GetMemoryBytes() / 1024 << " KB, " << field.buildMs << " ms" << std::endl;
+        return true;
+    }
+
+    void DistanceField::Clear() {
+        pImpl->Reset();
+    }
+
+    bool DistanceField::IsEmpty() const {
+        return pImpl->bricks.empty();
+    }
+
+    double DistanceField::Sample(const double point[3]) const {
+        return pImpl->Sample(point, nullptr);
+    }
+
+    double DistanceField::SampleGradient(const double point[3], double gradient[3]) const {
+        return pImpl->Sample(point, gradient);
+    }
+
+    double DistanceField::GetVoxelSize() const {
+        return pImpl->voxelSize;
+    }
+
+    double DistanceField::GetBandWidth() const {
+        return pImpl->bandWidth;
+    }
+
+    void DistanceField::GetBounds(double bounds[6]) const {
+        for (int a = 0; a < 3; a++) {
+            bounds[a * 2] = pImpl->origin[a];
+            bounds[a * 2 + 1] = pImpl->origin[a] + pImpl->sampleMax[a] * pImpl->voxelSize;
+        }
+    }
+
+    void DistanceField::GetRequestedSettings(double& voxelSize, double& bandWidth) const {
+        voxelSize = pImpl->requestedVoxelSize;
+        bandWidth = pImpl->requestedBandWidth;
+    }
+
+    unsigned long long DistanceField::GetGeometryHash() const {
+        return pImpl->geometryHash;
+    }
+
+    size_t DistanceField::GetAllocatedBricks() const {
+        return pImpl->values.size() / BrickValues;
+    }
+
+    size_t DistanceField::GetTotalBricks() const {
+        return pImpl->bricks.size();
+    }
+
+    size_t DistanceField::GetMemoryBytes() const {
+        return pImpl->bricks.size() * sizeof(int32_t) + pImpl->values.size() * sizeof(float);
+    }
+
+    double DistanceField::GetBuildMs() const {
+        return pImpl->buildMs;
+    }
+
+    void DistanceField::Serialize(std::vector<unsigned char>& data) const {
+        const Impl& field = *pImpl;
+        data.clear();
+        data.reserve(128 + GetMemoryBytes());
+
+        uint64_t hash = field.geometryHash;
+        int32_t dims[3] = { field.brickDims[0], field.brickDims[1], field.brickDims[2] };
+        uint64_t valueCount = field.values.size();
+
+        Append(data, FormatMagic, 4);
+        Append(data, &FormatVersion, 1);
+        Append(data, &hash, 1);
+        Append(data, &field.requestedVoxelSize, 1);
+        Append(data, &field.requestedBandWidth, 1);
+        Append(data, &field.voxelSize, 1);
+        Append(data, &field.bandWidth, 1);
+        Append(data, field.origin, 3);
+        Append(data, dims, 3);
+        Append(data, &valueCount, 1);
+        Append(data, field.bricks.data(), field.bricks.size());
+        Append(data, field.values.data(), field.values.size());
+    }
+
+    bool DistanceField::Deserialize(const unsigned char* data, size_t size) {
+        if (!data) return false;
+
+        Reader reader = { data, size, 0 };
+        char magic[4];
+        uint32_t version = 0;
+        uint64_t hash = 0;
+        double requested[2], voxel = 0.0, band = 0.0, origin[3];
+        int32_t dims[3];
+        uint64_t valueCount = 0;
+
+        if (!reader.Read(magic, 4) || std::memcmp(magic, FormatMagic, 4) != 0 ||
+            !reader.Read(&version, 1) || version != FormatVersion) {
+            std::cerr << "DistanceField: Unrecognized data format" << std::endl;
+            return false;
+        }
+        if (!reader.Read(&hash, 1) || !reader.Read(requested, 2) || !reader.Read(&voxel, 1) ||
+            !reader.Read(&band, 1) || !reader.Read(origin, 3) || !reader.Read(dims, 3) ||
+            !reader.Read(&valueCount, 1)) {
+            std::cerr << "DistanceField: Truncated data" << std::endl;
+            return false;
+        }
+
+        size_t totalBricks = 1;
+        for (int a = 0; a < 3; a++) {
+            if (dims[a] <= 0) return false;
+            totalBricks *= static_cast<size_t>(dims[a]);
+            if (totalBricks > MaxTotalBricks) return false;
+        }
+        if (!(voxel > 0.0) || !(band > 0.0) || valueCount % BrickValues != 0) {
+            std::cerr << "DistanceField: Invalid grid parameters" << std::endl;
+            return false;
+        }
+
+        std::vector<int32_t> bricks(totalBricks);
+        std::vector<float> values;
+        if (!reader.Read(bricks.data(), bricks.size()) || valueCount > (size - reader.offset) / sizeof(float)) {
+            std::cerr << "DistanceField: Truncated data" << std::endl;
+            return false;
+        }
+        values.resize(static_cast<size_t>(valueCount));
+        if (!reader.Read(values.data(), values.size())) {
+            return false;
+        }
+
+        // 块表中的序号必须在数据范围内
+        int64_t allocated = static_cast<int64_t>(valueCount / BrickValues);
+        for (int32_t brick : bricks) {
+            if (brick >= allocated || (brick < 0 && brick != FarInside && brick != FarOutside)) {
+                std::cerr << "DistanceField: Corrupted brick table" << std::endl;
+                return false;
+            }
+        }
+
+        Impl& field = *pImpl;
+        field.Reset();
+        field.geometryHash = hash;
+        field.requestedVoxelSize = requested[0];
+        field.requestedBandWidth = requested[1];
+        field.voxelSize = voxel;
+        field.bandWidth = band;
+        for (int a = 0; a < 3; a++) {
+            field.origin[a] = origin[a];
+            field.brickDims[a] = dims[a];
+        }
+        field.bricks.swap(bricks);
+        field.values.swap(values);
+        field.UpdateDerived();
+        return true;
+    }
+
+} // namespace BronchoscopyLib
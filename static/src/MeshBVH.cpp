@@ -0,0 +1,887 @@
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+
+// VTK headers
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// Standard headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        const float Infinity = std::numeric_limits<float>::infinity();
+
+        // 分箱SAH的箱数
+        const int BinCount = 16;
+        // SAH代价更低时才分裂；超过此数的叶子强制分裂
+        const uint32_t MaxLeafSize = 8;
+        // 三角形数达到此值的子树并行构建
+        const uint32_t ParallelBuildThreshold = 8192;
+        // 遍历栈深度，构建时达到此深度直接生成叶子
+        const int MaxTreeDepth = 60;
+        // 批量查询每块的射线数
+        const size_t RayBatchGrain = 256;
+        // 环绕数查询：距离超过节点半径此倍数时用偶极子近似代替子树
+        const float WindingFarRatio = 2.0f;
+        const double FourPi = 4.0 * 3.14159265358979323846;
+
+        // 展平后的节点（32字节，两个节点占一条缓存行）
+        // 内部节点的左孩子为下一个节点，offset为右孩子下标；叶子的offset为第一个三角形，count为三角形数
+        struct Node {
+            float boundsMin[3];
+            uint32_t offset;
+            float boundsMax[3];
+            uint32_t count;
+
+            bool IsLeaf() const { return count > 0; }
+        };
+
+        // 求交用的三角形：顶点和两条边
+        struct Triangle {
+            float v0[3];
+            float edge1[3];
+            float edge2[3];
+        };
+
+        // 节点的环绕数矩：面积加权法线之和（偶极子强度）、面积加权中心和包围半径
+        struct NodeMoment {
+            float center[3];
+            float radius;
+            float normal[3];
+            float area;
+        };
+
+        // 构建用的三角形包围盒和质心
+        struct BuildPrimitive {
+            float boundsMin[3];
+            float boundsMax[3];
+            float centroid[3];
+        };
+
+        struct Box {
+            float min[3];
+            float max[3];
+
+            Box() {
+                min[0] = min[1] = min[2] = Infinity;
+                max[0] = max[1] = max[2] = -Infinity;
+            }
+
+            void Grow(const float lo[3], const float hi[3]) {
+                for (int a = 0; a < 3; a++) {
+                    min[a] = std::min(min[a], lo[a]);
+                    max[a] = std::max(max[a], hi[a]);
+                }
+            }
+
+            void Grow(const Box& other) {
+                Grow(other.min, other.max);
+            }
+
+            float Area() const {
+                float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+                if (dx < 0.0f || dy < 0.0f || dz < 0.0f) return 0.0f;
+                return 2.0f * (dx * dy + dy * dz + dz * dx);
+            }
+        };
+
+        float NodeArea(const Node& node) {
+            Box box;
+            box.Grow(node.boundsMin, node.boundsMax);
+            return box.Area();
+        }
+
+        // 子树构建（各子树写入自己的节点数组，并行的两半完成后拼接）
+        struct Builder {
+            const std::vector<BuildPrimitive>& primitives;
+            std::vector<uint32_t>& order;
+            ThreadPool* pool;
+            const std::atomic<bool>* cancelFlag;
+
+            Builder(const std::vector<BuildPrimitive>& prims, std::vector<uint32_t>& indices, ThreadPool* threads,
+                    const std::atomic<bool>* cancel)
+                : primitives(prims), order(indices), pool(threads), cancelFlag(cancel) {}
+
+            void BuildNode(uint32_t begin, uint32_t end, int depth, std::vector<Node>& out) {
+                uint32_t nodeIndex = static_cast<uint32_t>(out.size());
+                out.emplace_back();
+
+                // 节点包围盒和质心包围盒
+                Box bounds, centroids;
+                for (uint32_t i = begin; i < end; i++) {
+                    const BuildPrimitive& prim = primitives[order[i]];
+                    bounds.Grow(prim.boundsMin, prim.boundsMax);
+                    centroids.Grow(prim.centroid, prim.centroid);
+                }
+                std::copy(bounds.min, bounds.min + 3, out[nodeIndex].boundsMin);
+                std::copy(bounds.max, bounds.max + 3, out[nodeIndex].boundsMax);
+
+                // 取消后剩余子树直接作为叶子结束递归（结果随后被丢弃）
+                uint32_t count = end - begin;
+                if (count <= 2 || depth >= MaxTreeDepth || (cancelFlag && cancelFlag->load())) {
+                    MakeLeaf(out[nodeIndex], begin, count);
+                    return;
+                }
+
+                // 在三个轴上分箱，求SAH代价最小的分裂
+                int bestAxis = -1;
+                int bestSplit = 0;
+                float bestCost = Infinity;
+                for (int axis = 0; axis < 3; axis++) {
+                    float extent = centroids.max[axis] - centroids.min[axis];
+                    if (!(extent > 0.0f)) continue;
+
+                    Box binBounds[BinCount];
+                    uint32_t binCounts[BinCount] = { 0 };
+                    float scale = BinCount / extent;
+                    for (uint32_t i = begin; i < end; i++) {
+                        const BuildPrimitive& prim = primitives[order[i]];
+                        int bin = std::min(BinCount - 1,
+                            static_cast<int>((prim.centroid[axis] - centroids.min[axis]) * scale));
+                        binCounts[bin]++;
+                        binBounds[bin].Grow(prim.boundsMin, prim.boundsMax);
+                    }
+
+                    // 从右向左累计，再从左向右扫描各分裂位置
+                    float rightArea[BinCount];
+                    uint32_t rightCount[BinCount];
+                    Box accumulated;
+                    uint32_t accumulatedCount = 0;
+                    for (int b = BinCount - 1; b > 0; b--) {
+                        accumulated.Grow(binBounds[b]);
+                        accumulatedCount += binCounts[b];
+                        rightArea[b] = accumulated.Area();
+                        rightCount[b] = accumulatedCount;
+                    }
+
+                    Box left;
+                    uint32_t leftCount = 0;
+                    for (int b = 1; b < BinCount; b++) {
+                        left.Grow(binBounds[b - 1]);
+                        leftCount += binCounts[b - 1];
+                        if (leftCount == 0 || rightCount[b] == 0) continue;
+
+                        float cost = leftCount * left.Area() + rightCount[b] * rightArea[b];
+                        if (cost < bestCost) {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = b;
+                        }
+                    }
+                }
+
+                uint32_t mid = begin;
+                if (bestAxis >= 0) {
+                    // 与叶子比较：遍历代价1 + 两侧期望求交数
+                    float area = bounds.Area();
+                    float splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+                    if (splitCost >= static_cast<float>(count) && count <= MaxLeafSize) {
+                        MakeLeaf(out[nodeIndex], begin, count);
+                        return;
+                    }
+
+                    float minimum = centroids.min[bestAxis];
+                    float scale = BinCount / (centroids.max[bestAxis] - minimum);
+                    uint32_t* first = order.data() + begin;
+                    uint32_t* last = order.data() + end;
+                    mid = begin + static_cast<uint32_t>(std::partition(first, last, [&](uint32_t index) {
+                        int bin = std::min(BinCount - 1,
+                            static_cast<int>((primitives[index].centroid[bestAxis] - minimum) * scale));
+                        return bin < bestSplit;
+                    }) - first);
+                }
+
+                // 质心重合（无法分箱）或分裂退化时对半分
+                if (mid == begin || mid == end) {
+                    if (count <= MaxLeafSize) {
+                        MakeLeaf(out[nodeIndex], begin, count);
+                        return;
+                    }
+                    mid = begin + count / 2;
+                }
+
+                uint32_t rightIndex = 0;
+                if (pool && count >= ParallelBuildThreshold) {
+                    std::vector<Node> halves[2];
+                    pool->ParallelFor(2, 1, [&](size_t first, size_t last) {
+                        for (size_t half = first; half < last; half++) {
+                            if (half == 0) {
+                                BuildNode(begin, mid, depth + 1, halves[0]);
+                            } else {
+                                BuildNode(mid, end, depth + 1, halves[1]);
+                            }
+                        }
+                    });
+                    Append(out, halves[0]);
+                    rightIndex = static_cast<uint32_t>(out.size());
+                    Append(out, halves[1]);
+                } else {
+                    BuildNode(begin, mid, depth + 1, out);
+                    rightIndex = static_cast<uint32_t>(out.size());
+                    BuildNode(mid, end, depth + 1, out);
+                }
+
+                out[nodeIndex].offset = rightIndex;
+                out[nodeIndex].count = 0;
+            }
+
+            static void MakeLeaf(Node& node, uint32_t begin, uint32_t count) {
+                node.offset = begin;
+                node.count = count;
+            }
+
+            // 拼接子树，内部节点的右孩子下标按拼接位置平移
+            static void Append(std::vector<Node>& out, const std::vector<Node>& subtree) {
+                uint32_t base = static_cast<uint32_t>(out.size());
+                out.reserve(out.size() + subtree.size());
+                for (const Node& node : subtree) {
+                    out.push_back(node);
+                    if (!node.IsLeaf()) {
+                        out.back().offset += base;
+                    }
+                }
+            }
+        };
+
+        // 射线与包围盒的进入距离，未命中或远于tMax时返回无穷大
+        inline float EnterDistance(const Node& node, const float origin[3], const float inverse[3], float tMax) {
+            float t0 = (node.boundsMin[0] - origin[0]) * inverse[0];
+            float t1 = (node.boundsMax[0] - origin[0]) * inverse[0];
+            float tNear = std::min(t0, t1), tFar = std::max(t0, t1);
+
+            t0 = (node.boundsMin[1] - origin[1]) * inverse[1];
+            t1 = (node.boundsMax[1] - origin[1]) * inverse[1];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+
+            t0 = (node.boundsMin[2] - origin[2]) * inverse[2];
+            t1 = (node.boundsMax[2] - origin[2]) * inverse[2];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+
+            tNear = std::max(tNear, 0.0f);
+            return (tNear <= tFar && tNear < tMax) ? tNear : Infinity;
+        }
+
+        // Moller-Trumbore求交（双面），命中且比tMax近时更新t和重心坐标
+        inline bool IntersectTriangle(const Triangle& tri, const float origin[3], const float direction[3],
+                                      float tMax, float& t, float& u, float& v) {
+            const float* e1 = tri.edge1;
+            const float* e2 = tri.edge2;
+            float p[3] = { direction[1] * e2[2] - direction[2] * e2[1],
+                           direction[2] * e2[0] - direction[0] * e2[2],
+                           direction[0] * e2[1] - direction[1] * e2[0] };
+            float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+            if (std::abs(det) < 1e-12f) return false;
+
+            float invDet = 1.0f / det;
+            float s[3] = { origin[0] - tri.v0[0], origin[1] - tri.v0[1], origin[2] - tri.v0[2] };
+            float uu = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+            if (uu < 0.0f || uu > 1.0f) return false;
+
+            float q[3] = { s[1] * e1[2] - s[2] * e1[1],
+                           s[2] * e1[0] - s[0] * e1[2],
+                           s[0] * e1[1] - s[1] * e1[0] };
+            float vv = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * invDet;
+            if (vv < 0.0f || uu + vv > 1.0f) return false;
+
+            float tt = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+            if (tt < 0.0f || tt >= tMax) return false;
+
+            t = tt;
+            u = uu;
+            v = vv;
+            return true;
+        }
+
+        // 点到包围盒的距离平方
+        inline float BoxDistance2(const Node& node, const float p[3]) {
+            float d2 = 0.0f;
+            for (int a = 0; a < 3; a++) {
+                float d = std::max(std::max(node.boundsMin[a] - p[a], p[a] - node.boundsMax[a]), 0.0f);
+                d2 += d * d;
+            }
+            return d2;
+        }
+
+        inline float Dot(const float a[3], const float b[3]) {
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+        }
+
+        // 三角形上离p最近的点（按Voronoi区域分类），返回重心坐标u、v
+        void ClosestOnTriangle(const Triangle& tri, const float p[3], float& u, float& v) {
+            const float* ab = tri.edge1;
+            const float* ac = tri.edge2;
+            float ap[3] = { p[0] - tri.v0[0], p[1] - tri.v0[1], p[2] - tri.v0[2] };
+
+            float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+            if (d1 <= 0.0f && d2 <= 0.0f) { u = 0.0f; v = 0.0f; return; }
+
+            float bp[3] = { ap[0] - ab[0], ap[1] - ab[1], ap[2] - ab[2] };
+            float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+            if (d3 >= 0.0f && d4 <= d3) { u = 1.0f; v = 0.0f; return; }
+
+            float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+                u = d1 / (d1 - d3); v = 0.0f; return;
+            }
+
+            float cp[3] = { ap[0] - ac[0], ap[1] - ac[1], ap[2] - ac[2] };
+            float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+            if (d6 >= 0.0f && d5 <= d6) { u = 0.0f; v = 1.0f; return; }
+
+            float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+                u = 0.0f; v = d2 / (d2 - d6); return;
+            }
+
+            float va = d3 * d6 - d5 * d4;
+            if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+                float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+                u = 1.0f - w; v = w; return;
+            }
+
+            float denom = 1.0f / (va + vb + vc);
+            u = vb * denom;
+            v = vc * denom;
+        }
+
+        // 射线转换为单精度；方向归一化，逆方向的零分量用极小值代替
+        void PrepareRay(const MeshBVH::Ray& ray, float origin[3], float direction[3], float inverse[3],
+                        float& tMax) {
+            double length = std::sqrt(ray.direction[0] * ray.direction[0] +
+                                      ray.direction[1] * ray.direction[1] +
+                                      ray.direction[2] * ray.direction[2]);
+            for (int a = 0; a < 3; a++) {
+                origin[a] = static_cast<float>(ray.origin[a]);
+                direction[a] = length > 0.0 ? static_cast<float>(ray.direction[a] / length) : 0.0f;
+                float d = std::abs(direction[a]) > 1e-20f ? direction[a] : std::copysign(1e-20f, direction[a]);
+                inverse[a] = 1.0f / d;
+            }
+            tMax = ray.maxDistance > 0.0 ? static_cast<float>(ray.maxDistance) : Infinity;
+            if (length <= 0.0) {
+                tMax = 0.0f;  // 零方向不求交
+            }
+        }
+
+    } // namespace
+
+    class MeshBVH::Impl {
+    public:
+        std::vector<Node> nodes;
+        std::vector<Triangle> triangles;  // 按叶子顺序
+        std::vector<long long> cellIds;   // 与triangles对应的网格单元编号
+        std::vector<NodeMoment> moments;  // 与nodes对应
+        BuildStats stats;
+
+        // 自底向上计算各节点的环绕数矩（孩子的下标总是大于父节点）
+        void ComputeMoments() {
+            moments.assign(nodes.size(), NodeMoment());
+            for (size_t index = nodes.size(); index-- > 0;) {
+                const Node& node = nodes[index];
+                double normal[3] = { 0.0, 0.0, 0.0 };
+                double weighted[3] = { 0.0, 0.0, 0.0 };
+                double area = 0.0;
+
+                auto accumulate = [&](const float n[3], const float c[3], double a) {
+                    for (int k = 0; k < 3; k++) {
+                        normal[k] += n[k];
+                        weighted[k] += c[k] * a;
+                    }
+                    area += a;
+                };
+
+                if (node.IsLeaf()) {
+                    for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                        const Triangle& tri = triangles[i];
+                        float n[3] = { 0.5f * (tri.edge1[1] * tri.edge2[2] - tri.edge1[2] * tri.edge2[1]),
+                                       0.5f * (tri.edge1[2] * tri.edge2[0] - tri.edge1[0] * tri.edge2[2]),
+                                       0.5f * (tri.edge1[0] * tri.edge2[1] - tri.edge1[1] * tri.edge2[0]) };
+                        float c[3];
+                        for (int k = 0; k < 3; k++) {
+                            c[k] = tri.v0[k] + (tri.edge1[k] + tri.edge2[k]) / 3.0f;
+                        }
+                        accumulate(n, c, std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+                    }
+                } else {
+                    const NodeMoment& left = moments[index + 1];
+                    const NodeMoment& right = moments[node.offset];
+                    accumulate(left.normal, left.center, left.area);
+                    accumulate(right.normal, right.center, right.area);
+                }
+
+                NodeMoment& moment = moments[index];
+                float radius2 = 0.0f;
+                for (int k = 0; k < 3; k++) {
+                    moment.normal[k] = static_cast<float>(normal[k]);
+                    moment.center[k] = area > 0.0 ? static_cast<float>(weighted[k] / area)
+                                                  : 0.5f * (node.boundsMin[k] + node.boundsMax[k]);
+                    float extent = std::max(moment.center[k] - node.boundsMin[k], node.boundsMax[k] - moment.center[k]);
+                    radius2 += extent * extent;
+                }
+                moment.radius = std::sqrt(radius2);
+                moment.area = static_cast<float>(area);
+            }
+        }
+
+        void FillHit(uint32_t index, float t, float u, float v, Hit& hit) const {
+            const Triangle& tri = triangles[index];
+            hit.hit = true;
+            hit.distance = t;
+            hit.cellId = cellIds[index];
+            hit.u = u;
+            hit.v = v;
+            for (int a = 0; a < 3; a++) {
+                hit.point[a] = static_cast<double>(tri.v0[a]) + u * tri.edge1[a] + v * tri.edge2[a];
+            }
+
+            const float* e1 = tri.edge1;
+            const float* e2 = tri.edge2;
+            double n[3] = { static_cast<double>(e1[1]) * e2[2] - static_cast<double>(e1[2]) * e2[1],
+                            static_cast<double>(e1[2]) * e2[0] - static_cast<double>(e1[0]) * e2[2],
+                            static_cast<double>(e1[0]) * e2[1] - static_cast<double>(e1[1]) * e2[0] };
+            double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int a = 0; a < 3; a++) {
+                hit.normal[a] = length > 0.0 ? n[a] / length : 0.0;
+            }
+        }
+
+        // anyHit为true时找到任意交点即返回
+        bool Traverse(const Ray& ray, bool anyHit, Hit* hit) const {
+            if (nodes.empty()) return false;
+
+            float origin[3], direction[3], inverse[3], tMax;
+            PrepareRay(ray, origin, direction, inverse, tMax);
+            if (EnterDistance(nodes[0], origin, inverse, tMax) == Infinity) return false;
+
+            uint32_t stack[MaxTreeDepth + 4];
+            int stackSize = 0;
+            uint32_t current = 0;
+            uint32_t hitIndex = 0;
+            float hitU = 0.0f, hitV = 0.0f;
+            bool found = false;
+
+            for (;;) {
+                const Node& node = nodes[current];
+                if (node.IsLeaf()) {
+                    for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                        float t, u, v;
+                        if (IntersectTriangle(triangles[i], origin, direction, tMax, t, u, v)) {
+                            if (anyHit) return true;
+                            tMax = t;
+                            hitIndex = i;
+                            hitU = u;
+                            hitV = v;
+                            found = true;
+                        }
+                    }
+                } else {
+                    // 先进入较近的孩子，较远的入栈
+                    uint32_t left = current + 1;
+                    uint32_t right = node.offset;
+                    float tLeft = EnterDistance(nodes[left], origin, inverse, tMax);
+                    float tRight = EnterDistance(nodes[right], origin, inverse, tMax);
+                    if (tLeft > tRight) {
+                        std::swap(tLeft, tRight);
+                        std::swap(left, right);
+                    }
+                    if (tLeft != Infinity) {
+                        if (tRight != Infinity) {
+                            stack[stackSize++] = right;
+                        }
+                        current = left;
+                        continue;
+                    }
+                }
+
+                // 出栈时跳过已比当前最近交点远的节点
+                bool next = false;
+                while (stackSize > 0) {
+                    current = stack[--stackSize];
+                    if (EnterDistance(nodes[current], origin, inverse, tMax) != Infinity) {
+                        next = true;
+                        break;
+                    }
+                }
+                if (!next) break;
+            }
+
+            if (found && hit) {
+                FillHit(hitIndex, tMax, hitU, hitV, *hit);
+            }
+            return found;
+        }
+    };
+
+    MeshBVH::MeshBVH() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    MeshBVH::~MeshBVH() = default;
+
+    bool MeshBVH::Build(vtkPolyData* mesh, ThreadPool* pool, const std::atomic<bool>* cancelFlag) {
+        Clear();
+        if (!mesh || !mesh->GetPoints() || mesh->GetNumberOfPolys() == 0) {
+            std::cerr << "MeshBVH: Mesh has no polygons" << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto cancelled = [cancelFlag]() {
+            return cancelFlag && cancelFlag->load();
+        };
+
+        // 按分块执行，取消后跳过尚未开始的分块
+        auto parallelFor = [pool, &cancelled](size_t count, size_t grain,
+                                              const std::function<void(size_t, size_t)>& body) {
+            auto guarded = [&](size_t begin, size_t end) {
+                if (!cancelled()) body(begin, end);
+            };
+            if (pool) {
+                pool->ParallelFor(count, grain, guarded);
+            } else {
+                for (size_t begin = 0; begin < count; begin += grain) {
+                    guarded(begin, std::min(count, begin + grain));
+                }
+            }
+        };
+
+        // 提取三角形（多边形按扇形三角化）；多边形单元编号排在顶点和线之后
+        std::vector<vtkIdType> indices;
+        std::vector<long long> sourceCells;
+        indices.reserve(mesh->GetNumberOfPolys() * 3);
+        sourceCells.reserve(mesh->GetNumberOfPolys());
+
+        long long cellId = mesh->GetNumberOfVerts() + mesh->GetNumberOfLines();
+        vtkCellArray* polys = mesh->GetPolys();
+        vtkIdType npts = 0;
+        vtkIdType* pts = nullptr;
+        polys->InitTraversal();
+        while (polys->GetNextCell(npts, pts)) {
+            for (vtkIdType k = 1; k + 1 < npts; k++) {
+                indices.push_back(pts[0]);
+                indices.push_back(pts[k]);
+                indices.push_back(pts[k + 1]);
+                sourceCells.push_back(cellId);
+            }
+            cellId++;
+        }
+
+        size_t count = sourceCells.size();
+        if (count == 0 || count >= std::numeric_limits<uint32_t>::max()) {
+            std::cerr << "MeshBVH: Unsupported triangle count " << count << std::endl;
+            return false;
+        }
+
+        // 三角形顶点、包围盒和质心
+        vtkPoints* points = mesh->GetPoints();
+        std::vector<Triangle> unordered(count);
+        std::vector<BuildPrimitive> primitives(count);
+        parallelFor(count, 4096, [&](size_t begin, size_t end) {
+            double p[3][3];
+            for (size_t t = begin; t < end; t++) {
+                for (int k = 0; k < 3; k++) {
+                    points->GetPoint(indices[t * 3 + k], p[k]);
+                }
+
+                Triangle& tri = unordered[t];
+                BuildPrimitive& prim = primitives[t];
+                for (int a = 0; a < 3; a++) {
+                    float v0 = static_cast<float>(p[0][a]);
+                    float v1 = static_cast<float>(p[1][a]);
+                    float v2 = static_cast<float>(p[2][a]);
+                    tri.v0[a] = v0;
+                    tri.edge1[a] = v1 - v0;
+                    tri.edge2[a] = v2 - v0;
+                    prim.boundsMin[a] = std::min(v0, std::min(v1, v2));
+                    prim.boundsMax[a] = std::max(v0, std::max(v1, v2));
+                    prim.centroid[a] = (v0 + v1 + v2) / 3.0f;
+                }
+            }
+        });
+        if (cancelled()) return false;
+
+        // 几何哈希（FNV-1a，按网格原顺序）和相对包围盒中心的有符号体积
+        BuildStats& stats = pImpl->stats;
+        Box meshBounds;
+        for (const BuildPrimitive& prim : primitives) {
+            meshBounds.Grow(prim.boundsMin, prim.boundsMax);
+        }
+        float center[3];
+        for (int a = 0; a < 3; a++) {
+            center[a] = 0.5f * (meshBounds.min[a] + meshBounds.max[a]);
+        }
+        unsigned long long hash = 1469598103934665603ULL;
+        double volume = 0.0;
+        for (const Triangle& tri : unordered) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&tri);
+            for (size_t b = 0; b < sizeof(Triangle); b++) {
+                hash = (hash ^ bytes[b]) * 1099511628211ULL;
+            }
+
+            double a[3], e1[3], e2[3];
+            for (int k = 0; k < 3; k++) {
+                a[k] = tri.v0[k] - center[k];
+                e1[k] = tri.edge1[k];
+                e2[k] = tri.edge2[k];
+            }
+            volume += (a[0] * (e1[1] * e2[2] - e1[2] * e2[1]) +
+                       a[1] * (e1[2] * e2[0] - e1[0] * e2[2]) +
+                       a[2] * (e1[0] * e2[1] - e1[1] * e2[0])) / 6.0;
+        }
+        stats.geometryHash = hash;
+        stats.signedVolume = volume;
+
+        std::vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; i++) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+
+        Builder builder(primitives, order, pool, cancelFlag);
+        pImpl->nodes.reserve(count / 2 + 1);
+        builder.BuildNode(0, static_cast<uint32_t>(count), 0, pImpl->nodes);
+        if (cancelled()) {
+            Clear();
+            return false;
+        }
+
+        // 三角形按叶子顺序重排
+        pImpl->triangles.resize(count);
+        pImpl->cellIds.resize(count);
+        parallelFor(count, 16384, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                pImpl->triangles[i] = unordered[order[i]];
+                pImpl->cellIds[i] = sourceCells[order[i]];
+            }
+        });
+        pImpl->nodes.shrink_to_fit();
+
+        // 统计：叶子数、深度和归一化SAH代价
+        stats.triangles = count;
+        stats.nodes = pImpl->nodes.size();
+        float rootArea = NodeArea(pImpl->nodes[0]);
+        double cost = 0.0;
+        std::vector<std::pair<uint32_t, int>> stack(1, std::make_pair(0u, 0));
+        while (!stack.empty()) {
+            uint32_t index = stack.back().first;
+            int depth = stack.back().second;
+            stack.pop_back();
+
+            const Node& node = pImpl->nodes[index];
+            double area = rootArea > 0.0f ? NodeArea(node) / rootArea : 1.0;
+            stats.maxDepth = std::max(stats.maxDepth, depth);
+            if (node.IsLeaf()) {
+                stats.leaves++;
+                cost += area * node.count;
+            } else {
+                cost += area;
+                stack.emplace_back(index + 1, depth + 1);
+                stack.emplace_back(node.offset, depth + 1);
+            }
+        }
+        stats.sahCost = cost;
+        pImpl->ComputeMoments();
+        stats.memoryBytes = pImpl->nodes.size() * (sizeof(Node) + sizeof(NodeMoment)) +
+                            pImpl->triangles.size() * sizeof(Triangle) +
+                            pImpl->cellIds.size() * sizeof(long long);
+        stats.buildMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "MeshBVH: Built over " << count << " triangles - "
+                 << stats.nodes << " nodes, depth " << stats.maxDepth
+                 << ", SAH cost " << stats.sahCost << ", "
+                 << stats.memoryBytes / 1024 << " KB, " << stats.buildMs << " ms" << std::endl;
+        return true;
+    }
+
+    void MeshBVH::Clear() {
+        pImpl->nodes.clear();
+        pImpl->triangles.clear();
+        pImpl->cellIds.clear();
+        pImpl->moments.clear();
+        pImpl->stats = BuildStats();
+    }
+
+    bool MeshBVH::IsEmpty() const {
+        return pImpl->nodes.empty();
+    }
+
+    const MeshBVH::BuildStats& MeshBVH::GetBuildStats() const {
+        return pImpl->stats;
+    }
+
+    void MeshBVH::GetBounds(double bounds[6]) const {
+        if (pImpl->nodes.empty()) {
+            for (int i = 0; i < 6; i++) bounds[i] = 0.0;
+            return;
+        }
+        const Node& root = pImpl->nodes[0];
+        for (int a = 0; a < 3; a++) {
+            bounds[a * 2] = root.boundsMin[a];
+            bounds[a * 2 + 1] = root.boundsMax[a];
+        }
+    }
+
+    bool MeshBVH::Intersect(const Ray& ray, Hit& hit) const {
+        hit = Hit();
+        return pImpl->Traverse(ray, false, &hit);
+    }
+
+    bool MeshBVH::IsOccluded(const Ray& ray) const {
+        return pImpl->Traverse(ray, true, nullptr);
+    }
+
+    void MeshBVH::IntersectBatch(const std::vector<Ray>& rays, std::vector<Hit>& hits,
+                                 ThreadPool* pool) const {
+        hits.assign(rays.size(), Hit());
+
+        auto body = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                pImpl->Traverse(rays[i], false, &hits[i]);
+            }
+        };
+
+        if (pool) {
+            pool->ParallelFor(rays.size(), RayBatchGrain, body);
+        } else {
+            body(0, rays.size());
+        }
+    }
+
+    bool MeshBVH::FindClosestPoint(const double point[3], double maxDistance, Hit& hit) const {
+        hit = Hit();
+        const std::vector<Node>& nodes = pImpl->nodes;
+        if (nodes.empty()) return false;
+
+        float p[3] = { static_cast<float>(point[0]), static_cast<float>(point[1]),
+                       static_cast<float>(point[2]) };
+        float best2 = maxDistance > 0.0 ? static_cast<float>(maxDistance * maxDistance) : Infinity;
+        if (BoxDistance2(nodes[0], p) > best2) return false;
+
+        uint32_t stack[MaxTreeDepth + 4];
+        int stackSize = 0;
+        uint32_t current = 0;
+        uint32_t bestIndex = 0;
+        float bestU = 0.0f, bestV = 0.0f;
+        bool found = false;
+
+        for (;;) {
+            const Node& node = nodes[current];
+            if (node.IsLeaf()) {
+                for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                    const Triangle& tri = pImpl->triangles[i];
+                    float u, v;
+                    ClosestOnTriangle(tri, p, u, v);
+                    float d2 = 0.0f;
+                    for (int a = 0; a < 3; a++) {
+                        float d = tri.v0[a] + u * tri.edge1[a] + v * tri.edge2[a] - p[a];
+                        d2 += d * d;
+                    }
+                    if (d2 <= best2) {
+                        best2 = d2;
+                        bestIndex = i;
+                        bestU = u;
+                        bestV = v;
+                        found = true;
+                    }
+                }
+            } else {
+                uint32_t left = current + 1;
+                uint32_t right = node.offset;
+                float dLeft = BoxDistance2(nodes[left], p);
+                float dRight = BoxDistance2(nodes[right], p);
+                if (dLeft > dRight) {
+                    std::swap(dLeft, dRight);
+                    std::swap(left, right);
+                }
+                if (dLeft <= best2) {
+                    if (dRight <= best2) {
+                        stack[stackSize++] = right;
+                    }
+                    current = left;
+                    continue;
+                }
+            }
+
+            bool next = false;
+            while (stackSize > 0) {
+                current = stack[--stackSize];
+                if (BoxDistance2(nodes[current], p) <= best2) {
+                    next = true;
+                    break;
+                }
+            }
+            if (!next) break;
+        }
+
+        if (found) {
+            pImpl->FillHit(bestIndex, std::sqrt(best2), bestU, bestV, hit);
+        }
+        return found;
+    }
+
+    double MeshBVH::GetWindingNumber(const double point[3]) const {
+        const std::vector<Node>& nodes = pImpl->nodes;
+        if (nodes.empty()) return 0.0;
+
+        // 远处的子树按偶极子近似，近处的三角形按精确立体角（Van Oosterom-Strackee）累加
+        double solidAngle = 0.0;
+        uint32_t stack[MaxTreeDepth + 4];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0) {
+            uint32_t current = stack[--stackSize];
+            const Node& node = nodes[current];
+            const NodeMoment& moment = pImpl->moments[current];
+
+            double d[3] = { moment.center[0] - point[0], moment.center[1] - point[1], moment.center[2] - point[2] };
+            double distance2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+            double far = WindingFarRatio * moment.radius;
+            if (distance2 > far * far) {
+                solidAngle += (moment.normal[0] * d[0] + moment.normal[1] * d[1] + moment.normal[2] * d[2]) /
+                              (distance2 * std::sqrt(distance2));
+                continue;
+            }
+
+            if (!node.IsLeaf()) {
+                stack[stackSize++] = node.offset;
+                stack[stackSize++] = current + 1;
+                continue;
+            }
+
+            for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                const Triangle& tri = pImpl->triangles[i];
+                double a[3], b[3], c[3];
+                for (int k = 0; k < 3; k++) {
+                    a[k] = tri.v0[k] - point[k];
+                    b[k] = a[k] + tri.edge1[k];
+                    c[k] = a[k] + tri.edge2[k];
+                }
+                double la = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+                double lb = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+                double lc = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+                double det = a[0] * (b[1] * c[2] - b[2] * c[1]) -
+                             a[1] * (b[0] * c[2] - b[2] * c[0]) +
+                             a[2] * (b[0] * c[1] - b[1] * c[0]);
+                double ab = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+                double bc = b[0] * c[0] + b[1] * c[1] + b[2] * c[2];
+                double ca = c[0] * a[0] + c[1] * a[1] + c[2] * a[2];
+                solidAngle += 2.0 * std::atan2(det, la * lb * lc + ab * lc + bc * la + ca * lb);
+            }
+        }
+        return solidAngle / FourPi;
+    }
+
+} // namespace BronchoscopyLib
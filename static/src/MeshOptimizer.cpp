@@ -0,0 +1,1005 @@
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+
+// VTK头文件
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkShortArray.h>
+
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+namespace BronchoscopyLib {
+
+    const char* MeshOptimizer::CompactNormalArrayName = "NormalsOct";
+
+    namespace {
+
+        // Forsyth评分参数（参见 "Linear-Speed Vertex Cache Optimisation"）
+        const int kMaxCacheSize = 64;
+        const float kCacheDecayPower = 1.5f;
+        const float kLastTriScore = 0.75f;
+        const float kValenceBoostScale = 2.0f;
+        const float kValenceBoostPower = 0.5f;
+
+        struct VertexState {
+            int cachePos;           // LRU缓存中的位置，-1表示不在缓存中
+            int activeTriangles;    // 尚未输出的相邻三角形数
+            int adjacencyStart;     // 在邻接数组中的起始位置
+            float score;
+        };
+
+        float ComputeVertexScore(const VertexState& v, int cacheSize) {
+            if (v.activeTriangles == 0) {
+                // 没有剩余三角形，不再参与评分
+                return -1.0f;
+            }
+
+            float score = 0.0f;
+            if (v.cachePos >= 0) {
+                if (v.cachePos < 3) {
+                    // 刚使用过的三个顶点固定得分，避免偏向刚输出三角形的“条带”方向
+                    score = kLastTriScore;
+                } else {
+                    const float scaler = 1.0f / (cacheSize - 3);
+                    score = 1.0f - (v.cachePos - 3) * scaler;
+                    score = std::pow(score, kCacheDecayPower);
+                }
+            }
+
+            // 剩余三角形少的顶点优先处理，尽快将其移出缓存
+            score += kValenceBoostScale *
+                     std::pow(static_cast<float>(v.activeTriangles), -kValenceBoostPower);
+            return score;
+        }
+    }
+
+    double MeshOptimizer::ComputeACMR(const std::vector<long long>& indices,
+                                      int vertexCount,
+                                      int cacheSize) {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0 || vertexCount <= 0 || cacheSize <= 0) {
+            return 0.0;
+        }
+
+        // FIFO缓存：记录每个顶点进入缓存时的时间戳
+        std::vector<long long> insertedAt(vertexCount, -1);
+        long long clock = 0;
+        long long misses = 0;
+
+        for (size_t i = 0; i < triangleCount * 3; i++) {
+            long long v = indices[i];
+            if (insertedAt[v] < 0 || clock - insertedAt[v] >= cacheSize) {
+                insertedAt[v] = clock++;
+                misses++;
+            }
+        }
+
+        return static_cast<double>(misses) / static_cast<double>(triangleCount);
+    }
+
+    void MeshOptimizer::OptimizeTriangleOrder(const std::vector<long long>& indices,
+                                              int vertexCount,
+                                              std::vector<long long>& triangleOrder,
+                                              int cacheSize) {
+        const int triangleCount = static_cast<int>(indices.size() / 3);
+        triangleOrder.clear();
+        if (triangleCount == 0 || vertexCount <= 0) return;
+        triangleOrder.reserve(triangleCount);
+
+        cacheSize = std::max(4, std::min(cacheSize, kMaxCacheSize));
+
+        // 构建顶点->三角形邻接表（CSR布局）
+        std::vector<VertexState> vertices(vertexCount);
+        for (auto& v : vertices) {
+            v.cachePos = -1;
+            v.activeTriangles = 0;
+            v.adjacencyStart = 0;
+            v.score = 0.0f;
+        }
+        for (int i = 0; i < triangleCount * 3; i++) {
+            vertices[indices[i]].activeTriangles++;
+        }
+
+        int offset = 0;
+        for (auto& v : vertices) {
+            v.adjacencyStart = offset;
+            offset += v.activeTriangles;
+        }
+
+        std::vector<int> adjacency(offset);
+        std::vector<int> fill(vertexCount, 0);
+        for (int t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                long long v = indices[t * 3 + k];
+                adjacency[vertices[v].adjacencyStart + fill[v]++] = t;
+            }
+        }
+
+        for (auto& v : vertices) {
+            v.score = ComputeVertexScore(v, cacheSize);
+        }
+
+        std::vector<char> emitted(triangleCount, 0);
+
+        // LRU缓存，额外预留3个位置容纳新输出三角形的顶点
+        std::vector<long long> cache;
+        cache.reserve(cacheSize + 3);
+        std::vector<long long> newCache;
+        newCache.reserve(cacheSize + 3);
+
+        int bestTriangle = -1;
+        int fallbackCursor = 0;
+
+        for (int emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+            if (bestTriangle < 0) {
+                // 缓存中没有可用三角形时，顺序扫描下一个未输出的三角形
+                while (fallbackCursor < triangleCount && emitted[fallbackCursor]) {
+                    fallbackCursor++;
+                }
+                bestTriangle = fallbackCursor;
+            }
+
+            const int t = bestTriangle;
+            emitted[t] = 1;
+            triangleOrder.push_back(t);
+
+            // 输出三角形并从顶点的活动邻接中移除
+            newCache.clear();
+            for (int k = 0; k < 3; k++) {
+                long long v = indices[t * 3 + k];
+                if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                    newCache.push_back(v);
+                }
+
+                VertexState& vs = vertices[v];
+                int* adj = &adjacency[vs.adjacencyStart];
+                for (int a = 0; a < vs.activeTriangles; a++) {
+                    if (adj[a] == t) {
+                        std::swap(adj[a], adj[vs.activeTriangles - 1]);
+                        break;
+                    }
+                }
+                vs.activeTriangles--;
+            }
+
+            // 更新LRU缓存：新顶点置前，其余顶点依次后移
+            const auto newEnd = newCache.begin() + newCache.size();
+            for (long long v : cache) {
+                if (std::find(newCache.begin(), newEnd, v) == newEnd) {
+                    newCache.push_back(v);
+                }
+            }
+            cache.swap(newCache);
+
+            // 被挤出缓存的顶点需要重新评分
+            if (static_cast<int>(cache.size()) > cacheSize) {
+                for (size_t i = cacheSize; i < cache.size(); i++) {
+                    VertexState& vs = vertices[cache[i]];
+                    vs.cachePos = -1;
+                    vs.score = ComputeVertexScore(vs, cacheSize);
+                }
+                cache.resize(cacheSize);
+            }
+
+            // 更新缓存内顶点的位置和得分
+            for (size_t i = 0; i < cache.size(); i++) {
+                VertexState& vs = vertices[cache[i]];
+                vs.cachePos = static_cast<int>(i);
+                vs.score = ComputeVertexScore(vs, cacheSize);
+            }
+
+            // 只在缓存相邻的三角形中挑选下一个最佳三角形
+            bestTriangle = -1;
+            float bestScore = -1.0f;
+            for (size_t i = 0; i < cache.size(); i++) {
+                const VertexState& vs = vertices[cache[i]];
+                for (int a = 0; a < vs.activeTriangles; a++) {
+                    int tri = adjacency[vs.adjacencyStart + a];
+                    float score = vertices[indices[tri * 3]].score +
+                                  vertices[indices[tri * 3 + 1]].score +
+                                  vertices[indices[tri * 3 + 2]].score;
+                    if (score > bestScore) {
+                        bestScore = score;
+                        bestTriangle = tri;
+                    }
+                }
+            }
+        }
+    }
+
+    int MeshOptimizer::ComputeFirstUseRemap(const std::vector<long long>& indices,
+                                            int vertexCount,
+                                            std::vector<long long>& remap) {
+        remap.assign(vertexCount, -1);
+
+        long long next = 0;
+        for (long long v : indices) {
+            if (remap[v] < 0) {
+                remap[v] = next++;
+            }
+        }
+        const int usedCount = static_cast<int>(next);
+
+        // 未被三角形引用的顶点保持原有相对顺序放在末尾
+        for (int v = 0; v < vertexCount; v++) {
+            if (remap[v] < 0) {
+                remap[v] = next++;
+            }
+        }
+
+        return usedCount;
+    }
+
+    bool MeshOptimizer::OptimizeVertexCache(vtkPolyData* input, vtkPolyData* output,
+                                            VertexCacheStats* stats) {
+        if (!input || !output || !input->GetPoints()) {
+            std::cerr << "MeshOptimizer: Invalid input mesh" << std::endl;
+            return false;
+        }
+
+        if (input->GetNumberOfVerts() > 0 || input->GetNumberOfLines() > 0 ||
+            input->GetNumberOfStrips() > 0) {
+            std::cerr << "MeshOptimizer: Mesh contains verts/lines/strips, "
+                      << "vertex cache optimization skipped" << std::endl;
+            return false;
+        }
+
+        const vtkIdType numPoints = input->GetNumberOfPoints();
+        const vtkIdType numTriangles = input->GetNumberOfPolys();
+        if (numPoints == 0 || numTriangles == 0) {
+            return false;
+        }
+
+        // 提取三角形索引
+        std::vector<long long> indices;
+        indices.reserve(numTriangles * 3);
+
+        vtkCellArray* polys = input->GetPolys();
+        vtkIdType npts = 0;
+        vtkIdType* pts = nullptr;
+        polys->InitTraversal();
+        while (polys->GetNextCell(npts, pts)) {
+            if (npts != 3) {
+                std::cerr << "MeshOptimizer: Mesh contains non-triangle polygons, "
+                          << "vertex cache optimization skipped" << std::endl;
+                return false;
+            }
+            indices.push_back(pts[0]);
+            indices.push_back(pts[1]);
+            indices.push_back(pts[2]);
+        }
+
+        const int vertexCount = static_cast<int>(numPoints);
+        const int cacheSize = DefaultCacheSize;
+
+        double acmrBefore = ComputeACMR(indices, vertexCount, cacheSize);
+
+        // 1. 三角形重排
+        std::vector<long long> triangleOrder;
+        OptimizeTriangleOrder(indices, vertexCount, triangleOrder, cacheSize);
+
+        std::vector<long long> ordered(indices.size());
+        for (vtkIdType t = 0; t < numTriangles; t++) {
+            long long src = triangleOrder[t];
+            ordered[t * 3] = indices[src * 3];
+            ordered[t * 3 + 1] = indices[src * 3 + 1];
+            ordered[t * 3 + 2] = indices[src * 3 + 2];
+        }
+        indices.swap(ordered);
+        double acmrAfter = ComputeACMR(indices, vertexCount, cacheSize);
+
+        // 2. 顶点按首次使用顺序重编号
+        std::vector<long long> remap;
+        ComputeFirstUseRemap(indices, vertexCount, remap);
+
+        std::vector<long long> inverse(vertexCount);
+        for (int v = 0; v < vertexCount; v++) {
+            inverse[remap[v]] = v;
+        }
+
+        // 重建点和点数据（保持原有精度）
+        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
+        newPoints->SetDataType(input->GetPoints()->GetDataType());
+        newPoints->SetNumberOfPoints(numPoints);
+
+        vtkPoints* inPoints = input->GetPoints();
+        vtkPointData* inPD = input->GetPointData();
+        vtkSmartPointer<vtkPointData> outPD = vtkSmartPointer<vtkPointData>::New();
+        outPD->CopyAllocate(inPD, numPoints);
+
+        double p[3];
+        for (vtkIdType newId = 0; newId < numPoints; newId++) {
+            vtkIdType oldId = inverse[newId];
+            inPoints->GetPoint(oldId, p);
+            newPoints->SetPoint(newId, p);
+            outPD->CopyData(inPD, oldId, newId);
+        }
+
+        // 写出重编号后的三角形
+        vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+        connectivity->SetNumberOfValues(numTriangles * 4);
+        vtkIdType* conn = connectivity->GetPointer(0);
+        for (vtkIdType t = 0; t < numTriangles; t++) {
+            conn[t * 4] = 3;
+            conn[t * 4 + 1] = static_cast<vtkIdType>(remap[indices[t * 3]]);
+            conn[t * 4 + 2] = static_cast<vtkIdType>(remap[indices[t * 3 + 1]]);
+            conn[t * 4 + 3] = static_cast<vtkIdType>(remap[indices[t * 3 + 2]]);
+        }
+
+        vtkSmartPointer<vtkCellArray> newPolys = vtkSmartPointer<vtkCellArray>::New();
+        newPolys->SetCells(numTriangles, connectivity);
+
+        vtkCellData* inCD = input->GetCellData();
+        vtkSmartPointer<vtkCellData> outCD = vtkSmartPointer<vtkCellData>::New();
+        outCD->CopyAllocate(inCD, numTriangles);
+        for (vtkIdType t = 0; t < numTriangles; t++) {
+            outCD->CopyData(inCD, triangleOrder[t], t);
+        }
+
+        output->Initialize();
+        output->SetPoints(newPoints);
+        output->SetPolys(newPolys);
+        output->GetPointData()->PassData(outPD);
+        output->GetCellData()->PassData(outCD);
+
+        if (stats) {
+            stats->acmrBefore = acmrBefore;
+            stats->acmrAfter = acmrAfter;
+            stats->cacheSize = cacheSize;
+            stats->triangles = numTriangles;
+        }
+
+        std::cout << "MeshOptimizer: Vertex cache optimized " << numTriangles
+                  << " triangles, ACMR " << acmrBefore << " -> " << acmrAfter
+                  << " (cache size " << cacheSize << ")" << std::endl;
+
+        return true;
+    }
+
+    void MeshOptimizer::EncodeOctahedralNormal(const float n[3], float encoded[2]) {
+        float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+        if (l1 <= 0.0f) {
+            encoded[0] = 0.0f;
+            encoded[1] = 0.0f;
+            return;
+        }
+        
+        float x = n[0] / l1;
+        float y = n[1] / l1;
+        
+        // 下半球折叠到八面体外侧三角形
+        if (n[2] < 0.0f) {
+            float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+        
+        encoded[0] = x;
+        encoded[1] = y;
+    }
+
+    void MeshOptimizer::DecodeOctahedralNormal(const float encoded[2], float n[3]) {
+        n[0] = encoded[0];
+        n[1] = encoded[1];
+        n[2] = 1.0f - std::abs(encoded[0]) - std::abs(encoded[1]);
+        
+        float t = std::max(-n[2], 0.0f);
+        n[0] += (n[0] >= 0.0f) ? -t : t;
+        n[1] += (n[1] >= 0.0f) ? -t : t;
+        
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0f) {
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+        }
+    }
+
+    bool MeshOptimizer::BuildCompactMesh(vtkPolyData* input, vtkPolyData* output) {
+        if (!input || !output || !input->GetPoints()) {
+            std::cerr << "MeshOptimizer: Invalid input mesh" << std::endl;
+            return false;
+        }
+        
+        vtkDataArray* normals = input->GetPointData()->GetNormals();
+        if (!normals || normals->GetNumberOfComponents() != 3) {
+            std::cerr << "MeshOptimizer: Compact mesh requires point normals" << std::endl;
+            return false;
+        }
+        
+        const vtkIdType numPoints = input->GetNumberOfPoints();
+        
+        // 1. 点坐标统一为float32（双精度输入只转换这一次）
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToFloat();
+        points->SetNumberOfPoints(numPoints);
+        
+        vtkPoints* inPoints = input->GetPoints();
+        vtkFloatArray* floatPoints = vtkFloatArray::SafeDownCast(points->GetData());
+        float* dst = floatPoints->GetPointer(0);
+        double p[3];
+        for (vtkIdType i = 0; i < numPoints; i++) {
+            inPoints->GetPoint(i, p);
+            dst[i * 3] = static_cast<float>(p[0]);
+            dst[i * 3 + 1] = static_cast<float>(p[1]);
+            dst[i * 3 + 2] = static_cast<float>(p[2]);
+        }
+        
+        // 2. 法线八面体编码为2个snorm16分量（12字节 -> 4字节）
+        vtkSmartPointer<vtkShortArray> packed = vtkSmartPointer<vtkShortArray>::New();
+        packed->SetName(CompactNormalArrayName);
+        packed->SetNumberOfComponents(2);
+        packed->SetNumberOfTuples(numPoints);
+        short* packedPtr = packed->GetPointer(0);
+        
+        double nd[3];
+        float n[3];
+        float encoded[2];
+        for (vtkIdType i = 0; i < numPoints; i++) {
+            normals->GetTuple(i, nd);
+            n[0] = static_cast<float>(nd[0]);
+            n[1] = static_cast<float>(nd[1]);
+            n[2] = static_cast<float>(nd[2]);
+            EncodeOctahedralNormal(n, encoded);
+            for (int c = 0; c < 2; c++) {
+                float v = std::max(-1.0f, std::min(1.0f, encoded[c]));
+                packedPtr[i * 2 + c] = static_cast<short>(std::lround(v * 32767.0f));
+            }
+        }
+        
+        // 3. 拓扑直接共享（vtkCellArray为只读使用）
+        output->Initialize();
+        output->SetPoints(points);
+        output->SetPolys(input->GetPolys());
+        output->GetPointData()->AddArray(packed);
+        
+        return true;
+    }
+
+    bool MeshOptimizer::ComputeFeatureNormals(vtkPolyData* input, double featureAngle,
+                                              vtkPolyData* output, ThreadPool* pool,
+                                              const std::atomic<bool>* cancelFlag) {
+        if (!input || !output || !input->GetPoints()) {
+            std::cerr << "MeshOptimizer: Invalid input mesh" << std::endl;
+            return false;
+        }
+
+        if (input->GetNumberOfVerts() > 0 || input->GetNumberOfLines() > 0 ||
+            input->GetNumberOfStrips() > 0) {
+            return false;
+        }
+
+        const vtkIdType numPoints = input->GetNumberOfPoints();
+        const vtkIdType numTriangles = input->GetNumberOfPolys();
+        if (numPoints == 0 || numTriangles == 0) {
+            return false;
+        }
+
+        // 提取三角形索引
+        std::vector<vtkIdType> indices;
+        indices.reserve(numTriangles * 3);
+
+        vtkCellArray* polys = input->GetPolys();
+        vtkIdType npts = 0;
+        vtkIdType* pts = nullptr;
+        polys->InitTraversal();
+        while (polys->GetNextCell(npts, pts)) {
+            if (npts != 3) {
+                return false;
+            }
+            indices.push_back(pts[0]);
+            indices.push_back(pts[1]);
+            indices.push_back(pts[2]);
+        }
+
+        auto cancelled = [cancelFlag]() {
+            return cancelFlag && cancelFlag->load();
+        };
+
+        // 按分块执行，取消后跳过尚未开始的分块
+        auto parallelFor = [pool, &cancelled](size_t count, size_t grain,
+                                              const std::function<void(size_t, size_t)>& body) {
+            auto guarded = [&](size_t begin, size_t end) {
+                if (!cancelled()) body(begin, end);
+            };
+            if (pool) {
+                pool->ParallelFor(count, grain, guarded);
+            } else {
+                for (size_t begin = 0; begin < count; begin += grain) {
+                    guarded(begin, std::min(count, begin + grain));
+                }
+            }
+        };
+
+        // 1. 面法线
+        vtkPoints* inPoints = input->GetPoints();
+        std::vector<double> faceNormals(numTriangles * 3);
+        parallelFor(static_cast<size_t>(numTriangles), 4096, [&](size_t begin, size_t end) {
+            double a[3], b[3], c[3];
+            for (size_t t = begin; t < end; t++) {
+                inPoints->GetPoint(indices[t * 3], a);
+                inPoints->GetPoint(indices[t * 3 + 1], b);
+                inPoints->GetPoint(indices[t * 3 + 2], c);
+
+                double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+                double n[3] = { u[1] * v[2] - u[2] * v[1],
+                                u[2] * v[0] - u[0] * v[2],
+                                u[0] * v[1] - u[1] * v[0] };
+                double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length > 0.0) {
+                    n[0] /= length;
+                    n[1] /= length;
+                    n[2] /= length;
+                }
+                faceNormals[t * 3] = n[0];
+                faceNormals[t * 3 + 1] = n[1];
+                faceNormals[t * 3 + 2] = n[2];
+            }
+        });
+        if (cancelled()) return false;
+
+        // 2. 顶点-三角形邻接（CSR），slot = 三角形编号 * 3 + 角编号
+        std::vector<vtkIdType> adjacencyStart(numPoints + 1, 0);
+        for (vtkIdType v : indices) {
+            adjacencyStart[v + 1]++;
+        }
+        for (vtkIdType v = 0; v < numPoints; v++) {
+            adjacencyStart[v + 1] += adjacencyStart[v];
+        }
+
+        std::vector<vtkIdType> adjacency(indices.size());
+        {
+            std::vector<vtkIdType> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+            for (size_t slot = 0; slot < indices.size(); slot++) {
+                adjacency[fill[indices[slot]]++] = static_cast<vtkIdType>(slot);
+            }
+        }
+
+        // 3. 按顶点将相邻面分组：共享一条平滑边的面属于同一组，每组对应一个输出点
+        const double cosAngle = std::cos(featureAngle * 3.14159265358979323846 / 180.0);
+        std::vector<int> slotGroup(adjacency.size());   // 与adjacency对齐
+        std::vector<int> groupCount(numPoints, 1);
+
+        parallelFor(static_cast<size_t>(numPoints), 1024, [&](size_t begin, size_t end) {
+            std::vector<int> parent;
+            std::vector<std::pair<vtkIdType, int>> edges;  // (对边顶点, 局部面序号)
+            std::vector<int> label;
+
+            for (size_t v = begin; v < end; v++) {
+                const vtkIdType first = adjacencyStart[v];
+                const int count = static_cast<int>(adjacencyStart[v + 1] - first);
+                if (count == 0) continue;
+
+                parent.resize(count);
+                for (int i = 0; i < count; i++) parent[i] = i;
+
+                auto find = [&parent](int i) {
+                    while (parent[i] != i) {
+                        parent[i] = parent[parent[i]];
+                        i = parent[i];
+                    }
+                    return i;
+                };
+
+                edges.clear();
+                for (int i = 0; i < count; i++) {
+                    vtkIdType slot = adjacency[first + i];
+                    vtkIdType tri = slot / 3;
+                    int corner = static_cast<int>(slot % 3);
+                    edges.emplace_back(indices[tri * 3 + (corner + 1) % 3], i);
+                    edges.emplace_back(indices[tri * 3 + (corner + 2) % 3], i);
+                }
+                std::sort(edges.begin(), edges.end());
+
+                // 对边顶点相同的面共享一条边；夹角小于特征角时合并
+                for (size_t runStart = 0; runStart < edges.size(); ) {
+                    size_t runEnd = runStart + 1;
+                    while (runEnd < edges.size() && edges[runEnd].first == edges[runStart].first) {
+                        runEnd++;
+                    }
+
+                    for (size_t a = runStart; a < runEnd; a++) {
+                        for (size_t b = a + 1; b < runEnd; b++) {
+                            const double* na = &faceNormals[(adjacency[first + edges[a].second] / 3) * 3];
+                            const double* nb = &faceNormals[(adjacency[first + edges[b].second] / 3) * 3];
+                            if (na[0] * nb[0] + na[1] * nb[1] + na[2] * nb[2] > cosAngle) {
+                                int ra = find(edges[a].second);
+                                int rb = find(edges[b].second);
+                                if (ra != rb) parent[rb] = ra;
+                            }
+                        }
+                    }
+                    runStart = runEnd;
+                }
+
+                // 按首次出现顺序编号各组
+                label.assign(count, -1);
+                int groups = 0;
+                for (int i = 0; i < count; i++) {
+                    int root = find(i);
+                    if (label[root] < 0) label[root] = groups++;
+                    slotGroup[first + i] = label[root];
+                }
+                groupCount[v] = groups;
+            }
+        });
+        if (cancelled()) return false;
+
+        // 4. 为额外的组分配新点编号（追加在原有点之后）
+        std::vector<vtkIdType> extraStart(numPoints + 1, 0);
+        for (vtkIdType v = 0; v < numPoints; v++) {
+            extraStart[v + 1] = extraStart[v] + (groupCount[v] - 1);
+        }
+        const vtkIdType totalPoints = numPoints + extraStart[numPoints];
+
+        // 5. 每组的法线为组内面法线之和（与vtkPolyDataNormals一致，不按面积加权）
+        vtkSmartPointer<vtkFloatArray> normals = vtkSmartPointer<vtkFloatArray>::New();
+        normals->SetName("Normals");
+        normals->SetNumberOfComponents(3);
+        normals->SetNumberOfTuples(totalPoints);
+        float* normalData = normals->GetPointer(0);
+
+        vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+        connectivity->SetNumberOfValues(numTriangles * 4);
+        vtkIdType* conn = connectivity->GetPointer(0);
+
+        std::vector<vtkIdType> sourcePoint(totalPoints - numPoints);
+
+        parallelFor(static_cast<size_t>(numPoints), 1024, [&](size_t begin, size_t end) {
+            std::vector<double> sums;
+
+            for (size_t v = begin; v < end; v++) {
+                const vtkIdType first = adjacencyStart[v];
+                const vtkIdType count = adjacencyStart[v + 1] - first;
+                const int groups = groupCount[v];
+
+                sums.assign(groups * 3, 0.0);
+                for (vtkIdType i = 0; i < count; i++) {
+                    vtkIdType slot = adjacency[first + i];
+                    const double* n = &faceNormals[(slot / 3) * 3];
+                    int g = slotGroup[first + i];
+                    sums[g * 3] += n[0];
+                    sums[g * 3 + 1] += n[1];
+                    sums[g * 3 + 2] += n[2];
+                }
+
+                for (int g = 0; g < groups; g++) {
+                    vtkIdType id = (g == 0) ? static_cast<vtkIdType>(v)
+                                            : numPoints + extraStart[v] + (g - 1);
+                    if (g > 0) {
+                        sourcePoint[id - numPoints] = static_cast<vtkIdType>(v);
+                    }
+
+                    double length = std::sqrt(sums[g * 3] * sums[g * 3] +
+                                              sums[g * 3 + 1] * sums[g * 3 + 1] +
+                                              sums[g * 3 + 2] * sums[g * 3 + 2]);
+                    double scale = length > 0.0 ? 1.0 / length : 0.0;
+                    normalData[id * 3] = static_cast<float>(sums[g * 3] * scale);
+                    normalData[id * 3 + 1] = static_cast<float>(sums[g * 3 + 1] * scale);
+                    normalData[id * 3 + 2] = static_cast<float>(sums[g * 3 + 2] * scale);
+                }
+
+                for (vtkIdType i = 0; i < count; i++) {
+                    vtkIdType slot = adjacency[first + i];
+                    int g = slotGroup[first + i];
+                    vtkIdType id = (g == 0) ? static_cast<vtkIdType>(v)
+                                            : numPoints + extraStart[v] + (g - 1);
+                    conn[(slot / 3) * 4 + 1 + slot % 3] = id;
+                }
+            }
+        });
+        if (cancelled()) return false;
+
+        for (vtkIdType t = 0; t < numTriangles; t++) {
+            conn[t * 4] = 3;
+        }
+
+        // 6. 点和点数据：原有点保持编号，复制的点沿用源点的坐标和属性
+        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
+        newPoints->SetDataType(inPoints->GetDataType());
+        newPoints->SetNumberOfPoints(totalPoints);
+
+        vtkPointData* inPD = input->GetPointData();
+        vtkSmartPointer<vtkPointData> outPD = vtkSmartPointer<vtkPointData>::New();
+        outPD->CopyNormalsOff();
+        outPD->CopyAllocate(inPD, totalPoints);
+
+        double p[3];
+        for (vtkIdType id = 0; id < totalPoints; id++) {
+            vtkIdType src = id < numPoints ? id : sourcePoint[id - numPoints];
+            inPoints->GetPoint(src, p);
+            newPoints->SetPoint(id, p);
+            outPD->CopyData(inPD, src, id);
+        }
+        outPD->SetNormals(normals);
+
+        vtkSmartPointer<vtkCellArray> newPolys = vtkSmartPointer<vtkCellArray>::New();
+        newPolys->SetCells(numTriangles, connectivity);
+
+        output->Initialize();
+        output->SetPoints(newPoints);
+        output->SetPolys(newPolys);
+        output->GetPointData()->PassData(outPD);
+        output->GetCellData()->CopyNormalsOff();
+        output->GetCellData()->PassData(input->GetCellData());
+
+        std::cout << "MeshOptimizer: Feature normals computed (angle " << featureAngle
+                  << "), " << totalPoints - numPoints << " points split" << std::endl;
+
+        return true;
+    }
+
+
+    bool MeshOptimizer::WeldVertices(vtkPolyData* input, double tolerance,
+                                     vtkPolyData* output, ThreadPool* pool,
+                                     const std::atomic<bool>* cancelFlag) {
+        if (!input || !output || !input->GetPoints()) {
+            std::cerr << "MeshOptimizer: Invalid input mesh" << std::endl;
+            return false;
+        }
+
+        if (input->GetNumberOfVerts() > 0 || input->GetNumberOfLines() > 0 ||
+            input->GetNumberOfStrips() > 0) {
+            return false;
+        }
+
+        const vtkIdType numPoints = input->GetNumberOfPoints();
+        const vtkIdType numTriangles = input->GetNumberOfPolys();
+        if (numPoints == 0 || numTriangles == 0) {
+            return false;
+        }
+
+        // 纯三角形网格的单元数组为连续的(3, a, b, c)，直接按下标读取
+        const vtkIdType* cells = input->GetPolys()->GetData()->GetPointer(0);
+        if (input->GetPolys()->GetData()->GetNumberOfValues() != numTriangles * 4) {
+            return false;
+        }
+
+        auto cancelled = [cancelFlag]() {
+            return cancelFlag && cancelFlag->load();
+        };
+
+        // 按分块执行，取消后跳过尚未开始的分块
+        auto parallelFor = [pool, &cancelled](size_t count, size_t grain,
+                                              const std::function<void(size_t, size_t)>& body) {
+            auto guarded = [&](size_t begin, size_t end) {
+                if (!cancelled()) body(begin, end);
+            };
+            if (pool) {
+                pool->ParallelFor(count, grain, guarded);
+            } else {
+                for (size_t begin = 0; begin < count; begin += grain) {
+                    guarded(begin, std::min(count, begin + grain));
+                }
+            }
+        };
+
+        std::atomic<bool> nonTriangle(false);
+        parallelFor(static_cast<size_t>(numTriangles), 16384, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++) {
+                if (cells[t * 4] != 3) {
+                    nonTriangle = true;
+                    return;
+                }
+            }
+        });
+        if (nonTriangle || cancelled()) {
+            return false;
+        }
+
+        // 1. 量化坐标：网格单元为容差乘包围盒对角线；容差为0时直接使用坐标的位模式
+        vtkPoints* inPoints = input->GetPoints();
+        double bounds[6];
+        inPoints->GetBounds(bounds);
+        const double diagonal = std::sqrt((bounds[1] - bounds[0]) * (bounds[1] - bounds[0]) +
+                                          (bounds[3] - bounds[2]) * (bounds[3] - bounds[2]) +
+                                          (bounds[5] - bounds[4]) * (bounds[5] - bounds[4]));
+        const double cellSize = tolerance * diagonal;
+
+        std::vector<long long> keys(static_cast<size_t>(numPoints) * 3);
+        parallelFor(static_cast<size_t>(numPoints), 4096, [&](size_t begin, size_t end) {
+            double p[3];
+            for (size_t v = begin; v < end; v++) {
+                inPoints->GetPoint(static_cast<vtkIdType>(v), p);
+                for (int i = 0; i < 3; i++) {
+                    if (cellSize > 0.0) {
+                        keys[v * 3 + i] = static_cast<long long>(std::floor((p[i] - bounds[i * 2]) / cellSize));
+                    } else {
+                        double value = p[i] + 0.0;  // -0.0与0.0视为相同
+                        std::memcpy(&keys[v * 3 + i], &value, sizeof(value));
+                    }
+                }
+            }
+        });
+        if (cancelled()) return false;
+
+        auto sameKey = [&keys](vtkIdType a, vtkIdType b) {
+            return keys[a * 3] == keys[b * 3] && keys[a * 3 + 1] == keys[b * 3 + 1] &&
+                   keys[a * 3 + 2] == keys[b * 3 + 2];
+        };
+        auto hashKey = [&keys](vtkIdType v) {
+            unsigned long long h = 1469598103934665603ULL;
+            for (int i = 0; i < 3; i++) {
+                h ^= static_cast<unsigned long long>(keys[v * 3 + i]);
+                h *= 0x9E3779B97F4A7C15ULL;
+                h ^= h >> 29;
+            }
+            return h;
+        };
+
+        // 2. 无锁开放寻址哈希表（线性探测），槽中存放点编号+1，0为空；
+        //    量化坐标相同的点只占一个槽，槽值原子地取最小编号，结果与线程调度无关
+        size_t tableSize = 1;
+        while (tableSize < static_cast<size_t>(numPoints) * 2) {
+            tableSize <<= 1;
+        }
+        const size_t mask = tableSize - 1;
+        std::vector<std::atomic<vtkIdType>> table(tableSize);
+
+        parallelFor(static_cast<size_t>(numPoints), 4096, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; v++) {
+                const vtkIdType entry = static_cast<vtkIdType>(v) + 1;
+                size_t h = static_cast<size_t>(hashKey(static_cast<vtkIdType>(v))) & mask;
+                vtkIdType current = table[h].load(std::memory_order_relaxed);
+                while (true) {
+                    if (current == 0) {
+                        if (table[h].compare_exchange_weak(current, entry)) break;
+                        continue;  // current已被更新为其他线程写入的值
+                    }
+                    if (!sameKey(current - 1, static_cast<vtkIdType>(v))) {
+                        h = (h + 1) & mask;
+                        current = table[h].load(std::memory_order_relaxed);
+                        continue;
+                    }
+                    while (entry < current && !table[h].compare_exchange_weak(current, entry)) {
+                    }
+                    break;
+                }
+            }
+        });
+        if (cancelled()) return false;
+
+        // 3. 每个点的代表点（同组中编号最小者）
+        std::vector<vtkIdType> representative(numPoints);
+        parallelFor(static_cast<size_t>(numPoints), 4096, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; v++) {
+                size_t h = static_cast<size_t>(hashKey(static_cast<vtkIdType>(v))) & mask;
+                while (!sameKey(table[h].load(std::memory_order_relaxed) - 1, static_cast<vtkIdType>(v))) {
+                    h = (h + 1) & mask;
+                }
+                representative[v] = table[h].load(std::memory_order_relaxed) - 1;
+            }
+        });
+        if (cancelled()) return false;
+        std::vector<std::atomic<vtkIdType>>().swap(table);
+        std::vector<long long>().swap(keys);
+
+        // 4. 按块统计非退化三角形，前缀和确定输出位置后并行写出（保持原顺序），同时标记被引用的点
+        const size_t chunkSize = 16384;
+        const size_t chunkCount = (static_cast<size_t>(numTriangles) + chunkSize - 1) / chunkSize;
+        std::vector<vtkIdType> chunkStart(chunkCount + 1, 0);
+
+        auto mapped = [&](size_t t, vtkIdType ids[3]) {
+            ids[0] = representative[cells[t * 4 + 1]];
+            ids[1] = representative[cells[t * 4 + 2]];
+            ids[2] = representative[cells[t * 4 + 3]];
+            return ids[0] != ids[1] && ids[1] != ids[2] && ids[0] != ids[2];
+        };
+
+        parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+            vtkIdType ids[3];
+            for (size_t c = begin; c < end; c++) {
+                size_t last = std::min(static_cast<size_t>(numTriangles), (c + 1) * chunkSize);
+                vtkIdType kept = 0;
+                for (size_t t = c * chunkSize; t < last; t++) {
+                    kept += mapped(t, ids) ? 1 : 0;
+                }
+                chunkStart[c + 1] = kept;
+            }
+        });
+        if (cancelled()) return false;
+        for (size_t c = 0; c < chunkCount; c++) {
+            chunkStart[c + 1] += chunkStart[c];
+        }
+        const vtkIdType keptTriangles = chunkStart[chunkCount];
+
+        vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+        connectivity->SetNumberOfValues(keptTriangles * 4);
+        vtkIdType* conn = connectivity->GetPointer(0);
+        std::vector<vtkIdType> sourceTriangle(keptTriangles);
+        std::vector<std::atomic<unsigned char>> used(numPoints);
+
+        parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+            vtkIdType ids[3];
+            for (size_t c = begin; c < end; c++) {
+                size_t last = std::min(static_cast<size_t>(numTriangles), (c + 1) * chunkSize);
+                vtkIdType out = chunkStart[c];
+                for (size_t t = c * chunkSize; t < last; t++) {
+                    if (!mapped(t, ids)) continue;
+                    conn[out * 4] = 3;
+                    for (int k = 0; k < 3; k++) {
+                        conn[out * 4 + 1 + k] = ids[k];
+                        used[ids[k]].store(1, std::memory_order_relaxed);
+                    }
+                    sourceTriangle[out++] = static_cast<vtkIdType>(t);
+                }
+            }
+        });
+        if (cancelled()) return false;
+
+        // 5. 被引用的代表点按原顺序重新编号
+        std::vector<vtkIdType> newId(numPoints, -1);
+        vtkIdType outputPoints = 0;
+        for (vtkIdType v = 0; v < numPoints; v++) {
+            if (used[v].load(std::memory_order_relaxed)) {
+                newId[v] = outputPoints++;
+            }
+        }
+
+        parallelFor(static_cast<size_t>(keptTriangles), 16384, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++) {
+                conn[t * 4 + 1] = newId[conn[t * 4 + 1]];
+                conn[t * 4 + 2] = newId[conn[t * 4 + 2]];
+                conn[t * 4 + 3] = newId[conn[t * 4 + 3]];
+            }
+        });
+        if (cancelled()) return false;
+
+        // 6. 点和点数据取自代表点，单元数据随保留的三角形
+        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
+        newPoints->SetDataType(inPoints->GetDataType());
+        newPoints->SetNumberOfPoints(outputPoints);
+
+        vtkPointData* inPD = input->GetPointData();
+        vtkSmartPointer<vtkPointData> outPD = vtkSmartPointer<vtkPointData>::New();
+        outPD->CopyAllocate(inPD, outputPoints);
+
+        double p[3];
+        for (vtkIdType v = 0; v < numPoints; v++) {
+            if (newId[v] < 0) continue;
+            inPoints->GetPoint(v, p);
+            newPoints->SetPoint(newId[v], p);
+            outPD->CopyData(inPD, v, newId[v]);
+        }
+
+        vtkSmartPointer<vtkCellArray> newPolys = vtkSmartPointer<vtkCellArray>::New();
+        newPolys->SetCells(keptTriangles, connectivity);
+
+        output->Initialize();
+        output->SetPoints(newPoints);
+        output->SetPolys(newPolys);
+        output->GetPointData()->PassData(outPD);
+        if (keptTriangles == numTriangles) {
+            output->GetCellData()->PassData(input->GetCellData());
+        } else {
+            vtkCellData* inCD = input->GetCellData();
+            vtkSmartPointer<vtkCellData> outCD = vtkSmartPointer<vtkCellData>::New();
+            outCD->CopyAllocate(inCD, keptTriangles);
+            for (vtkIdType t = 0; t < keptTriangles; t++) {
+                outCD->CopyData(inCD, sourceTriangle[t], t);
+            }
+            output->GetCellData()->PassData(outCD);
+        }
+
+        std::cout << "MeshOptimizer: Welded " << numPoints << " -> " << outputPoints
+                  << " points, " << numTriangles - keptTriangles
+                  << " degenerate triangles removed" << std::endl;
+
+        return true;
+    }
+
+} // namespace BronchoscopyLib
@@ -1,5 +1,10 @@
 #include "ModelManager.h"
 #include "ShaderSystem.h"
+#include "Centerline.h"
+#include "DistanceField.h"
+#include "MeshBVH.h"
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
 
 // VTK头文件
 #include <vtkSmartPointer.h>
@@ -11,11 +16,472 @@
 #include <vtkRenderer.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkCleanPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkShader.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
 
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <set>
 
 namespace BronchoscopyLib {
     
+    // 预处理结果：设置快照 + 各阶段输出
+    // 各阶段的输出被缓存，设置变化时只重新执行受影响的阶段及其后续阶段
+    struct PreparedModel {
+        // 预处理阶段（按依赖顺序，每个阶段以前面最近一个已执行阶段的输出为输入）
+        enum Stage {
+            STAGE_CLEAN = 0,      // 合并重复点
+            STAGE_ORIENT,         // 统一多边形朝向（与特征角无关，代价最高的拓扑遍历）
+            STAGE_NORMALS,        // 按特征角计算点法线（并行）
+            STAGE_VERTEX_CACHE,   // 可选：顶点缓存优化
+            STAGE_COMPACT,        // 可选：紧凑表示
+            STAGE_COUNT
+        };
+        
+        // 设置快照（创建时从ModelManager复制，之后不受其设置变化影响）
+        double smoothingAngle;
+        bool optimizeVertexCache;
+        bool compactMode;
+        std::shared_ptr<ThreadPool> pool;  // 并行阶段使用的线程池，可为空
+        bool distanceFieldEnabled;
+        double distanceFieldVoxelSize;
+        double distanceFieldBandWidth;
+        bool centerlineEnabled;
+        Centerline::Settings centerlineSettings;
+        ModelManager::CacheLoader loadCache;
+        ModelManager::CacheStore storeCache;
+        
+        // 预处理结果
+        vtkSmartPointer<vtkPolyData> source;                     // 输入数据（深拷贝或共享）
+        vtkSmartPointer<vtkPolyData> stageOutputs[STAGE_COUNT];  // 未执行的阶段为空
+        bool vertexCacheOptimized;
+        MeshOptimizer::VertexCacheStats vertexCacheStats;
+        bool compacted;
+        
+        // 渲染网格的射线求交加速结构（只依赖几何和三角形顺序，只改法线时沿用）
+        std::shared_ptr<const MeshBVH> bvh;
+        
+        // 管腔的有符号距离场（由BVH构建，几何哈希和参数一致时沿用）
+        std::shared_ptr<const DistanceField> distanceField;
+        
+        // 由距离场提取的中心线树
+        std::shared_ptr<const Centerline> centerline;
+        
+        // 紧凑化后中间阶段已释放，source被替换为紧凑数据，任何设置变化都需从头执行
+        bool stagesReleased;
+        
+        PreparedModel() : smoothingAngle(80.0), optimizeVertexCache(false), compactMode(false),
+                          distanceFieldEnabled(false), distanceFieldVoxelSize(0.0), distanceFieldBandWidth(0.0),
+                          centerlineEnabled(false),
+                          vertexCacheOptimized(false), compacted(false), stagesReleased(false) {
+        }
+        
+        // 某阶段的输入：前面最近一个已执行阶段的输出
+        vtkPolyData* GetStageInput(int stage) const {
+            for (int i = stage - 1; i >= 0; i--) {
+                if (stageOutputs[i]) return stageOutputs[i];
+            }
+            return source;
+        }
+        
+        // 用于渲染的最终数据
+        vtkPolyData* GetRendered() const {
+            return GetStageInput(STAGE_COUNT);
+        }
+    };
+    
+    namespace {
+        
+        // 将VTK滤波器的进度转发到预处理进度回调，并响应取消请求
+        struct ProgressRelay {
+            const ModelManager::PreprocessProgress* progress;
+            const std::atomic<bool>* cancelFlag;
+            double base;   // 该阶段在总进度中的起点
+            double span;   // 该阶段在总进度中的跨度
+            const char* stage;
+        };
+        
+        void OnFilterProgress(vtkObject* caller, unsigned long, void* clientData, void* callData) {
+            ProgressRelay* relay = static_cast<ProgressRelay*>(clientData);
+            double filterProgress = callData ? *static_cast<double*>(callData) : 0.0;
+            
+            if (relay->progress && *relay->progress) {
+                (*relay->progress)(relay->base + relay->span * filterProgress, relay->stage);
+            }
+            
+            if (relay->cancelFlag && relay->cancelFlag->load()) {
+                if (vtkAlgorithm* algorithm = vtkAlgorithm::SafeDownCast(caller)) {
+                    algorithm->AbortExecuteOn();
+                }
+            }
+        }
+        
+        void ReportProgress(const ModelManager::PreprocessProgress& progress,
+                            double value, const char* stage) {
+            if (progress) {
+                progress(value, stage);
+            }
+        }
+        
+        const char* const kStageNames[PreparedModel::STAGE_COUNT] = {
+            "cleaned", "oriented", "normals", "vertex-cache", "compact"
+        };
+        
+        // 各阶段在总进度中的起点和跨度
+        const double kStageProgress[PreparedModel::STAGE_COUNT][2] = {
+            { 0.0, 0.3 }, { 0.3, 0.3 }, { 0.6, 0.2 }, { 0.8, 0.15 }, { 0.95, 0.05 }
+        };
+        
+        // 清理阶段的点合并容差（包围盒对角线的比例），非常小，只合并完全相同的点
+        const double kCleanTolerance = 0.00001;
+        
+        // 派生数据在调用方缓存中的名称
+        const char* const kDistanceFieldCache = "sdf";
+        const char* const kCenterlineCache = "centerline";
+        
+        // 按当前BVH和距离场设置更新距离场：已有结果或缓存的几何哈希和参数一致时沿用，否则并行构建并写回缓存
+        // 只在开启距离场或需要它的中心线开启时构建
+        // 构建失败不影响预处理结果（距离场为空）；只在取消时返回false
+        bool UpdateDistanceField(PreparedModel& model,
+                                 const ModelManager::PreprocessProgress& progress,
+                                 const std::atomic<bool>* cancelFlag) {
+            if (!(model.distanceFieldEnabled || model.centerlineEnabled) || !model.bvh) {
+                model.distanceField = nullptr;
+                return true;
+            }
+            
+            unsigned long long hash = model.bvh->GetBuildStats().geometryHash;
+            auto matches = [&model, hash](const DistanceField& field) {
+                double voxelSize = 0.0, bandWidth = 0.0;
+                field.GetRequestedSettings(voxelSize, bandWidth);
+                return field.GetGeometryHash() == hash &&
+                       voxelSize == std::max(model.distanceFieldVoxelSize, 0.0) &&
+                       bandWidth == std::max(model.distanceFieldBandWidth, 0.0);
+            };
+            if (model.distanceField && matches(*model.distanceField)) {
+                return true;
+            }
+            
+            std::shared_ptr<DistanceField> field = std::make_shared<DistanceField>();
+            std::vector<unsigned char> data;
+            if (model.loadCache && model.loadCache(kDistanceFieldCache, data)) {
+                if (field->Deserialize(data.data(), data.size()) && matches(*field)) {
+                    std::cout << "ModelManager: Distance field loaded from cache ("
+                             << field->GetMemoryBytes() / 1024 << " KB)" << std::endl;
+                    model.distanceField = field;
+                    return true;
+                }
+                std::cout << "ModelManager: Distance field cache is stale, rebuilding" << std::endl;
+            }
+            
+            ReportProgress(progress, 1.0, "distance-field");
+            if (!field->Build(*model.bvh, model.distanceFieldVoxelSize, model.distanceFieldBandWidth,
+                              model.pool.get(), cancelFlag)) {
+                model.distanceField = nullptr;
+                return !(cancelFlag && cancelFlag->load());
+            }
+            
+            if (model.storeCache) {
+                field->Serialize(data);
+                model.storeCache(kDistanceFieldCache, data);
+            }
+            model.distanceField = field;
+            return true;
+        }
+        
+        // 由距离场更新中心线，缓存策略与距离场相同；没有距离场时中心线为空
+        bool UpdateCenterline(PreparedModel& model,
+                              const ModelManager::PreprocessProgress& progress,
+                              const std::atomic<bool>* cancelFlag) {
+            if (!model.centerlineEnabled || !model.distanceField) {
+                model.centerline = nullptr;
+                return true;
+            }
+            
+            const DistanceField& field = *model.distanceField;
+            auto matches = [&model, &field](const Centerline& centerline) {
+                return centerline.GetGeometryHash() == field.GetGeometryHash() &&
+                       centerline.GetFieldVoxelSize() == field.GetVoxelSize() &&
+                       centerline.GetSettings() == model.centerlineSettings;
+            };
+            if (model.centerline && matches(*model.centerline)) {
+                return true;
+            }
+            
+            std::shared_ptr<Centerline> centerline = std::make_shared<Centerline>();
+            std::vector<unsigned char> data;
+            if (model.loadCache && model.loadCache(kCenterlineCache, data)) {
+                if (centerline->Deserialize(data.data(), data.size()) && matches(*centerline)) {
+                    std::cout << "ModelManager: Centerline loaded from cache ("
+                             << centerline->GetBranchCount() << " branches)" << std::endl;
+                    model.centerline = centerline;
+                    return true;
+                }
+                std::cout << "ModelManager: Centerline cache is stale, rebuilding" << std::endl;
+            }
+            
+            ReportProgress(progress, 1.0, "centerline");
+            if (!centerline->Extract(field, model.centerlineSettings, model.pool.get(), cancelFlag)) {
+                model.centerline = nullptr;
+                return !(cancelFlag && cancelFlag->load());
+            }
+            
+            if (model.storeCache) {
+                centerline->Serialize(data);
+                model.storeCache(kCenterlineCache, data);
+            }
+            model.centerline = centerline;
+            return true;
+        }
+        
+        // 从firstStage开始执行预处理阶段，之前阶段的缓存输出直接复用
+        bool RunStages(PreparedModel& model, int firstStage,
+                       const ModelManager::PreprocessProgress& progress,
+                       const std::atomic<bool>* cancelFlag) {
+            auto cancelled = [cancelFlag]() {
+                return cancelFlag && cancelFlag->load();
+            };
+            
+            if (model.stagesReleased) {
+                firstStage = PreparedModel::STAGE_CLEAN;
+                model.stagesReleased = false;
+            }
+            bool wasReordered = model.vertexCacheOptimized;
+            
+            for (int stage = firstStage; stage < PreparedModel::STAGE_COUNT; stage++) {
+                model.stageOutputs[stage] = nullptr;
+            }
+            if (firstStage <= PreparedModel::STAGE_VERTEX_CACHE) {
+                model.vertexCacheOptimized = false;
+            }
+            model.compacted = false;
+            
+            // 进度转发
+            ProgressRelay relay = { &progress, cancelFlag, 0.0, 0.0, "" };
+            vtkSmartPointer<vtkCallbackCommand> progressCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+            progressCommand->SetCallback(OnFilterProgress);
+            progressCommand->SetClientData(&relay);
+            
+            for (int stage = firstStage; stage < PreparedModel::STAGE_COUNT; stage++) {
+                relay.base = kStageProgress[stage][0];
+                relay.span = kStageProgress[stage][1];
+                relay.stage = kStageNames[stage];
+                
+                vtkPolyData* input = model.GetStageInput(stage);
+                vtkSmartPointer<vtkPolyData> output;
+                
+                switch (stage) {
+                    case PreparedModel::STAGE_CLEAN: {
+                        ReportProgress(progress, relay.base, relay.stage);
+                        
+                        // 量化哈希并行合并重复点，同时丢弃退化三角形
+                        output = vtkSmartPointer<vtkPolyData>::New();
+                        if (!MeshOptimizer::WeldVertices(input, kCleanTolerance, output, model.pool.get(), cancelFlag)) {
+                            if (cancelled()) return false;
+                            // 含非三角形单元时退回VTK的串行实现
+                            vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
+                            cleaner->SetInputData(input);
+                            cleaner->SetTolerance(kCleanTolerance);
+                            cleaner->PointMergingOn();
+                            cleaner->AddObserver(vtkCommand::ProgressEvent, progressCommand);
+                            cleaner->Update();
+                            output = cleaner->GetOutput();
+                        }
+                        
+                        std::cout << "ModelManager: Cleaned model - " 
+                                 << "Original points: " << input->GetNumberOfPoints()
+                                 << ", Cleaned points: " << output->GetNumberOfPoints() 
+                                 << std::endl;
+                        break;
+                    }
+                    
+                    case PreparedModel::STAGE_ORIENT: {
+                        ReportProgress(progress, relay.base, relay.stage);
+                        
+                        // 只统一朝向，点法线在下一阶段按特征角计算
+                        vtkSmartPointer<vtkPolyDataNormals> orienter = 
+                            vtkSmartPointer<vtkPolyDataNormals>::New();
+                        orienter->SetInputData(input);
+                        orienter->SplittingOff();
+                        orienter->ComputePointNormalsOff();
+                        orienter->ComputeCellNormalsOn();
+                        
+                        // 确保法线一致性
+                        orienter->ConsistencyOn();
+                        
+                        // 自动确定法线方向
+                        orienter->AutoOrientNormalsOn();
+                        
+                        orienter->AddObserver(vtkCommand::ProgressEvent, progressCommand);
+                        orienter->Update();
+                        output = orienter->GetOutput();
+                        break;
+                    }
+                    
+                    case PreparedModel::STAGE_NORMALS: {
+                        ReportProgress(progress, relay.base, relay.stage);
+                        
+                        // 锐边（相邻面夹角大于特征角）两侧分别计算法线，其余区域平滑
+                        output = vtkSmartPointer<vtkPolyData>::New();
+                        if (!MeshOptimizer::ComputeFeatureNormals(input, model.smoothingAngle,
+                                                                  output, model.pool.get(), cancelFlag)) {
+                            if (cancelled()) return false;
+                            // 含非三角形单元时退回VTK的串行实现
+                            vtkSmartPointer<vtkPolyDataNormals> normalGenerator = 
+                                vtkSmartPointer<vtkPolyDataNormals>::New();
+                            normalGenerator->SetInputData(input);
+                            normalGenerator->SetFeatureAngle(model.smoothingAngle);
+                            normalGenerator->SplittingOn();
+                            normalGenerator->ConsistencyOff();  // 朝向已在上一阶段统一
+                            normalGenerator->ComputePointNormalsOn();
+                            normalGenerator->ComputeCellNormalsOff();
+                            normalGenerator->AddObserver(vtkCommand::ProgressEvent, progressCommand);
+                            normalGenerator->Update();
+                            output = normalGenerator->GetOutput();
+                        }
+                        break;
+                    }
+                    
+                    case PreparedModel::STAGE_VERTEX_CACHE: {
+                        // 可选：按顶点缓存局部性重排三角形并重编号顶点
+                        if (!model.optimizeVertexCache) break;
+                        ReportProgress(progress, relay.base, relay.stage);
+                        
+                        vtkSmartPointer<vtkPolyData> optimized = vtkSmartPointer<vtkPolyData>::New();
+                        if (MeshOptimizer::OptimizeVertexCache(input, optimized, &model.vertexCacheStats)) {
+                            output = optimized;
+                            model.vertexCacheOptimized = true;
+                        }
+                        break;
+                    }
+                    
+                    case PreparedModel::STAGE_COMPACT: {
+                        // 可选：转换为紧凑表示
+                        if (!model.compactMode) break;
+                        ReportProgress(progress, relay.base, relay.stage);
+                        
+                        vtkSmartPointer<vtkPolyData> compact = vtkSmartPointer<vtkPolyData>::New();
+                        if (MeshOptimizer::BuildCompactMesh(input, compact)) {
+                            output = compact;
+                            model.compacted = true;
+                        }
+                        break;
+                    }
+                }
+                
+                if (cancelled()) return false;
+                model.stageOutputs[stage] = output;
+            }
+            
+            // 清理或朝向阶段重新执行、或三角形顺序变化时重建BVH；只改法线或紧凑化时沿用
+            bool geometryChanged = firstStage <= PreparedModel::STAGE_ORIENT ||
+                                   wasReordered != model.vertexCacheOptimized ||
+                                   (model.vertexCacheOptimized && firstStage <= PreparedModel::STAGE_VERTEX_CACHE);
+            if (!model.bvh || geometryChanged) {
+                ReportProgress(progress, 1.0, "bvh");
+                std::shared_ptr<MeshBVH> bvh = std::make_shared<MeshBVH>();
+                if (bvh->Build(model.GetRendered(), model.pool.get(), cancelFlag)) {
+                    model.bvh = bvh;
+                } else {
+                    model.bvh = nullptr;
+                }
+                if (cancelled()) return false;
+            }
+            
+            if (!UpdateDistanceField(model, progress, cancelFlag) ||
+                !UpdateCenterline(model, progress, cancelFlag)) {
+                return false;
+            }
+            
+            if (model.compacted) {
+                // 紧凑数据已包含渲染所需的全部信息，释放双精度源副本和中间阶段
+                // 之后的重新预处理（如SetSmoothingAngle）以紧凑数据为输入
+                model.source = model.stageOutputs[PreparedModel::STAGE_COMPACT];
+                for (int stage = 0; stage < PreparedModel::STAGE_COUNT; stage++) {
+                    model.stageOutputs[stage] = nullptr;
+                }
+                model.stagesReleased = true;
+            }
+            
+            ReportProgress(progress, 1.0, "done");
+            return true;
+        }
+        
+        // 紧凑模式下的法线解码shader替换
+        // VTK 8.2将非unsigned char的顶点属性按float上传且不做归一化，因此在shader中除以32767
+        const char* kCompactNormalVSDec =
+            "//VTK::Normal::Dec\n"
+            "attribute vec2 normalOctMC;\n"
+            "uniform mat3 normalMatrix;\n"
+            "varying vec3 normalVCVSOutput;\n"
+            "vec3 DecodeOctNormal(vec2 e) {\n"
+            "  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+            "  float t = max(-n.z, 0.0);\n"
+            "  n.x += (n.x >= 0.0) ? -t : t;\n"
+            "  n.y += (n.y >= 0.0) ? -t : t;\n"
+            "  return normalize(n);\n"
+            "}\n";
+        
+        const char* kCompactNormalVSImpl =
+            "normalVCVSOutput = normalMatrix * DecodeOctNormal(normalOctMC / 32767.0);\n";
+        
+        const char* kCompactNormalFSDec =
+            "//VTK::Normal::Dec\n"
+            "varying vec3 normalVCVSOutput;\n";
+        
+        // 替换掉VTK在无法线时基于屏幕导数的面法线计算
+        const char* kCompactNormalFSImpl =
+            "vec3 normalVCVSOutput = normalize(normalVCVSOutput);\n"
+            "  if (gl_FrontFacing == false) { normalVCVSOutput = -normalVCVSOutput; }\n";
+        
+        // 收集polydata持有的数组（点、拓扑、点数据、单元数据）
+        void CollectArrays(vtkPolyData* polyData, std::vector<vtkObject*>& arrays) {
+            if (!polyData) return;
+            
+            if (polyData->GetPoints()) {
+                arrays.push_back(polyData->GetPoints()->GetData());
+            }
+            
+            vtkCellArray* cellArrays[4] = {
+                polyData->GetVerts(), polyData->GetLines(),
+                polyData->GetPolys(), polyData->GetStrips()
+            };
+            for (vtkCellArray* cells : cellArrays) {
+                if (cells && cells->GetNumberOfCells() > 0) {
+                    arrays.push_back(cells);
+                }
+            }
+            
+            vtkFieldData* fields[2] = { polyData->GetPointData(), polyData->GetCellData() };
+            for (vtkFieldData* field : fields) {
+                for (int i = 0; i < field->GetNumberOfArrays(); i++) {
+                    if (field->GetAbstractArray(i)) {
+                        arrays.push_back(field->GetAbstractArray(i));
+                    }
+                }
+            }
+        }
+        
+        // 单个数组的实际内存（字节）
+        size_t ArrayBytes(vtkObject* object) {
+            if (vtkAbstractArray* array = vtkAbstractArray::SafeDownCast(object)) {
+                return static_cast<size_t>(array->GetActualMemorySize()) * 1024;
+            }
+            if (vtkCellArray* cells = vtkCellArray::SafeDownCast(object)) {
+                return static_cast<size_t>(cells->GetActualMemorySize()) * 1024;
+            }
+            return 0;
+        }
+    }
+    
     class ModelManager::Impl {
     public:
         // 模型数据
@@ -26,6 +492,11 @@ namespace BronchoscopyLib {
         vtkSmartPointer<vtkPolyDataMapper> overviewMapper;
         vtkSmartPointer<vtkPolyDataMapper> endoscopeMapper;
         
+        // 内窥镜视图的可见三角形：开启时endoscopeMapper的输入为只含这些三角形的网格
+        bool endoscopeCulled;
+        std::vector<long long> endoscopeCells;
+        vtkSmartPointer<vtkPolyData> endoscopeModel;
+        
         // Actor
         vtkSmartPointer<vtkActor> overviewActor;
         vtkSmartPointer<vtkActor> endoscopeActor;
@@ -36,7 +507,61 @@ namespace BronchoscopyLib {
         double overviewOpacity;
         double smoothingAngle;  // 平滑角度
         
-        Impl() : overviewOpacity(0.7), smoothingAngle(80.0) {
+        // 顶点缓存优化（可选预处理阶段）
+        bool optimizeVertexCache;
+        bool vertexCacheOptimized;  // 最近一次预处理是否执行了优化
+        MeshOptimizer::VertexCacheStats vertexCacheStats;
+        
+        // 紧凑模式：float32坐标 + 八面体编码法线，预处理后丢弃中间副本
+        bool compactMode;
+        bool compacted;  // 当前渲染数据是否为紧凑表示
+        
+        // 当前安装的预处理结果（含各阶段缓存），设置变化时在其基础上增量更新
+        std::shared_ptr<PreparedModel> currentModel;
+        
+        // 当前模型的BVH（与currentModel共享）
+        std::shared_ptr<const MeshBVH> bvh;
+        
+        // 有符号距离场设置（默认关闭，自动选择体素尺寸和窄带宽度）
+        bool distanceFieldEnabled;
+        double distanceFieldVoxelSize;
+        double distanceFieldBandWidth;
+        
+        // 中心线提取设置（默认关闭，开启时一并构建距离场）
+        bool centerlineEnabled;
+        Centerline::Settings centerlineSettings;
+        
+        // 派生数据（距离场、中心线）的缓存回调，经cacheMutex串行调用
+        CacheLoader loadCache;
+        CacheStore storeCache;
+        std::shared_ptr<std::mutex> cacheMutex = std::make_shared<std::mutex>();
+        
+        // 当前模型的距离场和中心线（与currentModel共享）
+        std::shared_ptr<const DistanceField> distanceField;
+        std::shared_ptr<const Centerline> centerline;
+        
+        // 预处理并行阶段使用的线程池（首次预处理时创建）
+        std::shared_ptr<ThreadPool> preprocessPool;
+        
+        // 模型actor使用的ShaderSystem（不拥有，由所属实例设置）；
+        // 未设置时首次使用才创建自己的实例
+        ShaderSystem* shaderSystem = nullptr;
+        std::unique_ptr<ShaderSystem> ownedShaderSystem;
+        
+        ShaderSystem& GetShaderSystem() {
+            if (!shaderSystem) {
+                ownedShaderSystem = std::make_unique<ShaderSystem>();
+                ownedShaderSystem->Initialize();
+                shaderSystem = ownedShaderSystem.get();
+            }
+            return *shaderSystem;
+        }
+        
+        Impl() : endoscopeCulled(false), overviewOpacity(0.7), smoothingAngle(80.0),
+                 optimizeVertexCache(false), vertexCacheOptimized(false),
+                 compactMode(false), compacted(false),
+                 distanceFieldEnabled(false), distanceFieldVoxelSize(0.0), distanceFieldBandWidth(0.0),
+                 centerlineEnabled(false) {
             // 默认颜色
             overviewColor[0] = 0.8;
             overviewColor[1] = 0.8;
@@ -47,61 +572,198 @@ namespace BronchoscopyLib {
             endoscopeColor[2] = 0.7;
         }
         
-        void CreateMappers() {
-            if (!airwayModel) return;
+        // 将当前设置写入预处理结果
+        void ApplySettings(PreparedModel& model) {
+            if (!preprocessPool) {
+                preprocessPool = std::make_shared<ThreadPool>();
+            }
             
-            // 可选：清理模型数据
-            bool useCleanPolyData = true;  // 可以设置为false跳过清理
-            vtkPolyData* inputData = airwayModel;
+            model.smoothingAngle = smoothingAngle;
+            model.optimizeVertexCache = optimizeVertexCache;
+            model.compactMode = compactMode;
+            model.pool = preprocessPool;
+            model.distanceFieldEnabled = distanceFieldEnabled;
+            model.distanceFieldVoxelSize = distanceFieldVoxelSize;
+            model.distanceFieldBandWidth = distanceFieldBandWidth;
+            model.centerlineEnabled = centerlineEnabled;
+            model.centerlineSettings = centerlineSettings;
+        }
+        
+        // 设置变化后从firstStage开始重新预处理已加载的模型（同步）
+        // 之前阶段的缓存输出被复用，例如修改特征角只重新计算法线及其后续阶段
+        void Reprocess(int firstStage) {
+            if (!currentModel) return;
             
-            vtkSmartPointer<vtkCleanPolyData> cleaner;
-            if (useCleanPolyData) {
-                cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-                cleaner->SetInputData(airwayModel);
-                cleaner->SetTolerance(0.00001);  // 非常小的容差，只合并完全相同的点
-                cleaner->PointMergingOn();
-                cleaner->Update();
-                inputData = cleaner->GetOutput();
+            // 复制的只是各阶段数据的引用，失败时当前模型保持不变
+            std::shared_ptr<PreparedModel> model = std::make_shared<PreparedModel>(*currentModel);
+            ApplySettings(*model);
+            
+            if (RunStages(*model, firstStage, nullptr, nullptr)) {
+                Install(model);
                 
-                std::cout << "ModelManager: Cleaned model - " 
-                         << "Original points: " << airwayModel->GetNumberOfPoints()
-                         << ", Cleaned points: " << inputData->GetNumberOfPoints() 
-                         << std::endl;
+                // 更新Actor的mapper
+                if (overviewActor && overviewMapper) {
+                    overviewActor->SetMapper(overviewMapper);
+                }
+                if (endoscopeActor && endoscopeMapper) {
+                    endoscopeActor->SetMapper(endoscopeMapper);
+                }
             }
+        }
+        
+        // 距离场或中心线设置变化后只更新已加载模型的派生数据（同步），网格和mapper不变
+        void ReprocessDerivedData() {
+            if (!currentModel) return;
             
-            // 生成平滑法线
-            vtkSmartPointer<vtkPolyDataNormals> normalGenerator = 
-                vtkSmartPointer<vtkPolyDataNormals>::New();
-            normalGenerator->SetInputData(inputData);
-            
-            // 设置特征角度 - 使用很高的角度实现完全平滑
-            normalGenerator->SetFeatureAngle(160.0);  // 增加到160度
-            
-            // 关闭分割以获得完全平滑的效果
-            normalGenerator->SplittingOff();  // 不分割顶点
-            normalGenerator->ComputePointNormalsOn();   // 计算顶点法线
-            normalGenerator->ComputeCellNormalsOff();   // 不计算面法线
+            std::shared_ptr<PreparedModel> model = std::make_shared<PreparedModel>(*currentModel);
+            ApplySettings(*model);
             
-            // 确保法线一致性
-            normalGenerator->ConsistencyOn();
+            if (UpdateDistanceField(*model, nullptr, nullptr) && UpdateCenterline(*model, nullptr, nullptr)) {
+                currentModel = model;
+                distanceField = model->distanceField;
+                centerline = model->centerline;
+            }
+        }
+        
+        // 安装预处理结果：替换渲染数据并配置mapper（必须在渲染线程调用）
+        void Install(const std::shared_ptr<PreparedModel>& model) {
+            // BVH不同时三角形编号失效，内窥镜视图恢复为完整网格
+            if (!bvh || model->bvh != bvh) {
+                endoscopeCulled = false;
+                endoscopeCells.clear();
+            }
+            endoscopeModel = nullptr;
             
-            // 自动确定法线方向
-            normalGenerator->AutoOrientNormalsOn();
+            currentModel = model;
+            smoothedModel = model->GetRendered();
+            vertexCacheOptimized = model->vertexCacheOptimized;
+            vertexCacheStats = model->vertexCacheStats;
+            compacted = model->compacted;
+            bvh = model->bvh;
+            distanceField = model->distanceField;
+            centerline = model->centerline;
             
-            normalGenerator->Update();
-            smoothedModel = normalGenerator->GetOutput();
+            // 紧凑化后source即为紧凑数据，双精度源副本已释放
+            airwayModel = model->source;
             
             // 使用OpenGLPolyDataMapper以支持自定义shader
-            overviewMapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
+            // 重新预处理时复用已有mapper，保留其上已应用的shader替换
+            if (!overviewMapper) {
+                overviewMapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
+                overviewMapper->ScalarVisibilityOff();
+            }
             overviewMapper->SetInputData(smoothedModel);
-            overviewMapper->ScalarVisibilityOff();
             
-            endoscopeMapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
-            endoscopeMapper->SetInputData(smoothedModel);
-            endoscopeMapper->ScalarVisibilityOff();
+            if (!endoscopeMapper) {
+                endoscopeMapper = vtkSmartPointer<vtkOpenGLPolyDataMapper>::New();
+                endoscopeMapper->ScalarVisibilityOff();
+            }
+            UpdateEndoscopeInput();
+            
+            UpdateCompactNormalMapping(overviewMapper);
+            UpdateCompactNormalMapping(endoscopeMapper);
+            
+            if (compacted) {
+                size_t bytes = 0;
+                std::vector<vtkObject*> arrays;
+                CollectArrays(smoothedModel, arrays);
+                for (vtkObject* array : arrays) {
+                    bytes += ArrayBytes(array);
+                }
+                std::cout << "ModelManager: Compact mesh retained, " 
+                         << bytes / 1024 << " KB" << std::endl;
+            }
             
             std::cout << "ModelManager: Applied smooth shading with feature angle " 
-                     << smoothingAngle << " degrees" << std::endl;
+                     << model->smoothingAngle << " degrees" << std::endl;
+        }
+        
+        // 内窥镜mapper的输入：完整网格，或共享其点和点数据、只含可见三角形的网格
+        void UpdateEndoscopeInput() {
+            if (!endoscopeMapper) return;
+            
+            vtkIdTypeArray* connectivity = smoothedModel ? smoothedModel->GetPolys()->GetData() : nullptr;
+            const vtkIdType triangleCount = smoothedModel ? smoothedModel->GetNumberOfPolys() : 0;
+            if (!endoscopeCulled || !connectivity || connectivity->GetNumberOfValues() != triangleCount * 4) {
+                endoscopeModel = nullptr;
+                endoscopeMapper->SetInputData(smoothedModel);
+                return;
+            }
+            
+            // 点数组不变时VBO沿用，切换可见集只重建索引缓冲
+            if (!endoscopeModel || endoscopeModel->GetPoints() != smoothedModel->GetPoints()) {
+                endoscopeModel = vtkSmartPointer<vtkPolyData>::New();
+                endoscopeModel->SetPoints(smoothedModel->GetPoints());
+                endoscopeModel->GetPointData()->PassData(smoothedModel->GetPointData());
+            }
+            
+            vtkSmartPointer<vtkIdTypeArray> visible = vtkSmartPointer<vtkIdTypeArray>::New();
+            visible->SetNumberOfValues(static_cast<vtkIdType>(endoscopeCells.size()) * 4);
+            const vtkIdType* source = connectivity->GetPointer(0);
+            vtkIdType* target = visible->GetPointer(0);
+            vtkIdType count = 0;
+            for (long long cell : endoscopeCells) {
+                if (cell < 0 || cell >= triangleCount) continue;
+                std::copy(source + cell * 4, source + cell * 4 + 4, target + count * 4);
+                count++;
+            }
+            visible->SetNumberOfValues(count * 4);
+            
+            vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+            polys->SetCells(count, visible);
+            endoscopeModel->SetPolys(polys);
+            endoscopeMapper->SetInputData(endoscopeModel);
+        }
+        
+        // 根据当前是否为紧凑数据设置法线属性映射和解码shader
+        void UpdateCompactNormalMapping(vtkPolyDataMapper* mapper) {
+            if (!mapper) return;
+            
+            mapper->RemoveAllVertexAttributeMappings();
+            if (compacted) {
+                mapper->MapDataArrayToVertexAttribute(
+                    "normalOctMC", MeshOptimizer::CompactNormalArrayName,
+                    vtkDataObject::FIELD_ASSOCIATION_POINTS, -1);
+            }
+            
+            ApplyCompactNormalShader(mapper);
+        }
+        
+        // 应用shader变体；mapper已是该变体时不做任何修改，避免VTK重建shader程序
+        void ApplyVariant(ShaderSystem& shaderSystem, vtkActor* actor, vtkPolyDataMapper* mapper,
+                          const ShaderSystem::ShaderConfig& config) {
+            bool alreadyApplied = shaderSystem.HasVariant(
+                vtkOpenGLPolyDataMapper::SafeDownCast(mapper), config);
+            
+            shaderSystem.ApplyShader(actor, config);
+            
+            // 变体被重新应用时替换已全部清除，紧凑法线解码需要重新添加
+            if (!alreadyApplied) {
+                ApplyCompactNormalShader(mapper);
+            }
+        }
+        
+        // 紧凑数据的法线解码必须在视图/材质shader之后重新添加
+        // （ShaderSystem::ApplyShaderToMapper会清除所有替换）
+        void ApplyCompactNormalShader(vtkPolyDataMapper* mapper) {
+            vtkOpenGLPolyDataMapper* glMapper = vtkOpenGLPolyDataMapper::SafeDownCast(mapper);
+            if (!glMapper) return;
+            
+            if (compacted) {
+                glMapper->AddShaderReplacement(vtkShader::Vertex, "//VTK::Normal::Dec", true,
+                                               kCompactNormalVSDec, false);
+                glMapper->AddShaderReplacement(vtkShader::Vertex, "//VTK::Normal::Impl", true,
+                                               kCompactNormalVSImpl, false);
+                glMapper->AddShaderReplacement(vtkShader::Fragment, "//VTK::Normal::Dec", true,
+                                               kCompactNormalFSDec, false);
+                glMapper->AddShaderReplacement(vtkShader::Fragment, "//VTK::Normal::Impl", true,
+                                               kCompactNormalFSImpl, false);
+            } else {
+                glMapper->ClearShaderReplacement(vtkShader::Vertex, "//VTK::Normal::Dec", true);
+                glMapper->ClearShaderReplacement(vtkShader::Vertex, "//VTK::Normal::Impl", true);
+                glMapper->ClearShaderReplacement(vtkShader::Fragment, "//VTK::Normal::Dec", true);
+                glMapper->ClearShaderReplacement(vtkShader::Fragment, "//VTK::Normal::Impl", true);
+            }
         }
     };
     
@@ -110,7 +772,7 @@ namespace BronchoscopyLib {
     
     ModelManager::~ModelManager() = default;
     
-    bool ModelManager::LoadModel(vtkPolyData* polyData) {
+    bool ModelManager::LoadModel(vtkPolyData* polyData, bool adopt) {
         if (!polyData) {
             std::cerr << "ModelManager: Invalid polyData (null)" << std::endl;
             return false;
@@ -120,12 +782,88 @@ namespace BronchoscopyLib {
         std::cout << "Input PolyData points: " << polyData->GetNumberOfPoints() << std::endl;
         std::cout << "Input PolyData cells: " << polyData->GetNumberOfCells() << std::endl;
         
-        // 深拷贝polyData，确保数据的生命周期独立于外部
-        pImpl->airwayModel = vtkSmartPointer<vtkPolyData>::New();
-        pImpl->airwayModel->DeepCopy(polyData);
+        std::shared_ptr<PreparedModel> model = CreatePreparedModel();
+        if (!PrepareModel(*model, polyData, adopt)) {
+            return false;
+        }
+        
+        bool success = InstallPreparedModel(model);
+        
+        std::cout << "Model loaded successfully" << std::endl;
+        std::cout << "================================" << std::endl;
+        
+        return success;
+    }
+    
+    std::shared_ptr<PreparedModel> ModelManager::CreatePreparedModel() const {
+        std::shared_ptr<PreparedModel> model = std::make_shared<PreparedModel>();
+        pImpl->ApplySettings(*model);
+        
+        // 缓存回调随模型固定：之后SetCache指向其他文件不影响已加载模型的重新预处理
+        model->loadCache = pImpl->loadCache;
+        model->storeCache = pImpl->storeCache;
+        return model;
+    }
+    
+    bool ModelManager::PrepareModel(PreparedModel& model, vtkPolyData* polyData, bool adopt,
+                                    const PreprocessProgress& progress,
+                                    const std::atomic<bool>* cancelFlag) {
+        if (!polyData) {
+            std::cerr << "ModelManager: Invalid polyData (null)" << std::endl;
+            return false;
+        }
+        
+        model.source = vtkSmartPointer<vtkPolyData>::New();
+        if (adopt) {
+            // 接管模式：共享数组缓冲区，同时脱离调用方的管线（如reader输出）
+            model.source->ShallowCopy(polyData);
+        } else {
+            // 深拷贝polyData，确保数据的生命周期独立于外部
+            model.source->DeepCopy(polyData);
+        }
+        model.stagesReleased = false;
+        
+        return RunStages(model, PreparedModel::STAGE_CLEAN, progress, cancelFlag);
+    }
+    
+    bool ModelManager::PrepareModelFromVolume(PreparedModel& model, vtkImageData* volume,
+                                              const SurfaceExtractor::Settings& settings,
+                                              const PreprocessProgress& progress,
+                                              const std::atomic<bool>* cancelFlag) {
+        if (!volume) {
+            std::cerr << "ModelManager: Invalid volume (null)" << std::endl;
+            return false;
+        }
+        
+        // 表面提取在总进度中的份额
+        const double surfaceShare = 0.4;
         
-        // 创建mappers
-        pImpl->CreateMappers();
+        ReportProgress(progress, 0.0, "surface");
+        vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+        if (!SurfaceExtractor::Extract(volume, settings, surface, model.pool.get(), cancelFlag)) {
+            return false;
+        }
+        
+        // 提取结果由本对象独占，直接作为输入
+        model.source = surface;
+        model.stagesReleased = false;
+        
+        PreprocessProgress stageProgress;
+        if (progress) {
+            stageProgress = [&progress, surfaceShare](double value, const char* stage) {
+                progress(surfaceShare + (1.0 - surfaceShare) * value, stage);
+            };
+        }
+        return RunStages(model, PreparedModel::STAGE_CLEAN, stageProgress, cancelFlag);
+    }
+    
+    bool ModelManager::InstallPreparedModel(const std::shared_ptr<PreparedModel>& model) {
+        if (!model || !model->GetRendered()) {
+            std::cerr << "ModelManager: Prepared model is empty" << std::endl;
+            return false;
+        }
+        
+        pImpl->Install(model);
         
         // 如果Actor已存在，更新它们的mapper
         if (pImpl->overviewActor && pImpl->overviewMapper) {
@@ -135,9 +873,6 @@ namespace BronchoscopyLib {
             pImpl->endoscopeActor->SetMapper(pImpl->endoscopeMapper);
         }
         
-        std::cout << "Model loaded successfully" << std::endl;
-        std::cout << "================================" << std::endl;
-        
         return true;
     }
     
@@ -145,6 +880,24 @@ namespace BronchoscopyLib {
         return pImpl->airwayModel;
     }
     
+    vtkPolyData* ModelManager::GetRenderedData() const {
+        return pImpl->smoothedModel;
+    }
+    
+    void ModelManager::SetEndoscopeVisibleCells(const std::vector<long long>& cells) {
+        pImpl->endoscopeCulled = true;
+        pImpl->endoscopeCells = cells;
+        pImpl->UpdateEndoscopeInput();
+    }
+    
+    void ModelManager::ClearEndoscopeVisibleCells() {
+        if (!pImpl->endoscopeCulled) return;
+        
+        pImpl->endoscopeCulled = false;
+        pImpl->endoscopeCells.clear();
+        pImpl->UpdateEndoscopeInput();
+    }
+    
     vtkActor* ModelManager::CreateOverviewActor() {
         if (!pImpl->airwayModel || !pImpl->overviewMapper) {
             std::cerr << "ModelManager: Cannot create overview actor without model data" << std::endl;
@@ -187,13 +940,7 @@ namespace BronchoscopyLib {
     }
     
     void ModelManager::AddToRenderers(vtkRenderer* overviewRenderer, vtkRenderer* endoscopeRenderer) {
-        // 初始化ShaderSystem
-        static ShaderSystem shaderSystem;
-        static bool shaderInitialized = false;
-        if (!shaderInitialized) {
-            shaderSystem.Initialize();
-            shaderInitialized = true;
-        }
+        ShaderSystem& shaderSystem = pImpl->GetShaderSystem();
         
         // 创建Actor如果还不存在
         if (!pImpl->overviewActor && pImpl->airwayModel) {
@@ -206,35 +953,51 @@ namespace BronchoscopyLib {
         // 添加到渲染器并应用shader
         if (overviewRenderer && pImpl->overviewActor) {
             overviewRenderer->AddActor(pImpl->overviewActor);
+            shaderSystem.AttachRenderer(overviewRenderer);
             
-            // 先应用视图shader
+            // 视图 + 组织材质组合成一个缓存的变体
             ShaderSystem::ShaderConfig config(ShaderSystem::SURFACE, 
                                              ShaderSystem::EFFECT_NONE, 
-                                             ShaderSystem::VIEW_OVERVIEW);
-            shaderSystem.ApplyShader(pImpl->overviewActor, config);
-            
-            // 再应用材质shader（不会清除之前的替换）
-            shaderSystem.ApplyMaterialShader(pImpl->overviewActor, ShaderSystem::MATERIAL_TISSUE);
+                                             ShaderSystem::VIEW_OVERVIEW,
+                                             ShaderSystem::MATERIAL_TISSUE);
+            pImpl->ApplyVariant(shaderSystem, pImpl->overviewActor, pImpl->overviewMapper, config);
             
             std::cout << "Overview actor added with tissue material and view shader" << std::endl;
         }
         
         if (endoscopeRenderer && pImpl->endoscopeActor) {
             endoscopeRenderer->AddActor(pImpl->endoscopeActor);
+            shaderSystem.AttachRenderer(endoscopeRenderer);
             
-            // 先应用视图shader
             ShaderSystem::ShaderConfig config(ShaderSystem::SURFACE, 
                                              ShaderSystem::EFFECT_NONE, 
-                                             ShaderSystem::VIEW_ENDOSCOPE);
-            shaderSystem.ApplyShader(pImpl->endoscopeActor, config);
-            
-            // 再应用材质shader（不会清除之前的替换）
-            shaderSystem.ApplyMaterialShader(pImpl->endoscopeActor, ShaderSystem::MATERIAL_TISSUE);
+                                             ShaderSystem::VIEW_ENDOSCOPE,
+                                             ShaderSystem::MATERIAL_TISSUE);
+            pImpl->ApplyVariant(shaderSystem, pImpl->endoscopeActor, pImpl->endoscopeMapper, config);
             
             std::cout << "Endoscope actor added with tissue material and view shader" << std::endl;
         }
     }
     
+    void ModelManager::SetShaderSystem(ShaderSystem* shaderSystem) {
+        pImpl->shaderSystem = shaderSystem;
+        if (shaderSystem) {
+            pImpl->ownedShaderSystem.reset();
+        }
+    }
+    
+    ShaderSystem& ModelManager::GetShaderSystem() const {
+        return pImpl->GetShaderSystem();
+    }
+    
+    void ModelManager::GetShaderCacheStats(unsigned long& hits, unsigned long& misses, 
+                                           unsigned long& reusedMappers) const {
+        ShaderSystem::VariantCacheStats stats = pImpl->GetShaderSystem().GetVariantCacheStats();
+        hits = stats.hits;
+        misses = stats.misses;
+        reusedMappers = stats.reusedMappers;
+    }
+    
     void ModelManager::RemoveFromRenderers(vtkRenderer* overviewRenderer, vtkRenderer* endoscopeRenderer) {
         if (overviewRenderer && pImpl->overviewActor) {
             overviewRenderer->RemoveActor(pImpl->overviewActor);
@@ -279,20 +1042,92 @@ namespace BronchoscopyLib {
         
         pImpl->smoothingAngle = angle;
         
-        // 如果模型已加载，重新创建mapper以应用新的平滑度
+        // 如果模型已加载，在缓存的朝向统一结果上重新计算法线，不重新清理
         if (pImpl->airwayModel) {
-            pImpl->CreateMappers();
+            pImpl->Reprocess(PreparedModel::STAGE_NORMALS);
             
-            // 更新Actor的mapper
-            if (pImpl->overviewActor && pImpl->overviewMapper) {
-                pImpl->overviewActor->SetMapper(pImpl->overviewMapper);
+            std::cout << "ModelManager: Updated smoothing angle to " << angle << " degrees" << std::endl;
+        }
+    }
+    
+    void ModelManager::SetVertexCacheOptimization(bool enable) {
+        if (pImpl->optimizeVertexCache == enable) return;
+        
+        pImpl->optimizeVertexCache = enable;
+        
+        // 如果模型已加载，从顶点缓存优化阶段开始重新预处理
+        if (pImpl->airwayModel) {
+            pImpl->Reprocess(PreparedModel::STAGE_VERTEX_CACHE);
+        }
+        
+        std::cout << "ModelManager: Vertex cache optimization " 
+                 << (enable ? "enabled" : "disabled") << std::endl;
+    }
+    
+    bool ModelManager::GetVertexCacheOptimization() const {
+        return pImpl->optimizeVertexCache;
+    }
+    
+    bool ModelManager::GetVertexCacheStats(double& acmrBefore, double& acmrAfter) const {
+        if (!pImpl->vertexCacheOptimized) {
+            return false;
+        }
+        
+        acmrBefore = pImpl->vertexCacheStats.acmrBefore;
+        acmrAfter = pImpl->vertexCacheStats.acmrAfter;
+        return true;
+    }
+    
+    void ModelManager::SetCompactMode(bool enable) {
+        if (pImpl->compactMode == enable) return;
+        
+        pImpl->compactMode = enable;
+        
+        if (pImpl->airwayModel) {
+            pImpl->Reprocess(PreparedModel::STAGE_COMPACT);
+        }
+        
+        std::cout << "ModelManager: Compact mode " 
+                 << (enable ? "enabled" : "disabled") << std::endl;
+    }
+    
+    bool ModelManager::GetCompactMode() const {
+        return pImpl->compactMode;
+    }
+    
+    std::vector<ModelManager::StageMemory> ModelManager::GetMemoryUsage() const {
+        std::vector<StageMemory> usage;
+        
+        // 按阶段顺序统计，与前面阶段共享的数组只计入第一个持有它的阶段
+        const PreparedModel* model = pImpl->currentModel.get();
+        if (!model) return usage;
+        
+        std::vector<std::pair<std::string, vtkPolyData*>> stages;
+        stages.emplace_back("source", model->source.GetPointer());
+        for (int stage = 0; stage < PreparedModel::STAGE_COUNT; stage++) {
+            if (model->stageOutputs[stage]) {
+                stages.emplace_back(kStageNames[stage], model->stageOutputs[stage].GetPointer());
             }
-            if (pImpl->endoscopeActor && pImpl->endoscopeMapper) {
-                pImpl->endoscopeActor->SetMapper(pImpl->endoscopeMapper);
+        }
+        
+        std::set<vtkObject*> counted;
+        for (const auto& stage : stages) {
+            StageMemory entry;
+            entry.stage = stage.first;
+            entry.bytes = 0;
+            
+            std::vector<vtkObject*> arrays;
+            CollectArrays(stage.second, arrays);
+            for (vtkObject* array : arrays) {
+                if (counted.insert(array).second) {
+                    entry.bytes += ArrayBytes(array);
+                }
             }
             
-            std::cout << "ModelManager: Updated smoothing angle to " << angle << " degrees" << std::endl;
+            usage.push_back(entry);
         }
+        
+        return usage;
     }
     
     void ModelManager::GetModelBounds(double bounds[6]) const {
@@ -306,10 +1141,86 @@ namespace BronchoscopyLib {
         }
     }
     
+    std::shared_ptr<const MeshBVH> ModelManager::GetBVH() const {
+        return pImpl->bvh;
+    }
+    
+    ThreadPool* ModelManager::GetThreadPool() const {
+        return pImpl->preprocessPool.get();
+    }
+    
+    void ModelManager::SetDistanceField(bool enable, double voxelSize, double bandWidth) {
+        pImpl->distanceFieldEnabled = enable;
+        pImpl->distanceFieldVoxelSize = std::max(voxelSize, 0.0);
+        pImpl->distanceFieldBandWidth = std::max(bandWidth, 0.0);
+        
+        if (pImpl->airwayModel) {
+            pImpl->ReprocessDerivedData();
+        }
+        
+        std::cout << "ModelManager: Distance field " << (enable ? "enabled" : "disabled") << std::endl;
+    }
+    
+    bool ModelManager::GetDistanceFieldEnabled() const {
+        return pImpl->distanceFieldEnabled;
+    }
+    
+    void ModelManager::SetCache(CacheLoader load, CacheStore store) {
+        // 工作线程上的加载和渲染线程上的重新预处理可能同时访问缓存，回调调用一律串行
+        std::shared_ptr<std::mutex> mutex = pImpl->cacheMutex;
+        pImpl->loadCache = nullptr;
+        pImpl->storeCache = nullptr;
+        if (load) {
+            pImpl->loadCache = [load, mutex](const std::string& name, std::vector<unsigned char>& data) {
+                std::lock_guard<std::mutex> lock(*mutex);
+                return load(name, data);
+            };
+        }
+        if (store) {
+            pImpl->storeCache = [store, mutex](const std::string& name, const std::vector<unsigned char>& data) {
+                std::lock_guard<std::mutex> lock(*mutex);
+                store(name, data);
+            };
+        }
+    }
+    
+    std::shared_ptr<const DistanceField> ModelManager::GetDistanceField() const {
+        return pImpl->distanceField;
+    }
+    
+    void ModelManager::SetCenterlineExtraction(bool enable, const Centerline::Settings& settings) {
+        pImpl->centerlineEnabled = enable;
+        pImpl->centerlineSettings = settings;
+        
+        if (pImpl->airwayModel) {
+            pImpl->ReprocessDerivedData();
+        }
+        
+        std::cout << "ModelManager: Centerline extraction " << (enable ? "enabled" : "disabled") << std::endl;
+    }
+    
+    bool ModelManager::GetCenterlineExtraction() const {
+        return pImpl->centerlineEnabled;
+    }
+    
+    std::shared_ptr<const Centerline> ModelManager::GetCenterline() const {
+        return pImpl->centerline;
+    }
+    
     void ModelManager::ClearModel() {
         pImpl->airwayModel = nullptr;
+        pImpl->smoothedModel = nullptr;
+        pImpl->vertexCacheOptimized = false;
+        pImpl->compacted = false;
+        pImpl->currentModel = nullptr;
+        pImpl->bvh = nullptr;
+        pImpl->distanceField = nullptr;
+        pImpl->centerline = nullptr;
         pImpl->overviewMapper = nullptr;
         pImpl->endoscopeMapper = nullptr;
+        pImpl->endoscopeCulled = false;
+        pImpl->endoscopeCells.clear();
+        pImpl->endoscopeModel = nullptr;
         pImpl->overviewActor = nullptr;
         pImpl->endoscopeActor = nullptr;
     }
@@ -328,6 +1239,12 @@ namespace BronchoscopyLib {
         std::cout << "Points: " << pImpl->airwayModel->GetNumberOfPoints() << std::endl;
         std::cout << "Cells: " << pImpl->airwayModel->GetNumberOfCells() << std::endl;
         
+        if (pImpl->vertexCacheOptimized) {
+            std::cout << "ACMR: " << pImpl->vertexCacheStats.acmrBefore 
+                      << " -> " << pImpl->vertexCacheStats.acmrAfter 
+                      << " (cache size " << pImpl->vertexCacheStats.cacheSize << ")" << std::endl;
+        }
+        
         double bounds[6];
         GetModelBounds(bounds);
         std::cout << "Bounds: [" 
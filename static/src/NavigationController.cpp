@@ -147,6 +147,17 @@ namespace BronchoscopyLib {
         return result;
     }
     
+    bool NavigationController::MoveToNextBifurcation() {
+        if (!pImpl->cameraPath) return false;
+        
+        NodeTopology topology;
+        if (!pImpl->cameraPath->GetNodeTopology(pImpl->currentIndex, topology) ||
+            topology.nextBifurcation < 0) {
+            return false;
+        }
+        return MoveToPosition(topology.nextBifurcation);
+    }
+    
     PathNode* NavigationController::GetCurrentNode() const {
         return pImpl->currentNode;
     }
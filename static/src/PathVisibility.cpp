@@ -0,0 +1,508 @@
+#include "PathVisibility.h"
+#include "CameraPath.h"
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+
+// VTK头文件
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        const double Pi = 3.14159265358979323846;
+
+        // 每个节点向相邻节点方向取的位姿（沿连线的比例）；相机在两节点之间时总有一个节点离它更近
+        const double PoseOffsets[] = { 0.25, 0.5 };
+
+        // 圆锥半角上限（度），超过90度时圆锥退化为半球以上
+        const double MaxConeAngle = 89.0;
+
+        void Normalize(double v[3]) {
+            double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            if (length > 0.0) {
+                v[0] /= length;
+                v[1] /= length;
+                v[2] /= length;
+            }
+        }
+
+        // 相机位姿
+        struct Pose {
+            double position[3];
+            double direction[3];
+        };
+
+    } // namespace
+
+    class PathVisibility::Impl {
+    public:
+        std::shared_ptr<const MeshBVH> bvh;
+        Settings settings;
+
+        // 块划分：每个三角形所在块，各块的三角形（CSR，块内升序）
+        std::vector<int> cellChunk;
+        std::vector<size_t> chunkOffsets;
+        std::vector<long long> chunkCells;
+
+        // 块邻接（共享顶点），CSR
+        std::vector<size_t> adjacencyOffsets;
+        std::vector<int> adjacency;
+
+        // 节点坐标、方向和可见块位集（每节点wordsPerNode个64位字）
+        std::vector<double> nodePositions;
+        std::vector<double> nodeDirections;
+        std::vector<uint64_t> nodeBits;
+        size_t wordsPerNode;
+
+        double averageFraction;
+
+        Impl() : wordsPerNode(0), averageFraction(0.0) {}
+
+        int ChunkCount() const {
+            return chunkOffsets.empty() ? 0 : static_cast<int>(chunkOffsets.size() - 1);
+        }
+
+        // 按三角形质心递归中值划分，直到每块不超过目标三角形数
+        void BuildChunks(const std::vector<float>& centroids, size_t triangleCount, int targetTriangles) {
+            std::vector<long long> order(triangleCount);
+            for (size_t t = 0; t < triangleCount; t++) {
+                order[t] = static_cast<long long>(t);
+            }
+
+            const size_t target = static_cast<size_t>(std::max(targetTriangles, 1));
+            std::vector<std::pair<size_t, size_t>> stack;
+            std::vector<std::pair<size_t, size_t>> ranges;
+            stack.emplace_back(0, triangleCount);
+            while (!stack.empty()) {
+                std::pair<size_t, size_t> range = stack.back();
+                stack.pop_back();
+                if (range.second - range.first <= target) {
+                    ranges.push_back(range);
+                    continue;
+                }
+
+                float lo[3], hi[3];
+                for (int i = 0; i < 3; i++) {
+                    lo[i] = std::numeric_limits<float>::max();
+                    hi[i] = -std::numeric_limits<float>::max();
+                }
+                for (size_t k = range.first; k < range.second; k++) {
+                    const float* c = &centroids[order[k] * 3];
+                    for (int i = 0; i < 3; i++) {
+                        lo[i] = std::min(lo[i], c[i]);
+                        hi[i] = std::max(hi[i], c[i]);
+                    }
+                }
+                int axis = 0;
+                for (int i = 1; i < 3; i++) {
+                    if (hi[i] - lo[i] > hi[axis] - lo[axis]) axis = i;
+                }
+
+                size_t mid = range.first + (range.second - range.first) / 2;
+                std::nth_element(order.begin() + range.first, order.begin() + mid, order.begin() + range.second,
+                                 [&centroids, axis](long long a, long long b) {
+                                     return centroids[a * 3 + axis] < centroids[b * 3 + axis];
+                                 });
+                // 后压入前半段，块编号按深度优先顺序，相邻编号在空间上也相邻
+                stack.emplace_back(mid, range.second);
+                stack.emplace_back(range.first, mid);
+            }
+
+            cellChunk.assign(triangleCount, 0);
+            chunkOffsets.assign(1, 0);
+            chunkCells.clear();
+            chunkCells.reserve(triangleCount);
+            for (const auto& range : ranges) {
+                std::sort(order.begin() + range.first, order.begin() + range.second);
+                for (size_t k = range.first; k < range.second; k++) {
+                    cellChunk[order[k]] = static_cast<int>(chunkOffsets.size() - 1);
+                    chunkCells.push_back(order[k]);
+                }
+                chunkOffsets.push_back(chunkCells.size());
+            }
+        }
+
+        // 共享顶点的块互为相邻
+        void BuildAdjacency(const vtkIdType* cells, size_t triangleCount, vtkIdType pointCount) {
+            std::vector<int> owner(pointCount, -1);
+            std::vector<std::pair<int, int>> pairs;
+            for (size_t t = 0; t < triangleCount; t++) {
+                int chunk = cellChunk[t];
+                for (int k = 1; k <= 3; k++) {
+                    int& o = owner[cells[t * 4 + k]];
+                    if (o < 0) {
+                        o = chunk;
+                    } else if (o != chunk) {
+                        pairs.emplace_back(o, chunk);
+                        pairs.emplace_back(chunk, o);
+                    }
+                }
+            }
+            std::sort(pairs.begin(), pairs.end());
+            pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+            adjacencyOffsets.assign(ChunkCount() + 1, 0);
+            adjacency.resize(pairs.size());
+            for (size_t i = 0; i < pairs.size(); i++) {
+                adjacencyOffsets[pairs[i].first + 1]++;
+                adjacency[i] = pairs[i].second;
+            }
+            for (int c = 0; c < ChunkCount(); c++) {
+                adjacencyOffsets[c + 1] += adjacencyOffsets[c];
+            }
+        }
+    };
+
+    PathVisibility::PathVisibility() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    PathVisibility::~PathVisibility() = default;
+
+    bool PathVisibility::Build(vtkPolyData* mesh, std::shared_ptr<const MeshBVH> bvh, const CameraPath& path,
+                               const Settings& settings, ThreadPool* pool,
+                               const std::atomic<bool>* cancelFlag) {
+        Clear();
+        if (!mesh || !mesh->GetPoints() || !bvh || bvh->IsEmpty() || path.GetTotalNodes() == 0) {
+            return false;
+        }
+
+        // BVH的单元编号即多边形编号，要求网格只含三角形
+        const vtkIdType triangleCount = mesh->GetNumberOfPolys();
+        if (triangleCount == 0 || mesh->GetNumberOfVerts() > 0 || mesh->GetNumberOfLines() > 0 ||
+            mesh->GetNumberOfStrips() > 0 ||
+            mesh->GetPolys()->GetData()->GetNumberOfValues() != triangleCount * 4) {
+            std::cerr << "PathVisibility: Mesh must contain only triangles" << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto cancelled = [cancelFlag]() {
+            return cancelFlag && cancelFlag->load();
+        };
+
+        // 按分块执行，取消后跳过尚未开始的分块
+        auto parallelFor = [pool, &cancelled](size_t count, size_t grain,
+                                              const std::function<void(size_t, size_t)>& body) {
+            auto guarded = [&](size_t begin, size_t end) {
+                if (!cancelled()) body(begin, end);
+            };
+            if (pool) {
+                pool->ParallelFor(count, grain, guarded);
+            } else {
+                for (size_t begin = 0; begin < count; begin += grain) {
+                    guarded(begin, std::min(count, begin + grain));
+                }
+            }
+        };
+
+        // 1. 三角形质心和块划分
+        const vtkIdType* cells = mesh->GetPolys()->GetData()->GetPointer(0);
+        vtkPoints* points = mesh->GetPoints();
+        std::vector<float> centroids(static_cast<size_t>(triangleCount) * 3);
+        parallelFor(static_cast<size_t>(triangleCount), 4096, [&](size_t begin, size_t end) {
+            double p[3];
+            for (size_t t = begin; t < end; t++) {
+                double sum[3] = { 0.0, 0.0, 0.0 };
+                for (int k = 1; k <= 3; k++) {
+                    points->GetPoint(cells[t * 4 + k], p);
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                }
+                for (int i = 0; i < 3; i++) {
+                    centroids[t * 3 + i] = static_cast<float>(sum[i] / 3.0);
+                }
+            }
+        });
+        if (cancelled()) {
+            Clear();
+            return false;
+        }
+        pImpl->BuildChunks(centroids, static_cast<size_t>(triangleCount), settings.chunkTriangles);
+        pImpl->BuildAdjacency(cells, static_cast<size_t>(triangleCount), mesh->GetNumberOfPoints());
+        centroids.clear();
+        centroids.shrink_to_fit();
+
+        const int chunkCount = pImpl->ChunkCount();
+        const size_t words = (static_cast<size_t>(chunkCount) + 63) / 64;
+
+        // 2. 各节点的位姿：节点本身及朝相邻节点的插值位置，方向按比例插值后归一化
+        std::vector<const PathNode*> nodes;
+        for (const PathNode* node = path.GetHead(); node != nullptr; node = node->next) {
+            nodes.push_back(node);
+        }
+        const size_t nodeCount = nodes.size();
+
+        // 3. 覆盖视场的圆锥：垂直半角按最大宽高比换算到对角线
+        const double halfVertical = 0.5 * settings.viewAngle * Pi / 180.0;
+        double coneAngle = std::atan(std::tan(halfVertical) *
+                                     std::sqrt(1.0 + settings.maxAspect * settings.maxAspect)) * 180.0 / Pi;
+        coneAngle = std::min(coneAngle + settings.angleMargin, MaxConeAngle);
+        const double cosCone = std::cos(coneAngle * Pi / 180.0);
+        const int rayCount = std::max(settings.raysPerPose, 1);
+
+        std::vector<uint64_t> nodeBits(nodeCount * words, 0);
+        std::vector<size_t> nodeTriangles(nodeCount, 0);
+
+        parallelFor(nodeCount, 1, [&](size_t begin, size_t end) {
+            std::vector<Pose> poses;
+            std::vector<uint64_t> dilated(words);
+            MeshBVH::Ray ray;
+            MeshBVH::Hit hit;
+
+            for (size_t index = begin; index < end && !cancelled(); index++) {
+                const PathNode* node = nodes[index];
+                poses.clear();
+
+                Pose own;
+                for (int i = 0; i < 3; i++) {
+                    own.position[i] = node->position[i];
+                    own.direction[i] = node->direction[i];
+                }
+                poses.push_back(own);
+                for (const PathNode* neighbor : { node->prev, node->next }) {
+                    if (!neighbor) continue;
+                    for (double t : PoseOffsets) {
+                        Pose pose;
+                        for (int i = 0; i < 3; i++) {
+                            pose.position[i] = node->position[i] + t * (neighbor->position[i] - node->position[i]);
+                            pose.direction[i] = node->direction[i] + t * (neighbor->direction[i] - node->direction[i]);
+                        }
+                        Normalize(pose.direction);
+                        poses.push_back(pose);
+                    }
+                }
+
+                uint64_t* bits = &nodeBits[index * words];
+                for (const Pose& pose : poses) {
+                    // 方向为零（重合的相邻节点）时任取一个方向
+                    double d[3] = { pose.direction[0], pose.direction[1], pose.direction[2] };
+                    if (d[0] == 0.0 && d[1] == 0.0 && d[2] == 0.0) {
+                        d[2] = 1.0;
+                    }
+                    double helper[3] = { 1.0, 0.0, 0.0 };
+                    if (std::abs(d[0]) > 0.9) {
+                        helper[0] = 0.0;
+                        helper[1] = 1.0;
+                    }
+                    double u[3] = { d[1] * helper[2] - d[2] * helper[1],
+                                    d[2] * helper[0] - d[0] * helper[2],
+                                    d[0] * helper[1] - d[1] * helper[0] };
+                    Normalize(u);
+                    double w[3] = { d[1] * u[2] - d[2] * u[1],
+                                    d[2] * u[0] - d[0] * u[2],
+                                    d[0] * u[1] - d[1] * u[0] };
+
+                    // 球冠上的斐波那契点列：按面积均匀分布
+                    for (int k = 0; k < rayCount; k++) {
+                        double z = 1.0 - (1.0 - cosCone) * (k + 0.5) / rayCount;
+                        double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+                        double phi = k * Pi * (3.0 - std::sqrt(5.0));
+                        double c = std::cos(phi), s = std::sin(phi);
+                        for (int i = 0; i < 3; i++) {
+                            ray.origin[i] = pose.position[i];
+                            ray.direction[i] = z * d[i] + r * (c * u[i] + s * w[i]);
+                        }
+                        if (bvh->Intersect(ray, hit) && hit.cellId >= 0 && hit.cellId < triangleCount) {
+                            int chunk = pImpl->cellChunk[hit.cellId];
+                            bits[chunk >> 6] |= uint64_t(1) << (chunk & 63);
+                        }
+                    }
+                }
+
+                // 向相邻块扩展，弥补射线之间的间隙
+                for (int ring = 0; ring < settings.dilation; ring++) {
+                    std::copy(bits, bits + words, dilated.begin());
+                    for (int chunk = 0; chunk < chunkCount; chunk++) {
+                        if (!(bits[chunk >> 6] & (uint64_t(1) << (chunk & 63)))) continue;
+                        for (size_t a = pImpl->adjacencyOffsets[chunk]; a < pImpl->adjacencyOffsets[chunk + 1]; a++) {
+                            int neighbor = pImpl->adjacency[a];
+                            dilated[neighbor >> 6] |= uint64_t(1) << (neighbor & 63);
+                        }
+                    }
+                    std::copy(dilated.begin(), dilated.end(), bits);
+                }
+
+                for (int chunk = 0; chunk < chunkCount; chunk++) {
+                    if (bits[chunk >> 6] & (uint64_t(1) << (chunk & 63))) {
+                        nodeTriangles[index] += pImpl->chunkOffsets[chunk + 1] - pImpl->chunkOffsets[chunk];
+                    }
+                }
+            }
+        });
+
+        if (cancelled()) {
+            Clear();
+            return false;
+        }
+
+        pImpl->bvh = bvh;
+        pImpl->settings = settings;
+        pImpl->wordsPerNode = words;
+        pImpl->nodeBits.swap(nodeBits);
+        pImpl->nodePositions.resize(nodeCount * 3);
+        pImpl->nodeDirections.resize(nodeCount * 3);
+        double fractionSum = 0.0;
+        for (size_t index = 0; index < nodeCount; index++) {
+            for (int i = 0; i < 3; i++) {
+                pImpl->nodePositions[index * 3 + i] = nodes[index]->position[i];
+                pImpl->nodeDirections[index * 3 + i] = nodes[index]->direction[i];
+            }
+            fractionSum += static_cast<double>(nodeTriangles[index]) / static_cast<double>(triangleCount);
+        }
+        pImpl->averageFraction = fractionSum / static_cast<double>(nodeCount);
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "PathVisibility: " << nodeCount << " nodes, " << chunkCount << " chunks, "
+                 << pImpl->averageFraction * 100.0 << "% of triangles visible on average, built in "
+                 << elapsedMs << " ms" << std::endl;
+        return true;
+    }
+
+    void PathVisibility::Clear() {
+        pImpl = std::make_unique<Impl>();
+    }
+
+    bool PathVisibility::IsEmpty() const {
+        return pImpl->nodeBits.empty();
+    }
+
+    std::shared_ptr<const MeshBVH> PathVisibility::GetBVH() const {
+        return pImpl->bvh;
+    }
+
+    const PathVisibility::Settings& PathVisibility::GetSettings() const {
+        return pImpl->settings;
+    }
+
+    int PathVisibility::GetChunkCount() const {
+        return pImpl->ChunkCount();
+    }
+
+    int PathVisibility::GetNodeCount() const {
+        return static_cast<int>(pImpl->nodePositions.size() / 3);
+    }
+
+    size_t PathVisibility::GetTriangleCount() const {
+        return pImpl->cellChunk.size();
+    }
+
+    int PathVisibility::FindNearestNode(const double position[3]) const {
+        int nearest = -1;
+        double best = std::numeric_limits<double>::max();
+        const int nodeCount = GetNodeCount();
+        for (int index = 0; index < nodeCount; index++) {
+            const double* p = &pImpl->nodePositions[static_cast<size_t>(index) * 3];
+            double dx = p[0] - position[0], dy = p[1] - position[1], dz = p[2] - position[2];
+            double distance = dx * dx + dy * dy + dz * dz;
+            if (distance < best) {
+                best = distance;
+                nearest = index;
+            }
+        }
+        return nearest;
+    }
+
+    bool PathVisibility::IsPoseCovered(const double position[3], const double direction[3]) const {
+        const int nodeCount = GetNodeCount();
+        if (nodeCount == 0) return false;
+
+        // 路径折线上的最近点（单节点路径即该节点）及其插值方向
+        double best = std::numeric_limits<double>::max();
+        double nearestDirection[3] = { 0.0, 0.0, 0.0 };
+        const int segmentCount = std::max(nodeCount - 1, 1);
+        for (int segment = 0; segment < segmentCount; segment++) {
+            const int next = std::min(segment + 1, nodeCount - 1);
+            const double* a = &pImpl->nodePositions[static_cast<size_t>(segment) * 3];
+            const double* b = &pImpl->nodePositions[static_cast<size_t>(next) * 3];
+            double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            double lengthSquared = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+            double t = 0.0;
+            if (lengthSquared > 0.0) {
+                t = ((position[0] - a[0]) * ab[0] + (position[1] - a[1]) * ab[1] +
+                     (position[2] - a[2]) * ab[2]) / lengthSquared;
+                t = std::min(std::max(t, 0.0), 1.0);
+            }
+            double distance = 0.0;
+            for (int i = 0; i < 3; i++) {
+                double d = a[i] + t * ab[i] - position[i];
+                distance += d * d;
+            }
+            if (distance < best) {
+                best = distance;
+                const double* da = &pImpl->nodeDirections[static_cast<size_t>(segment) * 3];
+                const double* db = &pImpl->nodeDirections[static_cast<size_t>(next) * 3];
+                for (int i = 0; i < 3; i++) {
+                    nearestDirection[i] = da[i] + t * (db[i] - da[i]);
+                }
+            }
+        }
+
+        const double tolerance = pImpl->settings.positionTolerance;
+        if (best > tolerance * tolerance) return false;
+
+        double view[3] = { direction[0], direction[1], direction[2] };
+        Normalize(view);
+        Normalize(nearestDirection);
+        double cosAngle = view[0] * nearestDirection[0] + view[1] * nearestDirection[1] +
+                          view[2] * nearestDirection[2];
+        return cosAngle >= std::cos(pImpl->settings.angleMargin * Pi / 180.0);
+    }
+
+    void PathVisibility::GetVisibleChunks(int first, int last, std::vector<uint64_t>& bits) const {
+        const size_t words = pImpl->wordsPerNode;
+        bits.assign(words, 0);
+        if (IsEmpty()) return;
+
+        if (first > last) std::swap(first, last);
+        first = std::max(first, 0);
+        last = std::min(last, GetNodeCount() - 1);
+        for (int index = first; index <= last; index++) {
+            const uint64_t* nodeBits = &pImpl->nodeBits[static_cast<size_t>(index) * words];
+            for (size_t w = 0; w < words; w++) {
+                bits[w] |= nodeBits[w];
+            }
+        }
+    }
+
+    void PathVisibility::GetVisibleCells(const std::vector<uint64_t>& bits, std::vector<long long>& cells) const {
+        cells.clear();
+        cells.reserve(CountVisibleTriangles(bits));
+        const int chunkCount = GetChunkCount();
+        for (int chunk = 0; chunk < chunkCount && static_cast<size_t>(chunk >> 6) < bits.size(); chunk++) {
+            if (!(bits[chunk >> 6] & (uint64_t(1) << (chunk & 63)))) continue;
+            cells.insert(cells.end(), pImpl->chunkCells.begin() + pImpl->chunkOffsets[chunk],
+                         pImpl->chunkCells.begin() + pImpl->chunkOffsets[chunk + 1]);
+        }
+    }
+
+    size_t PathVisibility::CountVisibleTriangles(const std::vector<uint64_t>& bits) const {
+        size_t count = 0;
+        const int chunkCount = GetChunkCount();
+        for (int chunk = 0; chunk < chunkCount && static_cast<size_t>(chunk >> 6) < bits.size(); chunk++) {
+            if (bits[chunk >> 6] & (uint64_t(1) << (chunk & 63))) {
+                count += pImpl->chunkOffsets[chunk + 1] - pImpl->chunkOffsets[chunk];
+            }
+        }
+        return count;
+    }
+
+    double PathVisibility::GetAverageVisibleFraction() const {
+        return pImpl->averageFraction;
+    }
+
+} // namespace BronchoscopyLib
@@ -0,0 +1,400 @@
+#include "PostProcessor.h"
+#include "SectionTimer.h"
+
+// VTK headers
+#include <vtkImageProcessingPass.h>
+#include <vtkObjectFactory.h>
+#include <vtkOpenGLFramebufferObject.h>
+#include <vtkOpenGLRenderUtilities.h>
+#include <vtkOpenGLRenderWindow.h>
+#include <vtkOpenGLShaderCache.h>
+#include <vtkOpenGLVertexArrayObject.h>
+#include <vtkRenderState.h>
+#include <vtkRenderStepsPass.h>
+#include <vtkRenderer.h>
+#include <vtkShaderProgram.h>
+#include <vtkSmartPointer.h>
+#include <vtkTextureObject.h>
+#include <vtkWeakPointer.h>
+#include <vtk_glew.h>
+
+// Standard headers
+#include <iostream>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 区段结束后把计时结果写入通道耗时
+        void StoreTiming(const SectionTimer& timer, PostProcessor::PassTiming& timing) {
+            timing.cpuMs = timer.GetCpuMs();
+            timing.gpuMs = timer.GetGpuMs();
+            timing.gpuUpdated = timer.HasNewGpuResult();
+        }
+
+        // 一个全屏后处理通道
+        struct PostPass {
+            std::string name;
+            std::string vertexSource;
+            std::string fragmentSource;
+
+            vtkShaderProgram* program;  // 由渲染窗口的shader缓存持有
+            bool failed;                // 编译失败后不再重试
+            vtkSmartPointer<vtkOpenGLVertexArrayObject> vao;
+            SectionTimer timer;
+            PostProcessor::PassTiming timing;
+
+            PostPass() : program(nullptr), failed(false) {}
+        };
+
+        // PostProcessor和渲染通道共享的通道列表
+        struct PassChain {
+            std::vector<std::shared_ptr<PostPass>> passes;
+            SectionTimer sceneTimer;
+            PostProcessor::PassTiming sceneTiming;
+
+            PassChain() {
+                sceneTiming.name = "scene";
+            }
+        };
+
+        // VTK渲染通道：场景渲染到离屏纹理后依次执行后处理通道
+        class PostProcessingPass : public vtkImageProcessingPass {
+        public:
+            static PostProcessingPass* New();
+            vtkTypeMacro(PostProcessingPass, vtkImageProcessingPass);
+
+            std::shared_ptr<PassChain> Chain;
+
+            void Render(const vtkRenderState* s) override;
+            void ReleaseGraphicsResources(vtkWindow* window) override;
+
+        protected:
+            PostProcessingPass() {}
+            ~PostProcessingPass() override {}
+
+            // 离屏目标（场景和中间结果交替使用）
+            vtkSmartPointer<vtkOpenGLFramebufferObject> FrameBuffers[2];
+            vtkSmartPointer<vtkTextureObject> Textures[2];
+
+            void PrepareTarget(vtkOpenGLRenderWindow* renWin, int index, int width, int height);
+            bool PreparePass(vtkOpenGLRenderWindow* renWin, PostPass& pass);
+            void DrawPass(vtkOpenGLRenderWindow* renWin, PostPass& pass, vtkTextureObject* input,
+                          int width, int height);
+
+        private:
+            PostProcessingPass(const PostProcessingPass&) = delete;
+            void operator=(const PostProcessingPass&) = delete;
+        };
+
+        vtkStandardNewMacro(PostProcessingPass);
+
+        void PostProcessingPass::PrepareTarget(vtkOpenGLRenderWindow* renWin, int index,
+                                               int width, int height) {
+            if (!this->Textures[index]) {
+                this->Textures[index] = vtkSmartPointer<vtkTextureObject>::New();
+                this->Textures[index]->SetContext(renWin);
+                this->Textures[index]->SetMinificationFilter(vtkTextureObject::Linear);
+                this->Textures[index]->SetMagnificationFilter(vtkTextureObject::Linear);
+                this->Textures[index]->SetWrapS(vtkTextureObject::ClampToEdge);
+                this->Textures[index]->SetWrapT(vtkTextureObject::ClampToEdge);
+            }
+
+            vtkTextureObject* texture = this->Textures[index];
+            if (static_cast<int>(texture->GetWidth()) != width ||
+                static_cast<int>(texture->GetHeight()) != height) {
+                texture->Create2D(width, height, 4, VTK_UNSIGNED_CHAR, false);
+            }
+
+            if (!this->FrameBuffers[index]) {
+                this->FrameBuffers[index] = vtkSmartPointer<vtkOpenGLFramebufferObject>::New();
+                this->FrameBuffers[index]->SetContext(renWin);
+            }
+        }
+
+        bool PostProcessingPass::PreparePass(vtkOpenGLRenderWindow* renWin, PostPass& pass) {
+            if (pass.failed) {
+                return false;
+            }
+
+            if (!pass.program) {
+                pass.program = renWin->GetShaderCache()->ReadyShaderProgram(
+                    pass.vertexSource.c_str(), pass.fragmentSource.c_str(), "");
+                if (!pass.program) {
+                    std::cerr << "PostProcessor: Failed to compile pass " << pass.name
+                             << ", pass disabled" << std::endl;
+                    pass.failed = true;
+                    return false;
+                }
+                pass.vao = vtkSmartPointer<vtkOpenGLVertexArrayObject>::New();
+            }
+            return true;
+        }
+
+        void PostProcessingPass::DrawPass(vtkOpenGLRenderWindow* renWin, PostPass& pass,
+                                          vtkTextureObject* input, int width, int height) {
+            renWin->GetShaderCache()->ReadyShaderProgram(pass.program);
+
+            input->Activate();
+            pass.program->SetUniformi("screenTexture", input->GetTextureUnit());
+            float screenSize[2] = { static_cast<float>(width), static_cast<float>(height) };
+            pass.program->SetUniform2f("screenSize", screenSize);
+
+            // 覆盖整个目标的四边形（裁剪空间坐标）
+            float verts[12] = {
+                -1.0f, -1.0f, 0.0f,
+                 1.0f, -1.0f, 0.0f,
+                 1.0f,  1.0f, 0.0f,
+                -1.0f,  1.0f, 0.0f
+            };
+            float tcoords[8] = {
+                0.0f, 0.0f,
+                1.0f, 0.0f,
+                1.0f, 1.0f,
+                0.0f, 1.0f
+            };
+            vtkOpenGLRenderUtilities::RenderQuad(verts, tcoords, pass.program, pass.vao);
+
+            input->Deactivate();
+        }
+
+        void PostProcessingPass::Render(const vtkRenderState* s) {
+            this->NumberOfRenderedProps = 0;
+
+            vtkRenderer* renderer = s->GetRenderer();
+            vtkOpenGLRenderWindow* renWin =
+                vtkOpenGLRenderWindow::SafeDownCast(renderer->GetRenderWindow());
+            if (!this->DelegatePass || !renWin || !this->Chain) {
+                vtkWarningMacro("PostProcessingPass: no delegate pass or OpenGL render window");
+                return;
+            }
+
+            // 编译通道（失败的通道跳过）
+            std::vector<PostPass*> activePasses;
+            for (const auto& pass : this->Chain->passes) {
+                if (this->PreparePass(renWin, *pass)) {
+                    activePasses.push_back(pass.get());
+                }
+            }
+
+            // 没有可用的通道时直接渲染场景
+            if (activePasses.empty()) {
+                this->DelegatePass->Render(s);
+                this->NumberOfRenderedProps += this->DelegatePass->GetNumberOfRenderedProps();
+                return;
+            }
+
+            int width = 0, height = 0, x = 0, y = 0;
+            renderer->GetTiledSizeAndOrigin(&width, &height, &x, &y);
+            if (width <= 0 || height <= 0) {
+                return;
+            }
+
+            // 场景渲染到离屏纹理
+            this->Chain->sceneTimer.Begin();
+
+            this->PrepareTarget(renWin, 0, width, height);
+            this->RenderDelegate(s, width, height, width, height,
+                                 this->FrameBuffers[0], this->Textures[0]);
+
+            this->Chain->sceneTimer.End();
+            StoreTiming(this->Chain->sceneTimer, this->Chain->sceneTiming);
+
+            // 全屏通道不需要深度测试和混合，结束后恢复
+            GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+            GLboolean blend = glIsEnabled(GL_BLEND);
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_BLEND);
+
+            int input = 0;
+            for (size_t i = 0; i < activePasses.size(); i++) {
+                PostPass& pass = *activePasses[i];
+                bool last = (i + 1 == activePasses.size());
+
+                pass.timer.Begin();
+
+                if (last) {
+                    // 最后一个通道输出到渲染器视口
+                    glViewport(x, y, width, height);
+                    this->DrawPass(renWin, pass, this->Textures[input], width, height);
+                } else {
+                    int output = 1 - input;
+                    this->PrepareTarget(renWin, output, width, height);
+
+                    vtkOpenGLFramebufferObject* fbo = this->FrameBuffers[output];
+                    fbo->SaveCurrentBindingsAndBuffers();
+                    fbo->Bind();
+                    fbo->AddColorAttachment(fbo->GetBothMode(), 0, this->Textures[output]);
+                    fbo->ActivateDrawBuffer(0);
+                    glViewport(0, 0, width, height);
+
+                    this->DrawPass(renWin, pass, this->Textures[input], width, height);
+
+                    fbo->RestorePreviousBindingsAndBuffers();
+                    input = output;
+                }
+
+                pass.timer.End();
+                StoreTiming(pass.timer, pass.timing);
+            }
+
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            if (depthTest) glEnable(GL_DEPTH_TEST);
+            if (blend) glEnable(GL_BLEND);
+        }
+
+        void PostProcessingPass::ReleaseGraphicsResources(vtkWindow* window) {
+            this->Superclass::ReleaseGraphicsResources(window);
+
+            for (int i = 0; i < 2; i++) {
+                if (this->FrameBuffers[i]) {
+                    this->FrameBuffers[i]->ReleaseGraphicsResources(window);
+                    this->FrameBuffers[i] = nullptr;
+                }
+                if (this->Textures[i]) {
+                    this->Textures[i]->ReleaseGraphicsResources(window);
+                    this->Textures[i] = nullptr;
+                }
+            }
+
+            if (this->Chain) {
+                this->Chain->sceneTimer.ReleaseGraphicsResources();
+                for (const auto& pass : this->Chain->passes) {
+                    pass->program = nullptr;
+                    if (pass->vao) {
+                        pass->vao->ReleaseGraphicsResources();
+                        pass->vao = nullptr;
+                    }
+                    pass->timer.ReleaseGraphicsResources();
+                }
+            }
+        }
+
+    } // namespace
+
+    class PostProcessor::Impl {
+    public:
+        vtkWeakPointer<vtkRenderer> renderer;
+        vtkSmartPointer<PostProcessingPass> pass;
+        std::shared_ptr<PassChain> chain;
+        vtkSmartPointer<vtkRenderPass> defaultScene;  // Attach时渲染器没有渲染流程，自己创建的场景通道
+
+        Impl() : chain(std::make_shared<PassChain>()) {}
+    };
+
+    PostProcessor::PostProcessor() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    PostProcessor::~PostProcessor() {
+        Detach();
+    }
+
+    bool PostProcessor::Attach(vtkRenderer* renderer) {
+        if (!renderer) {
+            std::cerr << "PostProcessor: Invalid renderer" << std::endl;
+            return false;
+        }
+
+        Detach();
+
+        // 渲染器已有的渲染流程（如性能分析的计时步骤）作为场景通道，
+        // 否则使用默认渲染步骤（灯光、不透明、半透明、体、覆盖层）
+        vtkRenderPass* scene = renderer->GetPass();
+        pImpl->defaultScene = nullptr;
+        if (!scene) {
+            pImpl->defaultScene = vtkSmartPointer<vtkRenderStepsPass>::New();
+            scene = pImpl->defaultScene;
+        }
+
+        pImpl->pass = vtkSmartPointer<PostProcessingPass>::New();
+        pImpl->pass->Chain = pImpl->chain;
+        pImpl->pass->SetDelegatePass(scene);
+
+        renderer->SetPass(pImpl->pass);
+        pImpl->renderer = renderer;
+
+        std::cout << "PostProcessor: Attached with " << pImpl->chain->passes.size()
+                 << " passes" << std::endl;
+        return true;
+    }
+
+    void PostProcessor::Detach() {
+        if (!pImpl->pass) {
+            return;
+        }
+
+        if (pImpl->renderer) {
+            if (pImpl->renderer->GetRenderWindow()) {
+                pImpl->pass->ReleaseGraphicsResources(pImpl->renderer->GetRenderWindow());
+            }
+            // 恢复场景通道（期间可能被其他模块替换），自己创建的默认步骤则直接移除
+            vtkRenderPass* scene = pImpl->pass->GetDelegatePass();
+            pImpl->renderer->SetPass(scene != pImpl->defaultScene ? scene : nullptr);
+        }
+
+        pImpl->pass = nullptr;
+        pImpl->defaultScene = nullptr;
+        pImpl->renderer = nullptr;
+    }
+
+    bool PostProcessor::IsAttached() const {
+        return pImpl->pass != nullptr && pImpl->renderer != nullptr;
+    }
+
+    bool PostProcessor::AddPass(const std::string& name, const std::string& vertexSource,
+                                const std::string& fragmentSource) {
+        if (name.empty() || vertexSource.empty() || fragmentSource.empty()) {
+            std::cerr << "PostProcessor: Invalid pass " << name << std::endl;
+            return false;
+        }
+
+        std::shared_ptr<PostPass> pass = std::make_shared<PostPass>();
+        pass->name = name;
+        pass->vertexSource = vertexSource;
+        pass->fragmentSource = fragmentSource;
+        pass->timing.name = name;
+
+        for (auto& existing : pImpl->chain->passes) {
+            if (existing->name == name) {
+                existing = pass;
+                return true;
+            }
+        }
+
+        pImpl->chain->passes.push_back(pass);
+        return true;
+    }
+
+    void PostProcessor::RemovePass(const std::string& name) {
+        auto& passes = pImpl->chain->passes;
+        for (auto it = passes.begin(); it != passes.end(); ++it) {
+            if ((*it)->name == name) {
+                passes.erase(it);
+                return;
+            }
+        }
+    }
+
+    bool PostProcessor::HasPass(const std::string& name) const {
+        for (const auto& pass : pImpl->chain->passes) {
+            if (pass->name == name) return true;
+        }
+        return false;
+    }
+
+    size_t PostProcessor::GetPassCount() const {
+        return pImpl->chain->passes.size();
+    }
+
+    std::vector<PostProcessor::PassTiming> PostProcessor::GetTimings() const {
+        std::vector<PassTiming> timings;
+        timings.push_back(pImpl->chain->sceneTiming);
+        for (const auto& pass : pImpl->chain->passes) {
+            timings.push_back(pass->timing);
+        }
+        return timings;
+    }
+
+} // namespace BronchoscopyLib
@@ -0,0 +1,360 @@
+#include "RenderProfiler.h"
+#include "SectionTimer.h"
+
+// VTK headers
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkDepthPeelingPass.h>
+#include <vtkObjectFactory.h>
+#include <vtkOrderIndependentTranslucentPass.h>
+#include <vtkProp.h>
+#include <vtkRenderPass.h>
+#include <vtkRenderState.h>
+#include <vtkRenderStepsPass.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// Standard headers
+#include <iostream>
+#include <map>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        enum GeometryStep {
+            STEP_OPAQUE,
+            STEP_TRANSLUCENT,
+            STEP_GEOMETRY_COUNT
+        };
+
+        // 计时步骤和渲染器观察者共享的逐帧状态
+        struct ProfileFrame {
+            std::string name;
+            std::shared_ptr<RenderStats> stats;
+            RenderProfiler::PropLabeler labeler;
+            bool synchronousFallback;
+
+            // 每个prop在每个几何步骤中使用独立的计时器（查询结果延迟到达，不能跨prop复用）
+            std::map<vtkProp*, std::unique_ptr<SectionTimer>> propTimers[STEP_GEOMETRY_COUNT];
+
+            // 本帧按标签累计的actor耗时，帧结束时写入统计
+            struct ActorSample {
+                double cpuMs;
+                double gpuMs;
+                bool gpuComplete;  // 同标签的所有actor本帧都取得了新的GPU结果
+            };
+            std::map<std::string, ActorSample> actorSamples;
+
+            ProfileFrame() : synchronousFallback(true) {}
+
+            SectionTimer& GetPropTimer(vtkProp* prop, int step) {
+                auto& timers = propTimers[step];
+                // prop销毁后地址可能被复用，条目过多时整体丢弃（下一帧重新创建）
+                if (timers.size() > 256) {
+                    for (auto& entry : timers) entry.second->ReleaseGraphicsResources();
+                    timers.clear();
+                }
+                std::unique_ptr<SectionTimer>& timer = timers[prop];
+                if (!timer) {
+                    timer.reset(new SectionTimer);
+                    timer->SetSynchronousFallback(synchronousFallback);
+                }
+                return *timer;
+            }
+
+            void Record(const std::string& item, const SectionTimer& timer) {
+                stats->Record(name + "/" + item, timer.GetCpuMs(),
+                              timer.HasNewGpuResult() ? timer.GetGpuMs() : -1.0);
+            }
+
+            void AddActor(vtkProp* prop, const SectionTimer& timer) {
+                std::string label = labeler ? labeler(prop) : std::string();
+                if (label.empty()) {
+                    label = prop->GetClassName();
+                }
+
+                auto it = actorSamples.find(label);
+                if (it == actorSamples.end()) {
+                    ActorSample sample;
+                    sample.cpuMs = timer.GetCpuMs();
+                    sample.gpuMs = timer.GetGpuMs();
+                    sample.gpuComplete = timer.HasNewGpuResult();
+                    actorSamples[label] = sample;
+                } else {
+                    it->second.cpuMs += timer.GetCpuMs();
+                    it->second.gpuMs += timer.GetGpuMs();
+                    it->second.gpuComplete = it->second.gpuComplete && timer.HasNewGpuResult();
+                }
+            }
+
+            void FlushActors() {
+                for (const auto& entry : actorSamples) {
+                    stats->Record(name + "/actor/" + entry.first, entry.second.cpuMs,
+                                  entry.second.gpuComplete ? entry.second.gpuMs : -1.0);
+                }
+                actorSamples.clear();
+            }
+
+            void Release() {
+                for (auto& timers : propTimers) {
+                    for (auto& entry : timers) entry.second->ReleaseGraphicsResources();
+                    timers.clear();
+                }
+                actorSamples.clear();
+            }
+        };
+
+        // 逐个prop渲染不透明或半透明几何并分别计时（等价于vtkOpaquePass/vtkTranslucentPass）
+        class PropTimingPass : public vtkRenderPass {
+        public:
+            static PropTimingPass* New();
+            vtkTypeMacro(PropTimingPass, vtkRenderPass);
+
+            std::shared_ptr<ProfileFrame> Frame;
+            int Step;
+
+            void Render(const vtkRenderState* s) override {
+                this->NumberOfRenderedProps = 0;
+                vtkRenderer* renderer = s->GetRenderer();
+                vtkInformation* keys = s->GetRequiredKeys();
+
+                for (int i = 0; i < s->GetPropArrayCount(); i++) {
+                    vtkProp* prop = s->GetPropArray()[i];
+                    if (keys && !prop->HasKeys(keys)) {
+                        continue;
+                    }
+                    if (this->Step == STEP_TRANSLUCENT && !prop->HasTranslucentPolygonalGeometry()) {
+                        continue;
+                    }
+
+                    SectionTimer& timer = this->Frame->GetPropTimer(prop, this->Step);
+                    timer.Begin();
+                    int rendered = 0;
+                    if (this->Step == STEP_OPAQUE) {
+                        rendered = keys ? prop->RenderFilteredOpaqueGeometry(renderer, keys)
+                                        : prop->RenderOpaqueGeometry(renderer);
+                    } else {
+                        rendered = keys ? prop->RenderFilteredTranslucentPolygonalGeometry(renderer, keys)
+                                        : prop->RenderTranslucentPolygonalGeometry(renderer);
+                    }
+                    timer.End();
+
+                    if (rendered > 0) {
+                        this->Frame->AddActor(prop, timer);
+                        this->NumberOfRenderedProps += rendered;
+                    }
+                }
+            }
+
+        protected:
+            PropTimingPass() : Step(STEP_OPAQUE) {}
+            ~PropTimingPass() override {}
+
+        private:
+            PropTimingPass(const PropTimingPass&) = delete;
+            void operator=(const PropTimingPass&) = delete;
+        };
+
+        vtkStandardNewMacro(PropTimingPass);
+
+        // 对一个渲染步骤整体计时
+        class StepTimingPass : public vtkRenderPass {
+        public:
+            static StepTimingPass* New();
+            vtkTypeMacro(StepTimingPass, vtkRenderPass);
+
+            std::shared_ptr<ProfileFrame> Frame;
+            std::string Name;
+            vtkSmartPointer<vtkRenderPass> DelegatePass;
+            SectionTimer Timer;
+
+            void Render(const vtkRenderState* s) override {
+                this->NumberOfRenderedProps = 0;
+                if (!this->DelegatePass) {
+                    return;
+                }
+
+                this->Timer.Begin();
+                this->DelegatePass->Render(s);
+                this->Timer.End();
+
+                this->NumberOfRenderedProps = this->DelegatePass->GetNumberOfRenderedProps();
+                this->Frame->Record("step/" + this->Name, this->Timer);
+            }
+
+            void ReleaseGraphicsResources(vtkWindow* window) override {
+                if (this->DelegatePass) {
+                    this->DelegatePass->ReleaseGraphicsResources(window);
+                }
+                this->Timer.ReleaseGraphicsResources();
+            }
+
+        protected:
+            StepTimingPass() {}
+            ~StepTimingPass() override {}
+
+        private:
+            StepTimingPass(const StepTimingPass&) = delete;
+            void operator=(const StepTimingPass&) = delete;
+        };
+
+        vtkStandardNewMacro(StepTimingPass);
+
+    } // namespace
+
+    class RenderProfiler::Impl {
+    public:
+        std::shared_ptr<ProfileFrame> frame;
+        PassTimingSource passSource;
+
+        vtkWeakPointer<vtkRenderer> renderer;
+
+        vtkSmartPointer<vtkCallbackCommand> startObserver;
+        vtkSmartPointer<vtkCallbackCommand> endObserver;
+        unsigned long startTag;
+        unsigned long endTag;
+
+        SectionTimer frameTimer;
+
+        Impl() : frame(std::make_shared<ProfileFrame>()), startTag(0), endTag(0) {
+            frameTimer.SetSynchronousFallback(true);
+        }
+
+        vtkRenderPass* CreateStep(const std::string& name, vtkRenderPass* delegate) {
+            StepTimingPass* step = StepTimingPass::New();
+            step->Frame = frame;
+            step->Name = name;
+            step->DelegatePass = delegate;
+            step->Timer.SetSynchronousFallback(frame->synchronousFallback);
+            return step;
+        }
+
+        vtkRenderPass* CreatePropPass(int geometryStep) {
+            PropTimingPass* props = PropTimingPass::New();
+            props->Frame = frame;
+            props->Step = geometryStep;
+            return props;
+        }
+
+        static void OnRenderStart(vtkObject*, unsigned long, void* clientData, void*) {
+            Impl* self = static_cast<Impl*>(clientData);
+            self->frame->actorSamples.clear();
+            self->frameTimer.Begin();
+        }
+
+        static void OnRenderEnd(vtkObject*, unsigned long, void* clientData, void*) {
+            Impl* self = static_cast<Impl*>(clientData);
+            self->frameTimer.End();
+            self->frame->Record("frame", self->frameTimer);
+            self->frame->FlushActors();
+
+            if (self->passSource && self->renderer) {
+                for (const auto& timing : self->passSource(self->renderer)) {
+                    self->frame->stats->Record(self->frame->name + "/post/" + timing.name, timing.cpuMs,
+                                               timing.gpuUpdated ? timing.gpuMs : -1.0);
+                }
+            }
+        }
+    };
+
+    RenderProfiler::RenderProfiler(const std::string& name, std::shared_ptr<RenderStats> stats)
+        : pImpl(std::make_unique<Impl>()) {
+        pImpl->frame->name = name;
+        pImpl->frame->stats = stats ? stats : std::make_shared<RenderStats>();
+    }
+
+    RenderProfiler::~RenderProfiler() {
+        Detach();
+    }
+
+    bool RenderProfiler::Attach(vtkRenderer* renderer) {
+        if (!renderer) {
+            std::cerr << "RenderProfiler: Invalid renderer" << std::endl;
+            return false;
+        }
+
+        Detach();
+
+        pImpl->startObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+        pImpl->startObserver->SetCallback(&Impl::OnRenderStart);
+        pImpl->startObserver->SetClientData(pImpl.get());
+        pImpl->endObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+        pImpl->endObserver->SetCallback(&Impl::OnRenderEnd);
+        pImpl->endObserver->SetClientData(pImpl.get());
+        pImpl->startTag = renderer->AddObserver(vtkCommand::StartEvent, pImpl->startObserver);
+        pImpl->endTag = renderer->AddObserver(vtkCommand::EndEvent, pImpl->endObserver);
+
+        pImpl->renderer = renderer;
+        std::cout << "RenderProfiler: Profiling " << pImpl->frame->name << std::endl;
+        return true;
+    }
+
+    void RenderProfiler::Instrument(vtkRenderStepsPass* steps) {
+        if (!steps) {
+            return;
+        }
+
+        vtkSmartPointer<vtkRenderPass> opaqueProps;
+        opaqueProps.TakeReference(pImpl->CreatePropPass(STEP_OPAQUE));
+        vtkSmartPointer<vtkRenderPass> opaque;
+        opaque.TakeReference(pImpl->CreateStep("opaque", opaqueProps));
+        steps->SetOpaquePass(opaque);
+
+        // 半透明步骤可能包在深度剥离或OIT通道中，逐prop计时替换最内层的几何通道
+        vtkSmartPointer<vtkRenderPass> translucentProps;
+        translucentProps.TakeReference(pImpl->CreatePropPass(STEP_TRANSLUCENT));
+        vtkRenderPass* translucentStep = steps->GetTranslucentPass();
+        if (vtkDepthPeelingPass* peeling = vtkDepthPeelingPass::SafeDownCast(translucentStep)) {
+            peeling->SetTranslucentPass(translucentProps);
+        } else if (vtkOrderIndependentTranslucentPass* oit =
+                   vtkOrderIndependentTranslucentPass::SafeDownCast(translucentStep)) {
+            oit->SetTranslucentPass(translucentProps);
+        } else {
+            translucentStep = translucentProps;
+        }
+        vtkSmartPointer<vtkRenderPass> translucent;
+        translucent.TakeReference(pImpl->CreateStep("translucent", translucentStep));
+        steps->SetTranslucentPass(translucent);
+
+        vtkSmartPointer<vtkRenderPass> volume;
+        volume.TakeReference(pImpl->CreateStep("volume", steps->GetVolumetricPass()));
+        steps->SetVolumetricPass(volume);
+
+        vtkSmartPointer<vtkRenderPass> overlay;
+        overlay.TakeReference(pImpl->CreateStep("overlay", steps->GetOverlayPass()));
+        steps->SetOverlayPass(overlay);
+    }
+
+    void RenderProfiler::Detach() {
+        if (!pImpl->renderer) {
+            return;
+        }
+
+        pImpl->renderer->RemoveObserver(pImpl->startTag);
+        pImpl->renderer->RemoveObserver(pImpl->endTag);
+
+        pImpl->frame->Release();
+        pImpl->frameTimer.ReleaseGraphicsResources();
+        pImpl->renderer = nullptr;
+    }
+
+    bool RenderProfiler::IsAttached() const {
+        return pImpl->renderer != nullptr;
+    }
+
+    void RenderProfiler::SetPropLabeler(PropLabeler labeler) {
+        pImpl->frame->labeler = labeler;
+    }
+
+    void RenderProfiler::SetPassTimingSource(PassTimingSource source) {
+        pImpl->passSource = source;
+    }
+
+    void RenderProfiler::SetSynchronousFallback(bool enable) {
+        pImpl->frame->synchronousFallback = enable;
+        pImpl->frameTimer.SetSynchronousFallback(enable);
+    }
+
+} // namespace BronchoscopyLib
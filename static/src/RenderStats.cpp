@@ -0,0 +1,124 @@
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 一个计时项的样本环（CPU和GPU分开保存，GPU结果延迟到达且可能缺失）
+        struct Series {
+            std::deque<double> cpu;
+            std::deque<double> gpu;
+        };
+
+        void Push(std::deque<double>& samples, double value, size_t capacity) {
+            samples.push_back(value);
+            while (samples.size() > capacity) {
+                samples.pop_front();
+            }
+        }
+
+        // 最近邻秩的百分位数
+        double Percentile(std::vector<double> sorted, double fraction) {
+            std::sort(sorted.begin(), sorted.end());
+            size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+            return sorted[std::min(index, sorted.size() - 1)];
+        }
+
+    } // namespace
+
+    class RenderStats::Impl {
+    public:
+        mutable std::mutex mutex;
+        std::map<std::string, Series> series;
+        size_t capacity;
+
+        explicit Impl(size_t n) : capacity(std::max<size_t>(n, 1)) {}
+
+        static Summary Summarize(const std::string& name, const Series& values) {
+            Summary summary;
+            summary.name = name;
+            summary.samples = values.cpu.size();
+            if (!values.cpu.empty()) {
+                std::vector<double> cpu(values.cpu.begin(), values.cpu.end());
+                double sum = 0.0;
+                for (double value : cpu) sum += value;
+                summary.cpuLast = cpu.back();
+                summary.cpuMean = sum / cpu.size();
+                summary.cpuMin = *std::min_element(cpu.begin(), cpu.end());
+                summary.cpuMax = *std::max_element(cpu.begin(), cpu.end());
+                summary.cpuP95 = Percentile(cpu, 0.95);
+            }
+
+            summary.gpuSamples = values.gpu.size();
+            if (!values.gpu.empty()) {
+                std::vector<double> gpu(values.gpu.begin(), values.gpu.end());
+                double sum = 0.0;
+                for (double value : gpu) sum += value;
+                summary.gpuLast = gpu.back();
+                summary.gpuMean = sum / gpu.size();
+                summary.gpuMax = *std::max_element(gpu.begin(), gpu.end());
+                summary.gpuP95 = Percentile(gpu, 0.95);
+            }
+            return summary;
+        }
+    };
+
+    RenderStats::RenderStats(size_t capacity) : pImpl(std::make_unique<Impl>(capacity)) {
+    }
+
+    RenderStats::~RenderStats() = default;
+
+    void RenderStats::SetCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        pImpl->capacity = std::max<size_t>(capacity, 1);
+        for (auto& entry : pImpl->series) {
+            while (entry.second.cpu.size() > pImpl->capacity) entry.second.cpu.pop_front();
+            while (entry.second.gpu.size() > pImpl->capacity) entry.second.gpu.pop_front();
+        }
+    }
+
+    size_t RenderStats::GetCapacity() const {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        return pImpl->capacity;
+    }
+
+    void RenderStats::Record(const std::string& name, double cpuMs, double gpuMs) {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        Series& values = pImpl->series[name];
+        Push(values.cpu, cpuMs, pImpl->capacity);
+        if (gpuMs >= 0.0) {
+            Push(values.gpu, gpuMs, pImpl->capacity);
+        }
+    }
+
+    std::vector<RenderStats::Summary> RenderStats::GetSummaries() const {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        std::vector<Summary> summaries;
+        summaries.reserve(pImpl->series.size());
+        for (const auto& entry : pImpl->series) {
+            summaries.push_back(Impl::Summarize(entry.first, entry.second));
+        }
+        return summaries;
+    }
+
+    bool RenderStats::GetSummary(const std::string& name, Summary& summary) const {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        auto it = pImpl->series.find(name);
+        if (it == pImpl->series.end()) {
+            return false;
+        }
+        summary = Impl::Summarize(it->first, it->second);
+        return true;
+    }
+
+    void RenderStats::Clear() {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        pImpl->series.clear();
+    }
+
+} // namespace BronchoscopyLib
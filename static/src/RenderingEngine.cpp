@@ -1,7 +1,16 @@
 #include "RenderingEngine.h"
+#include "ResolutionScaler.h"
+#include "SectionTimer.h"
 
 // VTK头文件
 #include <vtkSmartPointer.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkDualDepthPeelingPass.h>
+#include <vtkImageProcessingPass.h>
+#include <vtkOrderIndependentTranslucentPass.h>
+#include <vtkRenderPass.h>
+#include <vtkRenderStepsPass.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
@@ -9,6 +18,7 @@
 #include <vtkCamera.h>
 #include <vtkRendererCollection.h>
 
+#include <algorithm>
 #include <iostream>
 
 namespace BronchoscopyLib {
@@ -27,15 +37,66 @@ namespace BronchoscopyLib {
         double overviewBgColor[3];
         double endoscopeBgColor[3];
         
+        // 性能分析
+        std::shared_ptr<RenderStats> stats;
+        std::unique_ptr<RenderProfiler> overviewProfiler;
+        std::unique_ptr<RenderProfiler> endoscopeProfiler;
+        RenderProfiler::PropLabeler profilingLabeler;
+        RenderProfiler::PassTimingSource profilingPassSource;
+        
+        // 半透明策略
+        TransparencyMode transparencyMode;
+        int maxPeels;
+        double occlusionRatio;
+        
+        // 当前安装的场景渲染通道（默认流程即可时为空）
+        vtkSmartPointer<vtkRenderPass> overviewPass;
+        vtkSmartPointer<vtkRenderPass> endoscopePass;
+        
+        // 内窥镜视图动态分辨率（未启用时为空）
+        std::unique_ptr<ResolutionScaler> resolutionScaler;
+        double resolutionTargetMs;
+        double resolutionMinScale;
+        bool endoscopeMoving;
+        
+        // 全局视图整帧计时（按半透明策略记录）
+        SectionTimer overviewFrameTimer;
+        vtkSmartPointer<vtkCallbackCommand> frameStartObserver;
+        vtkSmartPointer<vtkCallbackCommand> frameEndObserver;
+        unsigned long frameStartTag;
+        unsigned long frameEndTag;
+        
+        // 内窥镜窗口的交互样式及其开始交互观察者
+        vtkSmartPointer<vtkInteractorObserver> endoscopeStyle;
+        vtkSmartPointer<vtkCallbackCommand> interactionObserver;
+        unsigned long interactionTag;
+        InteractionCallback endoscopeInteractionCallback;
+        
         // 初始化标志
         bool initialized;
         
-        Impl() : overviewWindow(nullptr), endoscopeWindow(nullptr), initialized(false) {
+        Impl() : overviewWindow(nullptr), endoscopeWindow(nullptr), 
+                 stats(std::make_shared<RenderStats>()), 
+                 transparencyMode(TRANSPARENCY_BLEND), maxPeels(4), occlusionRatio(0.0),
+                 resolutionTargetMs(1000.0 / 60.0), resolutionMinScale(0.5), endoscopeMoving(false),
+                 frameStartTag(0), frameEndTag(0), interactionTag(0), initialized(false) {
             // 默认背景颜色
             overviewBgColor[0] = 0.1; overviewBgColor[1] = 0.2; overviewBgColor[2] = 0.4;
             endoscopeBgColor[0] = 0.15; endoscopeBgColor[1] = 0.15; endoscopeBgColor[2] = 0.15;
         }
         
+        ~Impl() {
+            // 渲染器可能被渲染窗口引用而比本对象存活更久
+            if (overviewRenderer) {
+                overviewRenderer->RemoveObserver(frameStartTag);
+                overviewRenderer->RemoveObserver(frameEndTag);
+            }
+            // 交互样式由窗口的交互器持有
+            if (endoscopeStyle) {
+                endoscopeStyle->RemoveObserver(interactionTag);
+            }
+        }
+        
         void CreateRenderers() {
             overviewRenderer = vtkSmartPointer<vtkRenderer>::New();
             endoscopeRenderer = vtkSmartPointer<vtkRenderer>::New();
@@ -44,8 +105,129 @@ namespace BronchoscopyLib {
             overviewRenderer->SetBackground(overviewBgColor);
             endoscopeRenderer->SetBackground(endoscopeBgColor);
             
+            frameStartObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+            frameStartObserver->SetCallback(&Impl::OnOverviewStart);
+            frameStartObserver->SetClientData(this);
+            frameEndObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+            frameEndObserver->SetCallback(&Impl::OnOverviewEnd);
+            frameEndObserver->SetClientData(this);
+            frameStartTag = overviewRenderer->AddObserver(vtkCommand::StartEvent, frameStartObserver);
+            frameEndTag = overviewRenderer->AddObserver(vtkCommand::EndEvent, frameEndObserver);
+            
             initialized = true;
         }
+        
+        static void OnEndoscopeInteraction(vtkObject*, unsigned long, void* clientData, void*) {
+            Impl* self = static_cast<Impl*>(clientData);
+            if (self->endoscopeInteractionCallback) {
+                self->endoscopeInteractionCallback();
+            }
+        }
+        
+        static void OnOverviewStart(vtkObject*, unsigned long, void* clientData, void*) {
+            static_cast<Impl*>(clientData)->overviewFrameTimer.Begin();
+        }
+        
+        static void OnOverviewEnd(vtkObject*, unsigned long, void* clientData, void*) {
+            Impl* self = static_cast<Impl*>(clientData);
+            SectionTimer& timer = self->overviewFrameTimer;
+            timer.End();
+            // GPU结果延迟几帧到达，切换策略后的最初几个GPU样本仍属于上一个策略
+            self->stats->Record(std::string("overview/transparency/") + 
+                                GetTransparencyModeName(self->transparencyMode),
+                                timer.GetCpuMs(), timer.HasNewGpuResult() ? timer.GetGpuMs() : -1.0);
+        }
+        
+        // 按半透明策略和性能分析设置组装场景渲染步骤；都是默认值时返回空（使用渲染器默认流程）
+        vtkSmartPointer<vtkRenderStepsPass> CreateSteps(bool applyTransparency, RenderProfiler* profiler) {
+            TransparencyMode mode = applyTransparency ? transparencyMode : TRANSPARENCY_BLEND;
+            if (mode == TRANSPARENCY_BLEND && !profiler) {
+                return nullptr;
+            }
+            
+            vtkSmartPointer<vtkRenderStepsPass> steps = vtkSmartPointer<vtkRenderStepsPass>::New();
+            if (mode == TRANSPARENCY_DEPTH_PEELING) {
+                // VTK要求的OpenGL 3.2已包含双向深度剥离所需的浮点和RG纹理
+                vtkSmartPointer<vtkDualDepthPeelingPass> peeling = vtkSmartPointer<vtkDualDepthPeelingPass>::New();
+                peeling->SetTranslucentPass(steps->GetTranslucentPass());
+                peeling->SetMaximumNumberOfPeels(maxPeels);
+                peeling->SetOcclusionRatio(occlusionRatio);
+                steps->SetTranslucentPass(peeling);
+            } else if (mode == TRANSPARENCY_WEIGHTED_OIT) {
+                vtkSmartPointer<vtkOrderIndependentTranslucentPass> oit = 
+                    vtkSmartPointer<vtkOrderIndependentTranslucentPass>::New();
+                oit->SetTranslucentPass(steps->GetTranslucentPass());
+                steps->SetTranslucentPass(oit);
+            }
+            
+            if (profiler) {
+                profiler->Instrument(steps);
+            }
+            return steps;
+        }
+        
+        // 安装场景渲染通道；渲染器已有后处理（不是上次安装的通道）时替换其场景通道
+        static void InstallPass(vtkRenderer* renderer, vtkSmartPointer<vtkRenderPass>& installed,
+                                vtkRenderPass* pass) {
+            vtkRenderPass* current = renderer->GetPass();
+            vtkImageProcessingPass* post = nullptr;
+            if (current && current != installed.GetPointer()) {
+                post = vtkImageProcessingPass::SafeDownCast(current);
+            }
+            
+            if (post) {
+                if (pass) {
+                    post->SetDelegatePass(pass);
+                } else {
+                    post->SetDelegatePass(vtkSmartPointer<vtkRenderStepsPass>::New());
+                }
+            } else {
+                renderer->SetPass(pass);
+            }
+            
+            if (installed && installed.GetPointer() != pass && renderer->GetRenderWindow()) {
+                installed->ReleaseGraphicsResources(renderer->GetRenderWindow());
+            }
+            installed = pass;
+        }
+        
+        void UpdateScenePasses() {
+            if (!initialized) {
+                return;
+            }
+            
+            // 使用渲染步骤时由深度剥离通道负责，避免渲染器重复剥离
+            overviewRenderer->SetUseDepthPeeling(0);
+            
+            InstallPass(overviewRenderer, overviewPass, 
+                        CreateSteps(true, overviewProfiler.get()));
+            
+            vtkSmartPointer<vtkRenderStepsPass> endoscopeSteps = CreateSteps(false, endoscopeProfiler.get());
+            if (resolutionScaler) {
+                // 动态分辨率包在场景步骤外层，后处理仍在最外层
+                vtkRenderPass* previous = resolutionScaler->GetScenePass();
+                if (previous && endoscopeRenderer->GetRenderWindow()) {
+                    previous->ReleaseGraphicsResources(endoscopeRenderer->GetRenderWindow());
+                }
+                resolutionScaler->SetScenePass(endoscopeSteps);
+                InstallPass(endoscopeRenderer, endoscopePass, resolutionScaler->GetPass());
+            } else {
+                InstallPass(endoscopeRenderer, endoscopePass, endoscopeSteps);
+            }
+            
+            // 性能分析时与其他计时一样同步计时，否则不插入glFinish
+            overviewFrameTimer.SetSynchronousFallback(overviewProfiler != nullptr);
+        }
+        
+        std::unique_ptr<RenderProfiler> CreateProfiler(const std::string& name, vtkRenderer* renderer) {
+            std::unique_ptr<RenderProfiler> profiler = std::make_unique<RenderProfiler>(name, stats);
+            profiler->SetPropLabeler(profilingLabeler);
+            profiler->SetPassTimingSource(profilingPassSource);
+            if (!profiler->Attach(renderer)) {
+                return nullptr;
+            }
+            return profiler;
+        }
     };
     
     RenderingEngine::RenderingEngine() : pImpl(std::make_unique<Impl>()) {
@@ -60,6 +242,7 @@ namespace BronchoscopyLib {
         }
         
         pImpl->CreateRenderers();
+        pImpl->UpdateScenePasses();
         
         std::cout << "RenderingEngine initialized" << std::endl;
     }
@@ -192,11 +375,27 @@ namespace BronchoscopyLib {
                 vtkSmartPointer<vtkInteractorStyleTrackballCamera> style = 
                     vtkSmartPointer<vtkInteractorStyleTrackballCamera>::New();
                 interactor->SetInteractorStyle(style);
+                
+                if (pImpl->endoscopeStyle) {
+                    pImpl->endoscopeStyle->RemoveObserver(pImpl->interactionTag);
+                }
+                if (!pImpl->interactionObserver) {
+                    pImpl->interactionObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+                    pImpl->interactionObserver->SetCallback(&Impl::OnEndoscopeInteraction);
+                    pImpl->interactionObserver->SetClientData(pImpl.get());
+                }
+                pImpl->endoscopeStyle = style;
+                pImpl->interactionTag = style->AddObserver(vtkCommand::StartInteractionEvent,
+                                                           pImpl->interactionObserver);
                 std::cout << "Endoscope interactor configured" << std::endl;
             }
         }
     }
     
+    void RenderingEngine::SetEndoscopeInteractionCallback(InteractionCallback callback) {
+        pImpl->endoscopeInteractionCallback = callback;
+    }
+    
     void RenderingEngine::SetViewport(int view, double xmin, double ymin, double xmax, double ymax) {
         if (view == 0 && pImpl->overviewRenderer) {
             pImpl->overviewRenderer->SetViewport(xmin, ymin, xmax, ymax);
@@ -205,6 +404,137 @@ namespace BronchoscopyLib {
         }
     }
     
+    void RenderingEngine::SetTransparencyMode(TransparencyMode mode) {
+        if (mode == pImpl->transparencyMode) {
+            return;
+        }
+        
+        pImpl->transparencyMode = mode;
+        pImpl->UpdateScenePasses();
+        std::cout << "RenderingEngine: Transparency mode " << GetTransparencyModeName(mode) << std::endl;
+    }
+    
+    RenderingEngine::TransparencyMode RenderingEngine::GetTransparencyMode() const {
+        return pImpl->transparencyMode;
+    }
+    
+    const char* RenderingEngine::GetTransparencyModeName(TransparencyMode mode) {
+        switch (mode) {
+            case TRANSPARENCY_BLEND:         return "blend";
+            case TRANSPARENCY_DEPTH_PEELING: return "depth_peeling";
+            case TRANSPARENCY_WEIGHTED_OIT:  return "weighted_oit";
+            default:                         return "unknown";
+        }
+    }
+    
+    void RenderingEngine::SetDepthPeelingBudget(int maxPeels, double occlusionRatio) {
+        pImpl->maxPeels = std::max(maxPeels, 1);
+        pImpl->occlusionRatio = std::min(std::max(occlusionRatio, 0.0), 1.0);
+        
+        if (pImpl->transparencyMode == TRANSPARENCY_DEPTH_PEELING) {
+            pImpl->UpdateScenePasses();
+        }
+    }
+    
+    void RenderingEngine::SetDynamicResolution(bool enable) {
+        if (enable == (pImpl->resolutionScaler != nullptr)) {
+            return;
+        }
+        
+        if (enable) {
+            pImpl->resolutionScaler = std::make_unique<ResolutionScaler>();
+            pImpl->resolutionScaler->SetTargetFrameTime(pImpl->resolutionTargetMs);
+            pImpl->resolutionScaler->SetScaleRange(pImpl->resolutionMinScale, 1.0);
+            pImpl->resolutionScaler->SetMoving(pImpl->endoscopeMoving);
+        } else {
+            pImpl->resolutionScaler.reset();
+        }
+        
+        // 已安装的缩放通道由endoscopePass持有，替换后释放
+        pImpl->UpdateScenePasses();
+        std::cout << "RenderingEngine: Dynamic resolution " << (enable ? "enabled" : "disabled") << std::endl;
+    }
+    
+    bool RenderingEngine::IsDynamicResolutionEnabled() const {
+        return pImpl->resolutionScaler != nullptr;
+    }
+    
+    void RenderingEngine::SetDynamicResolutionTarget(double frameMs, double minScale) {
+        if (frameMs <= 0.0) {
+            std::cerr << "RenderingEngine: Invalid target frame time " << frameMs << std::endl;
+            return;
+        }
+        
+        pImpl->resolutionTargetMs = frameMs;
+        pImpl->resolutionMinScale = std::min(std::max(minScale, 0.1), 1.0);
+        if (pImpl->resolutionScaler) {
+            pImpl->resolutionScaler->SetTargetFrameTime(frameMs);
+            pImpl->resolutionScaler->SetScaleRange(pImpl->resolutionMinScale, 1.0);
+        }
+    }
+    
+    bool RenderingEngine::SetEndoscopeMoving(bool moving) {
+        bool stopped = pImpl->endoscopeMoving && !moving;
+        pImpl->endoscopeMoving = moving;
+        if (pImpl->resolutionScaler) {
+            pImpl->resolutionScaler->SetMoving(moving);
+        }
+        return stopped && pImpl->resolutionScaler != nullptr;
+    }
+    
+    bool RenderingEngine::IsEndoscopeMoving() const {
+        return pImpl->endoscopeMoving;
+    }
+    
+    double RenderingEngine::GetEndoscopeResolutionScale() const {
+        if (!pImpl->resolutionScaler) {
+            return 1.0;
+        }
+        return pImpl->endoscopeMoving ? pImpl->resolutionScaler->GetScale() : 1.0;
+    }
+    
+    void RenderingEngine::SetProfilingEnabled(bool enable) {
+        if (!pImpl->initialized) {
+            std::cerr << "RenderingEngine: Cannot profile before initialization" << std::endl;
+            return;
+        }
+        
+        if (!enable) {
+            pImpl->overviewProfiler.reset();
+            pImpl->endoscopeProfiler.reset();
+        } else {
+            if (!pImpl->overviewProfiler) {
+                pImpl->overviewProfiler = pImpl->CreateProfiler("overview", pImpl->overviewRenderer);
+            }
+            if (!pImpl->endoscopeProfiler) {
+                pImpl->endoscopeProfiler = pImpl->CreateProfiler("endoscope", pImpl->endoscopeRenderer);
+            }
+        }
+        
+        // 重新组装渲染步骤（装入或移除计时步骤）
+        pImpl->UpdateScenePasses();
+    }
+    
+    bool RenderingEngine::IsProfilingEnabled() const {
+        return pImpl->overviewProfiler != nullptr || pImpl->endoscopeProfiler != nullptr;
+    }
+    
+    void RenderingEngine::SetProfilingLabeler(RenderProfiler::PropLabeler labeler) {
+        pImpl->profilingLabeler = labeler;
+        if (pImpl->overviewProfiler) pImpl->overviewProfiler->SetPropLabeler(labeler);
+        if (pImpl->endoscopeProfiler) pImpl->endoscopeProfiler->SetPropLabeler(labeler);
+    }
+    
+    void RenderingEngine::SetProfilingPassSource(RenderProfiler::PassTimingSource source) {
+        pImpl->profilingPassSource = source;
+        if (pImpl->overviewProfiler) pImpl->overviewProfiler->SetPassTimingSource(source);
+        if (pImpl->endoscopeProfiler) pImpl->endoscopeProfiler->SetPassTimingSource(source);
+    }
+    
+    std::shared_ptr<RenderStats> RenderingEngine::GetRenderStats() const {
+        return pImpl->stats;
+    }
+    
     bool RenderingEngine::IsInitialized() const {
         return pImpl->initialized;
     }
@@ -0,0 +1,346 @@
+#include "ResolutionScaler.h"
+#include "SectionTimer.h"
+
+// VTK headers
+#include <vtkImageProcessingPass.h>
+#include <vtkObjectFactory.h>
+#include <vtkOpenGLFramebufferObject.h>
+#include <vtkOpenGLRenderUtilities.h>
+#include <vtkOpenGLRenderWindow.h>
+#include <vtkOpenGLShaderCache.h>
+#include <vtkOpenGLVertexArrayObject.h>
+#include <vtkRenderState.h>
+#include <vtkRenderStepsPass.h>
+#include <vtkRenderer.h>
+#include <vtkShaderProgram.h>
+#include <vtkSmartPointer.h>
+#include <vtkTextureObject.h>
+#include <vtk_glew.h>
+
+// Standard headers
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 放大用的全屏着色器（线性过滤由纹理完成）
+        const char* UpscaleVertexShader =
+            "//VTK::System::Dec\n"
+            "attribute vec4 vertexMC;\n"
+            "attribute vec2 tcoordMC;\n"
+            "varying vec2 texCoord;\n"
+            "void main() {\n"
+            "    texCoord = tcoordMC;\n"
+            "    gl_Position = vertexMC;\n"
+            "}\n";
+
+        const char* UpscaleFragmentShader =
+            "//VTK::System::Dec\n"
+            "uniform sampler2D screenTexture;\n"
+            "varying vec2 texCoord;\n"
+            "//VTK::Output::Dec\n"
+            "void main() {\n"
+            "    gl_FragData[0] = texture2D(screenTexture, texCoord);\n"
+            "}\n";
+
+        // 比例按此步长取整，避免每帧重建离屏纹理
+        const double ScaleStep = 0.05;
+        // 估计的比例变化小于此比例时保持不变，避免在目标附近来回抖动
+        const double ScaleDeadband = 0.05;
+        // 向估计比例靠近的平滑系数
+        const double ScaleSmoothing = 0.5;
+
+        // ResolutionScaler和渲染通道共享的控制状态
+        struct ScaleControl {
+            bool moving;
+            double targetMs;
+            double minScale;
+            double maxScale;
+            double scale;           // 下一个运动帧的比例
+            double lastFrameScale;  // 最近一帧实际使用的比例（GPU结果延迟到达时近似对应）
+            SectionTimer timer;
+
+            ScaleControl() : moving(false), targetMs(1000.0 / 60.0), minScale(0.5), maxScale(1.0),
+                             scale(1.0), lastFrameScale(1.0) {
+                // 没有计时器查询时需要同步才能得到实际渲染时间
+                timer.SetSynchronousFallback(true);
+            }
+
+            double Clamp(double value) const {
+                return std::min(std::max(value, minScale), maxScale);
+            }
+
+            // 根据一帧的耗时和该帧的比例更新比例：耗时近似与像素数（比例的平方）成正比
+            void Update(double frameMs, double frameScale) {
+                if (frameMs <= 0.0 || targetMs <= 0.0) {
+                    return;
+                }
+
+                double fullMs = frameMs / (frameScale * frameScale);
+                double estimate = Clamp(std::sqrt(targetMs / fullMs));
+                if (std::abs(estimate - scale) < ScaleDeadband * scale) {
+                    return;
+                }
+
+                double next = scale + ScaleSmoothing * (estimate - scale);
+                next = std::round(next / ScaleStep) * ScaleStep;
+                scale = Clamp(next);
+            }
+        };
+
+        // VTK渲染通道：运动时场景以缩小的尺寸渲染到离屏纹理，再放大到渲染器视口
+        class ResolutionScalingPass : public vtkImageProcessingPass {
+        public:
+            static ResolutionScalingPass* New();
+            vtkTypeMacro(ResolutionScalingPass, vtkImageProcessingPass);
+
+            std::shared_ptr<ScaleControl> Control;
+
+            void Render(const vtkRenderState* s) override;
+            void ReleaseGraphicsResources(vtkWindow* window) override;
+
+        protected:
+            ResolutionScalingPass() : Program(nullptr), ProgramFailed(false) {}
+            ~ResolutionScalingPass() override {}
+
+            vtkSmartPointer<vtkOpenGLFramebufferObject> FrameBuffer;
+            vtkSmartPointer<vtkTextureObject> Texture;
+            vtkShaderProgram* Program;  // 由渲染窗口的shader缓存持有
+            bool ProgramFailed;
+            vtkSmartPointer<vtkOpenGLVertexArrayObject> VAO;
+
+            void PrepareTarget(vtkOpenGLRenderWindow* renWin, int width, int height);
+            bool PrepareProgram(vtkOpenGLRenderWindow* renWin);
+            void RenderScaled(const vtkRenderState* s, vtkOpenGLRenderWindow* renWin, double scale);
+
+        private:
+            ResolutionScalingPass(const ResolutionScalingPass&) = delete;
+            void operator=(const ResolutionScalingPass&) = delete;
+        };
+
+        vtkStandardNewMacro(ResolutionScalingPass);
+
+        void ResolutionScalingPass::PrepareTarget(vtkOpenGLRenderWindow* renWin, int width, int height) {
+            if (!this->Texture) {
+                this->Texture = vtkSmartPointer<vtkTextureObject>::New();
+                this->Texture->SetContext(renWin);
+                this->Texture->SetMinificationFilter(vtkTextureObject::Linear);
+                this->Texture->SetMagnificationFilter(vtkTextureObject::Linear);
+                this->Texture->SetWrapS(vtkTextureObject::ClampToEdge);
+                this->Texture->SetWrapT(vtkTextureObject::ClampToEdge);
+            }
+
+            if (static_cast<int>(this->Texture->GetWidth()) != width ||
+                static_cast<int>(this->Texture->GetHeight()) != height) {
+                this->Texture->Create2D(width, height, 4, VTK_UNSIGNED_CHAR, false);
+            }
+
+            if (!this->FrameBuffer) {
+                this->FrameBuffer = vtkSmartPointer<vtkOpenGLFramebufferObject>::New();
+                this->FrameBuffer->SetContext(renWin);
+            }
+        }
+
+        bool ResolutionScalingPass::PrepareProgram(vtkOpenGLRenderWindow* renWin) {
+            if (this->ProgramFailed) {
+                return false;
+            }
+
+            if (!this->Program) {
+                this->Program = renWin->GetShaderCache()->ReadyShaderProgram(
+                    UpscaleVertexShader, UpscaleFragmentShader, "");
+                if (!this->Program) {
+                    std::cerr << "ResolutionScaler: Failed to compile upscale shader, "
+                             << "rendering at full resolution" << std::endl;
+                    this->ProgramFailed = true;
+                    return false;
+                }
+                this->VAO = vtkSmartPointer<vtkOpenGLVertexArrayObject>::New();
+            }
+            return true;
+        }
+
+        void ResolutionScalingPass::RenderScaled(const vtkRenderState* s, vtkOpenGLRenderWindow* renWin,
+                                                 double scale) {
+            int width = 0, height = 0, x = 0, y = 0;
+            s->GetRenderer()->GetTiledSizeAndOrigin(&width, &height, &x, &y);
+            if (width <= 0 || height <= 0) {
+                return;
+            }
+
+            int scaledWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+            int scaledHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+
+            // 场景以缩小的尺寸渲染到离屏纹理（RenderDelegate按新尺寸调整视口）
+            this->PrepareTarget(renWin, scaledWidth, scaledHeight);
+            this->RenderDelegate(s, width, height, scaledWidth, scaledHeight,
+                                 this->FrameBuffer, this->Texture);
+
+            // 放大不需要深度测试和混合，结束后恢复
+            GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+            GLboolean blend = glIsEnabled(GL_BLEND);
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_BLEND);
+            glViewport(x, y, width, height);
+
+            renWin->GetShaderCache()->ReadyShaderProgram(this->Program);
+            this->Texture->Activate();
+            this->Program->SetUniformi("screenTexture", this->Texture->GetTextureUnit());
+
+            // 覆盖整个视口的四边形（裁剪空间坐标）
+            float verts[12] = {
+                -1.0f, -1.0f, 0.0f,
+                 1.0f, -1.0f, 0.0f,
+                 1.0f,  1.0f, 0.0f,
+                -1.0f,  1.0f, 0.0f
+            };
+            float tcoords[8] = {
+                0.0f, 0.0f,
+                1.0f, 0.0f,
+                1.0f, 1.0f,
+                0.0f, 1.0f
+            };
+            vtkOpenGLRenderUtilities::RenderQuad(verts, tcoords, this->Program, this->VAO);
+
+            this->Texture->Deactivate();
+
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            if (depthTest) glEnable(GL_DEPTH_TEST);
+            if (blend) glEnable(GL_BLEND);
+        }
+
+        void ResolutionScalingPass::Render(const vtkRenderState* s) {
+            this->NumberOfRenderedProps = 0;
+
+            vtkOpenGLRenderWindow* renWin =
+                vtkOpenGLRenderWindow::SafeDownCast(s->GetRenderer()->GetRenderWindow());
+            if (!this->DelegatePass || !renWin || !this->Control) {
+                vtkWarningMacro("ResolutionScalingPass: no delegate pass or OpenGL render window");
+                return;
+            }
+
+            ScaleControl& control = *this->Control;
+            double scale = control.moving ? control.scale : 1.0;
+            if (scale < 1.0 && !this->PrepareProgram(renWin)) {
+                scale = 1.0;
+            }
+
+            // 静止帧也计时，作为下一次运动的初始比例
+            control.timer.Begin();
+            if (control.timer.HasNewGpuResult()) {
+                control.Update(control.timer.GetGpuMs(), control.lastFrameScale);
+            }
+
+            if (scale < 1.0) {
+                this->RenderScaled(s, renWin, scale);
+            } else {
+                this->DelegatePass->Render(s);
+            }
+            this->NumberOfRenderedProps += this->DelegatePass->GetNumberOfRenderedProps();
+
+            control.timer.End();
+            if (!control.timer.IsGpuTimingAvailable()) {
+                control.Update(control.timer.GetCpuMs(), scale);
+            }
+            control.lastFrameScale = scale;
+        }
+
+        void ResolutionScalingPass::ReleaseGraphicsResources(vtkWindow* window) {
+            this->Superclass::ReleaseGraphicsResources(window);
+
+            if (this->FrameBuffer) {
+                this->FrameBuffer->ReleaseGraphicsResources(window);
+                this->FrameBuffer = nullptr;
+            }
+            if (this->Texture) {
+                this->Texture->ReleaseGraphicsResources(window);
+                this->Texture = nullptr;
+            }
+            this->Program = nullptr;
+            if (this->VAO) {
+                this->VAO->ReleaseGraphicsResources();
+                this->VAO = nullptr;
+            }
+            if (this->Control) {
+                this->Control->timer.ReleaseGraphicsResources();
+            }
+        }
+
+    } // namespace
+
+    class ResolutionScaler::Impl {
+    public:
+        std::shared_ptr<ScaleControl> control;
+        vtkSmartPointer<ResolutionScalingPass> pass;
+        vtkSmartPointer<vtkRenderPass> scene;         // 调用者设置的场景通道
+        vtkSmartPointer<vtkRenderPass> defaultScene;  // 未设置时使用的默认渲染步骤
+
+        Impl() : control(std::make_shared<ScaleControl>()) {
+            defaultScene = vtkSmartPointer<vtkRenderStepsPass>::New();
+            pass = vtkSmartPointer<ResolutionScalingPass>::New();
+            pass->Control = control;
+            pass->SetDelegatePass(defaultScene);
+        }
+    };
+
+    ResolutionScaler::ResolutionScaler() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    ResolutionScaler::~ResolutionScaler() = default;
+
+    void ResolutionScaler::SetScenePass(vtkRenderPass* scene) {
+        pImpl->scene = scene;
+        pImpl->pass->SetDelegatePass(scene ? scene : pImpl->defaultScene.GetPointer());
+    }
+
+    vtkRenderPass* ResolutionScaler::GetScenePass() const {
+        return pImpl->scene;
+    }
+
+    vtkRenderPass* ResolutionScaler::GetPass() const {
+        return pImpl->pass;
+    }
+
+    void ResolutionScaler::SetMoving(bool moving) {
+        pImpl->control->moving = moving;
+    }
+
+    bool ResolutionScaler::IsMoving() const {
+        return pImpl->control->moving;
+    }
+
+    void ResolutionScaler::SetTargetFrameTime(double frameMs) {
+        if (frameMs <= 0.0) {
+            std::cerr << "ResolutionScaler: Invalid target frame time " << frameMs << std::endl;
+            return;
+        }
+        pImpl->control->targetMs = frameMs;
+    }
+
+    double ResolutionScaler::GetTargetFrameTime() const {
+        return pImpl->control->targetMs;
+    }
+
+    void ResolutionScaler::SetScaleRange(double minScale, double maxScale) {
+        ScaleControl& control = *pImpl->control;
+        control.minScale = std::min(std::max(minScale, 0.1), 1.0);
+        control.maxScale = std::min(std::max(maxScale, control.minScale), 1.0);
+        control.scale = control.Clamp(control.scale);
+    }
+
+    double ResolutionScaler::GetScale() const {
+        return pImpl->control->scale;
+    }
+
+    void ResolutionScaler::ReleaseGraphicsResources(vtkWindow* window) {
+        if (window) {
+            pImpl->pass->ReleaseGraphicsResources(window);
+        }
+    }
+
+} // namespace BronchoscopyLib
@@ -0,0 +1,288 @@
+#include "RoutePlanner.h"
+#include "Centerline.h"
+
+// Standard headers
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        const double Unreached = std::numeric_limits<double>::max();
+
+        // 到目标距离相差小于此值的终点视为同样近，取路线较短者（避免为毫厘之差绕进更深的分支）
+        const double TargetTolerance = 1e-6;
+
+        double PointDistance(const double* a, const double* b) {
+            double dx = a[0] - b[0];
+            double dy = a[1] - b[1];
+            double dz = a[2] - b[2];
+            return std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+
+    } // namespace
+
+    class RoutePlanner::Impl {
+    public:
+        std::shared_ptr<const Centerline> centerline;
+
+        // 图：节点坐标、半径、所在分支，邻接表按CSR存放
+        std::vector<double> positions;
+        std::vector<double> radii;
+        std::vector<int> nodeBranch;
+        std::vector<size_t> edgeOffsets;
+        std::vector<int> edgeTargets;
+        std::vector<double> edgeWeights;
+
+        // 根分支开口段的节点数：开口处的离壁距离是到开口边缘的距离，从0逐渐增大，
+        // 离开口一个管腔半径之内不按半径限制
+        size_t openingNodes;
+
+        // 从根出发的最短路（根为节点0）
+        std::vector<double> distance;
+        std::vector<int> predecessor;
+        size_t reachable;
+
+        double minRadius;
+
+        Impl() : openingNodes(0), reachable(0), minRadius(0.0) {}
+
+        bool IsPassable(int node) const {
+            return static_cast<size_t>(node) < openingNodes || radii[node] >= minRadius;
+        }
+
+        void BuildGraph(const Centerline& source) {
+            positions.clear();
+            radii.clear();
+            nodeBranch.clear();
+
+            // 分支的首点与父分支的末点重合，合并为同一节点；父分支排在子分支之前
+            const std::vector<Centerline::Branch>& branches = source.GetBranches();
+            std::vector<int> lastNode(branches.size(), -1);
+            std::vector<std::pair<int, int>> edges;
+            for (size_t b = 0; b < branches.size(); b++) {
+                const Centerline::Branch& branch = branches[b];
+                int previous = branch.parent >= 0 ? lastNode[branch.parent] : -1;
+                for (size_t i = 0; i < branch.GetPointCount(); i++) {
+                    if (i == 0 && previous >= 0) {
+                        continue;
+                    }
+                    int node = static_cast<int>(radii.size());
+                    positions.insert(positions.end(), &branch.points[i * 3], &branch.points[i * 3] + 3);
+                    radii.push_back(branch.radii[i]);
+                    nodeBranch.push_back(static_cast<int>(b));
+                    if (previous >= 0) {
+                        edges.emplace_back(previous, node);
+                    }
+                    previous = node;
+                }
+                lastNode[b] = previous;
+            }
+
+            // 根分支的节点排在最前
+            openingNodes = 0;
+            if (!branches.empty()) {
+                const Centerline::Branch& root = branches[0];
+                double opening = *std::max_element(root.radii.begin(), root.radii.end());
+                double along = 0.0;
+                while (openingNodes < root.GetPointCount() && along < opening) {
+                    openingNodes++;
+                    if (openingNodes < root.GetPointCount()) {
+                        along += PointDistance(&positions[(openingNodes - 1) * 3], &positions[openingNodes * 3]);
+                    }
+                }
+            }
+
+            // 无向边展开为CSR
+            size_t nodeCount = radii.size();
+            edgeOffsets.assign(nodeCount + 1, 0);
+            for (const auto& edge : edges) {
+                edgeOffsets[edge.first + 1]++;
+                edgeOffsets[edge.second + 1]++;
+            }
+            for (size_t i = 0; i < nodeCount; i++) {
+                edgeOffsets[i + 1] += edgeOffsets[i];
+            }
+            edgeTargets.resize(edgeOffsets[nodeCount]);
+            edgeWeights.resize(edgeOffsets[nodeCount]);
+            std::vector<size_t> fill(edgeOffsets.begin(), edgeOffsets.end() - 1);
+            for (const auto& edge : edges) {
+                double weight = PointDistance(&positions[edge.first * 3], &positions[edge.second * 3]);
+                edgeTargets[fill[edge.first]] = edge.second;
+                edgeWeights[fill[edge.first]++] = weight;
+                edgeTargets[fill[edge.second]] = edge.first;
+                edgeWeights[fill[edge.second]++] = weight;
+            }
+        }
+
+        void ComputeDistances() {
+            size_t nodeCount = radii.size();
+            distance.assign(nodeCount, Unreached);
+            predecessor.assign(nodeCount, -1);
+            reachable = 0;
+            if (nodeCount == 0 || !IsPassable(0)) {
+                return;
+            }
+
+            typedef std::pair<double, int> Entry;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+            distance[0] = 0.0;
+            queue.emplace(0.0, 0);
+            while (!queue.empty()) {
+                Entry entry = queue.top();
+                queue.pop();
+                int node = entry.second;
+                if (entry.first > distance[node]) {
+                    continue;
+                }
+                reachable++;
+                for (size_t e = edgeOffsets[node]; e < edgeOffsets[node + 1]; e++) {
+                    int next = edgeTargets[e];
+                    if (!IsPassable(next)) {
+                        continue;
+                    }
+                    double candidate = entry.first + edgeWeights[e];
+                    if (candidate < distance[next]) {
+                        distance[next] = candidate;
+                        predecessor[next] = node;
+                        queue.emplace(candidate, next);
+                    }
+                }
+            }
+        }
+    };
+
+    RoutePlanner::RoutePlanner() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    RoutePlanner::~RoutePlanner() = default;
+
+    bool RoutePlanner::Build(std::shared_ptr<const Centerline> centerline) {
+        Clear();
+        if (!centerline || centerline->IsEmpty()) {
+            return false;
+        }
+
+        pImpl->centerline = centerline;
+        pImpl->BuildGraph(*centerline);
+        pImpl->ComputeDistances();
+
+        std::cout << "RoutePlanner: Graph built (" << pImpl->radii.size() << " nodes, "
+                 << pImpl->reachable << " reachable)" << std::endl;
+        return true;
+    }
+
+    void RoutePlanner::Clear() {
+        pImpl->centerline = nullptr;
+        pImpl->positions.clear();
+        pImpl->radii.clear();
+        pImpl->nodeBranch.clear();
+        pImpl->edgeOffsets.clear();
+        pImpl->edgeTargets.clear();
+        pImpl->edgeWeights.clear();
+        pImpl->openingNodes = 0;
+        pImpl->distance.clear();
+        pImpl->predecessor.clear();
+        pImpl->reachable = 0;
+    }
+
+    bool RoutePlanner::IsEmpty() const {
+        return pImpl->radii.empty();
+    }
+
+    std::shared_ptr<const Centerline> RoutePlanner::GetCenterline() const {
+        return pImpl->centerline;
+    }
+
+    void RoutePlanner::SetMinRadius(double radius) {
+        radius = std::max(radius, 0.0);
+        if (radius == pImpl->minRadius) {
+            return;
+        }
+        pImpl->minRadius = radius;
+        if (!IsEmpty()) {
+            pImpl->ComputeDistances();
+        }
+    }
+
+    double RoutePlanner::GetMinRadius() const {
+        return pImpl->minRadius;
+    }
+
+    bool RoutePlanner::PlanRoute(const double target[3], Route& route) const {
+        route = Route();
+        if (pImpl->reachable == 0) {
+            return false;
+        }
+
+        // 可达节点中离目标最近者；同样近时取路线较短者
+        int best = -1;
+        double bestDistance = Unreached;
+        for (size_t i = 0; i < pImpl->radii.size(); i++) {
+            if (pImpl->distance[i] == Unreached) {
+                continue;
+            }
+            double d = PointDistance(&pImpl->positions[i * 3], target);
+            if (best < 0 || d < bestDistance - TargetTolerance ||
+                (d < bestDistance + TargetTolerance && pImpl->distance[i] < pImpl->distance[best])) {
+                best = static_cast<int>(i);
+                bestDistance = d;
+            }
+        }
+
+        // 终点为根时补上根的下一个节点，相机路径至少需要两个点
+        if (best == 0) {
+            int next = -1;
+            for (size_t e = pImpl->edgeOffsets[0]; e < pImpl->edgeOffsets[1]; e++) {
+                int neighbor = pImpl->edgeTargets[e];
+                if (pImpl->distance[neighbor] != Unreached &&
+                    (next < 0 || PointDistance(&pImpl->positions[neighbor * 3], target) <
+                                 PointDistance(&pImpl->positions[next * 3], target))) {
+                    next = neighbor;
+                }
+            }
+            if (next < 0) {
+                return false;
+            }
+            best = next;
+            bestDistance = PointDistance(&pImpl->positions[best * 3], target);
+        }
+
+        std::vector<int> chain;
+        for (int node = best; node >= 0; node = pImpl->predecessor[node]) {
+            chain.push_back(node);
+        }
+
+        route.positions.reserve(chain.size() * 3);
+        route.narrowestRadius = Unreached;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            const double* point = &pImpl->positions[*it * 3];
+            route.positions.insert(route.positions.end(), point, point + 3);
+            if (static_cast<size_t>(*it) >= pImpl->openingNodes) {
+                route.narrowestRadius = std::min(route.narrowestRadius, pImpl->radii[*it]);
+            }
+        }
+        if (route.narrowestRadius == Unreached) {
+            route.narrowestRadius = pImpl->radii[best];
+        }
+        route.length = pImpl->distance[best];
+        route.targetDistance = bestDistance;
+        route.branch = pImpl->nodeBranch[best];
+        return true;
+    }
+
+    size_t RoutePlanner::GetNodeCount() const {
+        return pImpl->radii.size();
+    }
+
+    size_t RoutePlanner::GetReachableCount() const {
+        return pImpl->reachable;
+    }
+
+} // namespace BronchoscopyLib
@@ -5,12 +5,35 @@
 #include "RenderingEngine.h"
 #include "NavigationController.h"
 #include "CameraPath.h"
+#include "MeshBVH.h"
+#include "PathVisibility.h"
+#include "ThreadPool.h"
 
 #include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 namespace BronchoscopyLib {
     
+    // 在线程池上构建的可见集：工作线程写入success后置位finished，渲染线程随后取走result
+    struct PathVisibilityBuild {
+        std::atomic<bool> cancelled;
+        std::atomic<bool> finished;
+        bool success;
+        std::unique_ptr<PathVisibility> result;
+        
+        // 构建期间持有的输入快照（渲染网格、路径），模型或路径随后被替换也不受影响
+        vtkSmartPointer<vtkPolyData> mesh;
+        CameraPath path;
+        
+        PathVisibilityBuild() : cancelled(false), finished(false), success(false),
+                                result(std::make_unique<PathVisibility>()) {
+        }
+    };
+    
     class SceneManager::Impl {
     public:
         // 模块引用（不拥有）
@@ -26,11 +49,54 @@ namespace BronchoscopyLib {
         bool autoRender;
         bool sceneInitialized;
         
+        // 可见性剔除：预计算结果，以及请求构建时的BVH和视场角（跳过或失败时也记录，避免每帧重试）
+        // 构建在模型的线程池上进行，完成前pendingVisibility非空，内窥镜视图绘制完整网格
+        bool visibilityCulling;
+        std::unique_ptr<PathVisibility> pathVisibility;
+        std::shared_ptr<PathVisibilityBuild> pendingVisibility;
+        std::shared_ptr<const MeshBVH> visibilityBvh;
+        double visibilityViewAngle;
+        std::vector<uint64_t> visibleChunks;  // 当前交给内窥镜视图的块
+        double visibleFraction;
+        
         Impl() : cameraController(nullptr), modelManager(nullptr),
                  pathVisualization(nullptr), renderingEngine(nullptr),
                  navigationController(nullptr),
                  showPath(true), showMarker(true), 
-                 autoRender(true), sceneInitialized(false) {
+                 autoRender(true), sceneInitialized(false),
+                 visibilityCulling(false), pathVisibility(std::make_unique<PathVisibility>()),
+                 visibilityViewAngle(0.0), visibleFraction(1.0) {
+        }
+        
+        ~Impl() {
+            // 线程池属于ModelManager，析构时等待任务结束；让正在进行的构建尽早退出
+            CancelPendingVisibility();
+        }
+        
+        void CancelPendingVisibility() {
+            if (pendingVisibility) {
+                pendingVisibility->cancelled = true;
+                pendingVisibility.reset();
+            }
+        }
+        
+        // 取走已完成的后台构建，成功时替换当前可见集；返回是否替换
+        bool TakeFinishedVisibility() {
+            if (!pendingVisibility || !pendingVisibility->finished) return false;
+            std::shared_ptr<PathVisibilityBuild> build = pendingVisibility;
+            pendingVisibility.reset();
+            if (!build->success) return false;
+            pathVisibility = std::move(build->result);
+            return true;
+        }
+        
+        // 内窥镜视图改为绘制完整网格，下次导航更新时重新选择可见集
+        void ShowFullEndoscopeMesh() {
+            visibleChunks.clear();
+            visibleFraction = 1.0;
+            if (modelManager) {
+                modelManager->ClearEndoscopeVisibleCells();
+            }
         }
         
         bool AreAllModulesSet() const {
@@ -67,6 +133,15 @@ namespace BronchoscopyLib {
     
     void SceneManager::SetRenderingEngine(RenderingEngine* engine) {
         pImpl->renderingEngine = engine;
+        
+        if (engine) {
+            engine->SetEndoscopeInteractionCallback(
+                [this]() {
+                    this->OnEndoscopeInteraction();
+                }
+            );
+        }
+        
         std::cout << "SceneManager: RenderingEngine set" << std::endl;
     }
     
@@ -132,6 +207,9 @@ namespace BronchoscopyLib {
     void SceneManager::UpdateFromNavigation(PathNode* node, int index) {
         if (!node) return;
         
+        // 按相机当前位置（过渡开始前仍在上一个节点）选择可见集
+        ApplyPathVisibility(node, index);
+        
         // 更新内窥镜相机
         if (pImpl->cameraController) {
             pImpl->cameraController->UpdateEndoscopeCamera(node);
@@ -165,6 +243,8 @@ namespace BronchoscopyLib {
             // 清理模型数据
             pImpl->modelManager->ClearModel();
         }
+        OnDerivedDataChanged();
+        UpdatePathVisibility();
         
         pImpl->TriggerRender();
         std::cout << "SceneManager: Model cleared" << std::endl;
@@ -182,6 +262,7 @@ namespace BronchoscopyLib {
             // 清理路径数据
             pImpl->pathVisualization->ClearPath();
         }
+        UpdatePathVisibility();
         
         // 重置导航
         if (pImpl->navigationController) {
@@ -237,27 +318,46 @@ namespace BronchoscopyLib {
         UpdateScene();
     }
     
-    bool SceneManager::OnModelLoaded(vtkPolyData* polyData) {
+    bool SceneManager::OnModelLoaded(vtkPolyData* polyData, bool adopt) {
         if (!polyData || !pImpl->modelManager) return false;
         
         // 加载模型
-        if (pImpl->modelManager->LoadModel(polyData)) {
-            // 添加到渲染器
-            if (pImpl->renderingEngine) {
-                pImpl->modelManager->AddToRenderers(
-                    pImpl->renderingEngine->GetOverviewRenderer(),
-                    pImpl->renderingEngine->GetEndoscopeRenderer());
-            }
-            
-            // 重置相机以适应模型
-            ResetCameras();
-            
-            std::cout << "SceneManager: Model loaded and added to scene" << std::endl;
+        if (pImpl->modelManager->LoadModel(polyData, adopt)) {
+            AddModelToScene();
             return true;
         }
         return false;
     }
     
+    bool SceneManager::OnModelPrepared(const std::shared_ptr<PreparedModel>& model) {
+        if (!model || !pImpl->modelManager) return false;
+        
+        // 替换当前模型（在此之前旧模型保持可交互）
+        if (pImpl->modelManager->InstallPreparedModel(model)) {
+            AddModelToScene();
+            return true;
+        }
+        return false;
+    }
+    
+    void SceneManager::AddModelToScene() {
+        // 添加到渲染器
+        if (pImpl->renderingEngine) {
+            pImpl->modelManager->AddToRenderers(
+                pImpl->renderingEngine->GetOverviewRenderer(),
+                pImpl->renderingEngine->GetEndoscopeRenderer());
+        }
+        
+        // 重置相机以适应模型
+        ResetCameras();
+        
+        UpdateLumenProfile();
+        OnDerivedDataChanged();
+        UpdatePathVisibility();
+        
+        std::cout << "SceneManager: Model loaded and added to scene" << std::endl;
+    }
+    
     void SceneManager::OnPathLoaded() {
         if (!pImpl->pathVisualization) return;
         
@@ -274,17 +374,175 @@ namespace BronchoscopyLib {
             pImpl->navigationController->SetCameraPath(path);
         }
         
+        UpdateLumenProfile();
+        UpdatePathTopology();
+        UpdatePathVisibility();
+        
         // 更新场景
         UpdateScene();
         
         std::cout << "SceneManager: Path loaded and added to scene" << std::endl;
     }
     
+    void SceneManager::UpdateLumenProfile() {
+        if (!pImpl->pathVisualization || !pImpl->modelManager) return;
+        
+        CameraPath* path = pImpl->pathVisualization->GetCameraPath();
+        if (!path) return;
+        
+        std::shared_ptr<const MeshBVH> bvh = pImpl->modelManager->GetBVH();
+        if (bvh) {
+            path->ComputeLumenProfile(*bvh, CameraPath::DefaultProfileRays, pImpl->modelManager->GetThreadPool());
+        } else {
+            path->ClearLumenProfile();
+        }
+    }
+    
     void SceneManager::OnNavigationChanged(PathNode* node, int index) {
         UpdateFromNavigation(node, index);
         pImpl->TriggerRender();
     }
     
+    void SceneManager::OnDerivedDataChanged() {
+        if (!pImpl->cameraController || !pImpl->modelManager) return;
+        
+        pImpl->cameraController->SetLumenField(pImpl->modelManager->GetDistanceField());
+        UpdatePathTopology();
+    }
+    
+    void SceneManager::UpdatePathTopology() {
+        if (!pImpl->pathVisualization || !pImpl->modelManager) return;
+        
+        CameraPath* path = pImpl->pathVisualization->GetCameraPath();
+        if (!path) return;
+        
+        std::shared_ptr<const Centerline> centerline = pImpl->modelManager->GetCenterline();
+        if (centerline) {
+            path->ComputeTopology(*centerline, pImpl->modelManager->GetThreadPool());
+        } else {
+            path->ClearTopology();
+        }
+    }
+    
+    void SceneManager::SetVisibilityCulling(bool enable) {
+        if (pImpl->visibilityCulling == enable) return;
+        
+        pImpl->visibilityCulling = enable;
+        UpdatePathVisibility();
+        
+        if (enable && pImpl->navigationController) {
+            PathNode* currentNode = pImpl->navigationController->GetCurrentNode();
+            if (currentNode) {
+                ApplyPathVisibility(currentNode, pImpl->navigationController->GetCurrentIndex());
+            }
+        }
+        pImpl->TriggerRender();
+    }
+    
+    bool SceneManager::GetVisibilityCulling() const {
+        return pImpl->visibilityCulling;
+    }
+    
+    double SceneManager::GetEndoscopeVisibleFraction() const {
+        return pImpl->visibleFraction;
+    }
+    
+    void SceneManager::UpdatePathVisibility() {
+        pImpl->CancelPendingVisibility();
+        pImpl->pathVisibility->Clear();
+        pImpl->ShowFullEndoscopeMesh();
+        if (!pImpl->pathVisualization || !pImpl->modelManager) return;
+        
+        // 记录本次请求的BVH和视场角，即使因缺少BVH或路径而跳过，参数不变时也不再重复请求
+        CameraPath* path = pImpl->pathVisualization->GetCameraPath();
+        std::shared_ptr<const MeshBVH> bvh = pImpl->modelManager->GetBVH();
+        PathVisibility::Settings settings;
+        if (pImpl->cameraController) {
+            settings.viewAngle = pImpl->cameraController->GetEndoscopeFOV();
+        }
+        pImpl->visibilityBvh = bvh;
+        pImpl->visibilityViewAngle = settings.viewAngle;
+        if (!pImpl->visibilityCulling || !path || path->GetTotalNodes() == 0 || !bvh) return;
+        
+        // 在模型的线程池上构建（射线采样耗时较长，不阻塞渲染线程），输入为当前网格和路径的快照
+        std::shared_ptr<PathVisibilityBuild> build = std::make_shared<PathVisibilityBuild>();
+        build->mesh = pImpl->modelManager->GetRenderedData();
+        for (const PathNode* node = path->GetHead(); node != nullptr; node = node->next) {
+            build->path.AddPoint(node->position, node->direction);
+        }
+        
+        ThreadPool* pool = pImpl->modelManager->GetThreadPool();
+        auto task = [build, bvh, settings, pool]() {
+            build->success = build->result->Build(build->mesh, bvh, build->path, settings, pool,
+                                                  &build->cancelled);
+            build->finished = true;
+        };
+        pImpl->pendingVisibility = build;
+        if (pool) {
+            pool->Submit(task);
+        } else {
+            task();
+        }
+    }
+    
+    bool SceneManager::ProcessPathVisibility() {
+        if (!pImpl->TakeFinishedVisibility()) return false;
+        
+        if (pImpl->navigationController) {
+            PathNode* currentNode = pImpl->navigationController->GetCurrentNode();
+            if (currentNode) {
+                ApplyPathVisibility(currentNode, pImpl->navigationController->GetCurrentIndex());
+            }
+        }
+        return true;
+    }
+    
+    void SceneManager::ApplyPathVisibility(const PathNode* node, int index) {
+        if (!pImpl->visibilityCulling || !pImpl->modelManager || !node) return;
+        
+        // 网格重新预处理（BVH替换）或视场角变化后重建
+        double viewAngle = pImpl->cameraController ? pImpl->cameraController->GetEndoscopeFOV()
+                                                   : pImpl->visibilityViewAngle;
+        if (pImpl->visibilityBvh != pImpl->modelManager->GetBVH() || pImpl->visibilityViewAngle != viewAngle) {
+            UpdatePathVisibility();
+        }
+        
+        // 后台构建完成后换入；完成前继续绘制完整网格
+        pImpl->TakeFinishedVisibility();
+        if (pImpl->pendingVisibility) return;
+        
+        const PathVisibility& visibility = *pImpl->pathVisibility;
+        if (visibility.IsEmpty() || index < 0 || index >= visibility.GetNodeCount()) return;
+        
+        // 过渡从相机当前位姿开始：已被用户移离路径时可见集不可靠，绘制完整网格；
+        // 否则最近节点到目标节点之间的位姿都可能出现
+        PathNode state = *node;
+        if (pImpl->cameraController) {
+            pImpl->cameraController->GetCurrentEndoscopeState(&state);
+        }
+        if (!visibility.IsPoseCovered(state.position, state.direction)) {
+            pImpl->ShowFullEndoscopeMesh();
+            return;
+        }
+        int nearest = visibility.FindNearestNode(state.position);
+        
+        std::vector<uint64_t> chunks;
+        visibility.GetVisibleChunks(nearest, index, chunks);
+        if (chunks == pImpl->visibleChunks) return;
+        
+        pImpl->visibleChunks.swap(chunks);
+        std::vector<long long> cells;
+        visibility.GetVisibleCells(pImpl->visibleChunks, cells);
+        pImpl->visibleFraction = static_cast<double>(cells.size()) /
+                                 static_cast<double>(visibility.GetTriangleCount());
+        pImpl->modelManager->SetEndoscopeVisibleCells(cells);
+    }
+    
+    void SceneManager::OnEndoscopeInteraction() {
+        if (!pImpl->visibilityCulling || pImpl->visibleChunks.empty()) return;
+        pImpl->ShowFullEndoscopeMesh();
+    }
+    
     void SceneManager::RequestRender() {
         if (pImpl->renderingEngine) {
             pImpl->renderingEngine->Render();
@@ -0,0 +1,106 @@
+#include "SectionTimer.h"
+
+// VTK headers
+#include <vtkOpenGLRenderTimer.h>
+#include <vtk_glew.h>
+
+// Standard headers
+#include <chrono>
+
+namespace BronchoscopyLib {
+
+    class SectionTimer::Impl {
+    public:
+        std::unique_ptr<vtkOpenGLRenderTimer> timer;
+        bool checked;          // 是否已检查计时器查询支持
+        bool gpuAvailable;
+        bool measuring;        // 本区段是否发出了查询
+        bool synchronousFallback;
+        bool newGpuResult;
+        double cpuMs;
+        double gpuMs;
+        std::chrono::steady_clock::time_point start;
+
+        Impl() : checked(false), gpuAvailable(false), measuring(false), synchronousFallback(false),
+                 newGpuResult(false), cpuMs(0.0), gpuMs(-1.0) {}
+
+        bool Synchronous() const {
+            return synchronousFallback && !gpuAvailable;
+        }
+    };
+
+    SectionTimer::SectionTimer() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    SectionTimer::~SectionTimer() = default;
+
+    void SectionTimer::SetSynchronousFallback(bool enable) {
+        pImpl->synchronousFallback = enable;
+    }
+
+    void SectionTimer::Begin() {
+        // 需要当前上下文才能检查，因此推迟到第一次Begin
+        if (!pImpl->checked) {
+            pImpl->gpuAvailable = vtkOpenGLRenderTimer::IsSupported();
+            if (pImpl->gpuAvailable) {
+                pImpl->timer.reset(new vtkOpenGLRenderTimer);
+            }
+            pImpl->checked = true;
+        }
+
+        pImpl->newGpuResult = false;
+        if (pImpl->timer) {
+            if (pImpl->timer->Ready()) {
+                pImpl->gpuMs = pImpl->timer->GetElapsedMilliseconds();
+                pImpl->newGpuResult = true;
+                pImpl->timer->Reset();
+            }
+            pImpl->measuring = !pImpl->timer->Started();
+            if (pImpl->measuring) {
+                pImpl->timer->Start();
+            }
+        }
+
+        if (pImpl->Synchronous()) {
+            glFinish();
+        }
+        pImpl->start = std::chrono::steady_clock::now();
+    }
+
+    void SectionTimer::End() {
+        if (pImpl->Synchronous()) {
+            glFinish();
+        }
+        pImpl->cpuMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - pImpl->start).count();
+
+        if (pImpl->measuring) {
+            pImpl->timer->Stop();
+            pImpl->measuring = false;
+        }
+    }
+
+    double SectionTimer::GetCpuMs() const {
+        return pImpl->cpuMs;
+    }
+
+    double SectionTimer::GetGpuMs() const {
+        return pImpl->gpuMs;
+    }
+
+    bool SectionTimer::HasNewGpuResult() const {
+        return pImpl->newGpuResult;
+    }
+
+    bool SectionTimer::IsGpuTimingAvailable() const {
+        return pImpl->gpuAvailable;
+    }
+
+    void SectionTimer::ReleaseGraphicsResources() {
+        if (pImpl->timer) {
+            pImpl->timer->ReleaseGraphicsResources();
+        }
+        pImpl->measuring = false;
+    }
+
+} // namespace BronchoscopyLib
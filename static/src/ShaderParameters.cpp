@@ -0,0 +1,135 @@
+#include "ShaderParameters.h"
+
+// VTK headers
+#include <vtkShaderProgram.h>
+
+// Standard headers
+#include <iostream>
+
+namespace BronchoscopyLib {
+
+    ShaderParameters::ShaderParameters() : version(0) {
+    }
+
+    void ShaderParameters::Set(const std::string& name, Type type,
+                               float x, float y, float z, float w) {
+        Value& value = values[name];
+        value.type = type;
+        value.values[0] = x;
+        value.values[1] = y;
+        value.values[2] = z;
+        value.values[3] = w;
+        value.intValue = 0;
+        version++;
+    }
+
+    void ShaderParameters::SetFloat(const std::string& name, float value) {
+        Set(name, FLOAT, value, 0.0f, 0.0f, 0.0f);
+    }
+
+    void ShaderParameters::SetVec2(const std::string& name, float x, float y) {
+        Set(name, VEC2, x, y, 0.0f, 0.0f);
+    }
+
+    void ShaderParameters::SetVec3(const std::string& name, float x, float y, float z) {
+        Set(name, VEC3, x, y, z, 0.0f);
+    }
+
+    void ShaderParameters::SetVec4(const std::string& name, float x, float y, float z, float w) {
+        Set(name, VEC4, x, y, z, w);
+    }
+
+    void ShaderParameters::SetInt(const std::string& name, int value) {
+        Set(name, INT, static_cast<float>(value), 0.0f, 0.0f, 0.0f);
+        values[name].intValue = value;
+    }
+
+    bool ShaderParameters::GetFloat(const std::string& name, float& value) const {
+        auto it = values.find(name);
+        if (it == values.end() || it->second.type != FLOAT) {
+            return false;
+        }
+        value = it->second.values[0];
+        return true;
+    }
+
+    bool ShaderParameters::GetInt(const std::string& name, int& value) const {
+        auto it = values.find(name);
+        if (it == values.end() || it->second.type != INT) {
+            return false;
+        }
+        value = it->second.intValue;
+        return true;
+    }
+
+    bool ShaderParameters::Get(const std::string& name, Type& type, float result[4]) const {
+        auto it = values.find(name);
+        if (it == values.end()) {
+            return false;
+        }
+        type = it->second.type;
+        for (int i = 0; i < 4; ++i) {
+            result[i] = it->second.values[i];
+        }
+        return true;
+    }
+
+    bool ShaderParameters::Has(const std::string& name) const {
+        return values.find(name) != values.end();
+    }
+
+    void ShaderParameters::Remove(const std::string& name) {
+        if (values.erase(name) > 0) {
+            version++;
+        }
+    }
+
+    void ShaderParameters::Clear() {
+        if (!values.empty()) {
+            values.clear();
+            version++;
+        }
+    }
+
+    size_t ShaderParameters::GetCount() const {
+        return values.size();
+    }
+
+    unsigned long ShaderParameters::GetVersion() const {
+        return version;
+    }
+
+    int ShaderParameters::Upload(vtkShaderProgram* program) const {
+        if (!program) {
+            return 0;
+        }
+
+        int uploaded = 0;
+        for (const auto& entry : values) {
+            const char* name = entry.first.c_str();
+
+            // 程序中没有（或被编译器优化掉）的uniform跳过，不同变体可共用一个参数块
+            if (!program->IsUniformUsed(name)) {
+                continue;
+            }
+
+            const Value& value = entry.second;
+            bool ok = false;
+            switch (value.type) {
+                case FLOAT: ok = program->SetUniformf(name, value.values[0]); break;
+                case VEC2:  ok = program->SetUniform2f(name, value.values); break;
+                case VEC3:  ok = program->SetUniform3f(name, value.values); break;
+                case VEC4:  ok = program->SetUniform4f(name, value.values); break;
+                case INT:   ok = program->SetUniformi(name, value.intValue); break;
+            }
+
+            if (ok) {
+                uploaded++;
+            } else {
+                std::cerr << "ShaderParameters: Failed to set uniform " << name << std::endl;
+            }
+        }
+        return uploaded;
+    }
+
+} // namespace BronchoscopyLib
@@ -0,0 +1,544 @@
+#include "ShaderRegistry.h"
+#include "ShaderBundle.h"
+
+// Standard headers
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 变体编号在进程内唯一：mapper切换到其他注册表后，旧编号不会被误认为同一变体
+        std::atomic<unsigned long> nextVariantId(1);
+
+        // 检查目录是否存在
+        bool DirectoryExists(const std::string& path) {
+            #ifdef _WIN32
+                DWORD attrib = GetFileAttributesA(path.c_str());
+                return (attrib != INVALID_FILE_ATTRIBUTES &&
+                       (attrib & FILE_ATTRIBUTE_DIRECTORY));
+            #else
+                struct stat info;
+                return (stat(path.c_str(), &info) == 0 &&
+                       (info.st_mode & S_IFDIR));
+            #endif
+        }
+
+        // 检查文件是否存在
+        bool FileExists(const std::string& path) {
+            #ifdef _WIN32
+                DWORD attrib = GetFileAttributesA(path.c_str());
+                return (attrib != INVALID_FILE_ATTRIBUTES &&
+                       !(attrib & FILE_ATTRIBUTE_DIRECTORY));
+            #else
+                struct stat info;
+                return (stat(path.c_str(), &info) == 0 &&
+                       (info.st_mode & S_IFREG));
+            #endif
+        }
+
+    } // namespace
+
+    class ShaderRegistry::Impl {
+    public:
+        // 保护以下全部成员：读取共享，修改独占
+        mutable std::shared_mutex mutex;
+
+        // Shader路径（磁盘覆盖目录，为空时只使用编译进库的shader）
+        std::string shaderRootPath;
+
+        // 编译进库的预解析替换表（路径 -> 文件）
+        std::map<std::string, const ShaderBundle::File*> embeddedFiles;
+
+        // 构建时合并好的变体（组成文件都没有磁盘覆盖时直接使用）
+        std::map<ShaderPermutations::Key, const ShaderBundle::Variant*> embeddedVariants;
+
+        // 覆盖目录中实际存在的文件（设置覆盖目录和热重载替换文件时更新）
+        // 只有这些文件从磁盘读取；其余文件和不含这些文件的变体仍使用编译进库的版本
+        std::set<std::string> overriddenFiles;
+
+        // 缓存的完整shader源码
+        std::map<std::string, std::string> shaderCache;
+
+        // 缓存的shader替换
+        FileReplacements replacementCache;
+
+        // 变体缓存：(view, material, features) -> 合并后的替换集合
+        std::map<ShaderPermutations::Key, std::shared_ptr<const Variant>> variantCache;
+
+        std::atomic<unsigned long> hits;
+        std::atomic<unsigned long> misses;
+
+        bool initialized;
+
+        Impl() : hits(0), misses(0), initialized(false) {}
+
+        // 获取默认shader（后备方案）
+        static std::string GetDefaultShader(const std::string& relativePath) {
+            if (relativePath.find(".vert") != std::string::npos) {
+                // 默认顶点着色器
+                return R"glsl(
+                    #version 120
+                    varying vec3 vertexVC;
+                    varying vec3 normalVC;
+
+                    void main() {
+                        gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+                        vertexVC = vec3(gl_ModelViewMatrix * gl_Vertex);
+                        normalVC = gl_NormalMatrix * gl_Normal;
+                        gl_FrontColor = gl_Color;
+                    }
+                )glsl";
+            } else {
+                // 默认片段着色器
+                return R"glsl(
+                    #version 120
+                    varying vec3 vertexVC;
+                    varying vec3 normalVC;
+
+                    void main() {
+                        vec3 lightDir = normalize(vec3(0.0, 0.0, 1.0));
+                        float diff = max(dot(normalize(normalVC), lightDir), 0.0);
+                        vec3 color = gl_Color.rgb * (0.3 + 0.7 * diff);
+                        gl_FragColor = vec4(color, gl_Color.a);
+                    }
+                )glsl";
+            }
+        }
+
+        // 文件是否从磁盘覆盖目录读取（库未嵌入shader时全部从磁盘读取）
+        bool IsOverridden(const std::string& relativePath) const {
+            if (shaderRootPath.empty()) return false;
+            return embeddedFiles.empty() || overriddenFiles.count(relativePath) > 0;
+        }
+
+        // 记录覆盖目录中存在的嵌入文件
+        void ScanOverriddenFiles() {
+            overriddenFiles.clear();
+            if (shaderRootPath.empty()) return;
+            for (const auto& file : embeddedFiles) {
+                if (FileExists(shaderRootPath + file.first)) {
+                    overriddenFiles.insert(file.first);
+                }
+            }
+        }
+
+        // 以下Locked函数要求调用者已持有独占锁
+
+        // 读取完整shader文件：磁盘覆盖优先，否则使用编译进库的原文
+        std::string LoadShaderFileLocked(const std::string& relativePath) {
+            auto it = shaderCache.find(relativePath);
+            if (it != shaderCache.end()) {
+                return it->second;
+            }
+
+            std::string content;
+            if (IsOverridden(relativePath)) {
+                std::string fullPath = shaderRootPath + relativePath;
+                std::ifstream file(fullPath);
+                if (file.is_open()) {
+                    content.assign((std::istreambuf_iterator<char>(file)),
+                                   std::istreambuf_iterator<char>());
+                } else if (embeddedFiles.find(relativePath) == embeddedFiles.end()) {
+                    std::cerr << "ShaderRegistry: Failed to load shader: " << fullPath << std::endl;
+                }
+            }
+
+            if (content.empty()) {
+                auto embeddedIt = embeddedFiles.find(relativePath);
+                if (embeddedIt == embeddedFiles.end() || !embeddedIt->second->source) {
+                    return GetDefaultShader(relativePath);
+                }
+                content = embeddedIt->second->source;
+            }
+
+            shaderCache[relativePath] = content;
+            return content;
+        }
+
+        // 获取某个shader文件的替换（首次使用时读取并缓存）
+        std::vector<Replacement> GetReplacementsLocked(const std::string& filepath) {
+            std::vector<Replacement> replacements;
+            if (filepath.empty()) return replacements;
+
+            auto cacheIt = replacementCache.find(filepath);
+            if (cacheIt != replacementCache.end()) {
+                replacements = cacheIt->second;
+            } else {
+                replacements = LoadReplacements(filepath);
+                replacementCache[filepath] = replacements;
+            }
+
+            for (auto& replacement : replacements) {
+                replacement.fragment = ShaderPermutations::IsFragmentFile(filepath);
+            }
+            return replacements;
+        }
+
+        // 获取变体的替换：组成文件都没有磁盘覆盖时直接取构建时合并好的变体，
+        // 否则按ShaderPermutations的规则用当前缓存的文件替换合并
+        // （运行时合并和校验只发生在覆盖了shader文件的开发场景）
+        std::shared_ptr<const Variant> ComposeVariantLocked(const ShaderSystem::ShaderConfig& config) {
+            if (config.view != ShaderSystem::VIEW_NONE &&
+                ShaderPermutations::GetViewFiles(config.view).empty()) {
+                std::cerr << "ShaderRegistry: No shader files for view type " << config.view << std::endl;
+                return nullptr;
+            }
+            if (config.material != ShaderSystem::MATERIAL_NONE &&
+                ShaderPermutations::GetMaterialFiles(config.material).empty()) {
+                std::cerr << "ShaderRegistry: No shader files for material type " << config.material << std::endl;
+                return nullptr;
+            }
+
+            ShaderPermutations::Key key = ShaderPermutations::MakeKey(config);
+
+            std::shared_ptr<Variant> variant = std::make_shared<Variant>();
+            variant->id = nextVariantId++;
+            variant->config = config;
+
+            auto embeddedIt = embeddedVariants.find(key);
+            bool prebuilt = embeddedIt != embeddedVariants.end();
+            if (prebuilt) {
+                const ShaderBundle::Variant* embedded = embeddedIt->second;
+                for (size_t i = 0; i < embedded->sourceCount; ++i) {
+                    if (IsOverridden(embedded->sources[i])) prebuilt = false;
+                }
+            }
+            if (prebuilt) {
+                const ShaderBundle::Variant* embedded = embeddedIt->second;
+                variant->replacements.resize(embedded->replacementCount);
+                for (size_t i = 0; i < embedded->replacementCount; ++i) {
+                    Replacement& replacement = variant->replacements[i];
+                    replacement.fragment = embedded->replacements[i].fragment;
+                    replacement.tag = embedded->replacements[i].tag;
+                    replacement.before = embedded->replacements[i].before;
+                    replacement.code = embedded->replacements[i].code;
+                }
+                variant->sources.assign(embedded->sources, embedded->sources + embedded->sourceCount);
+                return variant;
+            }
+
+            variant->replacements = ShaderPermutations::Compose(key,
+                [this](const std::string& path) { return GetReplacementsLocked(path); });
+            variant->sources = ShaderPermutations::GetSourceFiles(key);
+
+            // 磁盘上的shader未经构建时校验，在这里报告问题（仍然应用）
+            for (const auto& error : ShaderPermutations::Validate(key, variant->replacements)) {
+                std::cerr << "ShaderRegistry: Warning - " << error << std::endl;
+            }
+
+            return variant;
+        }
+
+        // 加载编译进库的替换表和变体表
+        void LoadEmbeddedFiles() {
+            embeddedFiles.clear();
+            embeddedVariants.clear();
+
+#ifdef BRONCHOSCOPY_EMBEDDED_SHADERS
+            size_t count = 0;
+            const ShaderBundle::File* files = ShaderBundle::GetFiles(count);
+            for (size_t i = 0; i < count; ++i) {
+                embeddedFiles[files[i].path] = &files[i];
+            }
+
+            const ShaderBundle::Variant* variants = ShaderBundle::GetVariants(count);
+            for (size_t i = 0; i < count; ++i) {
+                ShaderPermutations::Key key(variants[i].view, variants[i].material, variants[i].features);
+                embeddedVariants[key] = &variants[i];
+            }
+#endif
+        }
+
+        // 读取文件的替换：磁盘覆盖优先，否则使用编译进库的版本（只读访问成员）
+        std::vector<Replacement> LoadReplacements(const std::string& filepath) const {
+            std::vector<Replacement> replacements;
+            if (IsOverridden(filepath)) {
+                replacements = ParseShaderFile(shaderRootPath + filepath);
+            }
+            if (replacements.empty()) {
+                replacements = GetEmbeddedReplacements(filepath);
+            }
+            return replacements;
+        }
+
+        // 从编译进库的替换表获取替换（无需解析）
+        std::vector<Replacement> GetEmbeddedReplacements(const std::string& filepath) const {
+            std::vector<Replacement> replacements;
+
+            auto it = embeddedFiles.find(filepath);
+            if (it == embeddedFiles.end()) {
+                if (shaderRootPath.empty()) {
+                    std::cerr << "ShaderRegistry: No embedded shader: " << filepath << std::endl;
+                }
+                return replacements;
+            }
+
+            const ShaderBundle::File* file = it->second;
+            for (size_t i = 0; i < file->replacementCount; ++i) {
+                Replacement replacement;
+                replacement.tag = file->replacements[i].tag;
+                replacement.before = file->replacements[i].before;
+                replacement.code = file->replacements[i].code;
+                replacements.push_back(replacement);
+            }
+
+            return replacements;
+        }
+    };
+
+    ShaderRegistry::ShaderRegistry() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    ShaderRegistry::~ShaderRegistry() = default;
+
+    bool ShaderRegistry::Initialize() {
+        std::unique_lock<std::shared_mutex> lock(pImpl->mutex);
+        if (!pImpl->initialized) {
+            pImpl->LoadEmbeddedFiles();
+
+            // 没有编译进库的shader时才查找磁盘目录
+            if (pImpl->embeddedFiles.empty()) {
+                pImpl->shaderRootPath = FindShaderRoot();
+            } else {
+                pImpl->ScanOverriddenFiles();
+                std::cout << "ShaderRegistry: Using " << pImpl->embeddedFiles.size()
+                         << " embedded shader files and " << pImpl->embeddedVariants.size()
+                         << " prebuilt variants" << std::endl;
+            }
+
+            pImpl->initialized = true;
+        }
+
+        return !pImpl->embeddedFiles.empty() || !pImpl->shaderRootPath.empty();
+    }
+
+    bool ShaderRegistry::IsInitialized() const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+        return pImpl->initialized;
+    }
+
+    bool ShaderRegistry::HasEmbeddedShaders() const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+        return !pImpl->embeddedFiles.empty();
+    }
+
+    bool ShaderRegistry::SetOverridePath(const std::string& path) {
+        std::string root = path;
+        if (!root.empty() && root[root.size() - 1] != '/' && root[root.size() - 1] != '\\') {
+            root += "/";
+        }
+
+        if (!root.empty() && !DirectoryExists(root)) {
+            std::cerr << "ShaderRegistry: Shader override path not found: " << path << std::endl;
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(pImpl->mutex);
+        pImpl->shaderRootPath = root;
+        pImpl->ScanOverriddenFiles();
+        return true;
+    }
+
+    std::string ShaderRegistry::GetOverridePath() const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+        return pImpl->shaderRootPath;
+    }
+
+    std::string ShaderRegistry::FindShaderRoot() const {
+        std::vector<std::string> possiblePaths = {
+            "shaders/",
+            "../shaders/",
+            "../../shaders/",
+            "../../../shaders/"
+        };
+
+        for (const auto& path : possiblePaths) {
+            if (DirectoryExists(path)) {
+                std::cout << "ShaderRegistry: Found shaders at: " << path << std::endl;
+                return path;
+            }
+        }
+
+        std::cerr << "ShaderRegistry: Warning - Shaders folder not found, using default shaders" << std::endl;
+        return "";
+    }
+
+    std::shared_ptr<const ShaderRegistry::Variant> ShaderRegistry::GetVariant(
+        const ShaderSystem::ShaderConfig& config) {
+        ShaderPermutations::Key key = ShaderPermutations::MakeKey(config);
+
+        // 命中：共享锁，多个实例可并发读取
+        {
+            std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+            auto it = pImpl->variantCache.find(key);
+            if (it != pImpl->variantCache.end()) {
+                pImpl->hits++;
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(pImpl->mutex);
+
+        // 等待独占锁期间其他线程可能已合并
+        auto it = pImpl->variantCache.find(key);
+        if (it != pImpl->variantCache.end()) {
+            pImpl->hits++;
+            return it->second;
+        }
+
+        std::shared_ptr<const Variant> variant = pImpl->ComposeVariantLocked(config);
+        if (!variant) {
+            return nullptr;
+        }
+
+        pImpl->variantCache[key] = variant;
+        pImpl->misses++;
+
+        std::cout << "ShaderRegistry: Shader variant " << variant->id << " ("
+                 << ShaderPermutations::Describe(key) << ", "
+                 << variant->replacements.size() << " replacements)" << std::endl;
+
+        return variant;
+    }
+
+    std::shared_ptr<const ShaderRegistry::Variant> ShaderRegistry::FindVariant(
+        const ShaderSystem::ShaderConfig& config) const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+        auto it = pImpl->variantCache.find(ShaderPermutations::MakeKey(config));
+        return it != pImpl->variantCache.end() ? it->second : nullptr;
+    }
+
+    std::vector<ShaderRegistry::Replacement> ShaderRegistry::GetReplacements(const std::string& path) {
+        std::unique_lock<std::shared_mutex> lock(pImpl->mutex);
+        return pImpl->GetReplacementsLocked(path);
+    }
+
+    std::string ShaderRegistry::LoadShaderFile(const std::string& path) {
+        {
+            std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+            auto it = pImpl->shaderCache.find(path);
+            if (it != pImpl->shaderCache.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(pImpl->mutex);
+        return pImpl->LoadShaderFileLocked(path);
+    }
+
+    std::vector<std::string> ShaderRegistry::GetUsedFiles() const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+
+        std::set<std::string> files;
+        for (const auto& entry : pImpl->replacementCache) {
+            files.insert(entry.first);
+        }
+        for (const auto& entry : pImpl->variantCache) {
+            files.insert(entry.second->sources.begin(), entry.second->sources.end());
+        }
+        return std::vector<std::string>(files.begin(), files.end());
+    }
+
+    ShaderRegistry::FileReplacements ShaderRegistry::ReadFiles(const std::vector<std::string>& paths) const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+
+        FileReplacements files;
+        for (const auto& path : paths) {
+            files[path] = pImpl->LoadReplacements(path);
+        }
+        return files;
+    }
+
+    ShaderRegistry::FileReplacements ShaderRegistry::GetCachedFiles(const std::vector<std::string>& paths) const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+
+        FileReplacements files;
+        for (const auto& path : paths) {
+            auto it = pImpl->replacementCache.find(path);
+            if (it != pImpl->replacementCache.end()) {
+                files[path] = it->second;
+            }
+        }
+        return files;
+    }
+
+    std::map<unsigned long, std::shared_ptr<const ShaderRegistry::Variant>> ShaderRegistry::ReplaceFiles(
+        const FileReplacements& files) {
+        std::unique_lock<std::shared_mutex> lock(pImpl->mutex);
+
+        for (const auto& file : files) {
+            pImpl->replacementCache[file.first] = file.second;
+
+            // 热重载期间新建的覆盖文件
+            if (!pImpl->shaderRootPath.empty() && FileExists(pImpl->shaderRootPath + file.first)) {
+                pImpl->overriddenFiles.insert(file.first);
+            }
+        }
+
+        std::map<unsigned long, std::shared_ptr<const Variant>> replaced;
+        for (auto& entry : pImpl->variantCache) {
+            std::shared_ptr<const Variant> oldVariant = entry.second;
+
+            bool affected = false;
+            for (const auto& source : oldVariant->sources) {
+                if (files.count(source)) affected = true;
+            }
+            if (!affected) continue;
+
+            std::shared_ptr<const Variant> newVariant = pImpl->ComposeVariantLocked(oldVariant->config);
+            if (!newVariant) continue;
+
+            entry.second = newVariant;
+            replaced[oldVariant->id] = newVariant;
+        }
+
+        return replaced;
+    }
+
+    void ShaderRegistry::ClearSourceCache() {
+        std::unique_lock<std::shared_mutex> lock(pImpl->mutex);
+        pImpl->shaderCache.clear();
+    }
+
+    std::vector<ShaderRegistry::Replacement> ShaderRegistry::ParseShaderFile(const std::string& fullPath) {
+        std::vector<Replacement> replacements;
+
+        std::ifstream file(fullPath);
+
+        if (!file.is_open()) {
+            std::cerr << "ShaderRegistry: Failed to open shader file: " << fullPath << std::endl;
+            return replacements;
+        }
+
+        for (const auto& parsed : ShaderBundle::Parse(file)) {
+            Replacement replacement;
+            replacement.tag = parsed.tag;
+            replacement.before = parsed.before;
+            replacement.code = parsed.code;
+            replacements.push_back(replacement);
+        }
+
+        return replacements;
+    }
+
+    void ShaderRegistry::GetStats(unsigned long& hits, unsigned long& misses, size_t& variantCount) const {
+        std::shared_lock<std::shared_mutex> lock(pImpl->mutex);
+        hits = pImpl->hits;
+        misses = pImpl->misses;
+        variantCount = pImpl->variantCache.size();
+    }
+
+} // namespace BronchoscopyLib
@@ -1,237 +1,333 @@
 #include "ShaderSystem.h"
+#include "ShaderRegistry.h"
+#include "ShaderWatcher.h"
+#include "PostProcessor.h"
 
 // VTK headers
 #include <vtkActor.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkOutputWindow.h>
 #include <vtkOpenGLPolyDataMapper.h>
 #include <vtkRenderer.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
 #include <vtkShader.h>
+#include <vtkShaderProgram.h>
+#include <vtkWeakPointer.h>
+#include <vtk_glew.h>
 
 // Standard headers
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <map>
+#include <mutex>
 #include <vector>
 
-#ifdef _WIN32
-#include <windows.h>
-#include <direct.h>
-#else
-#include <unistd.h>
-#include <sys/stat.h>
-#endif
-
 namespace BronchoscopyLib {
     
-    // Shader替换结构
-    struct ShaderReplacement {
-        vtkShader::Type shaderType;
-        std::string tag;
-        bool before;
-        std::string code;
-    };
+    typedef ShaderRegistry::Replacement ShaderReplacement;
+    typedef ShaderRegistry::Variant ShaderVariant;
     
-    class ShaderSystem::Impl {
-    public:
-        // Shader路径
-        std::string shaderRootPath;
-        
-        // 缓存的shader源码
-        std::map<std::string, std::string> shaderCache;
+    namespace {
         
-        // 缓存的shader替换
-        std::map<std::string, std::vector<ShaderReplacement>> replacementCache;
+        vtkShader::Type GetShaderType(const ShaderReplacement& replacement) {
+            return replacement.fragment ? vtkShader::Fragment : vtkShader::Vertex;
+        }
         
-        // 是否已初始化
-        bool initialized;
+        // 捕获VTK输出窗口中的shader编译/链接错误
+        void OnVTKError(vtkObject*, unsigned long, void* clientData, void* callData) {
+            const char* text = static_cast<const char*>(callData);
+            if (text && std::string(text).find("Shader") != std::string::npos) {
+                static_cast<std::vector<std::string>*>(clientData)->push_back(text);
+            }
+        }
         
-        Impl() : initialized(false) {}
+    } // namespace
+    
+    class ShaderSystem::Impl {
+    public:
+        // 文件和变体缓存（可与其他实例共享）
+        std::shared_ptr<ShaderRegistry> registry;
+        
+        // 各mapper当前应用的变体（弱引用，mapper销毁后条目失效）
+        // 单独叠加材质shader时variantId为0
+        struct AppliedVariant {
+            vtkWeakPointer<vtkOpenGLPolyDataMapper> mapper;
+            unsigned long variantId;
+            std::shared_ptr<const ShaderVariant> variant;  // 热重载时据此清除旧变体的替换
+            MaterialShader material;
+            unsigned long observerTag;  // UpdateShaderEvent观察者，上传参数块
+        };
+        std::map<vtkOpenGLPolyDataMapper*, AppliedVariant> appliedVariants;
+        
+        unsigned long reusedMappers;
+        
+        // 运行时参数块
+        ShaderParameters frameParameters;
+        std::map<int, ShaderParameters> materialParameters;
+        
+        // 各shader程序最近一次上传时的状态，全部相同时跳过上传
+        struct UploadState {
+            unsigned long frame;
+            unsigned long frameVersion;
+            unsigned long materialVersion;
+            int material;
+            GLint viewport[4];
+        };
+        std::map<vtkShaderProgram*, UploadState> uploadStates;
+        unsigned long frameNumber;
+        
+        vtkSmartPointer<vtkCallbackCommand> parameterObserver;
+        vtkSmartPointer<vtkCallbackCommand> frameObserver;
+        std::map<vtkRenderer*, std::pair<vtkWeakPointer<vtkRenderer>, unsigned long>> frameRenderers;
+        
+        // 各渲染器的后处理通道链
+        std::map<vtkRenderer*, std::unique_ptr<PostProcessor>> postProcessors;
+        
+        // 热重载：监视线程解析好的文件，等待渲染线程应用
+        std::mutex reloadMutex;
+        ShaderRegistry::FileReplacements reloadedFiles;
+        
+        // 最近一次应用的重载：文件的上一个可用版本，编译失败时回滚
+        ShaderRegistry::FileReplacements lastGoodFiles;
+        bool verifyPending;
+        std::vector<std::string> shaderErrors;
+        vtkSmartPointer<vtkCallbackCommand> errorObserver;
+        unsigned long errorObserverTag;
+        
+        // 文件监视（最后声明、最先析构，回调访问的成员此时仍有效）
+        ShaderWatcher watcher;
+        
+        explicit Impl(std::shared_ptr<ShaderRegistry> sharedRegistry) 
+            : registry(sharedRegistry), reusedMappers(0), frameNumber(1), verifyPending(false), 
+              errorObserverTag(0) {
+            if (!registry) {
+                registry = std::make_shared<ShaderRegistry>();
+            }
+            
+            parameterObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+            parameterObserver->SetCallback(&Impl::OnUpdateShader);
+            parameterObserver->SetClientData(this);
+            
+            frameObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+            frameObserver->SetCallback(&Impl::OnRenderStart);
+            frameObserver->SetClientData(this);
+        }
         
-        // 查找shader根目录
-        std::string FindShaderRoot() {
-            std::vector<std::string> possiblePaths = {
-                "shaders/",
-                "../shaders/",
-                "../../shaders/",
-                "../../../shaders/"
-            };
+        ~Impl() {
+            watcher.Stop();
+            StopErrorCapture();
             
-            for (const auto& path : possiblePaths) {
-                if (DirectoryExists(path)) {
-                    std::cout << "ShaderSystem: Found shaders at: " << path << std::endl;
-                    return path;
+            // mapper和渲染器可能比ShaderSystem存活更久，移除指向本对象的观察者
+            for (auto& applied : appliedVariants) {
+                if (applied.second.mapper && applied.second.observerTag) {
+                    applied.second.mapper->RemoveObserver(applied.second.observerTag);
+                }
+            }
+            for (auto& entry : frameRenderers) {
+                if (entry.second.first) {
+                    entry.second.first->RemoveObserver(entry.second.second);
                 }
             }
+        }
+        
+        // 记录mapper当前的变体，首次记录时添加参数上传观察者
+        void RecordMapper(vtkOpenGLPolyDataMapper* mapper, 
+                          const std::shared_ptr<const ShaderVariant>& variant, 
+                          MaterialShader material) {
+            PruneAppliedVariants();
             
-            std::cerr << "ShaderSystem: Warning - Shaders folder not found, using default shaders" << std::endl;
-            return "";
-        }
-        
-        // 检查目录是否存在
-        bool DirectoryExists(const std::string& path) {
-            #ifdef _WIN32
-                DWORD attrib = GetFileAttributesA(path.c_str());
-                return (attrib != INVALID_FILE_ATTRIBUTES && 
-                       (attrib & FILE_ATTRIBUTE_DIRECTORY));
-            #else
-                struct stat info;
-                return (stat(path.c_str(), &info) == 0 && 
-                       (info.st_mode & S_IFDIR));
-            #endif
-        }
-        
-        // 读取shader文件
-        std::string LoadShaderFile(const std::string& relativePath) {
-            // 先检查缓存
-            auto it = shaderCache.find(relativePath);
-            if (it != shaderCache.end()) {
-                return it->second;
+            AppliedVariant& applied = appliedVariants[mapper];
+            if (applied.mapper != mapper) {
+                applied.mapper = mapper;
+                applied.observerTag = mapper->AddObserver(vtkCommand::UpdateShaderEvent, 
+                                                          parameterObserver);
             }
+            applied.variantId = variant ? variant->id : 0;
+            applied.variant = variant;
+            applied.material = material;
+        }
+        
+        // mapper设置完VTK自身的uniform后调用，callData为当前绑定的shader程序
+        static void OnUpdateShader(vtkObject* caller, unsigned long, void* clientData, void* callData) {
+            static_cast<Impl*>(clientData)->UploadParameters(
+                static_cast<vtkOpenGLPolyDataMapper*>(caller),
+                static_cast<vtkShaderProgram*>(callData));
+        }
+        
+        // 渲染器开始新的一帧
+        static void OnRenderStart(vtkObject*, unsigned long, void* clientData, void*) {
+            static_cast<Impl*>(clientData)->frameNumber++;
+        }
+        
+        // 上传参数块；同一程序在同一帧内参数和视口都未变化时跳过
+        // （uniform是程序对象的状态，共用程序的mapper不需要重复上传）
+        void UploadParameters(vtkOpenGLPolyDataMapper* mapper, vtkShaderProgram* program) {
+            if (!program) return;
             
-            if (shaderRootPath.empty()) {
-                return GetDefaultShader(relativePath);
+            MaterialShader material = MATERIAL_NONE;
+            auto appliedIt = appliedVariants.find(mapper);
+            if (appliedIt != appliedVariants.end()) {
+                material = appliedIt->second.material;
             }
+            const ShaderParameters& materialBlock = materialParameters[material];
             
-            std::string fullPath = shaderRootPath + relativePath;
-            std::ifstream file(fullPath);
+            // 后处理时场景渲染到离屏缓冲，实际视口以GL状态为准
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
             
-            if (!file.is_open()) {
-                std::cerr << "ShaderSystem: Failed to load shader: " << fullPath << std::endl;
-                return GetDefaultShader(relativePath);
+            auto stateIt = uploadStates.find(program);
+            if (stateIt != uploadStates.end()) {
+                const UploadState& state = stateIt->second;
+                if (state.frame == frameNumber &&
+                    state.frameVersion == frameParameters.GetVersion() &&
+                    state.materialVersion == materialBlock.GetVersion() &&
+                    state.material == material &&
+                    std::equal(viewport, viewport + 4, state.viewport)) {
+                    return;
+                }
+            } else if (uploadStates.size() >= 256) {
+                // 程序被VTK释放后指针可能复用，定期丢弃旧记录（只会导致多上传一次）
+                uploadStates.clear();
             }
             
-            std::string content((std::istreambuf_iterator<char>(file)),
-                               std::istreambuf_iterator<char>());
+            if (program->IsUniformUsed("viewport")) {
+                float viewportValue[4] = {
+                    static_cast<float>(viewport[0]), static_cast<float>(viewport[1]),
+                    static_cast<float>(viewport[2]), static_cast<float>(viewport[3])
+                };
+                program->SetUniform4f("viewport", viewportValue);
+            }
+            frameParameters.Upload(program);
+            materialBlock.Upload(program);
             
-            // 缓存shader
-            shaderCache[relativePath] = content;
+            UploadState& state = uploadStates[program];
+            state.frame = frameNumber;
+            state.frameVersion = frameParameters.GetVersion();
+            state.materialVersion = materialBlock.GetVersion();
+            state.material = material;
+            std::copy(viewport, viewport + 4, state.viewport);
+        }
+        
+        // 替换文件内容，由注册表重新组合使用这些文件的变体，并只更新本实例中使用这些变体的mapper
+        // 只清除旧变体添加的替换，mapper上的其他替换（如紧凑法线解码）保持不变
+        // 共享注册表的其他实例在下次应用shader时才使用新变体
+        // 返回更新的mapper数
+        int ReplaceFiles(const ShaderRegistry::FileReplacements& files) {
+            std::map<unsigned long, std::shared_ptr<const ShaderVariant>> replaced = 
+                registry->ReplaceFiles(files);
+            
+            PruneAppliedVariants();
             
-            return content;
-        }
-        
-        // 获取默认shader（后备方案）
-        std::string GetDefaultShader(const std::string& relativePath) {
-            if (relativePath.find(".vert") != std::string::npos) {
-                // 默认顶点着色器
-                return R"glsl(
-                    #version 120
-                    varying vec3 vertexVC;
-                    varying vec3 normalVC;
-                    
-                    void main() {
-                        gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
-                        vertexVC = vec3(gl_ModelViewMatrix * gl_Vertex);
-                        normalVC = gl_NormalMatrix * gl_Normal;
-                        gl_FrontColor = gl_Color;
-                    }
-                )glsl";
-            } else {
-                // 默认片段着色器
-                return R"glsl(
-                    #version 120
-                    varying vec3 vertexVC;
-                    varying vec3 normalVC;
-                    
-                    void main() {
-                        vec3 lightDir = normalize(vec3(0.0, 0.0, 1.0));
-                        float diff = max(dot(normalize(normalVC), lightDir), 0.0);
-                        vec3 color = gl_Color.rgb * (0.3 + 0.7 * diff);
-                        gl_FragColor = vec4(color, gl_Color.a);
-                    }
-                )glsl";
+            int updatedMappers = 0;
+            for (auto& applied : appliedVariants) {
+                auto replacedIt = replaced.find(applied.second.variantId);
+                if (replacedIt == replaced.end()) continue;
+                
+                std::shared_ptr<const ShaderVariant> oldVariant = applied.second.variant;
+                std::shared_ptr<const ShaderVariant> newVariant = replacedIt->second;
+                
+                vtkOpenGLPolyDataMapper* mapper = applied.second.mapper;
+                for (const auto& replacement : oldVariant->replacements) {
+                    mapper->ClearShaderReplacement(GetShaderType(replacement), 
+                                                   replacement.tag.c_str(), 
+                                                   replacement.before);
+                }
+                for (const auto& replacement : newVariant->replacements) {
+                    mapper->AddShaderReplacement(GetShaderType(replacement), 
+                                                 replacement.tag.c_str(),
+                                                 replacement.before, 
+                                                 replacement.code.c_str(), 
+                                                 false);
+                }
+                applied.second.variantId = newVariant->id;
+                applied.second.variant = newVariant;
+                updatedMappers++;
             }
+            
+            return updatedMappers;
         }
         
-        
-        // 获取视图shader路径（分别返回顶点和片段）
-        std::pair<std::string, std::string> GetViewShaderPaths(ViewShader view) {
-            switch (view) {
-                case VIEW_ENDOSCOPE: 
-                    return std::make_pair("view/endoscope.vert", "view/endoscope.frag");
-                case VIEW_OVERVIEW: 
-                    return std::make_pair("view/overview.vert", "view/overview.frag");
-                default: 
-                    return std::make_pair("", "");
+        // 在VTK输出窗口上监听错误，收集shader编译/链接失败信息
+        void StartErrorCapture() {
+            shaderErrors.clear();
+            if (errorObserverTag) return;
+            
+            if (!errorObserver) {
+                errorObserver = vtkSmartPointer<vtkCallbackCommand>::New();
+                errorObserver->SetCallback(OnVTKError);
+                errorObserver->SetClientData(&shaderErrors);
             }
+            errorObserverTag = vtkOutputWindow::GetInstance()->AddObserver(
+                vtkCommand::ErrorEvent, errorObserver);
         }
         
-        // 获取材质shader路径
-        std::pair<std::string, std::string> GetMaterialShaderPaths(MaterialShader material) {
-            switch (material) {
-                case MATERIAL_TISSUE:
-                    return std::make_pair("material/tissue.vert", "material/tissue.frag");
-                case MATERIAL_NONE:
-                default:
-                    return std::make_pair("", "");
+        void StopErrorCapture() {
+            if (errorObserverTag) {
+                vtkOutputWindow::GetInstance()->RemoveObserver(errorObserverTag);
+                errorObserverTag = 0;
             }
         }
         
-        // 解析shader替换文件
-        std::vector<ShaderReplacement> ParseShaderFile(const std::string& filepath) {
-            std::vector<ShaderReplacement> replacements;
-            
-            std::string fullPath = shaderRootPath + filepath;
-            std::ifstream file(fullPath);
-            
-            if (!file.is_open()) {
-                std::cerr << "ShaderSystem: Failed to open shader file: " << fullPath << std::endl;
-                return replacements;
-            }
-            
-            std::string line;
-            while (std::getline(file, line)) {
-                // 跳过空行和#注释
-                if (line.empty() || line[0] == '#') continue;
-                
-                // 检查是否为VTK替换标签
-                if (line.find("//VTK::") == 0) {
-                    ShaderReplacement replacement;
-                    
-                    // 查找空格分隔标签和BEFORE/AFTER
-                    size_t spacePos = line.find(' ');
-                    if (spacePos != std::string::npos) {
-                        replacement.tag = line.substr(0, spacePos);
-                        std::string timing = line.substr(spacePos + 1);
-                        replacement.before = (timing == "BEFORE");
-                        
-                        // 读取下一行（应该是相同的标签作为替换点）
-                        if (std::getline(file, line)) {
-                            // 继续读取shader代码直到END_REPLACEMENT
-                            std::string code = line + "\n";  // 包含标签行本身
-                            while (std::getline(file, line)) {
-                                if (line == "END_REPLACEMENT") break;
-                                code += line + "\n";
-                            }
-                            replacement.code = code;
-                            replacements.push_back(replacement);
-                        }
-                    }
+        // 清理已销毁mapper的记录
+        void PruneAppliedVariants() {
+            for (auto it = appliedVariants.begin(); it != appliedVariants.end(); ) {
+                if (!it->second.mapper) {
+                    it = appliedVariants.erase(it);
+                } else {
+                    ++it;
                 }
-                // 其他//开头的行视为普通注释，忽略
             }
-            
-            return replacements;
         }
+        
     };
     
-    ShaderSystem::ShaderSystem() : pImpl(std::make_unique<Impl>()) {
+    ShaderSystem::ShaderSystem(std::shared_ptr<ShaderRegistry> registry) 
+        : pImpl(std::make_unique<Impl>(registry)) {
     }
     
     ShaderSystem::~ShaderSystem() = default;
+
     
     bool ShaderSystem::Initialize() {
-        if (pImpl->initialized) {
-            return true;
+        return pImpl->registry->Initialize();
+    }
+    
+    std::shared_ptr<ShaderRegistry> ShaderSystem::GetRegistry() const {
+        return pImpl->registry;
+    }
+    
+    void ShaderSystem::SetRegistry(std::shared_ptr<ShaderRegistry> registry) {
+        if (!registry || registry == pImpl->registry) {
+            return;
         }
         
-        // 查找shader根目录
-        pImpl->shaderRootPath = pImpl->FindShaderRoot();
+        // 变体编号在进程内唯一，已应用的mapper会在下次ApplyShader时换用新注册表的变体
+        pImpl->registry = registry;
+    }
+    
+    bool ShaderSystem::SetShaderOverridePath(const std::string& path) {
+        Initialize();
         
-        pImpl->initialized = true;
+        if (!pImpl->registry->SetOverridePath(path)) {
+            return false;
+        }
+        
+        std::string root = pImpl->registry->GetOverridePath();
+        if (root.empty()) {
+            std::cout << "ShaderSystem: Shader override disabled" << std::endl;
+        } else {
+            std::cout << "ShaderSystem: Loading shaders from " << root 
+                     << " (embedded shaders used for missing files)" << std::endl;
+        }
         
-        return !pImpl->shaderRootPath.empty();
+        // 已使用的文件按新来源重新读取，并更新已应用的mapper
+        return ReloadAllShaders();
+    }
+    
+    bool ShaderSystem::HasEmbeddedShaders() const {
+        return pImpl->registry->HasEmbeddedShaders();
     }
     
     bool ShaderSystem::ApplyShader(vtkActor* actor, const ShaderConfig& config) {
@@ -263,82 +359,111 @@ namespace BronchoscopyLib {
             return false;
         }
         
-        if (!pImpl->initialized) {
-            Initialize();
+        Initialize();
+        
+        std::shared_ptr<const ShaderVariant> variant = pImpl->registry->GetVariant(config);
+        if (!variant) {
+            return false;
+        }
+        
+        // mapper已是该变体：不修改替换，VTK不会重建shader程序
+        auto appliedIt = pImpl->appliedVariants.find(mapper);
+        if (appliedIt != pImpl->appliedVariants.end() &&
+            appliedIt->second.mapper == mapper &&
+            appliedIt->second.variantId == variant->id) {
+            pImpl->reusedMappers++;
+            return true;
         }
         
         // 清除之前的shader替换
         mapper->ClearAllShaderReplacements();
         
-        // 获取shader文件路径（顶点和片段分开）
-        auto shaderPaths = pImpl->GetViewShaderPaths(config.view);
-        if (shaderPaths.first.empty() && config.view != VIEW_NONE) {
-            std::cerr << "ShaderSystem: No shader files for view type " << config.view << std::endl;
-            return false;
+        for (const auto& replacement : variant->replacements) {
+            mapper->AddShaderReplacement(
+                GetShaderType(replacement),
+                replacement.tag.c_str(),
+                replacement.before,
+                replacement.code.c_str(),
+                false
+            );
         }
         
-        int totalReplacements = 0;
+        pImpl->RecordMapper(mapper, variant, config.material);
         
-        // 加载顶点shader替换
-        if (!shaderPaths.first.empty()) {
-            std::vector<ShaderReplacement> vertReplacements;
-            auto cacheIt = pImpl->replacementCache.find(shaderPaths.first);
-            if (cacheIt != pImpl->replacementCache.end()) {
-                vertReplacements = cacheIt->second;
-            } else {
-                vertReplacements = pImpl->ParseShaderFile(shaderPaths.first);
-                if (!vertReplacements.empty()) {
-                    pImpl->replacementCache[shaderPaths.first] = vertReplacements;
-                }
-            }
-            
-            // 应用顶点shader替换
-            for (auto& replacement : vertReplacements) {
-                replacement.shaderType = vtkShader::Vertex;  // 设置为顶点shader
-                mapper->AddShaderReplacement(
-                    replacement.shaderType,
-                    replacement.tag.c_str(),
-                    replacement.before,
-                    replacement.code.c_str(),
-                    false
-                );
-                totalReplacements++;
-            }
+        if (!variant->replacements.empty()) {
+            std::cout << "ShaderSystem: Applied shader variant " << variant->id 
+                     << " (" << variant->replacements.size() << " replacements)" << std::endl;
         }
         
-        // 加载片段shader替换
-        if (!shaderPaths.second.empty()) {
-            std::vector<ShaderReplacement> fragReplacements;
-            auto cacheIt = pImpl->replacementCache.find(shaderPaths.second);
-            if (cacheIt != pImpl->replacementCache.end()) {
-                fragReplacements = cacheIt->second;
-            } else {
-                fragReplacements = pImpl->ParseShaderFile(shaderPaths.second);
-                if (!fragReplacements.empty()) {
-                    pImpl->replacementCache[shaderPaths.second] = fragReplacements;
-                }
-            }
-            
-            // 应用片段shader替换
-            for (auto& replacement : fragReplacements) {
-                replacement.shaderType = vtkShader::Fragment;  // 设置为片段shader
-                mapper->AddShaderReplacement(
-                    replacement.shaderType,
-                    replacement.tag.c_str(),
-                    replacement.before,
-                    replacement.code.c_str(),
-                    false
-                );
-                totalReplacements++;
-            }
+        return true;
+    }
+    
+    bool ShaderSystem::HasVariant(vtkOpenGLPolyDataMapper* mapper, const ShaderConfig& config) const {
+        if (!mapper) return false;
+        
+        std::shared_ptr<const ShaderVariant> variant = pImpl->registry->FindVariant(config);
+        if (!variant) return false;
+        
+        auto appliedIt = pImpl->appliedVariants.find(mapper);
+        return appliedIt != pImpl->appliedVariants.end() &&
+               appliedIt->second.mapper == mapper &&
+               appliedIt->second.variantId == variant->id;
+    }
+    
+    ShaderSystem::VariantCacheStats ShaderSystem::GetVariantCacheStats() const {
+        VariantCacheStats stats;
+        pImpl->registry->GetStats(stats.hits, stats.misses, stats.variantCount);
+        stats.reusedMappers = pImpl->reusedMappers;
+        return stats;
+    }
+    
+    std::string ShaderSystem::GetShaderLabel(vtkActor* actor) const {
+        vtkOpenGLPolyDataMapper* mapper = actor ? 
+            vtkOpenGLPolyDataMapper::SafeDownCast(actor->GetMapper()) : nullptr;
+        auto appliedIt = pImpl->appliedVariants.find(mapper);
+        if (!mapper || appliedIt == pImpl->appliedVariants.end() || appliedIt->second.mapper != mapper) {
+            return std::string();
         }
         
-        if (totalReplacements > 0) {
-            std::cout << "ShaderSystem: Applied " << totalReplacements 
-                     << " shader replacements for view type " << config.view << std::endl;
+        const Impl::AppliedVariant& applied = appliedIt->second;
+        if (applied.variant) {
+            return ShaderPermutations::GetLabel(ShaderPermutations::MakeKey(applied.variant->config));
         }
+        // 单独叠加的材质shader
+        ShaderConfig config;
+        config.material = applied.material;
+        return ShaderPermutations::GetLabel(ShaderPermutations::MakeKey(config));
+    }
+    
+    ShaderParameters& ShaderSystem::GetFrameParameters() {
+        return pImpl->frameParameters;
+    }
+    
+    ShaderParameters& ShaderSystem::GetMaterialParameters(MaterialShader material) {
+        return pImpl->materialParameters[material];
+    }
+    
+    void ShaderSystem::AttachRenderer(vtkRenderer* renderer) {
+        if (!renderer) return;
         
-        return true;
+        auto it = pImpl->frameRenderers.find(renderer);
+        if (it != pImpl->frameRenderers.end()) {
+            if (it->second.first == renderer) return;
+            pImpl->frameRenderers.erase(it);
+        }
+        
+        unsigned long tag = renderer->AddObserver(vtkCommand::StartEvent, pImpl->frameObserver);
+        pImpl->frameRenderers[renderer] = std::make_pair(vtkWeakPointer<vtkRenderer>(renderer), tag);
+    }
+    
+    void ShaderSystem::DetachRenderer(vtkRenderer* renderer) {
+        auto it = pImpl->frameRenderers.find(renderer);
+        if (it == pImpl->frameRenderers.end()) return;
+        
+        if (it->second.first) {
+            it->second.first->RemoveObserver(it->second.second);
+        }
+        pImpl->frameRenderers.erase(it);
     }
     
     bool ShaderSystem::ApplyMaterialShader(vtkActor* actor, MaterialShader material) {
@@ -370,73 +495,33 @@ namespace BronchoscopyLib {
             return false;
         }
         
-        if (!pImpl->initialized) {
-            Initialize();
-        }
+        Initialize();
         
         // 不清除之前的替换，因为材质和视图shader是叠加的
         // mapper->ClearAllShaderReplacements();
         
-        // 获取材质shader文件路径
-        auto shaderPaths = pImpl->GetMaterialShaderPaths(material);
-        if (shaderPaths.first.empty() && material != MATERIAL_NONE) {
-            std::cerr << "ShaderSystem: No shader files for material type " << material << std::endl;
+        // 只含该材质的变体：构建时已合并并校验，覆盖了材质文件时才在运行时合并
+        ShaderConfig materialConfig;
+        materialConfig.material = material;
+        std::shared_ptr<const ShaderVariant> variant = pImpl->registry->GetVariant(materialConfig);
+        if (!variant) {
             return false;
         }
         
         int totalReplacements = 0;
-        
-        // 加载顶点shader替换
-        if (!shaderPaths.first.empty()) {
-            std::vector<ShaderReplacement> vertReplacements;
-            auto cacheIt = pImpl->replacementCache.find(shaderPaths.first);
-            if (cacheIt != pImpl->replacementCache.end()) {
-                vertReplacements = cacheIt->second;
-            } else {
-                vertReplacements = pImpl->ParseShaderFile(shaderPaths.first);
-                if (!vertReplacements.empty()) {
-                    pImpl->replacementCache[shaderPaths.first] = vertReplacements;
-                }
-            }
-            
-            for (auto& replacement : vertReplacements) {
-                replacement.shaderType = vtkShader::Vertex;
-                mapper->AddShaderReplacement(
-                    replacement.shaderType,
-                    replacement.tag.c_str(),
-                    replacement.before,
-                    replacement.code.c_str(),
-                    false
-                );
-                totalReplacements++;
-            }
+        for (const auto& replacement : variant->replacements) {
+            mapper->AddShaderReplacement(
+                GetShaderType(replacement),
+                replacement.tag.c_str(),
+                replacement.before,
+                replacement.code.c_str(),
+                false
+            );
+            totalReplacements++;
         }
         
-        // 加载片段shader替换
-        if (!shaderPaths.second.empty()) {
-            std::vector<ShaderReplacement> fragReplacements;
-            auto cacheIt = pImpl->replacementCache.find(shaderPaths.second);
-            if (cacheIt != pImpl->replacementCache.end()) {
-                fragReplacements = cacheIt->second;
-            } else {
-                fragReplacements = pImpl->ParseShaderFile(shaderPaths.second);
-                if (!fragReplacements.empty()) {
-                    pImpl->replacementCache[shaderPaths.second] = fragReplacements;
-                }
-            }
-            
-            for (auto& replacement : fragReplacements) {
-                replacement.shaderType = vtkShader::Fragment;
-                mapper->AddShaderReplacement(
-                    replacement.shaderType,
-                    replacement.tag.c_str(),
-                    replacement.before,
-                    replacement.code.c_str(),
-                    false
-                );
-                totalReplacements++;
-            }
-        }
+        // 替换集合已不再是某个缓存的变体，但仍按该材质上传参数
+        pImpl->RecordMapper(mapper, nullptr, material);
         
         if (totalReplacements > 0) {
             std::cout << "ShaderSystem: Applied " << totalReplacements 
@@ -447,31 +532,199 @@ namespace BronchoscopyLib {
     }
     
     bool ShaderSystem::ApplyPostProcessing(vtkRenderer* renderer, PostShader postEffect) {
-        if (!renderer || postEffect == POST_NONE) {
+        if (!renderer) {
             return false;
         }
         
-        // TODO: 实现FXAA后处理
-        // VTK 8.2中需要使用vtkRenderPass系统
-        std::cout << "ShaderSystem: Post-processing not yet implemented" << std::endl;
+        Initialize();
         
-        return false;
+        // POST_NONE：移除后处理，恢复默认渲染流程
+        if (postEffect == POST_NONE) {
+            auto it = pImpl->postProcessors.find(renderer);
+            if (it != pImpl->postProcessors.end()) {
+                it->second->Detach();
+                pImpl->postProcessors.erase(it);
+                std::cout << "ShaderSystem: Post-processing removed" << std::endl;
+            }
+            return true;
+        }
+        
+        std::string passName;
+        std::string vertexPath;
+        std::string fragmentPath;
+        switch (postEffect) {
+            case POST_FXAA:
+                passName = "fxaa";
+                vertexPath = "post/fxaa.vert";
+                fragmentPath = "post/fxaa.frag";
+                break;
+            default:
+                std::cerr << "ShaderSystem: Unknown post effect " << postEffect << std::endl;
+                return false;
+        }
+        
+        std::unique_ptr<PostProcessor>& processor = pImpl->postProcessors[renderer];
+        if (!processor) {
+            processor = std::make_unique<PostProcessor>();
+        }
+        
+        // 完整程序的源码：覆盖目录中没有该文件时直接使用编译进库的原文，不访问磁盘
+        if (!processor->HasPass(passName)) {
+            std::string vertexSource = pImpl->registry->LoadShaderFile(vertexPath);
+            std::string fragmentSource = pImpl->registry->LoadShaderFile(fragmentPath);
+            if (!processor->AddPass(passName, vertexSource, fragmentSource)) {
+                return false;
+            }
+        }
+        
+        if (!processor->IsAttached() && !processor->Attach(renderer)) {
+            pImpl->postProcessors.erase(renderer);
+            return false;
+        }
+        
+        std::cout << "ShaderSystem: Post-processing pass " << passName << " enabled" << std::endl;
+        return true;
+    }
+    
+    std::vector<PostProcessor::PassTiming> ShaderSystem::GetPostProcessingTimings(vtkRenderer* renderer) const {
+        auto it = pImpl->postProcessors.find(renderer);
+        if (it == pImpl->postProcessors.end()) {
+            return std::vector<PostProcessor::PassTiming>();
+        }
+        return it->second->GetTimings();
     }
     
     bool ShaderSystem::ReloadAllShaders() {
         // 清空缓存
-        pImpl->shaderCache.clear();
+        pImpl->registry->ClearSourceCache();
+        
+        // 重新读取已使用的文件（包括构建时合并好的变体的组成文件），
+        // 重新组合变体并更新使用它们的mapper
+        std::vector<std::string> usedFiles = pImpl->registry->GetUsedFiles();
+        ShaderRegistry::FileReplacements files = pImpl->registry->ReadFiles(usedFiles);
+        
+        pImpl->lastGoodFiles = pImpl->registry->GetCachedFiles(usedFiles);
+        int updatedMappers = pImpl->ReplaceFiles(files);
+        if (updatedMappers > 0) {
+            pImpl->verifyPending = true;
+            pImpl->StartErrorCapture();
+        }
         
-        std::cout << "ShaderSystem: All shaders reloaded" << std::endl;
+        std::cout << "ShaderSystem: All shaders reloaded (" << files.size() << " files, " 
+                 << updatedMappers << " mappers updated)" << std::endl;
         return true;
     }
     
+    bool ShaderSystem::StartHotReload(const std::string& directory) {
+        Initialize();
+        
+        // 监视磁盘覆盖目录；未指定时查找shaders目录
+        std::string currentRoot = pImpl->registry->GetOverridePath();
+        std::string root = directory;
+        if (root.empty()) {
+            root = currentRoot.empty() ? pImpl->registry->FindShaderRoot() : currentRoot;
+        }
+        if (root.empty()) {
+            std::cerr << "ShaderSystem: No shader directory to watch" << std::endl;
+            return false;
+        }
+        if (root != currentRoot && !SetShaderOverridePath(root)) {
+            return false;
+        }
+        
+        // 监视线程上防抖后只重新解析变化的文件，结果交给渲染线程应用
+        Impl* impl = pImpl.get();
+        std::string watchRoot = pImpl->registry->GetOverridePath();
+        return pImpl->watcher.Start(watchRoot, [impl, watchRoot](const std::string& relativePath) {
+            std::vector<ShaderReplacement> replacements = 
+                ShaderRegistry::ParseShaderFile(watchRoot + relativePath);
+            if (replacements.empty()) {
+                std::cerr << "ShaderSystem: No replacements in " << relativePath 
+                         << ", keeping previous version" << std::endl;
+                return;
+            }
+            
+            std::lock_guard<std::mutex> lock(impl->reloadMutex);
+            impl->reloadedFiles[relativePath] = replacements;
+        });
+    }
+    
+    void ShaderSystem::StopHotReload() {
+        pImpl->watcher.Stop();
+        
+        std::lock_guard<std::mutex> lock(pImpl->reloadMutex);
+        pImpl->reloadedFiles.clear();
+    }
+    
+    bool ShaderSystem::IsHotReloadActive() const {
+        return pImpl->watcher.IsRunning();
+    }
+    
+    int ShaderSystem::ApplyPendingReloads() {
+        ShaderRegistry::FileReplacements files;
+        {
+            std::lock_guard<std::mutex> lock(pImpl->reloadMutex);
+            files.swap(pImpl->reloadedFiles);
+        }
+        if (files.empty()) {
+            return 0;
+        }
+        
+        // 上一次的重载尚未验证时视为成功
+        pImpl->StopErrorCapture();
+        pImpl->verifyPending = false;
+        
+        // 记录上一个可用版本（只记录本次变化的文件）
+        std::vector<std::string> changedFiles;
+        for (const auto& file : files) {
+            changedFiles.push_back(file.first);
+        }
+        pImpl->lastGoodFiles = pImpl->registry->GetCachedFiles(changedFiles);
+        
+        int updatedMappers = pImpl->ReplaceFiles(files);
+        for (const auto& file : files) {
+            std::cout << "ShaderSystem: Reloaded " << file.first << std::endl;
+        }
+        
+        if (updatedMappers > 0) {
+            pImpl->verifyPending = true;
+            pImpl->StartErrorCapture();
+        }
+        return updatedMappers;
+    }
+    
+    bool ShaderSystem::VerifyReload() {
+        if (!pImpl->verifyPending) {
+            return true;
+        }
+        
+        pImpl->verifyPending = false;
+        pImpl->StopErrorCapture();
+        
+        if (pImpl->shaderErrors.empty()) {
+            pImpl->lastGoodFiles.clear();
+            return true;
+        }
+        
+        // 编译失败：恢复上一个可用版本（VTK的shader缓存中仍有对应程序，无需重新编译）
+        std::cerr << "ShaderSystem: Reloaded shader failed to compile, keeping last good version" << std::endl;
+        for (const auto& error : pImpl->shaderErrors) {
+            std::cerr << error << std::endl;
+        }
+        pImpl->shaderErrors.clear();
+        
+        ShaderRegistry::FileReplacements lastGood;
+        lastGood.swap(pImpl->lastGoodFiles);
+        pImpl->ReplaceFiles(lastGood);
+        return false;
+    }
+    
     bool ShaderSystem::IsInitialized() const {
-        return pImpl->initialized;
+        return pImpl->registry->IsInitialized();
     }
     
     std::string ShaderSystem::GetShaderRootPath() const {
-        return pImpl->shaderRootPath;
+        return pImpl->registry->GetOverridePath();
     }
     
 } // namespace BronchoscopyLib
\ No newline at end of file
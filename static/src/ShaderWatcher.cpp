@@ -0,0 +1,233 @@
+#include "ShaderWatcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 只关心shader源文件
+        bool IsShaderFile(const std::string& name) {
+            auto endsWith = [&name](const char* suffix) {
+                std::string s(suffix);
+                return name.size() >= s.size() &&
+                       name.compare(name.size() - s.size(), s.size(), s) == 0;
+            };
+            return endsWith(".vert") || endsWith(".frag");
+        }
+
+    } // namespace
+
+    class ShaderWatcher::Impl {
+    public:
+        std::string rootPath;
+        ChangeCallback callback;
+        std::chrono::milliseconds debounce;
+
+        std::thread thread;
+        std::atomic<bool> running;
+
+#ifdef __linux__
+        int inotifyFd;
+        int wakePipe[2];                        // Stop时写入，唤醒阻塞的poll
+        std::map<int, std::string> watchDirs;   // watch描述符 -> 相对目录（以/结尾或为空）
+
+        Impl() : debounce(150), running(false), inotifyFd(-1) {
+            wakePipe[0] = wakePipe[1] = -1;
+        }
+
+        // 监视目录及其全部子目录（inotify本身不递归）
+        void AddWatches(const std::string& relativeDir) {
+            std::string fullDir = rootPath + relativeDir;
+            int wd = inotify_add_watch(inotifyFd, fullDir.c_str(),
+                                       IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (wd < 0) {
+                std::cerr << "ShaderWatcher: Failed to watch " << fullDir << std::endl;
+                return;
+            }
+            watchDirs[wd] = relativeDir;
+
+            DIR* dir = opendir(fullDir.c_str());
+            if (!dir) return;
+
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name == "." || name == "..") continue;
+                if (entry->d_type == DT_DIR) {
+                    AddWatches(relativeDir + name + "/");
+                }
+            }
+            closedir(dir);
+        }
+
+        void WatchLoop() {
+            // 等待防抖的文件 -> 最后一次事件时间
+            std::map<std::string, std::chrono::steady_clock::time_point> pending;
+            alignas(inotify_event) char buffer[4096];
+
+            while (running) {
+                int timeoutMs = -1;
+                if (!pending.empty()) {
+                    auto now = std::chrono::steady_clock::now();
+                    auto earliest = pending.begin()->second;
+                    for (const auto& entry : pending) {
+                        if (entry.second < earliest) earliest = entry.second;
+                    }
+                    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        earliest + debounce - now).count();
+                    timeoutMs = remaining > 0 ? static_cast<int>(remaining) : 0;
+                }
+
+                pollfd fds[2];
+                fds[0].fd = inotifyFd;
+                fds[0].events = POLLIN;
+                fds[1].fd = wakePipe[0];
+                fds[1].events = POLLIN;
+
+                int ready = poll(fds, 2, timeoutMs);
+                if (!running) break;
+
+                if (ready > 0 && (fds[0].revents & POLLIN)) {
+                    ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+                    auto now = std::chrono::steady_clock::now();
+
+                    for (ssize_t offset = 0; offset < length; ) {
+                        const inotify_event* event =
+                            reinterpret_cast<const inotify_event*>(buffer + offset);
+                        offset += sizeof(inotify_event) + event->len;
+
+                        if (event->len == 0) continue;
+                        auto dirIt = watchDirs.find(event->wd);
+                        if (dirIt == watchDirs.end()) continue;
+
+                        std::string relativePath = dirIt->second + event->name;
+                        if (event->mask & IN_ISDIR) {
+                            // 新建的子目录也纳入监视
+                            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                                AddWatches(relativePath + "/");
+                            }
+                        } else if (IsShaderFile(event->name)) {
+                            pending[relativePath] = now;
+                        }
+                    }
+                }
+
+                // 静默超过防抖时间的文件才回调
+                auto now = std::chrono::steady_clock::now();
+                for (auto it = pending.begin(); it != pending.end(); ) {
+                    if (now - it->second >= debounce) {
+                        std::string relativePath = it->first;
+                        it = pending.erase(it);
+                        callback(relativePath);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+
+        bool StartWatching() {
+            inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+            if (inotifyFd < 0) {
+                std::cerr << "ShaderWatcher: inotify_init failed" << std::endl;
+                return false;
+            }
+            if (pipe(wakePipe) != 0) {
+                std::cerr << "ShaderWatcher: Failed to create wake pipe" << std::endl;
+                close(inotifyFd);
+                inotifyFd = -1;
+                return false;
+            }
+
+            AddWatches("");
+            if (watchDirs.empty()) {
+                StopWatching();
+                return false;
+            }
+
+            running = true;
+            thread = std::thread(&Impl::WatchLoop, this);
+            return true;
+        }
+
+        void StopWatching() {
+            running = false;
+            if (wakePipe[1] >= 0) {
+                char wake = 1;
+                ssize_t ignored = write(wakePipe[1], &wake, 1);
+                (void)ignored;
+            }
+            if (thread.joinable()) {
+                thread.join();
+            }
+
+            if (inotifyFd >= 0) close(inotifyFd);
+            if (wakePipe[0] >= 0) close(wakePipe[0]);
+            if (wakePipe[1] >= 0) close(wakePipe[1]);
+            inotifyFd = -1;
+            wakePipe[0] = wakePipe[1] = -1;
+            watchDirs.clear();
+        }
+#else
+        Impl() : debounce(150), running(false) {}
+
+        bool StartWatching() {
+            std::cerr << "ShaderWatcher: File watching is only supported on Linux" << std::endl;
+            return false;
+        }
+
+        void StopWatching() {
+            running = false;
+        }
+#endif
+    };
+
+    ShaderWatcher::ShaderWatcher() : pImpl(std::make_unique<Impl>()) {
+    }
+
+    ShaderWatcher::~ShaderWatcher() {
+        Stop();
+    }
+
+    bool ShaderWatcher::Start(const std::string& rootPath, ChangeCallback callback, int debounceMs) {
+        Stop();
+
+        if (rootPath.empty() || !callback) {
+            return false;
+        }
+
+        pImpl->rootPath = rootPath;
+        if (pImpl->rootPath[pImpl->rootPath.size() - 1] != '/') {
+            pImpl->rootPath += "/";
+        }
+        pImpl->callback = callback;
+        pImpl->debounce = std::chrono::milliseconds(debounceMs > 0 ? debounceMs : 0);
+
+        if (!pImpl->StartWatching()) {
+            return false;
+        }
+
+        std::cout << "ShaderWatcher: Watching " << pImpl->rootPath << std::endl;
+        return true;
+    }
+
+    void ShaderWatcher::Stop() {
+        pImpl->StopWatching();
+    }
+
+    bool ShaderWatcher::IsRunning() const {
+        return pImpl->running;
+    }
+
+} // namespace BronchoscopyLib
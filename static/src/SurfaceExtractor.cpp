@@ -0,0 +1,595 @@
+#include "SurfaceExtractor.h"
+#include "ThreadPool.h"
+
+// VTK头文件
+#include <vtkSmartPointer.h>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkFloatArray.h>
+#include <vtkQuadricDecimation.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace BronchoscopyLib {
+
+    namespace {
+
+        // 0/1场的等值面
+        const float IsoValue = 0.5f;
+
+        // 交点与边端点的最小距离（边长的比例）
+        const float CornerOffset = 1e-3f;
+
+        // Taubin平滑的收缩/膨胀系数（通带约0.1）
+        const double TaubinLambda = 0.5;
+        const double TaubinMu = -0.53;
+
+        // 立方体角点i的偏移为(i&1, (i>>1)&1, (i>>2)&1)，边连接只差一位的两个角点（a为低位角点）
+        struct CubeEdge {
+            int a, b;
+            int axis;
+        };
+
+        // 移动立方体的三角形表：按8个角点是否在标签内（第i位对应角点i）索引
+        struct CaseTable {
+            CubeEdge edges[12];
+            std::vector<unsigned char> triangles[256];  // 每3个边编号一个三角形
+
+            // 三角化一个交点环，弦的两端不位于同一个面上：
+            // 这样的弦只属于本立方体，相邻立方体不会生成同一条弦，每条网格边恰属于两个三角形
+            // （简单扇形三角化在歧义面上会与相邻立方体生成同一条弦，产生非流形边）
+            // 子多边形i..j可三角化当且仅当弦(i, j)允许且存在k使i..k和k..j可三角化；对全部256种情况都有解
+            static bool Triangulate(const std::vector<int>& loop, const unsigned faceMasks[12],
+                                    std::vector<unsigned char>& triangles) {
+                const int n = static_cast<int>(loop.size());
+                std::vector<int> split(static_cast<size_t>(n) * n, -1);
+                for (int length = 2; length < n; length++) {
+                    for (int i = 0; i + length < n; i++) {
+                        int j = i + length;
+                        bool side = (i == 0 && j == n - 1);
+                        if (!side && (faceMasks[loop[i]] & faceMasks[loop[j]])) continue;
+                        for (int k = i + 1; k < j; k++) {
+                            if ((k == i + 1 || split[i * n + k] >= 0) && (k + 1 == j || split[k * n + j] >= 0)) {
+                                split[i * n + j] = k;
+                                break;
+                            }
+                        }
+                    }
+                }
+                if (n > 2 && split[n - 1] < 0) return false;
+
+                // 按环的方向输出（i < k < j），法线方向不变
+                std::vector<std::pair<int, int>> stack(1, std::make_pair(0, n - 1));
+                while (!stack.empty()) {
+                    int i = stack.back().first, j = stack.back().second;
+                    stack.pop_back();
+                    if (j - i < 2) continue;
+                    int k = split[i * n + j];
+                    triangles.push_back(static_cast<unsigned char>(loop[i]));
+                    triangles.push_back(static_cast<unsigned char>(loop[k]));
+                    triangles.push_back(static_cast<unsigned char>(loop[j]));
+                    stack.push_back(std::make_pair(i, k));
+                    stack.push_back(std::make_pair(k, j));
+                }
+                return true;
+            }
+
+            CaseTable() {
+                int count = 0;
+                for (int a = 0; a < 8; a++) {
+                    for (int b = a + 1; b < 8; b++) {
+                        int d = a ^ b;
+                        if (d == 1 || d == 2 || d == 4) {
+                            edges[count++] = { a, b, d == 1 ? 0 : (d == 2 ? 1 : 2) };
+                        }
+                    }
+                }
+
+                int edgeOf[8][8];
+                for (int e = 0; e < 12; e++) {
+                    edgeOf[edges[e].a][edges[e].b] = edgeOf[edges[e].b][edges[e].a] = e;
+                }
+
+                // 6个面的角点，从立方体外看逆时针
+                int faces[6][4];
+                for (int axis = 0; axis < 3; axis++) {
+                    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+                    for (int side = 0; side < 2; side++) {
+                        int* face = faces[axis * 2 + side];
+                        const int uv[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+                        for (int k = 0; k < 4; k++) {
+                            face[k] = (side << axis) | (uv[k][0] << u) | (uv[k][1] << v);
+                        }
+                        // (u, v)顺序的法线为+axis，负侧的面反向
+                        if (side == 0) {
+                            std::swap(face[1], face[3]);
+                        }
+                    }
+                }
+
+                // 各边所在的两个面
+                unsigned faceMasks[12] = { 0 };
+                for (int f = 0; f < 6; f++) {
+                    for (int k = 0; k < 4; k++) {
+                        faceMasks[edgeOf[faces[f][k]][faces[f][(k + 1) % 4]]] |= 1u << f;
+                    }
+                }
+
+                for (int config = 0; config < 256; config++) {
+                    // 每个面上从进入标签的边连到离开标签的边；同一条边在相邻两个面上方向相反，
+                    // 因此每个交点恰有一个后继，连成闭合环；歧义面上每个标签角点单独切开
+                    int next[12];
+                    std::fill(next, next + 12, -1);
+                    for (const int* face : faces) {
+                        bool inside[4];
+                        for (int k = 0; k < 4; k++) {
+                            inside[k] = ((config >> face[k]) & 1) != 0;
+                        }
+                        for (int k = 0; k < 4; k++) {
+                            if (inside[k] || !inside[(k + 1) % 4]) continue;
+                            for (int j = 1; j < 4; j++) {
+                                int m = (k + j) % 4;
+                                if (inside[m] && !inside[(m + 1) % 4]) {
+                                    next[edgeOf[face[k]][face[(k + 1) % 4]]] = edgeOf[face[m]][face[(m + 1) % 4]];
+                                    break;
+                                }
+                            }
+                        }
+                    }
+
+                    // 逐个环三角化；环的方向使法线指向标签外
+                    bool used[12] = { false };
+                    for (int e = 0; e < 12; e++) {
+                        if (next[e] < 0 || used[e]) continue;
+                        std::vector<int> loop;
+                        for (int cur = e; !used[cur]; cur = next[cur]) {
+                            used[cur] = true;
+                            loop.push_back(cur);
+                        }
+                        if (!Triangulate(loop, faceMasks, triangles[config])) {
+                            std::cerr << "SurfaceExtractor: No manifold triangulation for case " << config << std::endl;
+                        }
+                    }
+                }
+            }
+        };
+
+        const CaseTable& GetCaseTable() {
+            static const CaseTable table;
+            return table;
+        }
+
+        inline bool IsLabel(double value, double label) {
+            return label == 0.0 ? value != 0.0 : value == label;
+        }
+
+        // 各z层中标签体素的xy范围（无标签时box[0] > box[1]）
+        template <typename T>
+        void ScanLabels(const T* data, int components, const int dims[3], double label,
+                        const std::function<void(size_t, size_t, const std::function<void(size_t, size_t)>&)>& parallelFor,
+                        std::vector<int>& boxes) {
+            boxes.assign(static_cast<size_t>(dims[2]) * 4, 0);
+            parallelFor(dims[2], 1, [&](size_t begin, size_t end) {
+                for (size_t z = begin; z < end; z++) {
+                    int* box = &boxes[z * 4];
+                    box[0] = box[2] = INT_MAX;
+                    box[1] = box[3] = INT_MIN;
+                    const T* slice = data + z * static_cast<size_t>(dims[0]) * dims[1] * components;
+                    for (int y = 0; y < dims[1]; y++) {
+                        const T* row = slice + static_cast<size_t>(y) * dims[0] * components;
+                        for (int x = 0; x < dims[0]; x++) {
+                            if (IsLabel(static_cast<double>(row[static_cast<size_t>(x) * components]), label)) {
+                                box[0] = std::min(box[0], x);
+                                box[1] = std::max(box[1], x);
+                                box[2] = std::min(box[2], y);
+                                box[3] = std::max(box[3], y);
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        // 裁剪后的0/1场；grid之外（体数据边界之外）为0
+        template <typename T>
+        void FillField(const T* data, int components, const int dims[3], double label,
+                       const int start[3], const int grid[3],
+                       const std::function<void(size_t, size_t, const std::function<void(size_t, size_t)>&)>& parallelFor,
+                       std::vector<float>& field) {
+            field.assign(static_cast<size_t>(grid[0]) * grid[1] * grid[2], 0.0f);
+            parallelFor(grid[2], 1, [&](size_t begin, size_t end) {
+                for (size_t gz = begin; gz < end; gz++) {
+                    int z = start[2] + static_cast<int>(gz);
+                    if (z < 0 || z >= dims[2]) continue;
+                    for (int gy = 0; gy < grid[1]; gy++) {
+                        int y = start[1] + gy;
+                        if (y < 0 || y >= dims[1]) continue;
+                        const T* row = data + (static_cast<size_t>(z) * dims[1] + y) * dims[0] * components;
+                        float* out = &field[(gz * grid[1] + gy) * grid[0]];
+                        int x0 = std::max(0, start[0]), x1 = std::min(dims[0], start[0] + grid[0]);
+                        for (int x = x0; x < x1; x++) {
+                            out[x - start[0]] = IsLabel(static_cast<double>(row[static_cast<size_t>(x) * components]), label) ? 1.0f : 0.0f;
+                        }
+                    }
+                }
+            });
+        }
+
+    } // namespace
+
+    bool SurfaceExtractor::Extract(vtkImageData* volume, const Settings& settings, vtkPolyData* output,
+                                   ThreadPool* pool, const std::atomic<bool>* cancelFlag) {
+        if (!volume || !output || !volume->GetScalarPointer()) {
+            std::cerr << "SurfaceExtractor: Volume has no scalars" << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto parallelFor = [pool](size_t count, size_t grain,
+                                  const std::function<void(size_t, size_t)>& body) {
+            if (pool) {
+                pool->ParallelFor(count, grain, body);
+            } else {
+                body(0, count);
+            }
+        };
+        auto cancelled = [cancelFlag]() {
+            return cancelFlag && cancelFlag->load();
+        };
+
+        int dims[3];
+        volume->GetDimensions(dims);
+        double spacing[3], origin[3];
+        volume->GetSpacing(spacing);
+        volume->GetOrigin(origin);
+        const int components = volume->GetNumberOfScalarComponents();
+        const void* scalars = volume->GetScalarPointer();
+        const double label = settings.label;
+
+        // 1. 标签的包围盒
+        std::vector<int> boxes;
+        switch (volume->GetScalarType()) {
+            vtkTemplateMacro(ScanLabels(static_cast<const VTK_TT*>(scalars), components, dims, label,
+                                        parallelFor, boxes));
+            default:
+                std::cerr << "SurfaceExtractor: Unsupported scalar type" << std::endl;
+                return false;
+        }
+
+        int lo[3] = { INT_MAX, INT_MAX, INT_MAX }, hi[3] = { INT_MIN, INT_MIN, INT_MIN };
+        for (int z = 0; z < dims[2]; z++) {
+            const int* box = &boxes[static_cast<size_t>(z) * 4];
+            if (box[0] > box[1]) continue;
+            lo[0] = std::min(lo[0], box[0]);
+            hi[0] = std::max(hi[0], box[1]);
+            lo[1] = std::min(lo[1], box[2]);
+            hi[1] = std::max(hi[1], box[3]);
+            lo[2] = std::min(lo[2], z);
+            hi[2] = z;
+        }
+        if (lo[2] > hi[2]) {
+            std::cerr << "SurfaceExtractor: No voxels with label " << settings.label << std::endl;
+            return false;
+        }
+
+        // 2. 裁剪（四周留出平滑核半径加一层0，表面在体数据边界处封口）并转为0/1场
+        std::vector<float> kernel;
+        if (settings.gaussianSigma > 0.0) {
+            int radius = static_cast<int>(std::ceil(3.0 * settings.gaussianSigma));
+            double sum = 0.0;
+            for (int k = -radius; k <= radius; k++) {
+                kernel.push_back(static_cast<float>(std::exp(-0.5 * k * k / (settings.gaussianSigma * settings.gaussianSigma))));
+                sum += kernel.back();
+            }
+            for (float& w : kernel) {
+                w = static_cast<float>(w / sum);
+            }
+        }
+        const int margin = static_cast<int>(kernel.size() / 2) + 1;
+        int first[3], grid[3];
+        for (int i = 0; i < 3; i++) {
+            first[i] = lo[i] - margin;
+            grid[i] = hi[i] - lo[i] + 1 + 2 * margin;
+        }
+        const int nx = grid[0], ny = grid[1], nz = grid[2];
+
+        std::vector<float> field;
+        switch (volume->GetScalarType()) {
+            vtkTemplateMacro(FillField(static_cast<const VTK_TT*>(scalars), components, dims, label,
+                                       first, grid, parallelFor, field));
+        }
+        boxes.clear();
+        boxes.shrink_to_fit();
+        if (cancelled()) return false;
+
+        // 3. 可分离高斯平滑：x方向逐行，y/z方向每次处理整行以保持连续访问
+        if (!kernel.empty()) {
+            const int radius = static_cast<int>(kernel.size() / 2);
+            const size_t sliceSize = static_cast<size_t>(nx) * ny;
+
+            parallelFor(static_cast<size_t>(ny) * nz, 64, [&](size_t begin, size_t end) {
+                std::vector<float> line(nx);
+                for (size_t r = begin; r < end; r++) {
+                    float* row = &field[r * nx];
+                    std::copy(row, row + nx, line.begin());
+                    for (int x = 0; x < nx; x++) {
+                        float sum = 0.0f;
+                        for (int k = -radius; k <= radius; k++) {
+                            int xi = x + k;
+                            if (xi >= 0 && xi < nx) sum += kernel[k + radius] * line[xi];
+                        }
+                        row[x] = sum;
+                    }
+                }
+            });
+
+            // 沿步长为rowStride的方向平滑：outer个独立的平面，每个平面length行
+            auto blurRows = [&](size_t outer, size_t outerStride, int length, size_t rowStride) {
+                parallelFor(outer, 1, [&](size_t begin, size_t end) {
+                    std::vector<float> rows(static_cast<size_t>(length) * nx);
+                    for (size_t o = begin; o < end; o++) {
+                        float* base = &field[o * outerStride];
+                        for (int i = 0; i < length; i++) {
+                            std::copy(base + i * rowStride, base + i * rowStride + nx, &rows[static_cast<size_t>(i) * nx]);
+                        }
+                        for (int i = 0; i < length; i++) {
+                            float* out = base + i * rowStride;
+                            std::fill(out, out + nx, 0.0f);
+                            for (int k = -radius; k <= radius; k++) {
+                                int j = i + k;
+                                if (j < 0 || j >= length) continue;
+                                const float w = kernel[k + radius];
+                                const float* in = &rows[static_cast<size_t>(j) * nx];
+                                for (int x = 0; x < nx; x++) out[x] += w * in[x];
+                            }
+                        }
+                    }
+                });
+            };
+            blurRows(nz, sliceSize, ny, nx);         // y方向：每个z层
+            blurRows(ny, nx, nz, sliceSize);         // z方向：每个y行
+            if (cancelled()) return false;
+        }
+
+        // 4. 移动立方体
+        const CaseTable& table = GetCaseTable();
+        auto at = [&](int x, int y, int z) -> float {
+            return field[(static_cast<size_t>(z) * ny + y) * nx + x];
+        };
+        auto in = [&](int x, int y, int z) {
+            return at(x, y, z) > IsoValue;
+        };
+
+        // 交点按行编号：x边行(y, z)、y边行(y, z)、z边行(y, z)依次排列；三角形按立方体行(y, z)编号
+        const size_t xRows = static_cast<size_t>(ny) * nz;
+        const size_t yRows = static_cast<size_t>(ny - 1) * nz;
+        const size_t zRows = static_cast<size_t>(ny) * (nz - 1);
+        const size_t cubeRows = static_cast<size_t>(ny - 1) * (nz - 1);
+        std::vector<vtkIdType> xBase(xRows + 1), yBase(yRows + 1), zBase(zRows + 1), triBase(cubeRows + 1);
+
+        auto cubeCase = [&](int x, int y, int z) {
+            int config = 0;
+            for (int c = 0; c < 8; c++) {
+                if (in(x + (c & 1), y + ((c >> 1) & 1), z + ((c >> 2) & 1))) config |= 1 << c;
+            }
+            return config;
+        };
+
+        // 第一遍：各行的交点数和三角形数
+        parallelFor(nz, 1, [&](size_t begin, size_t end) {
+            for (int z = static_cast<int>(begin); z < static_cast<int>(end); z++) {
+                for (int y = 0; y < ny; y++) {
+                    vtkIdType count = 0;
+                    for (int x = 0; x + 1 < nx; x++) count += in(x, y, z) != in(x + 1, y, z);
+                    xBase[static_cast<size_t>(z) * ny + y + 1] = count;
+                    if (y + 1 < ny) {
+                        count = 0;
+                        for (int x = 0; x < nx; x++) count += in(x, y, z) != in(x, y + 1, z);
+                        yBase[static_cast<size_t>(z) * (ny - 1) + y + 1] = count;
+                    }
+                    if (z + 1 < nz) {
+                        count = 0;
+                        for (int x = 0; x < nx; x++) count += in(x, y, z) != in(x, y, z + 1);
+                        zBase[static_cast<size_t>(z) * ny + y + 1] = count;
+                    }
+                    if (y + 1 < ny && z + 1 < nz) {
+                        count = 0;
+                        for (int x = 0; x + 1 < nx; x++) count += table.triangles[cubeCase(x, y, z)].size() / 3;
+                        triBase[static_cast<size_t>(z) * (ny - 1) + y + 1] = count;
+                    }
+                }
+            }
+        });
+
+        xBase[0] = 0;
+        for (size_t r = 0; r < xRows; r++) xBase[r + 1] += xBase[r];
+        yBase[0] = xBase[xRows];
+        for (size_t r = 0; r < yRows; r++) yBase[r + 1] += yBase[r];
+        zBase[0] = yBase[yRows];
+        for (size_t r = 0; r < zRows; r++) zBase[r + 1] += zBase[r];
+        triBase[0] = 0;
+        for (size_t r = 0; r < cubeRows; r++) triBase[r + 1] += triBase[r];
+        const vtkIdType numPoints = zBase[zRows];
+        const vtkIdType numTriangles = triBase[cubeRows];
+        if (numTriangles == 0 || cancelled()) {
+            return false;
+        }
+
+        std::vector<float> positions(static_cast<size_t>(numPoints) * 3);
+        vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+        connectivity->SetNumberOfValues(numTriangles * 4);
+        vtkIdType* conn = connectivity->GetPointer(0);
+
+        // 第二遍：写出交点和三角形
+        parallelFor(nz, 1, [&](size_t begin, size_t end) {
+            // 边的交点（c0, c1为两端的网格坐标）
+            auto emit = [&](vtkIdType id, int x0, int y0, int z0, int x1, int y1, int z1) {
+                float f0 = at(x0, y0, z0), f1 = at(x1, y1, z1);
+                // 场值恰为等值时交点会落在角点上，与该角点其他边的交点重合（焊接后成为非流形顶点），稍微内移
+                float t = std::min(std::max((IsoValue - f0) / (f1 - f0), CornerOffset), 1.0f - CornerOffset);
+                float* p = &positions[static_cast<size_t>(id) * 3];
+                p[0] = static_cast<float>(origin[0] + (first[0] + x0 + t * (x1 - x0)) * spacing[0]);
+                p[1] = static_cast<float>(origin[1] + (first[1] + y0 + t * (y1 - y0)) * spacing[1]);
+                p[2] = static_cast<float>(origin[2] + (first[2] + z0 + t * (z1 - z0)) * spacing[2]);
+            };
+
+            // 一行边的交点编号（无交点处为-1）
+            std::vector<vtkIdType> idX[2][2], idY[2], idZ[2];
+            auto rowIds = [&](std::vector<vtkIdType>& ids, int axis, int y, int z) {
+                int length = axis == 0 ? nx - 1 : nx;
+                vtkIdType id = axis == 0 ? xBase[static_cast<size_t>(z) * ny + y]
+                             : axis == 1 ? yBase[static_cast<size_t>(z) * (ny - 1) + y]
+                                         : zBase[static_cast<size_t>(z) * ny + y];
+                ids.resize(length);
+                for (int x = 0; x < length; x++) {
+                    bool crossed = axis == 0 ? in(x, y, z) != in(x + 1, y, z)
+                                 : axis == 1 ? in(x, y, z) != in(x, y + 1, z)
+                                             : in(x, y, z) != in(x, y, z + 1);
+                    ids[x] = crossed ? id++ : -1;
+                }
+            };
+
+            for (int z = static_cast<int>(begin); z < static_cast<int>(end); z++) {
+                for (int y = 0; y < ny; y++) {
+                    vtkIdType id = xBase[static_cast<size_t>(z) * ny + y];
+                    for (int x = 0; x + 1 < nx; x++) {
+                        if (in(x, y, z) != in(x + 1, y, z)) emit(id++, x, y, z, x + 1, y, z);
+                    }
+                    if (y + 1 < ny) {
+                        id = yBase[static_cast<size_t>(z) * (ny - 1) + y];
+                        for (int x = 0; x < nx; x++) {
+                            if (in(x, y, z) != in(x, y + 1, z)) emit(id++, x, y, z, x, y + 1, z);
+                        }
+                    }
+                    if (z + 1 < nz) {
+                        id = zBase[static_cast<size_t>(z) * ny + y];
+                        for (int x = 0; x < nx; x++) {
+                            if (in(x, y, z) != in(x, y, z + 1)) emit(id++, x, y, z, x, y, z + 1);
+                        }
+                    }
+                }
+
+                if (z + 1 >= nz) continue;
+                for (int y = 0; y + 1 < ny; y++) {
+                    vtkIdType tri = triBase[static_cast<size_t>(z) * (ny - 1) + y];
+                    if (tri == triBase[static_cast<size_t>(z) * (ny - 1) + y + 1]) continue;
+
+                    for (int d = 0; d < 4; d++) {
+                        rowIds(idX[d & 1][d >> 1], 0, y + (d & 1), z + (d >> 1));
+                    }
+                    for (int d = 0; d < 2; d++) {
+                        rowIds(idY[d], 1, y, z + d);
+                        rowIds(idZ[d], 2, y + d, z);
+                    }
+
+                    for (int x = 0; x + 1 < nx; x++) {
+                        const std::vector<unsigned char>& edges = table.triangles[cubeCase(x, y, z)];
+                        for (size_t i = 0; i < edges.size(); i += 3) {
+                            vtkIdType* cell = conn + tri++ * 4;
+                            cell[0] = 3;
+                            for (int k = 0; k < 3; k++) {
+                                const CubeEdge& edge = table.edges[edges[i + k]];
+                                int dx = edge.a & 1, dy = (edge.a >> 1) & 1, dz = (edge.a >> 2) & 1;
+                                cell[k + 1] = edge.axis == 0 ? idX[dy][dz][x]
+                                            : edge.axis == 1 ? idY[dz][x + dx]
+                                                             : idZ[dy][x + dx];
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        field.clear();
+        field.shrink_to_fit();
+        if (cancelled()) return false;
+
+        // 5. Taubin平滑：λ步收缩、μ步膨胀，邻点按三角形的边展开（封闭网格上每个邻点恰出现两次，不影响均值）
+        if (settings.smoothingIterations > 0) {
+            std::vector<vtkIdType> offsets(numPoints + 1, 0);
+            for (vtkIdType t = 0; t < numTriangles; t++) {
+                for (int k = 1; k <= 3; k++) offsets[conn[t * 4 + k] + 1] += 2;
+            }
+            for (vtkIdType v = 0; v < numPoints; v++) offsets[v + 1] += offsets[v];
+            std::vector<vtkIdType> neighbors(offsets[numPoints]);
+            std::vector<vtkIdType> fill(offsets.begin(), offsets.end() - 1);
+            for (vtkIdType t = 0; t < numTriangles; t++) {
+                const vtkIdType* cell = conn + t * 4 + 1;
+                for (int k = 0; k < 3; k++) {
+                    neighbors[fill[cell[k]]++] = cell[(k + 1) % 3];
+                    neighbors[fill[cell[k]]++] = cell[(k + 2) % 3];
+                }
+            }
+
+            std::vector<float> smoothed(positions.size());
+            for (int iteration = 0; iteration < settings.smoothingIterations * 2; iteration++) {
+                const double factor = (iteration % 2 == 0) ? TaubinLambda : TaubinMu;
+                parallelFor(numPoints, 4096, [&](size_t begin, size_t end) {
+                    for (size_t v = begin; v < end; v++) {
+                        double mean[3] = { 0.0, 0.0, 0.0 };
+                        for (vtkIdType n = offsets[v]; n < offsets[v + 1]; n++) {
+                            const float* q = &positions[static_cast<size_t>(neighbors[n]) * 3];
+                            mean[0] += q[0];
+                            mean[1] += q[1];
+                            mean[2] += q[2];
+                        }
+                        const double count = static_cast<double>(offsets[v + 1] - offsets[v]);
+                        const float* p = &positions[v * 3];
+                        for (int i = 0; i < 3; i++) {
+                            smoothed[v * 3 + i] = count > 0.0
+                                ? static_cast<float>(p[i] + factor * (mean[i] / count - p[i])) : p[i];
+                        }
+                    }
+                });
+                positions.swap(smoothed);
+                if (cancelled()) return false;
+            }
+        }
+
+        // 6. 输出
+        vtkSmartPointer<vtkFloatArray> pointData = vtkSmartPointer<vtkFloatArray>::New();
+        pointData->SetNumberOfComponents(3);
+        pointData->SetNumberOfTuples(numPoints);
+        std::copy(positions.begin(), positions.end(), pointData->GetPointer(0));
+        positions.clear();
+        positions.shrink_to_fit();
+
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        points->SetData(pointData);
+        vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+        polys->SetCells(numTriangles, connectivity);
+
+        vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+        surface->SetPoints(points);
+        surface->SetPolys(polys);
+
+        // 7. 可选削减（VTK滤波器，串行）
+        if (settings.decimation > 0.0) {
+            vtkSmartPointer<vtkQuadricDecimation> decimate = vtkSmartPointer<vtkQuadricDecimation>::New();
+            decimate->SetInputData(surface);
+            decimate->SetTargetReduction(std::min(settings.decimation, 0.99));
+            decimate->Update();
+            if (cancelled()) return false;
+            surface = decimate->GetOutput();
+        }
+
+        output->ShallowCopy(surface);
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "SurfaceExtractor: " << output->GetNumberOfPolys() << " triangles from "
+                 << (hi[0] - lo[0] + 1) << "x" << (hi[1] - lo[1] + 1) << "x" << (hi[2] - lo[2] + 1)
+                 << " labeled region in " << elapsedMs << " ms" << std::endl;
+        return true;
+    }
+
+} // namespace BronchoscopyLib
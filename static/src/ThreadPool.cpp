@@ -0,0 +1,161 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BronchoscopyLib {
+    
+    class ThreadPool::Impl {
+    public:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        
+        std::mutex mutex;
+        std::condition_variable taskAvailable;  // 有新任务或需要退出
+        std::condition_variable idle;           // 队列清空且无任务运行
+        
+        unsigned int activeTasks;
+        bool stopping;
+        
+        Impl() : activeTasks(0), stopping(false) {
+        }
+        
+        void WorkerLoop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+                    
+                    // 退出前先把队列中剩余的任务执行完
+                    if (tasks.empty()) return;
+                    
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                    activeTasks++;
+                }
+                
+                task();
+                
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    activeTasks--;
+                    if (tasks.empty() && activeTasks == 0) {
+                        idle.notify_all();
+                    }
+                }
+            }
+        }
+    };
+    
+    ThreadPool::ThreadPool(unsigned int threadCount) : pImpl(std::make_unique<Impl>()) {
+        if (threadCount == 0) {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        if (threadCount == 0) {
+            threadCount = 1;  // hardware_concurrency无法确定时
+        }
+        
+        pImpl->workers.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; i++) {
+            pImpl->workers.emplace_back(&Impl::WorkerLoop, pImpl.get());
+        }
+    }
+    
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(pImpl->mutex);
+            pImpl->stopping = true;
+        }
+        pImpl->taskAvailable.notify_all();
+        
+        for (std::thread& worker : pImpl->workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+    
+    void ThreadPool::Submit(std::function<void()> task) {
+        if (!task) return;
+        
+        {
+            std::lock_guard<std::mutex> lock(pImpl->mutex);
+            pImpl->tasks.push_back(std::move(task));
+        }
+        pImpl->taskAvailable.notify_one();
+    }
+    
+    void ThreadPool::WaitIdle() {
+        std::unique_lock<std::mutex> lock(pImpl->mutex);
+        pImpl->idle.wait(lock, [this] {
+            return pImpl->tasks.empty() && pImpl->activeTasks == 0;
+        });
+    }
+    
+    void ThreadPool::ParallelFor(size_t count, size_t grain,
+                                 const std::function<void(size_t begin, size_t end)>& body) {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        
+        size_t chunkCount = (count + grain - 1) / grain;
+        if (chunkCount == 1 || pImpl->workers.empty()) {
+            body(0, count);
+            return;
+        }
+        
+        // 各线程通过原子计数器领取分块；调用线程只等待已被领取但未完成的分块
+        struct ForState {
+            std::atomic<size_t> nextChunk;
+            size_t completedChunks;
+            std::mutex mutex;
+            std::condition_variable done;
+            
+            ForState() : nextChunk(0), completedChunks(0) {}
+        };
+        std::shared_ptr<ForState> state = std::make_shared<ForState>();
+        
+        // body在本函数返回前一定执行完毕，按引用捕获是安全的
+        const std::function<void(size_t, size_t)>* bodyPtr = &body;
+        auto runChunks = [state, bodyPtr, count, grain, chunkCount]() {
+            size_t finished = 0;
+            for (;;) {
+                size_t chunk = state->nextChunk.fetch_add(1);
+                if (chunk >= chunkCount) break;
+                
+                size_t begin = chunk * grain;
+                size_t end = begin + grain < count ? begin + grain : count;
+                (*bodyPtr)(begin, end);
+                finished++;
+            }
+            
+            if (finished > 0) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->completedChunks += finished;
+                if (state->completedChunks == chunkCount) {
+                    state->done.notify_all();
+                }
+            }
+        };
+        
+        size_t helpers = pImpl->workers.size();
+        if (helpers > chunkCount - 1) helpers = chunkCount - 1;
+        for (size_t i = 0; i < helpers; i++) {
+            Submit(runChunks);
+        }
+        
+        runChunks();
+        
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state, chunkCount] { return state->completedChunks == chunkCount; });
+    }
+    
+    unsigned int ThreadPool::GetThreadCount() const {
+        return static_cast<unsigned int>(pImpl->workers.size());
+    }
+    
+} // namespace BronchoscopyLib
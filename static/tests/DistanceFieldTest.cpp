@@ -0,0 +1,139 @@
+// DistanceFieldTest - DistanceField的符号、精度和序列化
+// 单段圆管（气道的第一代）远离两端的部分有解析的有符号距离：半径减去到轴线的距离，
+// 检查采样值的符号（管腔内为正）、窄带内的误差和截断、梯度方向；
+// 另外检查网格外的取值、串行与并行构建一致、序列化往返后逐点相同，以及取消构建
+
+#include "DistanceField.h"
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+#include "TestMeshes.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using BronchoscopyLib::DistanceField;
+    using BronchoscopyLib::MeshBVH;
+    using BronchoscopyLib::ThreadPool;
+    using namespace BronchoscopyTest;
+
+    // 圆管远离开口的部分（沿-z方向，两端各留20）内外的随机点
+    std::vector<double> SamplePoints(const Segment& tube, size_t count) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::vector<double> points;
+        for (size_t i = 0; i < count; i++) {
+            double radius = 2.0 * tube.radius * unit(rng);
+            double angle = 2.0 * Pi * unit(rng);
+            points.push_back(radius * std::cos(angle));
+            points.push_back(radius * std::sin(angle));
+            points.push_back(-20.0 - (tube.length - 40.0) * unit(rng));
+        }
+        return points;
+    }
+
+} // namespace
+
+int main() {
+    std::vector<Segment> segments;
+    vtkSmartPointer<vtkPolyData> mesh = CreateAirway(1, 64, 50, segments);
+    const Segment& tube = segments[0];
+
+    ThreadPool pool(4);
+    MeshBVH bvh;
+    TEST_CHECK(bvh.Build(mesh, &pool));
+
+    // 体素尺寸约为自动选择（最长边256个体素）的1.3倍，缩短构建时间；窄带宽度自动选择
+    const double VoxelSize = 0.5;
+    DistanceField field;
+    TEST_CHECK(field.Build(bvh, VoxelSize, 0.0, &pool));
+    TEST_CHECK(!field.IsEmpty());
+    TEST_CHECK(field.GetGeometryHash() == bvh.GetBuildStats().geometryHash);
+
+    const double voxel = field.GetVoxelSize();
+    const double band = field.GetBandWidth();
+    TEST_CHECK(voxel == VoxelSize && band == DistanceField::DefaultBandVoxels * voxel);
+
+    // 多边形近似圆管的偏差（弦高）加上一个体素的插值误差
+    const double chord = tube.radius * (1.0 - std::cos(Pi / 64));
+    const double tolerance = voxel + chord;
+
+    std::vector<double> points = SamplePoints(tube, 20000);
+    bool signs = true, accurate = true, clamped = true, gradients = true;
+    for (size_t i = 0; i < points.size(); i += 3) {
+        const double* p = &points[i];
+        double exact = tube.radius - std::sqrt(p[0] * p[0] + p[1] * p[1]);
+        double gradient[3];
+        double value = field.SampleGradient(p, gradient);
+        TEST_CHECK(value == field.Sample(p));
+
+        if (std::abs(exact) > 2.0 * voxel) {
+            signs = signs && (value > 0.0) == (exact > 0.0);
+        }
+        clamped = clamped && std::abs(value) <= band + 1e-9;
+        if (std::abs(exact) < band - tolerance) {
+            accurate = accurate && std::abs(value - exact) < tolerance;
+            // 梯度指向轴线（管腔内部）
+            double radial[3] = { -p[0], -p[1], 0.0 };
+            Normalize(radial);
+            Normalize(gradient);
+            gradients = gradients && Dot(radial, gradient) > 0.9;
+        } else if (std::abs(exact) > band + 2.0 * tolerance) {
+            // 窄带外（插值不再涉及窄带内的体素）只保留符号
+            clamped = clamped && std::abs(std::abs(value) - band) < 1e-6;
+        }
+    }
+    TEST_CHECK(signs);
+    TEST_CHECK(accurate);
+    TEST_CHECK(clamped);
+    TEST_CHECK(gradients);
+
+    // 网格范围外视为壁外
+    const double far[3] = { 1000.0, 0.0, -50.0 };
+    TEST_CHECK(field.Sample(far) == -band);
+
+    // 串行构建逐点相同
+    DistanceField serial;
+    TEST_CHECK(serial.Build(bvh, VoxelSize, 0.0, nullptr));
+    bool sameSerial = serial.GetAllocatedBricks() == field.GetAllocatedBricks();
+    for (size_t i = 0; i < points.size(); i += 3) {
+        sameSerial = sameSerial && serial.Sample(&points[i]) == field.Sample(&points[i]);
+    }
+    TEST_CHECK(sameSerial);
+
+    // 序列化往返：参数、哈希和采样值逐点相同
+    std::vector<unsigned char> data;
+    field.Serialize(data);
+    DistanceField restored;
+    TEST_CHECK(restored.Deserialize(data.data(), data.size()));
+    TEST_CHECK(restored.GetGeometryHash() == field.GetGeometryHash());
+    TEST_CHECK(restored.GetVoxelSize() == voxel && restored.GetBandWidth() == band);
+    TEST_CHECK(restored.GetAllocatedBricks() == field.GetAllocatedBricks());
+    double requestedVoxel = -1.0, requestedBand = -1.0;
+    restored.GetRequestedSettings(requestedVoxel, requestedBand);
+    TEST_CHECK(requestedVoxel == VoxelSize && requestedBand == 0.0);
+    bool sameRestored = true;
+    for (size_t i = 0; i < points.size(); i += 3) {
+        double a[3], b[3];
+        sameRestored = sameRestored && restored.SampleGradient(&points[i], a) == field.SampleGradient(&points[i], b) &&
+                       a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+    }
+    TEST_CHECK(sameRestored);
+
+    // 截断的数据：失败且内容不变
+    TEST_CHECK(!restored.Deserialize(data.data(), data.size() - 3));
+    TEST_CHECK(!restored.IsEmpty() && restored.Sample(&points[0]) == field.Sample(&points[0]));
+
+    // 已置位的取消标志：构建失败，结果为空
+    std::atomic<bool> cancel(true);
+    DistanceField cancelled;
+    TEST_CHECK(!cancelled.Build(bvh, VoxelSize, 0.0, &pool, &cancel));
+    TEST_CHECK(cancelled.IsEmpty());
+
+    return BronchoscopyTest::Finish("DistanceFieldTest");
+}
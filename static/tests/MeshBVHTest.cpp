@@ -0,0 +1,300 @@
+// MeshBVHTest - MeshBVH的查询与逐个三角形暴力计算的一致性
+// 在合成气道上比较：
+//   射线求交（最近交点的距离、位置和三角形，maxDistance截断，遮挡测试，批量求交）
+//   最近点查询（距离和位置，maxDistance截断）
+// 另外检查封闭网格的环绕数、串行与并行构建的一致性以及取消构建
+// BVH内部为单精度，暴力计算使用同样舍入到float的顶点，比较时留出单精度的误差
+
+#include "MeshBVH.h"
+#include "ThreadPool.h"
+#include "TestMeshes.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using BronchoscopyLib::MeshBVH;
+    using BronchoscopyLib::ThreadPool;
+    using namespace BronchoscopyTest;
+
+    // 比较距离和位置的容差（网格尺度约300，单精度相对误差约1e-7）
+    const double Tolerance = 1e-3;
+
+    struct Triangle {
+        double p0[3], p1[3], p2[3];
+    };
+
+    // 按单元顺序取出三角形，顶点舍入到float
+    std::vector<Triangle> GetTriangles(vtkPolyData* mesh) {
+        std::vector<Triangle> triangles;
+        vtkCellArray* polys = mesh->GetPolys();
+        vtkIdType npts = 0;
+        vtkIdType* pts = nullptr;
+        polys->InitTraversal();
+        while (polys->GetNextCell(npts, pts)) {
+            Triangle triangle;
+            double* corners[3] = { triangle.p0, triangle.p1, triangle.p2 };
+            for (int k = 0; k < 3; k++) {
+                mesh->GetPoints()->GetPoint(pts[k], corners[k]);
+                for (int a = 0; a < 3; a++) {
+                    corners[k][a] = static_cast<float>(corners[k][a]);
+                }
+            }
+            triangles.push_back(triangle);
+        }
+        return triangles;
+    }
+
+    // 双面Möller-Trumbore，direction为单位向量；不相交时返回无穷大
+    double IntersectTriangle(const Triangle& t, const double origin[3], const double direction[3]) {
+        double e1[3], e2[3], s[3], p[3], q[3];
+        for (int a = 0; a < 3; a++) {
+            e1[a] = t.p1[a] - t.p0[a];
+            e2[a] = t.p2[a] - t.p0[a];
+            s[a] = origin[a] - t.p0[a];
+        }
+        Cross(direction, e2, p);
+        double det = Dot(e1, p);
+        const double none = std::numeric_limits<double>::infinity();
+        if (det == 0.0) return none;
+        double u = Dot(s, p) / det;
+        if (u < 0.0 || u > 1.0) return none;
+        Cross(s, e1, q);
+        double v = Dot(direction, q) / det;
+        if (v < 0.0 || u + v > 1.0) return none;
+        double distance = Dot(e2, q) / det;
+        return distance > 0.0 ? distance : none;
+    }
+
+    // 三角形上离point最近的点（Ericson, Real-Time Collision Detection 5.1.5）
+    void ClosestPointOnTriangle(const Triangle& t, const double point[3], double closest[3]) {
+        double ab[3], ac[3], ap[3], bp[3], cp[3];
+        for (int a = 0; a < 3; a++) {
+            ab[a] = t.p1[a] - t.p0[a];
+            ac[a] = t.p2[a] - t.p0[a];
+            ap[a] = point[a] - t.p0[a];
+            bp[a] = point[a] - t.p1[a];
+            cp[a] = point[a] - t.p2[a];
+        }
+        auto blend = [&](const double* base, const double* edge, double s) {
+            for (int a = 0; a < 3; a++) closest[a] = base[a] + edge[a] * s;
+        };
+
+        double d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+        if (d1 <= 0.0 && d2 <= 0.0) { blend(t.p0, ab, 0.0); return; }
+        double d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+        if (d3 >= 0.0 && d4 <= d3) { blend(t.p1, ab, 0.0); return; }
+        double vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) { blend(t.p0, ab, d1 / (d1 - d3)); return; }
+        double d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+        if (d6 >= 0.0 && d5 <= d6) { blend(t.p2, ab, 0.0); return; }
+        double vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) { blend(t.p0, ac, d2 / (d2 - d6)); return; }
+        double va = d3 * d6 - d5 * d4;
+        if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) {
+            double bc[3] = { t.p2[0] - t.p1[0], t.p2[1] - t.p1[1], t.p2[2] - t.p1[2] };
+            blend(t.p1, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+            return;
+        }
+        double denom = 1.0 / (va + vb + vc);
+        double v = vb * denom, w = vc * denom;
+        for (int a = 0; a < 3; a++) {
+            closest[a] = t.p0[a] + ab[a] * v + ac[a] * w;
+        }
+    }
+
+    double Distance(const double a[3], const double b[3]) {
+        double d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+        return std::sqrt(Dot(d, d));
+    }
+
+    // 单位立方体表面，法线朝外
+    vtkSmartPointer<vtkPolyData> CreateCube() {
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        for (int i = 0; i < 8; i++) {
+            double p[3] = { double(i & 1), double((i >> 1) & 1), double((i >> 2) & 1) };
+            points->InsertNextPoint(p);
+        }
+        const vtkIdType faces[6][4] = {
+            { 0, 2, 3, 1 }, { 4, 5, 7, 6 },  // z = 0, z = 1
+            { 0, 1, 5, 4 }, { 2, 6, 7, 3 },  // y = 0, y = 1
+            { 0, 4, 6, 2 }, { 1, 3, 7, 5 }   // x = 0, x = 1
+        };
+        vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+        for (const vtkIdType* face : faces) {
+            vtkIdType first[3] = { face[0], face[1], face[2] };
+            vtkIdType second[3] = { face[0], face[2], face[3] };
+            polys->InsertNextCell(3, first);
+            polys->InsertNextCell(3, second);
+        }
+        vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+        mesh->SetPoints(points);
+        mesh->SetPolys(polys);
+        return mesh;
+    }
+
+    void TestRays(const MeshBVH& bvh, const std::vector<Triangle>& triangles,
+                  const std::vector<Segment>& segments, ThreadPool& pool) {
+        std::mt19937 rng(3);
+        std::normal_distribution<double> gaussian;
+        std::uniform_int_distribution<size_t> pick(0, segments.size() - 1);
+
+        std::vector<MeshBVH::Ray> rays;
+        for (int i = 0; i < 2000; i++) {
+            MeshBVH::Ray ray;
+            if (i % 4 == 0) {
+                // 气道外的点，大部分射线不相交
+                for (int a = 0; a < 3; a++) ray.origin[a] = 300.0 * gaussian(rng);
+            } else {
+                SampleSegment(segments[pick(rng)], 0.0, 1.0, 0.9, rng, ray.origin);
+            }
+            for (int a = 0; a < 3; a++) ray.direction[a] = gaussian(rng) * (1.0 + i % 3);
+            rays.push_back(ray);
+        }
+
+        size_t hits = 0;
+        bool sameHits = true, sameDistances = true, samePoints = true, sameCells = true;
+        bool clipped = true, occlusion = true;
+        for (const MeshBVH::Ray& ray : rays) {
+            double direction[3] = { ray.direction[0], ray.direction[1], ray.direction[2] };
+            Normalize(direction);
+            double nearest = std::numeric_limits<double>::infinity();
+            for (const Triangle& triangle : triangles) {
+                nearest = std::min(nearest, IntersectTriangle(triangle, ray.origin, direction));
+            }
+
+            MeshBVH::Hit hit;
+            bool found = bvh.Intersect(ray, hit);
+            sameHits = sameHits && found == std::isfinite(nearest) && found == hit.hit;
+            occlusion = occlusion && bvh.IsOccluded(ray) == found;
+            if (!found || !std::isfinite(nearest)) continue;
+            hits++;
+
+            sameDistances = sameDistances && std::abs(hit.distance - nearest) < Tolerance;
+            double expected[3];
+            for (int a = 0; a < 3; a++) expected[a] = ray.origin[a] + direction[a] * nearest;
+            samePoints = samePoints && Distance(hit.point, expected) < Tolerance;
+            // 共边处的并列交点可能报告相邻的三角形，只要求报告的三角形在同一距离相交
+            sameCells = sameCells && hit.cellId >= 0 && hit.cellId < static_cast<long long>(triangles.size()) &&
+                        std::abs(IntersectTriangle(triangles[hit.cellId], ray.origin, direction) - nearest) < Tolerance;
+
+            // 限制在交点之前时不相交
+            MeshBVH::Ray shorter = ray;
+            shorter.maxDistance = 0.5 * nearest;
+            MeshBVH::Hit none;
+            clipped = clipped && !bvh.Intersect(shorter, none) && !bvh.IsOccluded(shorter);
+        }
+        TEST_CHECK(sameHits);
+        TEST_CHECK(sameDistances);
+        TEST_CHECK(samePoints);
+        TEST_CHECK(sameCells);
+        TEST_CHECK(clipped);
+        TEST_CHECK(occlusion);
+        TEST_CHECK(hits > rays.size() / 2);
+
+        // 批量求交与逐条求交相同（串行和线程池）
+        for (ThreadPool* batchPool : { static_cast<ThreadPool*>(nullptr), &pool }) {
+            std::vector<MeshBVH::Hit> batch;
+            bvh.IntersectBatch(rays, batch, batchPool);
+            TEST_CHECK(batch.size() == rays.size());
+            bool sameBatch = batch.size() == rays.size();
+            for (size_t i = 0; sameBatch && i < rays.size(); i++) {
+                MeshBVH::Hit single;
+                bvh.Intersect(rays[i], single);
+                sameBatch = batch[i].hit == single.hit && batch[i].distance == single.distance &&
+                            batch[i].cellId == single.cellId;
+            }
+            TEST_CHECK(sameBatch);
+        }
+    }
+
+    void TestClosestPoints(const MeshBVH& bvh, const std::vector<Triangle>& triangles,
+                           const std::vector<Segment>& segments) {
+        std::mt19937 rng(5);
+        std::normal_distribution<double> gaussian;
+        std::uniform_int_distribution<size_t> pick(0, segments.size() - 1);
+
+        bool sameDistances = true, samePoints = true, clipped = true;
+        for (int i = 0; i < 500; i++) {
+            double point[3];
+            if (i % 4 == 0) {
+                for (int a = 0; a < 3; a++) point[a] = 200.0 * gaussian(rng);
+            } else {
+                SampleSegment(segments[pick(rng)], 0.0, 1.0, 1.5, rng, point);
+            }
+
+            double nearest = std::numeric_limits<double>::infinity();
+            for (const Triangle& triangle : triangles) {
+                double closest[3];
+                ClosestPointOnTriangle(triangle, point, closest);
+                nearest = std::min(nearest, Distance(point, closest));
+            }
+
+            MeshBVH::Hit hit;
+            TEST_CHECK(bvh.FindClosestPoint(point, 0.0, hit) && hit.hit);
+            sameDistances = sameDistances && std::abs(hit.distance - nearest) < Tolerance;
+            samePoints = samePoints && std::abs(Distance(point, hit.point) - nearest) < Tolerance;
+
+            if (nearest > 2.0 * Tolerance) {
+                MeshBVH::Hit none;
+                clipped = clipped && !bvh.FindClosestPoint(point, 0.5 * nearest, none);
+            }
+        }
+        TEST_CHECK(sameDistances);
+        TEST_CHECK(samePoints);
+        TEST_CHECK(clipped);
+    }
+
+    void TestWindingNumber(ThreadPool& pool) {
+        MeshBVH bvh;
+        TEST_CHECK(bvh.Build(CreateCube(), &pool));
+        TEST_CHECK(bvh.GetBuildStats().signedVolume > 0.99 && bvh.GetBuildStats().signedVolume < 1.01);
+
+        const double inside[3] = { 0.3, 0.6, 0.5 };
+        const double outside[3] = { 1.7, 0.4, -0.2 };
+        TEST_CHECK(std::abs(bvh.GetWindingNumber(inside) - 1.0) < 0.05);
+        TEST_CHECK(std::abs(bvh.GetWindingNumber(outside)) < 0.05);
+    }
+
+} // namespace
+
+int main() {
+    std::vector<Segment> segments;
+    vtkSmartPointer<vtkPolyData> mesh = CreateAirway(4, 24, 20, segments);
+    std::vector<Triangle> triangles = GetTriangles(mesh);
+
+    ThreadPool pool(4);
+    MeshBVH bvh;
+    TEST_CHECK(bvh.Build(mesh, &pool));
+    TEST_CHECK(!bvh.IsEmpty());
+    TEST_CHECK(bvh.GetBuildStats().triangles == triangles.size());
+
+    TestRays(bvh, triangles, segments, pool);
+    TestClosestPoints(bvh, triangles, segments);
+    TestWindingNumber(pool);
+
+    // 串行构建的结果相同
+    MeshBVH serial;
+    TEST_CHECK(serial.Build(mesh, nullptr));
+    TEST_CHECK(serial.GetBuildStats().geometryHash == bvh.GetBuildStats().geometryHash);
+    MeshBVH::Ray ray;
+    ray.origin[2] = -50.0;
+    ray.direction[0] = 1.0; ray.direction[2] = 0.0;
+    MeshBVH::Hit a, b;
+    TEST_CHECK(serial.Intersect(ray, a) && bvh.Intersect(ray, b));
+    TEST_CHECK(a.distance == b.distance && a.cellId == b.cellId);
+
+    // 已置位的取消标志：构建失败，结果为空
+    std::atomic<bool> cancel(true);
+    MeshBVH cancelled;
+    TEST_CHECK(!cancelled.Build(mesh, &pool, &cancel));
+    TEST_CHECK(cancelled.IsEmpty());
+
+    return BronchoscopyTest::Finish("MeshBVHTest");
+}
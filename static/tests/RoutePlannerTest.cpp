@@ -0,0 +1,202 @@
+// RoutePlannerTest - RoutePlanner的路线与中心线上的暴力计算一致
+// 在合成气道上由距离场提取中心线，按中心线分支逐点建立参照（从根出发的路径长度、可达性），
+// 对随机目标检查：
+//   终点是可达节点中离目标最近者（targetDistance与暴力最小值相同）
+//   路线是从根到终点所在分支的中心线路径的前缀，长度等于折线长度和参照的路径长度
+//   沿途最小半径不小于限制（开口段除外），可达节点数与参照相同且随限制增大不增加
+
+#include "Centerline.h"
+#include "DistanceField.h"
+#include "MeshBVH.h"
+#include "RoutePlanner.h"
+#include "ThreadPool.h"
+#include "TestMeshes.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+    using BronchoscopyLib::Centerline;
+    using BronchoscopyLib::DistanceField;
+    using BronchoscopyLib::MeshBVH;
+    using BronchoscopyLib::RoutePlanner;
+    using BronchoscopyLib::ThreadPool;
+    using namespace BronchoscopyTest;
+
+    // 比较长度的容差（累加顺序不同的舍入误差）
+    const double Tolerance = 1e-9;
+
+    double Distance(const double a[3], const double b[3]) {
+        double d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+        return std::sqrt(Dot(d, d));
+    }
+
+    // 中心线节点的参照：分叉点只出现一次（子分支的首点即父分支的末点）
+    struct Node {
+        const double* position;
+        double radius;
+        double along;   // 从根出发沿中心线的长度
+        bool opening;   // 气管开口段：根分支上从根出发的长度小于根分支最大半径的节点
+        int parent;     // 上一个节点，根为-1
+    };
+
+    std::vector<Node> CreateNodes(const Centerline& centerline) {
+        std::vector<Node> nodes;
+        const std::vector<Centerline::Branch>& branches = centerline.GetBranches();
+        std::vector<int> lastNode(branches.size(), -1);
+        const double opening = *std::max_element(branches[0].radii.begin(), branches[0].radii.end());
+
+        // 父分支排在子分支之前
+        for (size_t b = 0; b < branches.size(); b++) {
+            const Centerline::Branch& branch = branches[b];
+            int previous = branch.parent >= 0 ? lastNode[branch.parent] : -1;
+            for (size_t i = (branch.parent >= 0 ? 1 : 0); i < branch.GetPointCount(); i++) {
+                Node node;
+                node.position = &branch.points[i * 3];
+                node.radius = branch.radii[i];
+                node.along = previous >= 0 ? nodes[previous].along + Distance(nodes[previous].position, node.position) : 0.0;
+                node.opening = b == 0 && node.along < opening;
+                node.parent = previous;
+                previous = static_cast<int>(nodes.size());
+                nodes.push_back(node);
+            }
+            lastNode[b] = previous;
+        }
+        return nodes;
+    }
+
+    // 节点可达：从根出发的路径上每个节点都在开口段或半径不小于限制
+    std::vector<bool> FindReachable(const std::vector<Node>& nodes, double minRadius) {
+        std::vector<bool> reachable(nodes.size(), false);
+        for (size_t i = 0; i < nodes.size(); i++) {
+            bool passable = nodes[i].opening || nodes[i].radius >= minRadius;
+            reachable[i] = passable && (nodes[i].parent < 0 || reachable[nodes[i].parent]);
+        }
+        return reachable;
+    }
+
+    double PolylineLength(const std::vector<double>& positions) {
+        double length = 0.0;
+        for (size_t i = 3; i < positions.size(); i += 3) {
+            length += Distance(&positions[i - 3], &positions[i]);
+        }
+        return length;
+    }
+
+    void TestRoutes(const RoutePlanner& planner, const Centerline& centerline, const std::vector<Node>& nodes,
+                    const std::vector<double>& targets, double minRadius) {
+        std::vector<bool> reachable = FindReachable(nodes, minRadius);
+        TEST_CHECK(planner.GetReachableCount() == static_cast<size_t>(std::count(reachable.begin(), reachable.end(), true)));
+
+        size_t checked = 0;
+        bool nearest = true, prefixes = true, lengths = true, radii = true;
+        for (size_t t = 0; t < targets.size(); t += 3) {
+            const double* target = &targets[t];
+            int expected = -1;
+            double expectedDistance = std::numeric_limits<double>::infinity();
+            for (size_t i = 0; i < nodes.size(); i++) {
+                double d = Distance(nodes[i].position, target);
+                if (reachable[i] && d < expectedDistance) {
+                    expected = static_cast<int>(i);
+                    expectedDistance = d;
+                }
+            }
+            // 离根最近时终点改为根的下一个节点（路线至少两个点），不参与比较
+            if (expected <= 0) continue;
+
+            RoutePlanner::Route route;
+            TEST_CHECK(planner.PlanRoute(target, route));
+            checked++;
+
+            nearest = nearest && std::abs(route.targetDistance - expectedDistance) < Tolerance;
+
+            std::vector<double> path;
+            bool prefix = centerline.GetPathToBranch(route.branch, path) && route.positions.size() >= 6 &&
+                          route.positions.size() <= path.size() &&
+                          std::equal(route.positions.begin(), route.positions.end(), path.begin());
+            prefixes = prefixes && prefix;
+
+            // 距离相同的并列节点可能选择路线较短的另一个，按实际终点比较路径长度
+            double along = -1.0;
+            for (const Node& node : nodes) {
+                if (Distance(node.position, &route.positions[route.positions.size() - 3]) == 0.0) {
+                    along = node.along;
+                }
+            }
+            lengths = lengths && std::abs(route.length - PolylineLength(route.positions)) < Tolerance &&
+                      std::abs(route.length - along) < Tolerance;
+
+            bool pastOpening = false;
+            for (size_t i = 0; i < nodes.size(); i++) {
+                if (!nodes[i].opening && Distance(nodes[i].position, &route.positions[route.positions.size() - 3]) == 0.0) {
+                    pastOpening = true;
+                }
+            }
+            radii = radii && (!pastOpening || route.narrowestRadius >= minRadius);
+        }
+        TEST_CHECK(checked > targets.size() / 3 / 2);
+        TEST_CHECK(nearest);
+        TEST_CHECK(prefixes);
+        TEST_CHECK(lengths);
+        TEST_CHECK(radii);
+    }
+
+} // namespace
+
+int main() {
+    std::vector<Segment> segments;
+    vtkSmartPointer<vtkPolyData> mesh = CreateAirway(3, 32, 20, segments);
+
+    ThreadPool pool(4);
+    MeshBVH bvh;
+    TEST_CHECK(bvh.Build(mesh, &pool));
+    DistanceField field;
+    TEST_CHECK(field.Build(bvh, 1.0, 0.0, &pool));
+    std::shared_ptr<Centerline> centerline = std::make_shared<Centerline>();
+    TEST_CHECK(centerline->Extract(field, Centerline::Settings(), &pool));
+    if (centerline->IsEmpty()) {
+        return BronchoscopyTest::Finish("RoutePlannerTest");
+    }
+    // 开口的管道在分叉处互相穿插，分支数不一定与管道段数相同，只要求有分叉
+    TEST_CHECK(centerline->GetBranchCount() >= 3);
+
+    std::vector<Node> nodes = CreateNodes(*centerline);
+    RoutePlanner planner;
+    TEST_CHECK(!planner.Build(nullptr));
+    TEST_CHECK(planner.Build(centerline));
+    TEST_CHECK(planner.GetNodeCount() == nodes.size());
+
+    // 管腔内外的目标（离轴距离至多两倍半径）
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<size_t> pick(0, segments.size() - 1);
+    std::vector<double> targets(300 * 3);
+    for (size_t i = 0; i < targets.size(); i += 3) {
+        SampleSegment(segments[pick(rng)], 0.0, 1.0, 2.0, rng, &targets[i]);
+    }
+
+    size_t previousReachable = nodes.size();
+    for (double minRadius : { 0.0, 3.0, 5.0, 7.0, 100.0 }) {
+        planner.SetMinRadius(minRadius);
+        TEST_CHECK(planner.GetMinRadius() == minRadius);
+        TEST_CHECK(planner.GetReachableCount() <= previousReachable);
+        previousReachable = planner.GetReachableCount();
+        TestRoutes(planner, *centerline, nodes, targets, minRadius);
+    }
+    TEST_CHECK(planner.GetReachableCount() < nodes.size());
+
+    // 目标在中心线上：终点即该点
+    planner.SetMinRadius(0.0);
+    TEST_CHECK(planner.GetReachableCount() == nodes.size());
+    const Node& leaf = nodes.back();
+    RoutePlanner::Route route;
+    TEST_CHECK(planner.PlanRoute(leaf.position, route));
+    TEST_CHECK(route.targetDistance == 0.0 && std::abs(route.length - leaf.along) < Tolerance);
+
+    return BronchoscopyTest::Finish("RoutePlannerTest");
+}
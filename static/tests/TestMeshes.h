@@ -0,0 +1,154 @@
+#ifndef TEST_MESHES_H
+#define TEST_MESHES_H
+
+// 单元测试的合成网格：对称分叉的管道树（与RayCastBenchmark的气道相同的构造，规模较小）
+// 各段为开口的圆管，法线朝外；段之间在分叉处互相穿插，不做布尔合并
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace BronchoscopyTest {
+
+    const double Pi = 3.14159265358979323846;
+
+    struct Segment {
+        double start[3];
+        double direction[3];  // 单位向量
+        double length;
+        double radius;
+    };
+
+    inline void Normalize(double v[3]) {
+        double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0) {
+            v[0] /= length; v[1] /= length; v[2] /= length;
+        }
+    }
+
+    inline void Cross(const double a[3], const double b[3], double out[3]) {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    inline double Dot(const double a[3], const double b[3]) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // 与direction垂直的单位正交基
+    inline void Frame(const double direction[3], double u[3], double w[3]) {
+        double helper[3] = { 1.0, 0.0, 0.0 };
+        if (std::abs(direction[0]) > 0.9) {
+            helper[0] = 0.0; helper[1] = 1.0;
+        }
+        Cross(direction, helper, u);
+        Normalize(u);
+        Cross(direction, u, w);
+    }
+
+    // 绕单位轴旋转（Rodrigues公式）
+    inline void Rotate(const double v[3], const double axis[3], double angle, double out[3]) {
+        double c = std::cos(angle), s = std::sin(angle);
+        double cross[3];
+        Cross(axis, v, cross);
+        double dot = Dot(axis, v);
+        for (int a = 0; a < 3; a++) {
+            out[a] = v[a] * c + cross[a] * s + axis[a] * dot * (1.0 - c);
+        }
+    }
+
+    // 每级长度和半径按比例缩小，分叉面逐级旋转90度
+    inline void BuildTree(const Segment& parent, int generation, int generations, std::vector<Segment>& segments) {
+        segments.push_back(parent);
+        if (generation + 1 >= generations) return;
+
+        double u[3], w[3];
+        Frame(parent.direction, u, w);
+        const double* axis = (generation % 2 == 0) ? u : w;
+
+        for (int side = 0; side < 2; side++) {
+            Segment child;
+            for (int a = 0; a < 3; a++) {
+                child.start[a] = parent.start[a] + parent.direction[a] * parent.length;
+            }
+            Rotate(parent.direction, axis, side == 0 ? 0.6 : -0.6, child.direction);
+            Normalize(child.direction);
+            child.length = parent.length * 0.8;
+            child.radius = parent.radius * 0.75;
+            BuildTree(child, generation + 1, generations, segments);
+        }
+    }
+
+    // 2^generations - 1段管道，气管从原点沿-z方向；每段rings*sides*2个三角形
+    inline vtkSmartPointer<vtkPolyData> CreateAirway(int generations, int sides, int rings,
+                                                     std::vector<Segment>& segments) {
+        segments.clear();
+        Segment trachea = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, -1.0 }, 100.0, 9.0 };
+        BuildTree(trachea, 0, generations, segments);
+
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToFloat();
+        vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+
+        for (const Segment& segment : segments) {
+            double u[3], w[3];
+            Frame(segment.direction, u, w);
+            vtkIdType base = points->GetNumberOfPoints();
+
+            for (int r = 0; r <= rings; r++) {
+                double along = segment.length * r / rings;
+                for (int s = 0; s < sides; s++) {
+                    double angle = 2.0 * Pi * s / sides;
+                    double p[3];
+                    for (int a = 0; a < 3; a++) {
+                        p[a] = segment.start[a] + segment.direction[a] * along +
+                               segment.radius * (std::cos(angle) * u[a] + std::sin(angle) * w[a]);
+                    }
+                    points->InsertNextPoint(p);
+                }
+            }
+
+            for (int r = 0; r < rings; r++) {
+                for (int s = 0; s < sides; s++) {
+                    vtkIdType a = base + r * sides + s;
+                    vtkIdType b = base + r * sides + (s + 1) % sides;
+                    vtkIdType c = a + sides;
+                    vtkIdType d = b + sides;
+                    vtkIdType first[3] = { a, b, d };
+                    vtkIdType second[3] = { a, d, c };
+                    polys->InsertNextCell(3, first);
+                    polys->InsertNextCell(3, second);
+                }
+            }
+        }
+
+        vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+        mesh->SetPoints(points);
+        mesh->SetPolys(polys);
+        return mesh;
+    }
+
+    // 某段管腔内的随机点：along为沿轴位置的范围（0~1），radial为离轴距离占半径的上限
+    inline void SampleSegment(const Segment& segment, double alongMin, double alongMax, double radial,
+                              std::mt19937& rng, double point[3]) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        double u[3], w[3];
+        Frame(segment.direction, u, w);
+        double along = segment.length * (alongMin + (alongMax - alongMin) * unit(rng));
+        double offset = radial * segment.radius * unit(rng);
+        double angle = 2.0 * Pi * unit(rng);
+        for (int a = 0; a < 3; a++) {
+            point[a] = segment.start[a] + segment.direction[a] * along +
+                       offset * (std::cos(angle) * u[a] + std::sin(angle) * w[a]);
+        }
+    }
+
+} // namespace BronchoscopyTest
+
+#endif // TEST_MESHES_H
@@ -0,0 +1,35 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+// 单元测试的公共部分：不依赖测试框架，检查失败时输出位置并计数，
+// main以Finish的返回值退出，非零即失败（由CTest汇总）
+
+#include <iostream>
+
+namespace BronchoscopyTest {
+
+    inline int& FailureCount() {
+        static int failures = 0;
+        return failures;
+    }
+
+    inline int Finish(const char* name) {
+        if (FailureCount() > 0) {
+            std::cerr << name << ": " << FailureCount() << " check(s) failed" << std::endl;
+            return 1;
+        }
+        std::cout << name << ": all checks passed" << std::endl;
+        return 0;
+    }
+
+} // namespace BronchoscopyTest
+
+#define TEST_CHECK(condition)                                                                   \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            BronchoscopyTest::FailureCount()++;                                                 \
+        }                                                                                       \
+    } while (0)
+
+#endif // TEST_SUPPORT_H
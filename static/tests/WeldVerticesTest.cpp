@@ -0,0 +1,182 @@
+// WeldVerticesTest - MeshOptimizer::WeldVertices与vtkCleanPolyData的一致性
+// 测试网格为经纬球的三角形汤（每个三角形三个独立的点，按首次使用顺序排列，末尾另有未引用的点）：
+// 焊接需要合并共享顶点、经线接缝和两极的重复点，两极处的三角形焊接后退化
+// 在这种输入上两者的结果应完全相同：
+//   点数和坐标、三角形索引（WeldVertices按原编号、vtkCleanPolyData按首次使用顺序编号，此处一致）、
+//   丢弃的退化三角形（单元数据随保留的三角形）
+// 另外检查线程池并行与串行的结果相同
+
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+#include "TestSupport.h"
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkCleanPolyData.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+    using BronchoscopyLib::MeshOptimizer;
+    using BronchoscopyLib::ThreadPool;
+
+    const double Pi = 3.14159265358979323846;
+
+    // 与ModelManager清理阶段相同的容差
+    const double CleanTolerance = 0.00001;
+
+    // 经纬球的三角形汤：(rings+1)*(sides+1)个网格点（接缝列重复，两极各sides+1个相同的点），
+    // 每个四边形两个三角形；单元数据"SourceTriangle"记录原三角形编号
+    vtkSmartPointer<vtkPolyData> CreateSphereSoup(int rings, int sides, double radius) {
+        std::vector<double> grid;
+        for (int r = 0; r <= rings; r++) {
+            double theta = Pi * r / rings;
+            for (int s = 0; s <= sides; s++) {
+                double phi = 2.0 * Pi * (s % sides) / sides;
+                grid.push_back(radius * std::sin(theta) * std::cos(phi));
+                grid.push_back(radius * std::sin(theta) * std::sin(phi));
+                grid.push_back(radius * std::cos(theta));
+            }
+        }
+        // 两极的点精确重合，sin(0)和sin(Pi)的舍入误差不影响合并
+        for (int s = 0; s <= sides; s++) {
+            grid[s * 3] = grid[s * 3 + 1] = 0.0;
+            size_t south = (static_cast<size_t>(rings) * (sides + 1) + s) * 3;
+            grid[south] = grid[south + 1] = 0.0;
+        }
+
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+        vtkSmartPointer<vtkIdTypeArray> source = vtkSmartPointer<vtkIdTypeArray>::New();
+        source->SetName("SourceTriangle");
+
+        auto addTriangle = [&](int a, int b, int c) {
+            vtkIdType ids[3];
+            const int corners[3] = { a, b, c };
+            for (int k = 0; k < 3; k++) {
+                ids[k] = points->InsertNextPoint(&grid[static_cast<size_t>(corners[k]) * 3]);
+            }
+            source->InsertNextValue(polys->InsertNextCell(3, ids));
+        };
+
+        for (int r = 0; r < rings; r++) {
+            for (int s = 0; s < sides; s++) {
+                int a = r * (sides + 1) + s;
+                int b = a + 1;
+                int c = a + sides + 1;
+                int d = c + 1;
+                addTriangle(a, c, d);  // 南极处c、d重合，焊接后退化
+                addTriangle(a, d, b);  // 北极处a、b重合，焊接后退化
+            }
+        }
+
+        // 未被引用的点
+        const double unused[2][3] = { { 2.0 * radius, 0.0, 0.0 }, { 0.0, 0.0, -3.0 * radius } };
+        points->InsertNextPoint(unused[0]);
+        points->InsertNextPoint(unused[1]);
+
+        vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+        mesh->SetPoints(points);
+        mesh->SetPolys(polys);
+        mesh->GetCellData()->AddArray(source);
+        return mesh;
+    }
+
+    vtkSmartPointer<vtkPolyData> CleanWithVTK(vtkPolyData* input, double tolerance) {
+        vtkSmartPointer<vtkCleanPolyData> clean = vtkSmartPointer<vtkCleanPolyData>::New();
+        clean->SetInputData(input);
+        clean->PointMergingOn();
+        clean->SetTolerance(tolerance);
+        clean->ConvertPolysToLinesOff();   // 退化三角形直接丢弃，与WeldVertices一致
+        clean->ConvertLinesToPointsOff();
+        clean->ConvertStripsToPolysOff();
+        clean->Update();
+
+        vtkSmartPointer<vtkPolyData> output = vtkSmartPointer<vtkPolyData>::New();
+        output->ShallowCopy(clean->GetOutput());
+        return output;
+    }
+
+    std::vector<vtkIdType> GetTriangles(vtkPolyData* mesh) {
+        std::vector<vtkIdType> indices;
+        vtkCellArray* polys = mesh->GetPolys();
+        vtkIdType npts = 0;
+        vtkIdType* pts = nullptr;
+        polys->InitTraversal();
+        while (polys->GetNextCell(npts, pts)) {
+            indices.insert(indices.end(), pts, pts + npts);
+        }
+        return indices;
+    }
+
+    std::vector<vtkIdType> GetSourceTriangles(vtkPolyData* mesh) {
+        std::vector<vtkIdType> values;
+        vtkIdTypeArray* array = vtkIdTypeArray::SafeDownCast(mesh->GetCellData()->GetArray("SourceTriangle"));
+        if (array) {
+            for (vtkIdType i = 0; i < array->GetNumberOfValues(); i++) {
+                values.push_back(array->GetValue(i));
+            }
+        }
+        return values;
+    }
+
+    void CheckSameMesh(vtkPolyData* actual, vtkPolyData* expected) {
+        TEST_CHECK(actual->GetNumberOfPoints() == expected->GetNumberOfPoints());
+        TEST_CHECK(actual->GetNumberOfPolys() == expected->GetNumberOfPolys());
+        TEST_CHECK(actual->GetNumberOfLines() == 0 && expected->GetNumberOfLines() == 0);
+        TEST_CHECK(GetTriangles(actual) == GetTriangles(expected));
+        TEST_CHECK(GetSourceTriangles(actual) == GetSourceTriangles(expected));
+
+        if (actual->GetNumberOfPoints() != expected->GetNumberOfPoints()) return;
+        bool samePoints = true;
+        double a[3], b[3];
+        for (vtkIdType i = 0; i < actual->GetNumberOfPoints(); i++) {
+            actual->GetPoint(i, a);
+            expected->GetPoint(i, b);
+            samePoints = samePoints && a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+        }
+        TEST_CHECK(samePoints);
+    }
+
+} // namespace
+
+int main() {
+    const int rings = 24, sides = 32;
+    vtkSmartPointer<vtkPolyData> soup = CreateSphereSoup(rings, sides, 10.0);
+
+    // 共享顶点：(rings-1)*sides个纬线点加两极；两极各有sides个退化三角形
+    const vtkIdType expectedPoints = static_cast<vtkIdType>(rings - 1) * sides + 2;
+    const vtkIdType expectedTriangles = 2 * static_cast<vtkIdType>(rings) * sides - 2 * sides;
+
+    ThreadPool pool(4);
+    for (double tolerance : { 0.0, CleanTolerance }) {
+        vtkSmartPointer<vtkPolyData> reference = CleanWithVTK(soup, tolerance);
+        TEST_CHECK(reference->GetNumberOfPoints() == expectedPoints);
+        TEST_CHECK(reference->GetNumberOfPolys() == expectedTriangles);
+
+        vtkSmartPointer<vtkPolyData> serial = vtkSmartPointer<vtkPolyData>::New();
+        TEST_CHECK(MeshOptimizer::WeldVertices(soup, tolerance, serial, nullptr));
+        CheckSameMesh(serial, reference);
+
+        vtkSmartPointer<vtkPolyData> parallel = vtkSmartPointer<vtkPolyData>::New();
+        TEST_CHECK(MeshOptimizer::WeldVertices(soup, tolerance, parallel, &pool));
+        CheckSameMesh(parallel, reference);
+    }
+
+    // 非三角形单元：返回false，输出不变
+    vtkSmartPointer<vtkPolyData> quad = vtkSmartPointer<vtkPolyData>::New();
+    quad->DeepCopy(soup);
+    vtkIdType corners[4] = { 0, 1, 2, 3 };
+    quad->GetPolys()->InsertNextCell(4, corners);
+    vtkSmartPointer<vtkPolyData> untouched = vtkSmartPointer<vtkPolyData>::New();
+    TEST_CHECK(!MeshOptimizer::WeldVertices(quad, 0.0, untouched, &pool));
+    TEST_CHECK(untouched->GetNumberOfPoints() == 0);
+
+    return BronchoscopyTest::Finish("WeldVerticesTest");
+}
@@ -0,0 +1,263 @@
+// EmbedShaders - 构建时工具
+// 预解析shaders/目录下的替换文件，按ShaderPermutations的规则合并并校验全部变体，
+// 生成编译进库的替换表和变体表（ShaderBundle::GetFiles、ShaderBundle::GetVariants）
+// 任一变体校验失败时返回非零，构建随之失败
+//
+// 用法: EmbedShaders <输出.cpp> <shaders根目录> <相对路径>...
+
+#include "ShaderBundle.h"
+#include "ShaderPermutations.h"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // 转义为C++字符串字面量，每行一段，避免单个字面量超出编译器长度限制
+    std::string ToLiteral(const std::string& text) {
+        if (text.empty()) return "\"\"";
+
+        std::string result;
+        std::string current = "\"";
+        for (char c : text) {
+            switch (c) {
+                case '\\': current += "\\\\"; break;
+                case '"':  current += "\\\""; break;
+                case '\t': current += "\\t"; break;
+                case '\n':
+                    current += "\\n\"";
+                    result += (result.empty() ? "" : "\n            ") + current;
+                    current = "\"";
+                    break;
+                default:   current += c; break;
+            }
+        }
+        if (current != "\"") {
+            result += (result.empty() ? "" : "\n            ") + current + "\"";
+        }
+        return result;
+    }
+
+    // 只写入内容变化的文件，避免无关的重新编译
+    bool WriteIfChanged(const std::string& path, const std::string& content) {
+        std::ifstream existing(path, std::ios::binary);
+        if (existing) {
+            std::ostringstream buffer;
+            buffer << existing.rdbuf();
+            if (buffer.str() == content) return true;
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+        out << content;
+        return static_cast<bool>(out);
+    }
+
+    // 代码字符串池：变体之间大量共用相同的代码段，每段只生成一次
+    class StringPool {
+    public:
+        std::string Add(const std::string& text) {
+            auto it = names.find(text);
+            if (it != names.end()) return it->second;
+
+            std::string name = "kCode" + std::to_string(names.size());
+            names[text] = name;
+            definitions << "    const char " << name << "[] =\n        " << ToLiteral(text) << ";\n";
+            return name;
+        }
+
+        std::string GetDefinitions() const { return definitions.str(); }
+
+    private:
+        std::map<std::string, std::string> names;
+        std::ostringstream definitions;
+    };
+
+} // namespace
+
+int main(int argc, char** argv) {
+    using namespace BronchoscopyLib;
+
+    if (argc < 3) {
+        std::cerr << "Usage: EmbedShaders <output.cpp> <shader root> <relative paths>..." << std::endl;
+        return 1;
+    }
+
+    const std::string outputPath = argv[1];
+    std::string shaderRoot = argv[2];
+    if (!shaderRoot.empty() && shaderRoot[shaderRoot.size() - 1] != '/') {
+        shaderRoot += "/";
+    }
+
+    StringPool pool;
+    std::ostringstream tables;
+
+    std::vector<std::string> paths;
+    std::vector<size_t> counts;
+    std::vector<std::string> sourceNames;
+    std::map<std::string, std::vector<ShaderBundle::ParsedReplacement>> parsedFiles;
+
+    for (int i = 3; i < argc; ++i) {
+        std::string path = argv[i];
+        std::ifstream file(shaderRoot + path, std::ios::binary);
+        if (!file) {
+            std::cerr << "EmbedShaders: Failed to open shader file: " << shaderRoot + path << std::endl;
+            return 1;
+        }
+
+        std::ostringstream source;
+        source << file.rdbuf();
+
+        std::istringstream stream(source.str());
+        std::vector<ShaderBundle::ParsedReplacement> replacements = ShaderBundle::Parse(stream);
+
+        paths.push_back(path);
+        counts.push_back(replacements.size());
+        sourceNames.push_back(pool.Add(source.str()));
+        parsedFiles[path] = replacements;
+
+        // 完整程序（不含替换）只嵌入原文
+        if (replacements.empty()) continue;
+
+        tables << "    // " << path << "\n"
+               << "    const Replacement kFile" << paths.size() - 1 << "[] = {\n";
+        for (const auto& replacement : replacements) {
+            tables << "        { " << ToLiteral(replacement.tag) << ", "
+                   << (replacement.before ? "true" : "false") << ", "
+                   << pool.Add(replacement.code) << " },\n";
+        }
+        tables << "    };\n\n";
+    }
+
+    // 枚举、合并并校验全部变体
+    bool missingFile = false;
+    ShaderPermutations::FileLoader loadFile = [&](const std::string& path) {
+        std::vector<ShaderPermutations::Replacement> replacements;
+        auto it = parsedFiles.find(path);
+        if (it == parsedFiles.end()) {
+            std::cerr << "EmbedShaders: Variant source not found: " << path << std::endl;
+            missingFile = true;
+            return replacements;
+        }
+        for (const auto& parsed : it->second) {
+            ShaderPermutations::Replacement replacement;
+            replacement.tag = parsed.tag;
+            replacement.before = parsed.before;
+            replacement.code = parsed.code;
+            replacements.push_back(replacement);
+        }
+        return replacements;
+    };
+
+    std::vector<ShaderPermutations::Key> keys = ShaderPermutations::EnumerateKeys();
+    std::vector<size_t> variantCounts;
+    std::vector<size_t> variantSourceCounts;
+    size_t errorCount = 0;
+
+    for (size_t v = 0; v < keys.size(); ++v) {
+        const ShaderPermutations::Key& key = keys[v];
+        std::vector<ShaderPermutations::Replacement> replacements =
+            ShaderPermutations::Compose(key, loadFile);
+
+        for (const auto& error : ShaderPermutations::Validate(key, replacements)) {
+            std::cerr << "EmbedShaders: " << error << std::endl;
+            errorCount++;
+        }
+
+        std::vector<std::string> sources = ShaderPermutations::GetSourceFiles(key);
+        variantCounts.push_back(replacements.size());
+        variantSourceCounts.push_back(sources.size());
+
+        tables << "    // " << ShaderPermutations::Describe(key) << "\n";
+        if (!replacements.empty()) {
+            tables << "    const VariantReplacement kVariant" << v << "[] = {\n";
+            for (const auto& replacement : replacements) {
+                tables << "        { " << (replacement.fragment ? "true" : "false") << ", "
+                       << ToLiteral(replacement.tag) << ", "
+                       << (replacement.before ? "true" : "false") << ", "
+                       << pool.Add(replacement.code) << " },\n";
+            }
+            tables << "    };\n";
+        }
+        if (!sources.empty()) {
+            tables << "    const char* const kVariantSources" << v << "[] = {";
+            for (size_t i = 0; i < sources.size(); ++i) {
+                tables << (i ? ", " : " ") << ToLiteral(sources[i]);
+            }
+            tables << " };\n";
+        }
+        tables << "\n";
+    }
+
+    if (missingFile || errorCount > 0) {
+        std::cerr << "EmbedShaders: Shader variant validation failed (" << errorCount 
+                  << " errors)" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream out;
+    out << "// 由EmbedShaders根据shaders/目录生成，请勿手动修改\n\n"
+        << "#include \"ShaderBundle.h\"\n\n"
+        << "namespace BronchoscopyLib {\n"
+        << "namespace ShaderBundle {\n\n"
+        << "namespace {\n\n"
+        << pool.GetDefinitions() << "\n"
+        << tables.str();
+
+    out << "    const File kFiles[] = {\n";
+    for (size_t i = 0; i < paths.size(); ++i) {
+        out << "        { " << ToLiteral(paths[i]) << ", ";
+        if (counts[i] > 0) {
+            out << "kFile" << i << ", " << counts[i];
+        } else {
+            out << "nullptr, 0";
+        }
+        out << ", " << sourceNames[i] << " },\n";
+    }
+    if (paths.empty()) {
+        out << "        { nullptr, nullptr, 0, nullptr },\n";
+    }
+    out << "    };\n\n";
+
+    out << "    const Variant kVariants[] = {\n";
+    for (size_t v = 0; v < keys.size(); ++v) {
+        out << "        { " << keys[v].view << ", " << keys[v].material << ", " 
+            << keys[v].features << "u, ";
+        if (variantCounts[v] > 0) {
+            out << "kVariant" << v << ", " << variantCounts[v] << ", ";
+        } else {
+            out << "nullptr, 0, ";
+        }
+        if (variantSourceCounts[v] > 0) {
+            out << "kVariantSources" << v << ", " << variantSourceCounts[v];
+        } else {
+            out << "nullptr, 0";
+        }
+        out << " },\n";
+    }
+    out << "    };\n\n"
+        << "} // namespace\n\n"
+        << "const File* GetFiles(size_t& count) {\n"
+        << "    count = " << paths.size() << ";\n"
+        << "    return kFiles;\n"
+        << "}\n\n"
+        << "const Variant* GetVariants(size_t& count) {\n"
+        << "    count = " << keys.size() << ";\n"
+        << "    return kVariants;\n"
+        << "}\n\n"
+        << "} // namespace ShaderBundle\n"
+        << "} // namespace BronchoscopyLib\n";
+
+    if (!WriteIfChanged(outputPath, out.str())) {
+        std::cerr << "EmbedShaders: Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "EmbedShaders: Embedded " << paths.size() << " shader files and " 
+              << keys.size() << " variants" << std::endl;
+    return 0;
+}
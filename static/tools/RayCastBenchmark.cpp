@@ -0,0 +1,376 @@
+// RayCastBenchmark - MeshBVH性能测试
+// 在不同规模的合成气道网格（对称分叉的管道树）上测量BVH构建时间和查询吞吐量：
+//   lumen   管腔内的随机方向射线（管径测量、碰撞检测的访问模式，不相干）
+//   camera  内窥镜视点的针孔相机射线（拾取、可见性的访问模式，相干）
+//   closest 管腔内的点到表面的最近点查询
+// 每种查询分别在单线程和线程池批量执行
+// 另外把网格展开为三角形汤（每个三角形独立的三个点），比较MeshOptimizer::WeldVertices
+// （单线程/线程池）与vtkCleanPolyData的焊接时间，两者使用预处理的清理容差
+//
+// 用法: RayCastBenchmark [三角形数]...（默认50000 200000 500000 1000000 2000000）
+
+#include "MeshBVH.h"
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+
+#include <vtkCellArray.h>
+#include <vtkCleanPolyData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using BronchoscopyLib::MeshBVH;
+    using BronchoscopyLib::MeshOptimizer;
+    using BronchoscopyLib::ThreadPool;
+
+    const double Pi = 3.14159265358979323846;
+
+    // 分叉代数（管道段数为2^Generations - 1）
+    const int Generations = 8;
+    const size_t LumenRayCount = 1000000;
+    const int CameraResolution = 512;
+    const size_t ClosestQueryCount = 200000;
+    // 与ModelManager清理阶段相同的容差
+    const double CleanTolerance = 0.00001;
+
+    struct Segment {
+        double start[3];
+        double direction[3];  // 单位向量
+        double length;
+        double radius;
+    };
+
+    void Normalize(double v[3]) {
+        double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0) {
+            v[0] /= length; v[1] /= length; v[2] /= length;
+        }
+    }
+
+    void Cross(const double a[3], const double b[3], double out[3]) {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // 与direction垂直的单位正交基
+    void Frame(const double direction[3], double u[3], double w[3]) {
+        double helper[3] = { 1.0, 0.0, 0.0 };
+        if (std::abs(direction[0]) > 0.9) {
+            helper[0] = 0.0; helper[1] = 1.0;
+        }
+        Cross(direction, helper, u);
+        Normalize(u);
+        Cross(direction, u, w);
+    }
+
+    // 绕单位轴旋转（Rodrigues公式）
+    void Rotate(const double v[3], const double axis[3], double angle, double out[3]) {
+        double c = std::cos(angle), s = std::sin(angle);
+        double cross[3];
+        Cross(axis, v, cross);
+        double dot = axis[0] * v[0] + axis[1] * v[1] + axis[2] * v[2];
+        for (int a = 0; a < 3; a++) {
+            out[a] = v[a] * c + cross[a] * s + axis[a] * dot * (1.0 - c);
+        }
+    }
+
+    // 对称分叉的管道树：每级长度和半径按比例缩小，分叉面逐级旋转90度
+    void BuildTree(const Segment& parent, int generation, std::vector<Segment>& segments) {
+        segments.push_back(parent);
+        if (generation + 1 >= Generations) return;
+
+        double u[3], w[3];
+        Frame(parent.direction, u, w);
+        const double* axis = (generation % 2 == 0) ? u : w;
+
+        for (int side = 0; side < 2; side++) {
+            Segment child;
+            for (int a = 0; a < 3; a++) {
+                child.start[a] = parent.start[a] + parent.direction[a] * parent.length;
+            }
+            Rotate(parent.direction, axis, side == 0 ? 0.6 : -0.6, child.direction);
+            Normalize(child.direction);
+            child.length = parent.length * 0.8;
+            child.radius = parent.radius * 0.75;
+            BuildTree(child, generation + 1, segments);
+        }
+    }
+
+    // 按目标三角形数生成管道网格（各段的环向和轴向分段数相同）
+    vtkSmartPointer<vtkPolyData> CreateAirway(size_t targetTriangles, std::vector<Segment>& segments) {
+        segments.clear();
+        Segment trachea = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, -1.0 }, 100.0, 9.0 };
+        BuildTree(trachea, 0, segments);
+
+        double perSegment = static_cast<double>(targetTriangles) / (2.0 * segments.size());
+        int sides = std::max(6, static_cast<int>(std::sqrt(perSegment)));
+        int rings = std::max(2, static_cast<int>(perSegment / sides));
+
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToFloat();
+        vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+
+        for (const Segment& segment : segments) {
+            double u[3], w[3];
+            Frame(segment.direction, u, w);
+            vtkIdType base = points->GetNumberOfPoints();
+
+            for (int r = 0; r <= rings; r++) {
+                double along = segment.length * r / rings;
+                for (int s = 0; s < sides; s++) {
+                    double angle = 2.0 * Pi * s / sides;
+                    double p[3];
+                    for (int a = 0; a < 3; a++) {
+                        p[a] = segment.start[a] + segment.direction[a] * along +
+                               segment.radius * (std::cos(angle) * u[a] + std::sin(angle) * w[a]);
+                    }
+                    points->InsertNextPoint(p);
+                }
+            }
+
+            for (int r = 0; r < rings; r++) {
+                for (int s = 0; s < sides; s++) {
+                    vtkIdType a = base + r * sides + s;
+                    vtkIdType b = base + r * sides + (s + 1) % sides;
+                    vtkIdType c = a + sides;
+                    vtkIdType d = b + sides;
+                    vtkIdType first[3] = { a, b, d };
+                    vtkIdType second[3] = { a, d, c };
+                    polys->InsertNextCell(3, first);
+                    polys->InsertNextCell(3, second);
+                }
+            }
+        }
+
+        vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+        mesh->SetPoints(points);
+        mesh->SetPolys(polys);
+        return mesh;
+    }
+
+    // 管腔中轴上的随机点（半径内扰动）
+    void SampleLumen(const std::vector<Segment>& segments, std::mt19937& rng, double point[3]) {
+        std::uniform_int_distribution<size_t> pick(0, segments.size() - 1);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const Segment& segment = segments[pick(rng)];
+
+        double u[3], w[3];
+        Frame(segment.direction, u, w);
+        double along = segment.length * unit(rng);
+        double radial = 0.5 * segment.radius * unit(rng);
+        double angle = 2.0 * Pi * unit(rng);
+        for (int a = 0; a < 3; a++) {
+            point[a] = segment.start[a] + segment.direction[a] * along +
+                       radial * (std::cos(angle) * u[a] + std::sin(angle) * w[a]);
+        }
+    }
+
+    std::vector<MeshBVH::Ray> CreateLumenRays(const std::vector<Segment>& segments, size_t count) {
+        std::mt19937 rng(7);
+        std::normal_distribution<double> gaussian(0.0, 1.0);
+        std::vector<MeshBVH::Ray> rays(count);
+        for (MeshBVH::Ray& ray : rays) {
+            SampleLumen(segments, rng, ray.origin);
+            for (int a = 0; a < 3; a++) {
+                ray.direction[a] = gaussian(rng);
+            }
+        }
+        return rays;
+    }
+
+    // 气管入口处沿管道方向的针孔相机，视场90度
+    std::vector<MeshBVH::Ray> CreateCameraRays(const Segment& segment, int resolution) {
+        double u[3], w[3];
+        Frame(segment.direction, u, w);
+
+        std::vector<MeshBVH::Ray> rays;
+        rays.reserve(static_cast<size_t>(resolution) * resolution);
+        for (int y = 0; y < resolution; y++) {
+            for (int x = 0; x < resolution; x++) {
+                double sx = (2.0 * (x + 0.5) / resolution) - 1.0;
+                double sy = (2.0 * (y + 0.5) / resolution) - 1.0;
+                MeshBVH::Ray ray;
+                for (int a = 0; a < 3; a++) {
+                    ray.origin[a] = segment.start[a] + segment.direction[a] * 5.0;
+                    ray.direction[a] = segment.direction[a] + sx * u[a] + sy * w[a];
+                }
+                rays.push_back(ray);
+            }
+        }
+        return rays;
+    }
+
+    template <typename Body>
+    double MeasureSeconds(Body body) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void Report(const std::string& name, size_t queries, double seconds, size_t hits) {
+        std::cout << "  " << std::left << std::setw(26) << name << std::right
+                  << std::setw(10) << std::fixed << std::setprecision(2)
+                  << (seconds > 0.0 ? queries / seconds / 1e6 : 0.0) << " M/s"
+                  << "   hit " << std::setprecision(1) << (queries ? 100.0 * hits / queries : 0.0) << "%"
+                  << std::endl;
+    }
+
+    size_t CountHits(const std::vector<MeshBVH::Hit>& hits) {
+        return static_cast<size_t>(std::count_if(hits.begin(), hits.end(),
+            [](const MeshBVH::Hit& hit) { return hit.hit; }));
+    }
+
+    void RunRays(const MeshBVH& bvh, ThreadPool& pool, const std::string& name,
+                 const std::vector<MeshBVH::Ray>& rays) {
+        std::vector<MeshBVH::Hit> hits;
+        double serial = MeasureSeconds([&]() { bvh.IntersectBatch(rays, hits, nullptr); });
+        Report(name + " (1 thread)", rays.size(), serial, CountHits(hits));
+
+        double parallel = MeasureSeconds([&]() { bvh.IntersectBatch(rays, hits, &pool); });
+        Report(name + " (" + std::to_string(pool.GetThreadCount()) + " threads)",
+               rays.size(), parallel, CountHits(hits));
+    }
+
+    void RunClosest(const MeshBVH& bvh, ThreadPool& pool, const std::vector<Segment>& segments) {
+        std::mt19937 rng(11);
+        std::vector<double> queries(ClosestQueryCount * 3);
+        for (size_t i = 0; i < ClosestQueryCount; i++) {
+            SampleLumen(segments, rng, &queries[i * 3]);
+        }
+
+        std::vector<MeshBVH::Hit> hits(ClosestQueryCount);
+        auto body = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                bvh.FindClosestPoint(&queries[i * 3], 0.0, hits[i]);
+            }
+        };
+
+        double serial = MeasureSeconds([&]() { body(0, ClosestQueryCount); });
+        Report("closest (1 thread)", ClosestQueryCount, serial, CountHits(hits));
+
+        double parallel = MeasureSeconds([&]() { pool.ParallelFor(ClosestQueryCount, 256, body); });
+        Report("closest (" + std::to_string(pool.GetThreadCount()) + " threads)",
+               ClosestQueryCount, parallel, CountHits(hits));
+    }
+
+    // 三角形汤：按三角形顺序为每个角点插入独立的点（读取STL等格式后的典型输入）
+    vtkSmartPointer<vtkPolyData> CreateTriangleSoup(vtkPolyData* mesh) {
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToFloat();
+        points->Allocate(mesh->GetNumberOfPolys() * 3);
+        vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+
+        vtkCellArray* input = mesh->GetPolys();
+        vtkIdType npts = 0;
+        vtkIdType* pts = nullptr;
+        double point[3];
+        input->InitTraversal();
+        while (input->GetNextCell(npts, pts)) {
+            vtkIdType ids[3];
+            for (int k = 0; k < 3; k++) {
+                mesh->GetPoint(pts[k], point);
+                ids[k] = points->InsertNextPoint(point);
+            }
+            polys->InsertNextCell(3, ids);
+        }
+
+        vtkSmartPointer<vtkPolyData> soup = vtkSmartPointer<vtkPolyData>::New();
+        soup->SetPoints(points);
+        soup->SetPolys(polys);
+        return soup;
+    }
+
+    void ReportWeld(const std::string& name, vtkPolyData* output, double seconds) {
+        std::cout << "  " << std::left << std::setw(26) << name << std::right
+                  << std::setw(10) << std::fixed << std::setprecision(1) << seconds * 1000.0 << " ms"
+                  << "   " << output->GetNumberOfPoints() << " points, "
+                  << output->GetNumberOfPolys() << " triangles" << std::endl;
+    }
+
+    void RunWeld(vtkPolyData* mesh, ThreadPool& pool) {
+        vtkSmartPointer<vtkPolyData> soup = CreateTriangleSoup(mesh);
+
+        vtkSmartPointer<vtkPolyData> welded = vtkSmartPointer<vtkPolyData>::New();
+        double serial = MeasureSeconds([&]() {
+            MeshOptimizer::WeldVertices(soup, CleanTolerance, welded, nullptr);
+        });
+        ReportWeld("weld (1 thread)", welded, serial);
+
+        double parallel = MeasureSeconds([&]() {
+            MeshOptimizer::WeldVertices(soup, CleanTolerance, welded, &pool);
+        });
+        ReportWeld("weld (" + std::to_string(pool.GetThreadCount()) + " threads)", welded, parallel);
+
+        vtkSmartPointer<vtkCleanPolyData> clean = vtkSmartPointer<vtkCleanPolyData>::New();
+        double reference = MeasureSeconds([&]() {
+            clean->SetInputData(soup);
+            clean->PointMergingOn();
+            clean->SetTolerance(CleanTolerance);
+            clean->ConvertPolysToLinesOff();
+            clean->ConvertLinesToPointsOff();
+            clean->ConvertStripsToPolysOff();
+            clean->Update();
+        });
+        ReportWeld("vtkCleanPolyData", clean->GetOutput(), reference);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) {
+        long long value = std::atoll(argv[i]);
+        if (value <= 0) {
+            std::cerr << "Usage: RayCastBenchmark [triangle count]..." << std::endl;
+            return 1;
+        }
+        sizes.push_back(static_cast<size_t>(value));
+    }
+    if (sizes.empty()) {
+        sizes = { 50000, 200000, 500000, 1000000, 2000000 };
+    }
+
+    ThreadPool pool;
+
+    for (size_t size : sizes) {
+        std::vector<Segment> segments;
+        vtkSmartPointer<vtkPolyData> mesh = CreateAirway(size, segments);
+
+        MeshBVH bvh;
+        double serialBuild = MeasureSeconds([&]() { bvh.Build(mesh, nullptr); });
+        double parallelBuild = MeasureSeconds([&]() { bvh.Build(mesh, &pool); });
+        if (bvh.IsEmpty()) {
+            std::cerr << "RayCastBenchmark: Build failed" << std::endl;
+            return 1;
+        }
+
+        const MeshBVH::BuildStats& stats = bvh.GetBuildStats();
+        std::cout << "\n=== " << stats.triangles << " triangles ===" << std::endl;
+        std::cout << "  build " << std::fixed << std::setprecision(1)
+                  << serialBuild * 1000.0 << " ms (1 thread), "
+                  << parallelBuild * 1000.0 << " ms (" << pool.GetThreadCount() << " threads); "
+                  << stats.nodes << " nodes, depth " << stats.maxDepth
+                  << ", SAH " << std::setprecision(2) << stats.sahCost
+                  << ", " << stats.memoryBytes / (1024 * 1024) << " MB" << std::endl;
+
+        RunRays(bvh, pool, "lumen", CreateLumenRays(segments, LumenRayCount));
+        RunRays(bvh, pool, "camera", CreateCameraRays(segments[0], CameraResolution));
+        RunClosest(bvh, pool, segments);
+        RunWeld(mesh, pool);
+    }
+
+    return 0;
+}